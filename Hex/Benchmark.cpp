@@ -0,0 +1,700 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Benchmark.cpp
+// SYNOPSIS : Measures Hex's throughput on synthetic inputs.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+
+#include "PCH.h"
+
+// LINKER DIRECTIVES //////////////////////////////////////////////////////////
+
+#pragma comment(lib, "boost_program_options-vc142-mt-x32-1_77.lib")
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+
+#include "Encoders.h"
+#include "HexLib.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// USING
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace HexLib;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+///////////////////////////////////////////////////////////////////////////////
+
+//! The kinds of synthetic input.
+const char* const INPUT_KINDS[]{ "random", "zero", "ascii", "pattern" };
+
+//! Bytes in a mebibyte, the unit of input sizes.
+const std::uint64_t BYTES_PER_MEBIBYTE{ 1ULL << 20 };
+
+//! Bytes in a gigabyte, the unit of throughput.
+const double BYTES_PER_GIGABYTE{ 1e9 };
+
+//! Length of the block repeated by pattern inputs.
+const std::size_t PATTERN_PERIOD{ 4096 };
+
+//! Text repeated by ASCII inputs.
+const std::string_view ASCII_TEXT{
+    "The quick brown fox jumps over the lazy dog. 0123456789\n"
+    "Pack my box with five dozen liquor jugs!\tSphinx of black quartz.\n"
+};
+
+//! Seed of the random inputs, fixed so every run dumps the same bytes.
+const std::uint64_t RANDOM_SEED{ 0x9E3779B97F4A7C15ULL };
+
+#ifdef _WIN32
+const char* const NULL_DEVICE{ "NUL" };
+const char* const HEX_EXECUTABLE{ "Hex.exe" };
+#else
+const char* const NULL_DEVICE{ "/dev/null" };
+const char* const HEX_EXECUTABLE{ "Hex" };
+#endif /* _WIN32 */
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CLASSES
+///////////////////////////////////////////////////////////////////////////////
+
+//! One measurement.
+struct result_struct
+{
+  std::string tool{};
+  std::string format{};
+  std::string input{};
+  std::uint64_t size{};
+  std::string cache{};
+  std::string backend{};
+  unsigned threads{};
+  double best_seconds{};
+  double median_seconds{};
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Writes a synthetic input file.
+ *
+ * @param[in] filename The file to write.
+ * @param[in] kind One of INPUT_KINDS.
+ * @param[in] size The number of bytes to write.
+ * @returns \c true if the file was written.
+ */
+bool make_input (
+    const std::string& filename,
+    const std::string& kind,
+    std::uint64_t size
+)
+{
+  std::vector<char> block( READ_BLOCK_SIZE );
+  if ( kind == "ascii" )
+  {
+    for ( std::size_t i{ 0 }; i < block.size (); ++i )
+    {
+      block[i] = ASCII_TEXT[i % ASCII_TEXT.size ()];
+    }
+  }
+  else if ( kind == "pattern" )
+  {
+    for ( std::size_t i{ 0 }; i < block.size (); ++i )
+    {
+      block[i] = static_cast<char>( ( i % PATTERN_PERIOD ) * 31 / 7 );
+    }
+  }
+
+  std::ofstream output{ filename, std::ios::binary };
+  auto state{ RANDOM_SEED };
+  for ( std::uint64_t written{ 0 }; output && written < size; )
+  {
+    if ( kind == "random" )
+    {
+      for ( std::size_t i{ 0 }; i < block.size (); i += 8 )
+      {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::memcpy ( block.data () + i, &state, 8 );
+      }
+    }
+    const auto count{
+        static_cast<std::size_t>(
+            std::min<std::uint64_t> ( block.size (), size - written )
+        )
+    };
+    output.write ( block.data (), static_cast<std::streamsize>( count ) );
+    written += count;
+  }
+  output.close ();
+  return ( !output.fail () );
+}
+
+
+/**
+ * @brief Asks the kernel to drop a file from the page cache.
+ *
+ * @param[in] filename The file.
+ * @returns \c false where cold runs are not possible.
+ */
+bool drop_cached ( const std::string& filename )
+{
+#ifndef _WIN32
+  const auto fd{ ::open ( filename.c_str (), O_RDONLY | O_CLOEXEC ) };
+  if ( fd < 0 )
+  {
+    return ( false );
+  }
+  ::fdatasync ( fd );
+  const auto result{ ::posix_fadvise ( fd, 0, 0, POSIX_FADV_DONTNEED ) };
+  ::close ( fd );
+  return ( result == 0 );
+#else
+  static_cast<void>( filename );
+  return ( false );
+#endif /* _WIN32 */
+}
+
+
+/**
+ * @brief Reads a file so that it is in the page cache.
+ *
+ * @param[in] filename The file.
+ */
+void warm_cache ( const std::string& filename )
+{
+  const auto input{ open_reader ( filename, false ) };
+  std::vector<char> block( READ_BLOCK_SIZE );
+  while ( input->is_open () && input->read ( block.data (), block.size () ) )
+  {
+  }
+}
+
+
+/**
+ * @brief Gives the command dumping a file with Hex on a number of threads.
+ *
+ * The file is given once per thread, so every thread dumps all of it, and
+ * the dumps go to standard output like those of the reference tools.
+ *
+ * @param[in] hex The Hex executable.
+ * @param[in] filename The file.
+ * @param[in] format The output format.
+ * @param[in] is_no_cache Whether to use the uncached reader.
+ * @param[in] threads The number of threads.
+ * @returns The command.
+ */
+std::string hex_command (
+    const std::string& hex,
+    const std::string& filename,
+    const std::string& format,
+    bool is_no_cache,
+    unsigned threads
+)
+{
+  auto command{
+      "\"" + hex + "\" -F " + format + " -j " + std::to_string ( threads )
+  };
+  if ( is_no_cache )
+  {
+    command += " --no-cache";
+  }
+  for ( unsigned t{ 0 }; t < threads; ++t )
+  {
+    command += " \"" + filename + "\"";
+  }
+  return ( command );
+}
+
+
+/**
+ * @brief Runs a shell command, discarding its output.
+ *
+ * @param[in] command The command.
+ * @param[out] seconds The seconds taken.
+ * @returns \c true if the command succeeded.
+ */
+bool time_command ( const std::string& command, double& seconds )
+{
+  const auto start{ std::chrono::steady_clock::now () };
+  const auto status{
+      std::system ( ( command + " > " + NULL_DEVICE ).c_str () )
+  };
+  const std::chrono::duration<double> elapsed{
+      std::chrono::steady_clock::now () - start
+  };
+  seconds = elapsed.count ();
+  return ( status == 0 );
+}
+
+
+/**
+ * @brief Checks whether a reference tool can be run.
+ *
+ * @param[in] tool The name of the tool.
+ * @returns \c true if it is on the path.
+ */
+bool has_tool ( const std::string& tool )
+{
+#ifndef _WIN32
+  return (
+      std::system (
+          ( "command -v " + tool + " > /dev/null 2>&1" ).c_str ()
+      ) == 0
+  );
+#else
+  return (
+      std::system ( ( "where " + tool + " > NUL 2>&1" ).c_str () ) == 0
+  );
+#endif /* _WIN32 */
+}
+
+
+/**
+ * @brief Repeats a measurement and keeps its best and median times.
+ *
+ * @param[in] repeat The number of runs.
+ * @param[in] is_cold Whether the input is dropped from the cache before each
+ * run, rather than read into it.
+ * @param[in] filename The input.
+ * @param[in] run Runs once, returning the seconds taken or a negative number
+ * on failure.
+ * @param[in,out] result Where to record the times.
+ * @returns \c true if every run succeeded.
+ */
+bool measure (
+    unsigned repeat,
+    bool is_cold,
+    const std::string& filename,
+    const std::function<double ()>& run,
+    result_struct& result
+)
+{
+  std::vector<double> times{};
+  for ( unsigned r{ 0 }; r < repeat; ++r )
+  {
+    if ( is_cold )
+    {
+      drop_cached ( filename );
+    }
+    else
+    {
+      warm_cache ( filename );
+    }
+    const auto seconds{ run () };
+    if ( seconds < 0.0 )
+    {
+      return ( false );
+    }
+    times.push_back ( seconds );
+  }
+  std::sort ( times.begin (), times.end () );
+  result.best_seconds = times.front ();
+  result.median_seconds = times[times.size () / 2];
+  return ( true );
+}
+
+
+/**
+ * @brief Gives the throughput of a measurement.
+ *
+ * @param[in] result The measurement.
+ * @returns Gigabytes (10^9 bytes) of input per second at the best time.
+ */
+double gigabytes_per_second ( const result_struct& result )
+{
+  return (
+      static_cast<double>( result.size ) * result.threads
+      / result.best_seconds / BYTES_PER_GIGABYTE
+  );
+}
+
+
+/**
+ * @brief Writes measurements as a JSON array of objects.
+ *
+ * @param[in] results The measurements.
+ * @param[in] out The stream to write to.
+ */
+void write_json (
+    const std::vector<result_struct>& results,
+    std::ostream& out
+)
+{
+  out << "[\n";
+  for ( std::size_t i{ 0 }; i < results.size (); ++i )
+  {
+    const auto& r{ results[i] };
+    out << "  { \"tool\": \"" << r.tool
+        << "\", \"format\": \"" << r.format
+        << "\", \"input\": \"" << r.input
+        << "\", \"bytes\": " << r.size
+        << ", \"cache\": \"" << r.cache
+        << "\", \"backend\": \"" << r.backend
+        << "\", \"threads\": " << r.threads
+        << ", \"best_seconds\": " << r.best_seconds
+        << ", \"median_seconds\": " << r.median_seconds
+        << ", \"gb_per_second\": " << gigabytes_per_second ( r )
+        << " }" << ( i + 1 < results.size () ? "," : "" ) << "\n";
+  }
+  out << "]\n";
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DRIVER
+///////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char** argv )
+{
+  std::ios::sync_with_stdio ( false );
+
+  bool is_help{};
+  bool is_keep{};
+  bool is_no_reference{};
+
+  boost::program_options::options_description description{
+      "Benchmark [options]"
+  };
+  description.add_options ()
+      (
+          "help,h",
+          boost::program_options::bool_switch ( &is_help ),
+          "Display a help dialog"
+      )
+      (
+          "sizes,s",
+          boost::program_options::value<std::vector<std::uint64_t>> ()
+              ->multitoken ()
+              ->default_value ( { 1, 16, 256 }, "1 16 256" ),
+          "Input sizes in mebibytes"
+      )
+      (
+          "inputs,i",
+          boost::program_options::value<std::vector<std::string>> ()
+              ->multitoken ()
+              ->default_value (
+                  { "random", "zero", "ascii", "pattern" },
+                  "random zero ascii pattern"
+              ),
+          "Kinds of input: 'random', 'zero', 'ascii', or 'pattern'"
+      )
+      (
+          "formats,F",
+          boost::program_options::value<std::vector<std::string>> ()
+              ->multitoken ()
+              ->default_value ( { "canonical" }, "canonical" ),
+          "Output formats to measure"
+      )
+      (
+          "threads,t",
+          boost::program_options::value<std::vector<unsigned>> ()
+              ->multitoken ()
+              ->default_value ( { 1 }, "1" ),
+          "Hex job counts; each job dumps its own copy of the input"
+      )
+      (
+          "repeat,n",
+          boost::program_options::value<unsigned> ()->default_value ( 3 ),
+          "Runs of each measurement, of which the best and median are kept"
+      )
+      (
+          "directory,d",
+          boost::program_options::value<std::string> ()->default_value (
+              ( std::filesystem::temp_directory_path () / "hex-benchmark" )
+                  .string ()
+          ),
+          "Where to write the inputs"
+      )
+      (
+          "keep",
+          boost::program_options::bool_switch ( &is_keep ),
+          "Keep the inputs afterwards"
+      )
+      (
+          "hex,x",
+          boost::program_options::value<std::string> ()->default_value (
+              ( std::filesystem::path{ argv[0] }.parent_path ()
+                  / HEX_EXECUTABLE ).string ()
+          ),
+          "The Hex executable to measure"
+      )
+      (
+          "no-reference",
+          boost::program_options::bool_switch ( &is_no_reference ),
+          "Skip 'xxd' and 'hexdump -C'"
+      )
+      (
+          "output,o",
+          boost::program_options::value<std::string> ()->default_value (
+              "benchmark.json"
+          ),
+          "File to write the results to as JSON"
+      );
+
+  boost::program_options::variables_map vm{};
+  try
+  {
+    store ( parse_command_line ( argc, argv, description ), vm );
+    notify ( vm );
+  }
+  catch ( const std::exception& e )
+  {
+    std::cerr << e.what () << "\n";
+    return ( 1 );
+  }
+
+  if ( is_help )
+  {
+    std::cout << description;
+    return ( 0 );
+  }
+
+  const auto& kinds{ vm["inputs"].as<std::vector<std::string>> () };
+  for ( const auto& k : kinds )
+  {
+    if (
+        std::find_if (
+            std::begin ( INPUT_KINDS ),
+            std::end ( INPUT_KINDS ),
+            [&] ( const char* known ) { return ( k == known ); }
+        ) == std::end ( INPUT_KINDS )
+    )
+    {
+      std::cerr << "Unknown kind of input '" << k << "' !\n";
+      return ( 1 );
+    }
+  }
+  const auto& formats{ vm["formats"].as<std::vector<std::string>> () };
+  for ( const auto& f : formats )
+  {
+    if ( !make_encoder ( f ) )
+    {
+      std::cerr << "Unknown output format '" << f << "' !\n";
+      return ( 1 );
+    }
+  }
+  const auto repeat{ std::max ( vm["repeat"].as<unsigned> (), 1U ) };
+
+  const auto& hex{ vm["hex"].as<std::string> () };
+  double seconds{};
+  if ( !time_command ( "\"" + hex + "\" --help", seconds ) )
+  {
+    std::cerr << "Cannot run Hex as '" << hex << "' !\n";
+    return ( 1 );
+  }
+
+  const std::filesystem::path directory{ vm["directory"].as<std::string> () };
+  std::error_code ec{};
+  std::filesystem::create_directories ( directory, ec );
+
+  std::vector<std::string> references{};
+  if ( !is_no_reference )
+  {
+    for ( const auto* tool : { "xxd", "hexdump" } )
+    {
+      if ( has_tool ( tool ) )
+      {
+        references.emplace_back ( tool );
+      }
+    }
+  }
+
+  const std::vector<std::pair<std::string, bool>> backends{
+      { "stream", false },
+#ifndef _WIN32
+      { "uncached", true },
+#endif /* _WIN32 */
+  };
+#ifndef _WIN32
+  const std::vector<std::pair<std::string, bool>> caches{
+      { "hot", false }, { "cold", true }
+  };
+#else
+  const std::vector<std::pair<std::string, bool>> caches{ { "hot", false } };
+#endif /* _WIN32 */
+
+  const auto& sizes{ vm["sizes"].as<std::vector<std::uint64_t>> () };
+  const auto& thread_counts{ vm["threads"].as<std::vector<unsigned>> () };
+
+  std::vector<result_struct> results{};
+  auto report = [&] ( const result_struct& r )
+  {
+    std::cout << r.tool << " " << r.format << " " << r.input << " "
+        << r.size / BYTES_PER_MEBIBYTE << "MiB " << r.cache << " "
+        << r.backend << " x" << r.threads << ": "
+        << gigabytes_per_second ( r ) << " GB/s\n" << std::flush;
+    results.push_back ( r );
+  };
+
+  // Every tool is run the same way, as a process writing to the null
+  // device, and any run failing ends the benchmark rather than leaving a
+  // gap in the results.
+  auto measure_command = [&] (
+      const std::string& command,
+      const std::string& filename,
+      bool is_cold,
+      result_struct& r
+  )
+  {
+    const auto is_measured{
+        measure (
+            repeat,
+            is_cold,
+            filename,
+            [&] ()
+            {
+              double seconds{};
+              const auto is_ok{ time_command ( command, seconds ) };
+              return ( is_ok ? seconds : -1.0 );
+            },
+            r
+        )
+    };
+    if ( !is_measured )
+    {
+      std::cerr << "Measuring '" << command << "' failed !\n";
+      if ( !is_keep )
+      {
+        std::filesystem::remove ( filename, ec );
+        std::filesystem::remove ( directory, ec );
+      }
+      return ( false );
+    }
+    report ( r );
+    return ( true );
+  };
+
+  for ( const auto& kind : kinds )
+  {
+    for ( const auto mebibytes : sizes )
+    {
+      const auto size{ mebibytes * BYTES_PER_MEBIBYTE };
+      const auto filename{
+          ( directory / ( kind + "-" + std::to_string ( mebibytes ) ) )
+              .string ()
+      };
+      if ( !make_input ( filename, kind, size ) )
+      {
+        std::cerr << "Cannot write input file '" << filename << "' !\n";
+        return ( 4 );
+      }
+
+      for ( const auto& [cache, is_cold] : caches )
+      {
+        for ( const auto& format : formats )
+        {
+          for ( const auto& [backend, is_no_cache] : backends )
+          {
+            for ( const auto threads : thread_counts )
+            {
+              result_struct r{
+                  "hex", format, kind, size, cache, backend,
+                  std::max ( threads, 1U )
+              };
+              if (
+                  !measure_command (
+                      hex_command (
+                          hex, filename, format, is_no_cache, r.threads
+                      ),
+                      filename,
+                      is_cold,
+                      r
+                  )
+              )
+              {
+                return ( 5 );
+              }
+            }
+          }
+        }
+
+        for ( const auto& tool : references )
+        {
+          result_struct r{
+              tool,
+              tool == "xxd" ? "xxd" : "hexdump -C",
+              kind, size, cache, "stream", 1
+          };
+          if (
+              !measure_command (
+                  tool == "xxd"
+                      ? "xxd \"" + filename + "\""
+                      : "hexdump -C \"" + filename + "\"",
+                  filename,
+                  is_cold,
+                  r
+              )
+          )
+          {
+            return ( 5 );
+          }
+        }
+      }
+
+      if ( !is_keep )
+      {
+        std::filesystem::remove ( filename, ec );
+      }
+    }
+  }
+
+  if ( !is_keep )
+  {
+    // Only removed when empty, so nothing of the user's is ever lost.
+    std::filesystem::remove ( directory, ec );
+  }
+
+  const auto& output_filename{ vm["output"].as<std::string> () };
+  std::ofstream output{ output_filename };
+  if ( !output.is_open () )
+  {
+    std::cerr << "Cannot open output file '" << output_filename
+        << "' for writing !\n";
+    return ( 4 );
+  }
+  write_json ( results, output );
+  return ( 0 );
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Measures Hex's throughput on synthetic inputs.
+ *
+ * Built from this file alone, as it measures the Hex executable given by
+ * \c --hex , by default the one beside it. Every input is measured hot, after
+ * being read into the page cache, and cold, after being dropped from it, for
+ * each output format, reader, and thread count, and once each with \c xxd
+ * and \c hexdump \c -C when they are installed. Hex runs as a process writing
+ * to the null device exactly as the reference tools do, so start-up and
+ * writing are measured alike, and a run that fails ends the benchmark with an
+ * error. Results are printed as they come and written as JSON, one object per
+ * measurement, so runs can be compared over time.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
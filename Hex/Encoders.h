@@ -0,0 +1,1744 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Encoders.h
+// SYNOPSIS : Output encoders sharing Hex's input pipeline.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// SYSTEM /////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+
+#include "Simd.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+///////////////////////////////////////////////////////////////////////////////
+
+const char PRINTABLES[]{
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    ' ', '!', '"', '#', '$', '%', '&', '\'',
+    '(', ')', '*', '+', ',', '-', '.', '/',
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', ':', ';', '<', '=', '>', '?',
+    '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
+    'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
+    'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W',
+    'X', 'Y', 'Z', '[', '\\', ']', '^', '_',
+    '`', 'a', 'b', 'c', 'd', 'e', 'f', 'g',
+    'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+    'p', 'q', 'r', 's', 't', 'u', 'v', 'w',
+    'x', 'y', 'z', '{', '|', '}', '~', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.',
+    '.', '.', '.', '.', '.', '.', '.', '.'
+};
+
+const char HEX_CHARS[]{
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+const char LOWER_HEX_CHARS[]{
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+const char BASE64_CHARS[]{
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
+    'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
+    'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
+    'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3',
+    '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+//! Minimum number of hexadecimal digits written for an offset.
+const auto OFFSET_DIGITS{ 8 };
+
+//! Maximum number of hexadecimal digits written for an offset.
+const auto MAX_OFFSET_DIGITS{ 16 };
+
+//! Bytes in a row of the canonical format.
+const std::size_t CANONICAL_ROW_BYTES{ 16 };
+
+//! Most characters in a row of the canonical format, newline included.
+const std::size_t MAX_CANONICAL_ROW_CHARS{
+    MAX_OFFSET_DIGITS + 2 + 3 * CANONICAL_ROW_BYTES + 1 + CANONICAL_ROW_BYTES
+    + 1
+};
+
+//! Bytes in a line of the plain format, as for 'xxd -p'.
+const std::size_t PLAIN_LINE_BYTES{ 30 };
+
+//! Bytes in a line of the C array format, as for 'xxd -i'.
+const std::size_t C_ARRAY_LINE_BYTES{ 12 };
+
+//! Data bytes in an Intel HEX or Motorola S-record data record.
+const std::size_t RECORD_BYTES{ 16 };
+
+//! Bytes in a line of the base64 format, giving 76 characters per line.
+const std::size_t BASE64_LINE_BYTES{ 57 };
+
+//! Highest address plus one that 32-bit record formats can reach.
+const std::uint64_t RECORD_ADDRESS_LIMIT{ 1ULL << 32 };
+
+//! The start of C array names for inputs whose names start with no letter.
+const char* const C_ARRAY_NAME_PREFIX{ "data" };
+
+//! Spare bytes after a line that vector kernels may scribble on.
+const std::size_t KERNEL_SLACK{ 16 };
+
+//! Most characters any format writes before and after the data, besides
+//! those taken from the name of the input.
+const std::size_t MAX_FRAMING_CHARS{ 256 };
+
+//! Most characters any format writes for each character of the name of the
+//! input.
+const std::size_t MAX_CHARS_PER_NAME_CHAR{ 4 };
+
+//! Distance from \c '9'+1 to \c 'A' , for upper case digits.
+const char UPPER_LETTER_GAP{ 'A' - '9' - 1 };
+
+//! Distance from \c '9'+1 to \c 'a' , for lower case digits.
+const char LOWER_LETTER_GAP{ 'a' - '9' - 1 };
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LOOKUP TABLES
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Builds a table of the two hexadecimal digits for every byte value.
+ *
+ * @param[in] digits The sixteen digit characters to use.
+ * @returns 512 characters, the pair for byte \c b starting at \c 2*b .
+ */
+constexpr std::array<char, 512> make_hex_pairs ( const char ( &digits )[16] )
+{
+  std::array<char, 512> table{};
+  for ( std::size_t b{ 0 }; b < 256; ++b )
+  {
+    table[2 * b] = digits[b >> 4];
+    table[2 * b + 1] = digits[b & 0xF];
+  }
+  return ( table );
+}
+
+
+/**
+ * @brief Builds a table of the two base64 characters for every 12-bit value.
+ *
+ * @returns 8192 characters, the pair for value \c v starting at \c 2*v .
+ */
+constexpr std::array<char, 8192> make_base64_pairs ()
+{
+  std::array<char, 8192> table{};
+  for ( std::size_t v{ 0 }; v < 4096; ++v )
+  {
+    table[2 * v] = BASE64_CHARS[v >> 6];
+    table[2 * v + 1] = BASE64_CHARS[v & 0x3F];
+  }
+  return ( table );
+}
+
+
+inline constexpr auto UPPER_HEX_PAIRS{ make_hex_pairs ( HEX_CHARS ) };
+inline constexpr auto LOWER_HEX_PAIRS{ make_hex_pairs ( LOWER_HEX_CHARS ) };
+inline constexpr auto BASE64_PAIRS{ make_base64_pairs () };
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// VECTOR KERNELS
+///////////////////////////////////////////////////////////////////////////////
+
+// The kernels below turn whole lines into text sixteen characters at a time.
+// SSE2 is enough for digits and printables; the layouts with separators need
+// the SSSE3 byte shuffle. Without either, the scalar table code is used.
+// Unless the build enables SSSE3, its kernels are compiled for it alone and
+// only run when HAS_SSSE3 finds it on the processor.
+
+/**
+ * @brief Byte shuffles laying out the 32 digits of 16 bytes as text.
+ *
+ * Each 16-character chunk of the layout takes digits from the low and high
+ * halves of the digits, then has its literal characters merged in.
+ *
+ * @tparam CHUNKS The number of 16-character chunks in the layout.
+ */
+template<std::size_t CHUNKS>
+struct shuffle_plan_struct
+{
+  //! Shuffle indices into the digits of bytes 0 to 7, or -1.
+  alignas( 16 ) std::array<std::array<signed char, 16>, CHUNKS> from_low{};
+  //! Shuffle indices into the digits of bytes 8 to 15, or -1.
+  alignas( 16 ) std::array<std::array<signed char, 16>, CHUNKS> from_high{};
+  //! Literal characters, or zero where a digit goes.
+  alignas( 16 ) std::array<std::array<char, 16>, CHUNKS> literals{};
+};
+
+
+/**
+ * @brief Builds the shuffles for a text layout.
+ *
+ * @tparam CHUNKS The number of 16-character chunks in the layout.
+ * @param[in] layout The text, with \c @ standing for the next digit in
+ * order. Positions past its end are left as spaces.
+ * @returns The shuffles for the layout.
+ */
+template<std::size_t CHUNKS>
+constexpr shuffle_plan_struct<CHUNKS> make_shuffle_plan ( const char* layout )
+{
+  shuffle_plan_struct<CHUNKS> plan{};
+  auto digit{ 0 };
+  auto ended{ false };
+  for ( std::size_t i{ 0 }; i < 16 * CHUNKS; ++i )
+  {
+    ended = ended || !layout[i];
+    const auto c{ ended ? ' ' : layout[i] };
+    auto& low{ plan.from_low[i / 16][i % 16] };
+    auto& high{ plan.from_high[i / 16][i % 16] };
+    low = -1;
+    high = -1;
+    if ( c == '@' )
+    {
+      if ( digit < 16 )
+      {
+        low = static_cast<signed char>( digit );
+      }
+      else
+      {
+        high = static_cast<signed char>( digit - 16 );
+      }
+      ++digit;
+    }
+    else
+    {
+      plan.literals[i / 16][i % 16] = c;
+    }
+  }
+  return ( plan );
+}
+
+
+//! The hexadecimal area of a canonical row.
+inline constexpr auto CANONICAL_PLAN{
+    make_shuffle_plan<3> (
+        "@@ @@ @@ @@ @@ @@ @@ @@ @@ @@ @@ @@ @@ @@ @@ @@ "
+    )
+};
+
+//! A line of the C array format, less its leading space and newline.
+inline constexpr auto C_ARRAY_PLAN{
+    make_shuffle_plan<5> (
+        " 0x@@, 0x@@, 0x@@, 0x@@, 0x@@, 0x@@,"
+        " 0x@@, 0x@@, 0x@@, 0x@@, 0x@@, 0x@@,"
+    )
+};
+
+
+#ifdef HEX_HAVE_SSE2
+/**
+ * @brief Turns sixteen nibbles into hexadecimal digits.
+ *
+ * @param[in] nibbles Values from 0 to 15.
+ * @param[in] letter_gap UPPER_LETTER_GAP or LOWER_LETTER_GAP.
+ * @returns The digit characters.
+ */
+inline __m128i nibbles_to_digits ( __m128i nibbles, char letter_gap )
+{
+  const auto is_letter{ _mm_cmpgt_epi8 ( nibbles, _mm_set1_epi8 ( 9 ) ) };
+  return (
+      _mm_add_epi8 (
+          _mm_add_epi8 ( nibbles, _mm_set1_epi8 ( '0' ) ),
+          _mm_and_si128 ( is_letter, _mm_set1_epi8 ( letter_gap ) )
+      )
+  );
+}
+
+
+/**
+ * @brief Gives the 32 hexadecimal digits of sixteen bytes.
+ *
+ * @param[in] bytes The bytes.
+ * @param[in] letter_gap UPPER_LETTER_GAP or LOWER_LETTER_GAP.
+ * @param[out] low The digits of bytes 0 to 7.
+ * @param[out] high The digits of bytes 8 to 15.
+ */
+inline void bytes_to_digits (
+    __m128i bytes,
+    char letter_gap,
+    __m128i& low,
+    __m128i& high
+)
+{
+  const auto nibble_mask{ _mm_set1_epi8 ( 0x0F ) };
+  const auto high_nibbles{
+      nibbles_to_digits (
+          _mm_and_si128 ( _mm_srli_epi16 ( bytes, 4 ), nibble_mask ),
+          letter_gap
+      )
+  };
+  const auto low_nibbles{
+      nibbles_to_digits ( _mm_and_si128 ( bytes, nibble_mask ), letter_gap )
+  };
+  low = _mm_unpacklo_epi8 ( high_nibbles, low_nibbles );
+  high = _mm_unpackhi_epi8 ( high_nibbles, low_nibbles );
+}
+
+
+/**
+ * @brief Writes the 32 hexadecimal digits of sixteen bytes.
+ *
+ * @param[in] data Sixteen bytes.
+ * @param[in] letter_gap UPPER_LETTER_GAP or LOWER_LETTER_GAP.
+ * @param[out] out Where to write.
+ */
+inline void put_digits_16 (
+    const unsigned char* data,
+    char letter_gap,
+    char* out
+)
+{
+  __m128i low{};
+  __m128i high{};
+  bytes_to_digits (
+      _mm_loadu_si128 ( reinterpret_cast<const __m128i*>( data ) ),
+      letter_gap,
+      low,
+      high
+  );
+  _mm_storeu_si128 ( reinterpret_cast<__m128i*>( out ), low );
+  _mm_storeu_si128 ( reinterpret_cast<__m128i*>( out + 16 ), high );
+}
+
+
+/**
+ * @brief Writes the printable characters of sixteen bytes.
+ *
+ * Bytes from \c ' ' to \c '~' are kept and all others become \c '.' , as in
+ * PRINTABLES.
+ *
+ * @param[in] data Sixteen bytes.
+ * @param[out] out Where to write.
+ */
+inline void put_printables_16 ( const unsigned char* data, char* out )
+{
+  const auto bytes{
+      _mm_loadu_si128 ( reinterpret_cast<const __m128i*>( data ) )
+  };
+  // Signed compares also reject 0x80 and above, which are negative.
+  const auto keep{
+      _mm_and_si128 (
+          _mm_cmpgt_epi8 ( bytes, _mm_set1_epi8 ( ' ' - 1 ) ),
+          _mm_cmplt_epi8 ( bytes, _mm_set1_epi8 ( '~' + 1 ) )
+      )
+  };
+  _mm_storeu_si128 (
+      reinterpret_cast<__m128i*>( out ),
+      _mm_or_si128 (
+          _mm_and_si128 ( keep, bytes ),
+          _mm_andnot_si128 ( keep, _mm_set1_epi8 ( '.' ) )
+      )
+  );
+}
+#endif /* HEX_HAVE_SSE2 */
+
+
+#ifdef HEX_HAVE_SSSE3
+/**
+ * @brief Tells whether the processor running Hex has SSSE3.
+ *
+ * @returns Always \c true when the build enables SSSE3.
+ */
+inline bool detect_ssse3 ()
+{
+#if !defined( HEX_SSSE3_DISPATCH )
+  return ( true );
+#elif defined( _MSC_VER )
+  int registers[4]{};
+  __cpuid ( registers, 1 );
+  return ( ( registers[2] & ( 1 << 9 ) ) != 0 );
+#else
+  __builtin_cpu_init ();
+  return ( __builtin_cpu_supports ( "ssse3" ) != 0 );
+#endif /* HEX_SSSE3_DISPATCH */
+}
+
+
+//! Whether the SSSE3 kernels may be run.
+inline const bool HAS_SSSE3{ detect_ssse3 () };
+
+
+/**
+ * @brief Writes the digits of sixteen bytes laid out by a shuffle plan.
+ *
+ * @tparam CHUNKS The number of 16-character chunks in the layout.
+ * @param[in] plan The layout.
+ * @param[in] bytes The bytes.
+ * @param[in] letter_gap UPPER_LETTER_GAP or LOWER_LETTER_GAP.
+ * @param[out] out Where to write all the chunks.
+ */
+template<std::size_t CHUNKS>
+HEX_SSSE3_TARGET inline void put_shuffled (
+    const shuffle_plan_struct<CHUNKS>& plan,
+    __m128i bytes,
+    char letter_gap,
+    char* out
+)
+{
+  __m128i low{};
+  __m128i high{};
+  bytes_to_digits ( bytes, letter_gap, low, high );
+  for ( std::size_t c{ 0 }; c < CHUNKS; ++c )
+  {
+    const auto from_low{
+        _mm_load_si128 (
+            reinterpret_cast<const __m128i*>( plan.from_low[c].data () )
+        )
+    };
+    const auto from_high{
+        _mm_load_si128 (
+            reinterpret_cast<const __m128i*>( plan.from_high[c].data () )
+        )
+    };
+    const auto literals{
+        _mm_load_si128 (
+            reinterpret_cast<const __m128i*>( plan.literals[c].data () )
+        )
+    };
+    _mm_storeu_si128 (
+        reinterpret_cast<__m128i*>( out + 16 * c ),
+        _mm_or_si128 (
+            _mm_or_si128 (
+                _mm_shuffle_epi8 ( low, from_low ),
+                _mm_shuffle_epi8 ( high, from_high )
+            ),
+            literals
+        )
+    );
+  }
+}
+
+
+/**
+ * @brief Writes the base64 encoding of twelve bytes.
+ *
+ * The bytes are spread into sixteen 6-bit indices with a shuffle and two
+ * multiplies, then turned into characters by adding an offset looked up from
+ * the range each index falls in.
+ *
+ * @param[in] data Twelve bytes, with four more readable after them.
+ * @param[out] out Where to write the sixteen characters.
+ */
+HEX_SSSE3_TARGET inline void put_base64_12 (
+    const unsigned char* data,
+    char* out
+)
+{
+  const auto bytes{
+      _mm_shuffle_epi8 (
+          _mm_loadu_si128 ( reinterpret_cast<const __m128i*>( data ) ),
+          _mm_set_epi8 ( 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 )
+      )
+  };
+  const auto indices{
+      _mm_or_si128 (
+          _mm_mulhi_epu16 (
+              _mm_and_si128 ( bytes, _mm_set1_epi32 ( 0x0FC0FC00 ) ),
+              _mm_set1_epi32 ( 0x04000040 )
+          ),
+          _mm_mullo_epi16 (
+              _mm_and_si128 ( bytes, _mm_set1_epi32 ( 0x003F03F0 ) ),
+              _mm_set1_epi32 ( 0x01000010 )
+          )
+      )
+  };
+
+  // Ranges 0-25, 26-51, 52-61, 62, and 63 select different offsets.
+  auto range{ _mm_subs_epu8 ( indices, _mm_set1_epi8 ( 51 ) ) };
+  range = _mm_or_si128 (
+      range,
+      _mm_and_si128 (
+          _mm_cmpgt_epi8 ( _mm_set1_epi8 ( 26 ), indices ),
+          _mm_set1_epi8 ( 13 )
+      )
+  );
+  const auto offsets{
+      _mm_setr_epi8 (
+          'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+          '/' - 63, 'A', 0, 0
+      )
+  };
+  _mm_storeu_si128 (
+      reinterpret_cast<__m128i*>( out ),
+      _mm_add_epi8 ( _mm_shuffle_epi8 ( offsets, range ), indices )
+  );
+}
+#endif /* HEX_HAVE_SSSE3 */
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Writes the two hexadecimal digits of a byte.
+ *
+ * @param[in] pairs One of the hexadecimal pair tables.
+ * @param[in] byte_value The byte to write.
+ * @param[out] out Where to write.
+ * @returns The position after the written digits.
+ */
+inline char* put_hex_byte (
+    const std::array<char, 512>& pairs,
+    unsigned byte_value,
+    char* out
+)
+{
+  std::memcpy ( out, pairs.data () + 2 * ( byte_value & 0xFF ), 2 );
+  return ( out + 2 );
+}
+
+
+/**
+ * @brief Writes the base64 encoding of three bytes.
+ *
+ * @param[in] data Three bytes.
+ * @param[out] out Where to write the four characters.
+ */
+inline void put_base64_3 ( const unsigned char* data, char* out )
+{
+  const auto bits{
+      ( static_cast<unsigned>( data[0] ) << 16 )
+      | ( static_cast<unsigned>( data[1] ) << 8 )
+      | data[2]
+  };
+  std::memcpy ( out, BASE64_PAIRS.data () + 2 * ( bits >> 12 ), 2 );
+  std::memcpy ( out + 2, BASE64_PAIRS.data () + 2 * ( bits & 0xFFF ), 2 );
+}
+
+
+/**
+ * @brief Writes an offset as upper case hexadecimal digits.
+ *
+ * At least OFFSET_DIGITS digits are written, and more only when the offset
+ * needs them.
+ *
+ * @param[in] offset The offset to write.
+ * @param[out] out Where to write.
+ * @returns The position after the written digits.
+ */
+inline char* put_offset ( std::uint64_t offset, char* out )
+{
+  if ( !( offset >> ( 4 * OFFSET_DIGITS ) ) )
+  {
+    for ( auto i{ 0 }; i < OFFSET_DIGITS / 2; ++i )
+    {
+      put_hex_byte (
+          UPPER_HEX_PAIRS,
+          static_cast<unsigned>( offset >> ( 4 * OFFSET_DIGITS - 8 - 8 * i ) ),
+          out + 2 * i
+      );
+    }
+    return ( out + OFFSET_DIGITS );
+  }
+
+  auto digits{ OFFSET_DIGITS };
+  while ( digits < MAX_OFFSET_DIGITS && ( offset >> ( 4 * digits ) ) )
+  {
+    ++digits;
+  }
+  for ( auto i{ digits - 1 }; i >= 0; --i )
+  {
+    out[i] = HEX_CHARS[offset & 0xF];
+    offset >>= 4;
+  }
+  return ( out + digits );
+}
+
+
+#ifdef HEX_HAVE_SSE2
+/**
+ * @brief Writes an offset as upper case hexadecimal digits with SSE2.
+ *
+ * Offsets needing more than OFFSET_DIGITS digits go to put_offset().
+ *
+ * @param[in] offset The offset to write.
+ * @param[out] out Where to write, with room for 16 characters.
+ * @returns The position after the written digits.
+ */
+inline char* put_offset_8 ( std::uint64_t offset, char* out )
+{
+  if ( offset >> ( 4 * OFFSET_DIGITS ) )
+  {
+    return ( put_offset ( offset, out ) );
+  }
+
+  // The most significant byte goes first so its digits come first.
+  const auto value{ static_cast<std::uint32_t>( offset ) };
+  const auto big_endian{
+      ( value >> 24 ) | ( ( value >> 8 ) & 0xFF00 )
+      | ( ( value << 8 ) & 0xFF0000 ) | ( value << 24 )
+  };
+  __m128i low{};
+  __m128i high{};
+  bytes_to_digits (
+      _mm_cvtsi32_si128 ( static_cast<int>( big_endian ) ),
+      UPPER_LETTER_GAP,
+      low,
+      high
+  );
+  _mm_storel_epi64 ( reinterpret_cast<__m128i*>( out ), low );
+  return ( out + OFFSET_DIGITS );
+}
+#endif /* HEX_HAVE_SSE2 */
+
+
+/**
+ * @brief Sums bytes for record checksums.
+ *
+ * @param[in] data The bytes.
+ * @param[in] size The number of bytes.
+ * @returns The sum of the bytes.
+ */
+inline unsigned sum_bytes ( const unsigned char* data, std::size_t size )
+{
+  unsigned sum{};
+#ifdef HEX_HAVE_SSE2
+  for ( ; size >= 16; size -= 16, data += 16 )
+  {
+    const auto sums{
+        _mm_sad_epu8 (
+            _mm_loadu_si128 ( reinterpret_cast<const __m128i*>( data ) ),
+            _mm_setzero_si128 ()
+        )
+    };
+    sum += static_cast<unsigned>( _mm_cvtsi128_si32 ( sums ) )
+        + static_cast<unsigned>(
+            _mm_cvtsi128_si32 ( _mm_srli_si128 ( sums, 8 ) )
+        );
+  }
+#endif /* HEX_HAVE_SSE2 */
+  for ( ; size; --size, ++data )
+  {
+    sum += *data;
+  }
+  return ( sum );
+}
+
+
+/**
+ * @brief Writes a row of the canonical format.
+ *
+ * Unlike the other kernels, rows are written exactly, with nothing past the
+ * newline.
+ *
+ * @tparam IS_FULL Whether the row has all CANONICAL_ROW_BYTES bytes.
+ * @param[in] data The bytes of the row.
+ * @param[in] size The number of bytes, below CANONICAL_ROW_BYTES for a short
+ * last row.
+ * @param[in] offset The offset of the row.
+ * @param[out] out Where to write.
+ * @returns The position after the row.
+ */
+template<bool IS_FULL>
+inline char* put_canonical_row (
+    const unsigned char* data,
+    std::size_t size,
+    std::uint64_t offset,
+    char* out
+)
+{
+  out = put_offset ( offset, out );
+  *out++ = ' ';
+  *out++ = ' ';
+
+  for ( std::size_t i{ 0 }; i < CANONICAL_ROW_BYTES; ++i )
+  {
+    if ( IS_FULL || i < size )
+    {
+      put_hex_byte ( UPPER_HEX_PAIRS, data[i], out );
+    }
+    else
+    {
+      out[0] = ' ';
+      out[1] = ' ';
+    }
+    out[2] = ' ';
+    out += 3;
+  }
+  *out++ = ' ';
+
+  for ( std::size_t i{ 0 }; i < CANONICAL_ROW_BYTES; ++i )
+  {
+    *out++ = ( IS_FULL || i < size ) ? PRINTABLES[data[i]] : ' ';
+  }
+  *out++ = '\n';
+  return ( out );
+}
+
+
+#ifdef HEX_HAVE_SSSE3
+/**
+ * @brief Writes full canonical rows with SSSE3.
+ *
+ * @param[in] data The bytes.
+ * @param[in] size The number of bytes, a multiple of CANONICAL_ROW_BYTES.
+ * @param[in] offset The offset of the first byte.
+ * @param[out] out Where to write.
+ * @returns The position after the rows.
+ */
+HEX_SSSE3_TARGET inline char* put_canonical_rows_ssse3 (
+    const unsigned char* data,
+    std::size_t size,
+    std::uint64_t offset,
+    char* out
+)
+{
+  for ( ; size; size -= CANONICAL_ROW_BYTES )
+  {
+    out = put_offset_8 ( offset, out );
+    *out++ = ' ';
+    *out++ = ' ';
+    put_shuffled (
+        CANONICAL_PLAN,
+        _mm_loadu_si128 ( reinterpret_cast<const __m128i*>( data ) ),
+        UPPER_LETTER_GAP,
+        out
+    );
+    out += 3 * CANONICAL_ROW_BYTES;
+    *out++ = ' ';
+    put_printables_16 ( data, out );
+    out += CANONICAL_ROW_BYTES;
+    *out++ = '\n';
+    data += CANONICAL_ROW_BYTES;
+    offset += CANONICAL_ROW_BYTES;
+  }
+  return ( out );
+}
+#endif /* HEX_HAVE_SSSE3 */
+
+
+/**
+ * @brief Writes the canonical rows of some bytes, the last of which may be
+ * short.
+ *
+ * @param[in] data The bytes.
+ * @param[in] size The number of bytes.
+ * @param[in] offset The offset of the first byte.
+ * @param[out] out Where to write.
+ * @returns The position after the rows.
+ */
+inline char* put_canonical_rows (
+    const unsigned char* data,
+    std::size_t size,
+    std::uint64_t offset,
+    char* out
+)
+{
+#ifdef HEX_HAVE_SSSE3
+  if ( HAS_SSSE3 )
+  {
+    const auto full{ size - size % CANONICAL_ROW_BYTES };
+    out = put_canonical_rows_ssse3 ( data, full, offset, out );
+    data += full;
+    offset += full;
+    size -= full;
+  }
+#endif /* HEX_HAVE_SSSE3 */
+  for ( ; size >= CANONICAL_ROW_BYTES; size -= CANONICAL_ROW_BYTES )
+  {
+    out = put_canonical_row<true> ( data, CANONICAL_ROW_BYTES, offset, out );
+    data += CANONICAL_ROW_BYTES;
+    offset += CANONICAL_ROW_BYTES;
+  }
+  if ( size )
+  {
+    out = put_canonical_row<false> ( data, size, offset, out );
+  }
+  return ( out );
+}
+
+
+#ifdef HEX_HAVE_SSSE3
+/**
+ * @brief Writes full lines of the C array format with SSSE3.
+ *
+ * @param[in] data The bytes.
+ * @param[in] lines The number of lines of C_ARRAY_LINE_BYTES bytes.
+ * @param[out] out Where to write.
+ * @returns The position after the lines.
+ */
+HEX_SSSE3_TARGET inline char* put_c_array_lines_ssse3 (
+    const unsigned char* data,
+    std::size_t lines,
+    char* out
+)
+{
+  for ( ; lines; --lines )
+  {
+    // Twelve bytes are loaded as eight and four so as not to read past the
+    // end of the input.
+    std::uint32_t last_four{};
+    std::memcpy ( &last_four, data + 8, 4 );
+    *out++ = ' ';
+    put_shuffled (
+        C_ARRAY_PLAN,
+        _mm_unpacklo_epi64 (
+            _mm_loadl_epi64 ( reinterpret_cast<const __m128i*>( data ) ),
+            _mm_cvtsi32_si128 ( static_cast<int>( last_four ) )
+        ),
+        LOWER_LETTER_GAP,
+        out
+    );
+    out += 6 * C_ARRAY_LINE_BYTES;
+    *out++ = '\n';
+    data += C_ARRAY_LINE_BYTES;
+  }
+  return ( out );
+}
+
+
+/**
+ * @brief Writes full lines of base64 with SSSE3.
+ *
+ * @param[in] data The bytes.
+ * @param[in] lines The number of lines of BASE64_LINE_BYTES bytes.
+ * @param[out] out Where to write.
+ * @returns The position after the lines.
+ */
+HEX_SSSE3_TARGET inline char* put_base64_lines_ssse3 (
+    const unsigned char* data,
+    std::size_t lines,
+    char* out
+)
+{
+  for ( ; lines; --lines )
+  {
+    auto triples{ BASE64_LINE_BYTES / 3 };
+    // Each group reads four bytes past its twelve, which stay in the line.
+    for ( ; triples >= 6; triples -= 4 )
+    {
+      put_base64_12 ( data, out );
+      data += 12;
+      out += 16;
+    }
+    for ( ; triples; --triples )
+    {
+      put_base64_3 ( data, out );
+      data += 3;
+      out += 4;
+    }
+    *out++ = '\n';
+  }
+  return ( out );
+}
+#endif /* HEX_HAVE_SSSE3 */
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CLASSES
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A growable character buffer that is reused between blocks.
+ *
+ * Unlike \c std::string , growing it does not fill the new space, so kernels
+ * can be handed room for a whole block of lines for free.
+ */
+class TextBuffer final
+{
+public:
+  //! The characters in the buffer.
+  const char* data () const
+  {
+    return ( data_.get () );
+  }
+
+  //! The number of characters in the buffer.
+  std::size_t size () const
+  {
+    return ( size_ );
+  }
+
+  //! Empties the buffer, keeping its storage.
+  void clear ()
+  {
+    size_ = 0;
+  }
+
+  /**
+   * @brief Makes room after the current characters.
+   *
+   * @param[in] room The number of characters that may be written.
+   * @returns Where to write, to be passed on to commit().
+   */
+  char* reserve ( std::size_t room )
+  {
+    if ( size_ + room > capacity_ )
+    {
+      const auto capacity{ std::max ( 2 * capacity_, size_ + room ) };
+      std::unique_ptr<char[]> data{ new char[capacity] };
+      if ( size_ )
+      {
+        std::memcpy ( data.get (), data_.get (), size_ );
+      }
+      data_ = std::move ( data );
+      capacity_ = capacity;
+    }
+    return ( data_.get () + size_ );
+  }
+
+  /**
+   * @brief Keeps the characters written after reserve().
+   *
+   * @param[in] end The position after the last character written.
+   */
+  void commit ( const char* end )
+  {
+    size_ = static_cast<std::size_t>( end - data_.get () );
+  }
+
+  //! Appends some characters.
+  void append ( std::string_view text )
+  {
+    auto* const out{ reserve ( text.size () ) };
+    std::memcpy ( out, text.data (), text.size () );
+    commit ( out + text.size () );
+  }
+
+private:
+  std::unique_ptr<char[]> data_{};
+  std::size_t size_{};
+  std::size_t capacity_{};
+};
+
+
+/**
+ * @brief The base class of every output format.
+ *
+ * Input arrives in blocks of any size. The base class cuts it into lines of
+ * a fixed number of bytes, carrying a partial line over to the next block, so
+ * each format only has to encode whole lines plus a final partial line.
+ * Encoded text is appended to a caller-owned buffer that is reused between
+ * blocks, keeping the hot path free of per-line allocation and I/O.
+ */
+class Encoder
+{
+public:
+  virtual ~Encoder () = default;
+
+  //! The extension of files written with this format.
+  virtual const char* extension () const = 0;
+
+  /**
+   * @brief Appends any text that comes before the data.
+   *
+   * @param[in] name The name of the input being encoded.
+   * @param[in,out] out The text to append to.
+   */
+  virtual void begin ( const std::string& name, TextBuffer& out )
+  {
+    static_cast<void>( name );
+    static_cast<void>( out );
+  }
+
+  /**
+   * @brief Appends the encoding of the next block of input.
+   *
+   * @param[in] data The input bytes.
+   * @param[in] size The number of input bytes.
+   * @param[in,out] out The text to append to.
+   */
+  void encode ( const unsigned char* data, std::size_t size, TextBuffer& out )
+  {
+    if ( carry_size_ )
+    {
+      const auto taken{ std::min ( size, line_bytes_ - carry_size_ ) };
+      std::memcpy ( carry_.data () + carry_size_, data, taken );
+      carry_size_ += taken;
+      data += taken;
+      size -= taken;
+      if ( carry_size_ < line_bytes_ )
+      {
+        return;
+      }
+      append_lines ( carry_.data (), line_bytes_, out );
+      carry_size_ = 0;
+    }
+
+    const auto whole{ size - size % line_bytes_ };
+    if ( whole )
+    {
+      append_lines ( data, whole, out );
+    }
+
+    carry_size_ = size - whole;
+    if ( carry_size_ )
+    {
+      std::memcpy ( carry_.data (), data + whole, carry_size_ );
+    }
+  }
+
+  /**
+   * @brief Appends any partial last line and the text after the data.
+   *
+   * @param[in,out] out The text to append to.
+   */
+  void finish ( TextBuffer& out )
+  {
+    if ( carry_size_ )
+    {
+      append_lines ( carry_.data (), carry_size_, out );
+      carry_size_ = 0;
+    }
+    end ( offset_, out );
+  }
+
+  //! Number of input bytes in a line of this format.
+  std::size_t line_bytes () const
+  {
+    return ( line_bytes_ );
+  }
+
+  /**
+   * @brief Gives the most characters a whole input can encode to.
+   *
+   * @param[in] size The number of input bytes.
+   * @param[in] name The name of the input.
+   * @returns The bound, for reserving the text of a whole dump at once.
+   */
+  std::uint64_t max_chars ( std::uint64_t size, const std::string& name ) const
+  {
+    return (
+        ( size + line_bytes_ - 1 ) / line_bytes_ * max_line_chars_
+        + MAX_FRAMING_CHARS + MAX_CHARS_PER_NAME_CHAR * name.size ()
+    );
+  }
+
+  /**
+   * @brief Starts encoding part way into an input.
+   *
+   * Offsets written by the format count from \c offset , so a slice that
+   * starts on a line boundary encodes to exactly the lines a whole dump has
+   * for it.
+   *
+   * @param[in] offset The offset of the next byte encoded.
+   */
+  void start_at ( std::uint64_t offset )
+  {
+    carry_size_ = 0;
+    offset_ = offset;
+  }
+
+protected:
+  /**
+   * @brief Sets the line geometry of a format.
+   *
+   * @param[in] line_bytes Number of input bytes in a line.
+   * @param[in] max_line_chars Most characters a line can encode to.
+   */
+  Encoder ( std::size_t line_bytes, std::size_t max_line_chars )
+    : line_bytes_{ line_bytes },
+      max_line_chars_{ max_line_chars },
+      carry_( line_bytes )
+  {
+  }
+
+  /**
+   * @brief Encodes whole lines, or the final partial line, of input.
+   *
+   * Kernels may write up to KERNEL_SLACK characters past the end of the text
+   * they return.
+   *
+   * @param[in] data The input bytes.
+   * @param[in] size A multiple of the line size, unless this is the last
+   * line of input.
+   * @param[in] offset The offset of \c data in the input.
+   * @param[out] out Where to write, with room for every line.
+   * @returns The position after the written text.
+   */
+  virtual char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) = 0;
+
+  /**
+   * @brief Appends the text that comes after the data.
+   *
+   * @param[in] total The number of input bytes encoded.
+   * @param[in,out] out The text to append to.
+   */
+  virtual void end ( std::uint64_t total, TextBuffer& out )
+  {
+    static_cast<void>( total );
+    static_cast<void>( out );
+  }
+
+private:
+  void append_lines (
+      const unsigned char* data,
+      std::size_t size,
+      TextBuffer& out
+  )
+  {
+    const auto lines{ ( size + line_bytes_ - 1 ) / line_bytes_ };
+    out.commit (
+        encode_lines (
+            data,
+            size,
+            offset_,
+            out.reserve ( lines * max_line_chars_ + KERNEL_SLACK )
+        )
+    );
+    offset_ += size;
+  }
+
+  std::size_t line_bytes_;
+  std::size_t max_line_chars_;
+  std::vector<unsigned char> carry_;
+  std::size_t carry_size_{};
+  std::uint64_t offset_{};
+};
+
+
+/**
+ * @brief Offset, sixteen hexadecimal bytes, and their printable characters.
+ *
+ * This is the original Hex output. A short last row is padded with spaces,
+ * and input ending on a row boundary is closed by a blank row giving the
+ * final offset.
+ */
+class CanonicalEncoder final : public Encoder
+{
+public:
+  CanonicalEncoder ()
+    : Encoder{ CANONICAL_ROW_BYTES, MAX_CANONICAL_ROW_CHARS }
+  {
+  }
+
+  const char* extension () const override
+  {
+    return ( ".hex" );
+  }
+
+protected:
+  char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) override
+  {
+    return ( put_canonical_rows ( data, size, offset, out ) );
+  }
+
+  void end ( std::uint64_t total, TextBuffer& out ) override
+  {
+    if ( total % CANONICAL_ROW_BYTES == 0 )
+    {
+      auto* const row{ out.reserve ( MAX_CANONICAL_ROW_CHARS ) };
+      out.commit ( put_canonical_row<false> ( nullptr, 0, total, row ) );
+    }
+  }
+};
+
+
+//! Continuous lower case hexadecimal, as for 'xxd -p'.
+class PlainEncoder final : public Encoder
+{
+public:
+  PlainEncoder ()
+    : Encoder{ PLAIN_LINE_BYTES, 2 * PLAIN_LINE_BYTES + 1 }
+  {
+  }
+
+  const char* extension () const override
+  {
+    return ( ".hex" );
+  }
+
+protected:
+  char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) override
+  {
+    static_cast<void>( offset );
+#ifdef HEX_HAVE_SSE2
+    // The second half of a line overlaps the first by two bytes.
+    for ( ; size >= PLAIN_LINE_BYTES; size -= PLAIN_LINE_BYTES )
+    {
+      put_digits_16 ( data, LOWER_LETTER_GAP, out );
+      put_digits_16 (
+          data + PLAIN_LINE_BYTES - 16,
+          LOWER_LETTER_GAP,
+          out + 2 * ( PLAIN_LINE_BYTES - 16 )
+      );
+      out += 2 * PLAIN_LINE_BYTES;
+      *out++ = '\n';
+      data += PLAIN_LINE_BYTES;
+    }
+#endif /* HEX_HAVE_SSE2 */
+    while ( size )
+    {
+      const auto line{ std::min ( size, PLAIN_LINE_BYTES ) };
+      for ( std::size_t i{ 0 }; i < line; ++i )
+      {
+        out = put_hex_byte ( LOWER_HEX_PAIRS, data[i], out );
+      }
+      *out++ = '\n';
+      data += line;
+      size -= line;
+    }
+    return ( out );
+  }
+};
+
+
+/**
+ * @brief A C++ header defining the input as a \c constexpr byte array.
+ *
+ * The array and its size are named after the input file, with each run of
+ * characters that cannot appear in an identifier replaced by one \c _ , or
+ * dropped at either end, and C_ARRAY_NAME_PREFIX put before a name not
+ * starting with a letter. Names never start with \c _ or hold \c __ , as
+ * those are reserved.
+ */
+class CArrayEncoder final : public Encoder
+{
+public:
+  CArrayEncoder ()
+    : Encoder{ C_ARRAY_LINE_BYTES, 1 + 6 * C_ARRAY_LINE_BYTES + 1 }
+  {
+  }
+
+  const char* extension () const override
+  {
+    return ( ".h" );
+  }
+
+  void begin ( const std::string& name, TextBuffer& out ) override
+  {
+    identifier_.clear ();
+    for ( const auto c : std::filesystem::path{ name }.filename ().string () )
+    {
+      if ( std::isalnum ( static_cast<unsigned char>( c ) ) )
+      {
+        identifier_ += c;
+      }
+      else if ( !identifier_.empty () && identifier_.back () != '_' )
+      {
+        identifier_ += '_';
+      }
+    }
+    if ( !identifier_.empty () && identifier_.back () == '_' )
+    {
+      identifier_.pop_back ();
+    }
+    if ( identifier_.empty () )
+    {
+      identifier_ = C_ARRAY_NAME_PREFIX;
+    }
+    else if ( !std::isalpha ( static_cast<unsigned char>( identifier_[0] ) ) )
+    {
+      identifier_ = std::string{ C_ARRAY_NAME_PREFIX } + "_" + identifier_;
+    }
+
+    out.append (
+        "// Generated by Hex from '" + name + "'.\n"
+        "#pragma once\n"
+        "\n"
+        "#include <cstddef>\n"
+        "\n"
+        "inline constexpr unsigned char " + identifier_ + "[]{\n"
+    );
+  }
+
+protected:
+  char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) override
+  {
+    static_cast<void>( offset );
+#ifdef HEX_HAVE_SSSE3
+    if ( HAS_SSSE3 )
+    {
+      const auto lines{ size / C_ARRAY_LINE_BYTES };
+      out = put_c_array_lines_ssse3 ( data, lines, out );
+      data += lines * C_ARRAY_LINE_BYTES;
+      size -= lines * C_ARRAY_LINE_BYTES;
+    }
+#endif /* HEX_HAVE_SSSE3 */
+    while ( size )
+    {
+      const auto line{ std::min ( size, C_ARRAY_LINE_BYTES ) };
+      *out++ = ' ';
+      for ( std::size_t i{ 0 }; i < line; ++i )
+      {
+        *out++ = ' ';
+        *out++ = '0';
+        *out++ = 'x';
+        out = put_hex_byte ( LOWER_HEX_PAIRS, data[i], out );
+        *out++ = ',';
+      }
+      *out++ = '\n';
+      data += line;
+      size -= line;
+    }
+    return ( out );
+  }
+
+  void end ( std::uint64_t total, TextBuffer& out ) override
+  {
+    if ( !total )
+    {
+      // A zero-sized array is ill-formed, so hold one unused byte.
+      out.append ( "  0x00,\n" );
+    }
+    out.append (
+        "};\n"
+        "inline constexpr std::size_t " + identifier_ + "_size{ "
+        + std::to_string ( total ) + " };\n"
+    );
+  }
+
+private:
+  std::string identifier_{};
+};
+
+
+/**
+ * @brief Intel HEX records starting at address zero.
+ *
+ * Extended linear address records are written when the data passes a 64 KiB
+ * boundary, so up to 4 GiB of input can be encoded.
+ */
+class IntelHexEncoder final : public Encoder
+{
+public:
+  IntelHexEncoder ()
+    : Encoder{ RECORD_BYTES, 2 * MAX_RECORD_CHARS }
+  {
+  }
+
+  const char* extension () const override
+  {
+    return ( ".hex" );
+  }
+
+protected:
+  char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) override
+  {
+    if ( offset + size > RECORD_ADDRESS_LIMIT )
+    {
+      throw std::out_of_range{ "Intel HEX cannot address beyond 4 GiB !" };
+    }
+
+    while ( size )
+    {
+      const auto line{ std::min ( size, RECORD_BYTES ) };
+      const auto upper{ static_cast<unsigned>( offset >> 16 ) };
+      if ( upper != upper_address_ )
+      {
+        const unsigned char address[]{
+            static_cast<unsigned char>( upper >> 8 ),
+            static_cast<unsigned char>( upper )
+        };
+        out = put_record ( EXTENDED_LINEAR_ADDRESS, 0, address, 2, out );
+        upper_address_ = upper;
+      }
+      out = put_record (
+          DATA,
+          static_cast<unsigned>( offset & 0xFFFF ),
+          data,
+          line,
+          out
+      );
+      data += line;
+      offset += line;
+      size -= line;
+    }
+    return ( out );
+  }
+
+  void end ( std::uint64_t total, TextBuffer& out ) override
+  {
+    static_cast<void>( total );
+    out.append ( ":00000001FF\n" );
+  }
+
+private:
+  static constexpr unsigned DATA{ 0x00 };
+  static constexpr unsigned EXTENDED_LINEAR_ADDRESS{ 0x04 };
+  static constexpr std::size_t MAX_RECORD_CHARS{ 1 + 8 + 2 * RECORD_BYTES + 3 };
+
+  static char* put_record (
+      unsigned type,
+      unsigned address,
+      const unsigned char* data,
+      std::size_t size,
+      char* out
+  )
+  {
+    const auto sum{
+        static_cast<unsigned>( size ) + ( address >> 8 ) + address + type
+        + sum_bytes ( data, size )
+    };
+    *out++ = ':';
+    out = put_hex_byte ( UPPER_HEX_PAIRS, static_cast<unsigned>( size ), out );
+    out = put_hex_byte ( UPPER_HEX_PAIRS, address >> 8, out );
+    out = put_hex_byte ( UPPER_HEX_PAIRS, address, out );
+    out = put_hex_byte ( UPPER_HEX_PAIRS, type, out );
+    out = put_data ( data, size, out );
+    out = put_hex_byte ( UPPER_HEX_PAIRS, 0x100 - ( sum & 0xFF ), out );
+    *out++ = '\n';
+    return ( out );
+  }
+
+  static char* put_data (
+      const unsigned char* data,
+      std::size_t size,
+      char* out
+  )
+  {
+#ifdef HEX_HAVE_SSE2
+    if ( size == RECORD_BYTES )
+    {
+      put_digits_16 ( data, UPPER_LETTER_GAP, out );
+      return ( out + 2 * RECORD_BYTES );
+    }
+#endif /* HEX_HAVE_SSE2 */
+    for ( std::size_t i{ 0 }; i < size; ++i )
+    {
+      out = put_hex_byte ( UPPER_HEX_PAIRS, data[i], out );
+    }
+    return ( out );
+  }
+
+  unsigned upper_address_{};
+};
+
+
+/**
+ * @brief Motorola S-records with 32-bit addresses starting at zero.
+ *
+ * An S0 header carries the input name, S3 records carry the data, an S5 or
+ * S6 record gives the number of data records, and an S7 record ends the
+ * file.
+ */
+class SRecordEncoder final : public Encoder
+{
+public:
+  SRecordEncoder ()
+    : Encoder{ RECORD_BYTES, MAX_RECORD_CHARS }
+  {
+  }
+
+  const char* extension () const override
+  {
+    return ( ".srec" );
+  }
+
+  void begin ( const std::string& name, TextBuffer& out ) override
+  {
+    const auto header_size{ std::min ( name.size (), MAX_HEADER_BYTES ) };
+    auto* const record{ out.reserve ( 4 + 2 * ( 3 + header_size ) + 1 ) };
+    out.commit (
+        put_record (
+            '0',
+            0,
+            2,
+            reinterpret_cast<const unsigned char*>( name.data () ),
+            header_size,
+            record
+        )
+    );
+  }
+
+protected:
+  char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) override
+  {
+    if ( offset + size > RECORD_ADDRESS_LIMIT )
+    {
+      throw std::out_of_range{ "S-records cannot address beyond 4 GiB !" };
+    }
+
+    while ( size )
+    {
+      const auto line{ std::min ( size, RECORD_BYTES ) };
+      out = put_record (
+          '3',
+          static_cast<std::uint32_t>( offset ),
+          4,
+          data,
+          line,
+          out
+      );
+      ++records_;
+      data += line;
+      offset += line;
+      size -= line;
+    }
+    return ( out );
+  }
+
+  void end ( std::uint64_t total, TextBuffer& out ) override
+  {
+    static_cast<void>( total );
+    auto* record{ out.reserve ( 2 * MAX_RECORD_CHARS ) };
+    if ( records_ <= 0xFFFF )
+    {
+      record = put_record (
+          '5',
+          static_cast<std::uint32_t>( records_ ),
+          2,
+          nullptr,
+          0,
+          record
+      );
+    }
+    else if ( records_ <= 0xFFFFFF )
+    {
+      record = put_record (
+          '6',
+          static_cast<std::uint32_t>( records_ ),
+          3,
+          nullptr,
+          0,
+          record
+      );
+    }
+    out.commit ( put_record ( '7', 0, 4, nullptr, 0, record ) );
+  }
+
+private:
+  static constexpr std::size_t MAX_HEADER_BYTES{ 64 };
+  static constexpr std::size_t MAX_RECORD_CHARS{
+      4 + 2 * ( 4 + RECORD_BYTES ) + 2 + 1
+  };
+
+  static char* put_record (
+      char type,
+      std::uint32_t address,
+      unsigned address_bytes,
+      const unsigned char* data,
+      std::size_t size,
+      char* out
+  )
+  {
+    const auto count{ static_cast<unsigned>( address_bytes + size + 1 ) };
+    auto sum{ count + sum_bytes ( data, size ) };
+    *out++ = 'S';
+    *out++ = type;
+    out = put_hex_byte ( UPPER_HEX_PAIRS, count, out );
+    for ( auto i{ address_bytes }; i > 0; --i )
+    {
+      const auto address_byte{ ( address >> ( 8 * ( i - 1 ) ) ) & 0xFF };
+      sum += address_byte;
+      out = put_hex_byte ( UPPER_HEX_PAIRS, address_byte, out );
+    }
+#ifdef HEX_HAVE_SSE2
+    if ( size == RECORD_BYTES )
+    {
+      put_digits_16 ( data, UPPER_LETTER_GAP, out );
+      out += 2 * RECORD_BYTES;
+      size = 0;
+    }
+#endif /* HEX_HAVE_SSE2 */
+    for ( std::size_t i{ 0 }; i < size; ++i )
+    {
+      out = put_hex_byte ( UPPER_HEX_PAIRS, data[i], out );
+    }
+    out = put_hex_byte ( UPPER_HEX_PAIRS, ~sum & 0xFF, out );
+    *out++ = '\n';
+    return ( out );
+  }
+
+  std::uint64_t records_{};
+};
+
+
+//! Base64 with 76 character lines, as for the 'base64' utility.
+class Base64Encoder final : public Encoder
+{
+public:
+  Base64Encoder ()
+    : Encoder{ BASE64_LINE_BYTES, 4 * BASE64_LINE_BYTES / 3 + 1 }
+  {
+  }
+
+  const char* extension () const override
+  {
+    return ( ".b64" );
+  }
+
+protected:
+  char* encode_lines (
+      const unsigned char* data,
+      std::size_t size,
+      std::uint64_t offset,
+      char* out
+  ) override
+  {
+    static_cast<void>( offset );
+#ifdef HEX_HAVE_SSSE3
+    if ( HAS_SSSE3 )
+    {
+      const auto lines{ size / BASE64_LINE_BYTES };
+      out = put_base64_lines_ssse3 ( data, lines, out );
+      data += lines * BASE64_LINE_BYTES;
+      size -= lines * BASE64_LINE_BYTES;
+    }
+#endif /* HEX_HAVE_SSSE3 */
+    while ( size )
+    {
+      const auto line{ std::min ( size, BASE64_LINE_BYTES ) };
+      const auto triples{ line / 3 };
+      for ( std::size_t i{ 0 }; i < triples; ++i )
+      {
+        put_base64_3 ( data, out );
+        data += 3;
+        out += 4;
+      }
+
+      const auto remaining{ line % 3 };
+      if ( remaining )
+      {
+        const auto bits{
+            ( static_cast<unsigned>( data[0] ) << 16 )
+            | ( remaining == 2 ? static_cast<unsigned>( data[1] ) << 8 : 0U )
+        };
+        std::memcpy ( out, BASE64_PAIRS.data () + 2 * ( bits >> 12 ), 2 );
+        out[2] = remaining == 2 ? BASE64_CHARS[( bits >> 6 ) & 0x3F] : '=';
+        out[3] = '=';
+        data += remaining;
+        out += 4;
+      }
+      *out++ = '\n';
+      size -= line;
+    }
+    return ( out );
+  }
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FACTORY
+///////////////////////////////////////////////////////////////////////////////
+
+//! The names of every output format, the first being the default.
+const char* const FORMAT_NAMES[]{
+    "canonical", "plain", "c", "ihex", "srec", "base64"
+};
+
+
+/**
+ * @brief Creates an encoder from the name of its format.
+ *
+ * @param[in] format One of FORMAT_NAMES.
+ * @returns A new encoder, or \c nullptr if the format is not known.
+ */
+inline std::unique_ptr<Encoder> make_encoder ( const std::string& format )
+{
+  if ( format == "canonical" )
+  {
+    return ( std::make_unique<CanonicalEncoder> () );
+  }
+  if ( format == "plain" )
+  {
+    return ( std::make_unique<PlainEncoder> () );
+  }
+  if ( format == "c" )
+  {
+    return ( std::make_unique<CArrayEncoder> () );
+  }
+  if ( format == "ihex" )
+  {
+    return ( std::make_unique<IntelHexEncoder> () );
+  }
+  if ( format == "srec" )
+  {
+    return ( std::make_unique<SRecordEncoder> () );
+  }
+  if ( format == "base64" )
+  {
+    return ( std::make_unique<Base64Encoder> () );
+  }
+  return ( nullptr );
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Output encoders sharing Hex's input pipeline.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -18,96 +18,37 @@
 
 #pragma comment(lib, "boost_program_options-vc142-mt-x32-1_77.lib")
 
+// LOCAL //////////////////////////////////////////////////////////////////////
+
+#include "Encoders.h"
+#include "HexLib.h"
+#include "Server.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// USING
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace HexLib;
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // CONSTANTS
 ///////////////////////////////////////////////////////////////////////////////
 
-const char *HEX_VALUES[]{
-    "00", "01", "02", "03", "04", "05", "06", "07",
-    "08", "09", "0A", "0B", "0C", "0D", "0E", "0F",
-    "10", "11", "12", "13", "14", "15", "16", "17",
-    "18", "19", "1A", "1B", "1C", "1D", "1E", "1F",
-    "20", "21", "22", "23", "24", "25", "26", "27",
-    "28", "29", "2A", "2B", "2C", "2D", "2E", "2F",
-    "30", "31", "32", "33", "34", "35", "36", "37",
-    "38", "39", "3A", "3B", "3C", "3D", "3E", "3F",
-    "40", "41", "42", "43", "44", "45", "46", "47",
-    "48", "49", "4A", "4B", "4C", "4D", "4E", "4F",
-    "50", "51", "52", "53", "54", "55", "56", "57",
-    "58", "59", "5A", "5B", "5C", "5D", "5E", "5F",
-    "60", "61", "62", "63", "64", "65", "66", "67",
-    "68", "69", "6A", "6B", "6C", "6D", "6E", "6F",
-    "70", "71", "72", "73", "74", "75", "76", "77",
-    "78", "79", "7A", "7B", "7C", "7D", "7E", "7F",
-    "80", "81", "82", "83", "84", "85", "86", "87",
-    "88", "89", "8A", "8B", "8C", "8D", "8E", "8F",
-    "90", "91", "92", "93", "94", "95", "96", "97",
-    "98", "99", "9A", "9B", "9C", "9D", "9E", "9F",
-    "A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7",
-    "A8", "A9", "AA", "AB", "AC", "AD", "AE", "AF",
-    "B0", "B1", "B2", "B3", "B4", "B5", "B6", "B7",
-    "B8", "B9", "BA", "BB", "BC", "BD", "BE", "BF",
-    "C0", "C1", "C2", "C3", "C4", "C5", "C6", "C7",
-    "C8", "C9", "CA", "CB", "CC", "CD", "CE", "CF",
-    "D0", "D1", "D2", "D3", "D4", "D5", "D6", "D7",
-    "D8", "D9", "DA", "DB", "DC", "DD", "DE", "DF",
-    "E0", "E1", "E2", "E3", "E4", "E5", "E6", "E7",
-    "E8", "E9", "EA", "EB", "EC", "ED", "EE", "EF",
-    "F0", "F1", "F2", "F3", "F4", "F5", "F6", "F7",
-    "F8", "F9", "FA", "FB", "FC", "FD", "FE", "FF"
-};
-
-const char PRINTABLES[]{
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    ' ', '!', '"', '#', '$', '%', '&', '\'',
-    '(', ')', '*', '+', ',', '-', '.', '/',
-    '0', '1', '2', '3', '4', '5', '6', '7',
-    '8', '9', ':', ';', '<', '=', '>', '?',
-    '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
-    'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
-    'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W',
-    'X', 'Y', 'Z', '[', '\\', ']', '^', '_',
-    '`', 'a', 'b', 'c', 'd', 'e', 'f', 'g',
-    'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
-    'p', 'q', 'r', 's', 't', 'u', 'v', 'w',
-    'x', 'y', 'z', '{', '|', '}', '~', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.',
-    '.', '.', '.', '.', '.', '.', '.', '.'
-};
-
-const char HEX_CHARS[]{
-    '0', '1', '2', '3', '4', '5', '6', '7', 
-    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
-};
-
-const auto BIT_SHIFT_AMOUNT{ 4 };
-constexpr auto READ_SIZE{ 1 << BIT_SHIFT_AMOUNT };
-
-const auto OFFSET_LIMIT_POSITION{ 7 };
-const auto HEX_START_POSITION{ 10 };
-const auto PRINTABLES_START_POSITION{ 59 };
-const auto HEX_SKIP_AMOUNT{ 2 };
-
-const auto FILE_ARG_POSITION{ 1 };
+const auto FILE_ARG_POSITION{ -1 };
+
+const auto* DEFAULT_FORMAT{ FORMAT_NAMES[0] };
+
+//! Megabytes of formatted text a server caches by default.
+const auto DEFAULT_CACHE_MEGABYTES{ 64U };
+
+//! Finished dumps per job that may wait in memory to be written to stdout.
+const auto BUFFERED_FILES_PER_JOB{ 2U };
 
 
 
@@ -117,10 +58,17 @@ const auto FILE_ARG_POSITION{ 1 };
 
 int main ( int argc, char** argv )
 { 
+  std::ios::sync_with_stdio ( false );
+
   bool is_help{};
+  bool is_recursive{};
+  bool is_output_files{};
+  bool is_no_cache{};
+  bool is_stats{};
+  bool is_json_stats{};
 
   boost::program_options::options_description description{ 
-      "Hex [options] file" 
+      "Hex [options] file ..." 
   };
   description.add_options ()
       ( 
@@ -129,9 +77,81 @@ int main ( int argc, char** argv )
           "Display a help dialog" 
       )
       ( 
-          "file,f", 
+          "recursive,r", 
+          boost::program_options::bool_switch ( &is_recursive ), 
+          "Dump every file below any directory given" 
+      )
+      ( 
+          "output-files,o", 
+          boost::program_options::bool_switch ( &is_output_files ), 
+          "Write each file's dump to its own file, named after the input "
+          "with the format's extension added" 
+      )
+      ( 
+          "format,F", 
+          boost::program_options::value<std::string> ()->default_value ( 
+              DEFAULT_FORMAT 
+          ), 
+          "Output format: 'canonical', 'plain', 'c', 'ihex', 'srec', or "
+          "'base64'"
+      )
+      ( 
+          "no-cache", 
+          boost::program_options::bool_switch ( &is_no_cache ), 
+          "Keep input files out of the page cache while reading them "
+          "(not on Windows)" 
+      )
+      ( 
+          "rate-limit", 
+          boost::program_options::value<double> (), 
+          "Most megabytes (10^6 bytes) per second to read, over all files" 
+      )
+      ( 
+          "serve", 
           boost::program_options::value<std::string> (), 
-          "File to show in hexadecimal form"
+          "Serve formatted ranges of files on this Unix socket until "
+          "interrupted, instead of dumping files (not on Windows)" 
+      )
+      ( 
+          "root", 
+          boost::program_options::value<std::string> ()->default_value ( 
+              "." 
+          ), 
+          "Directory a server serves files from, refusing any request for "
+          "a file outside it"
+      )
+      ( 
+          "cache-size", 
+          boost::program_options::value<unsigned> ()->default_value ( 
+              DEFAULT_CACHE_MEGABYTES 
+          ), 
+          "Megabytes of formatted text a server keeps cached"
+      )
+      ( 
+          "stats", 
+          boost::program_options::bool_switch ( &is_stats ), 
+          "Report time summed over threads, calls, bytes and system calls "
+          "of reading, formatting and writing, throughput and peak memory "
+          "on stderr" 
+      )
+      ( 
+          "stats-json", 
+          boost::program_options::bool_switch ( &is_json_stats ), 
+          "Report statistics as JSON" 
+      )
+      ( 
+          "jobs,j", 
+          boost::program_options::value<unsigned> ()->default_value ( 
+              std::max ( std::thread::hardware_concurrency (), 1U ) 
+          ), 
+          "Number of files dumped, or server requests answered, at the same "
+          "time"
+      )
+      ( 
+          "file,f", 
+          boost::program_options::value<std::vector<std::string>> (), 
+          "Files, wildcard patterns, or directories to show in hexadecimal "
+          "form"
       );
 
   boost::program_options::positional_options_description positional{};
@@ -159,85 +179,285 @@ int main ( int argc, char** argv )
     std::cout << description;
     return ( 0 );
   }
+  if ( vm["jobs"].as<unsigned> () == 0 )
+  {
+    std::cerr << "The number of jobs must be at least one !\n";
+    return ( 1 );
+  }
+  if ( !vm["serve"].empty () )
+  {
+#ifndef _WIN32
+    try
+    {
+      RangeServer server{
+          vm["serve"].as<std::string> (),
+          vm["root"].as<std::string> (),
+          vm["jobs"].as<unsigned> (),
+          std::size_t{ vm["cache-size"].as<unsigned> () } << 20
+      };
+      server.run ();
+    }
+    catch ( const std::exception& e )
+    {
+      std::cerr << "Cannot serve: " << e.what () << "\n";
+      return ( 6 );
+    }
+    return ( 0 );
+#else
+    std::cerr << "Serving is not supported on Windows !\n";
+    return ( 1 );
+#endif /* _WIN32 */
+  }
   if ( vm["file"].empty () )
   {
     std::cerr << "No input file given !\n";
     return ( 2 );
   }
-  const auto &filename{ vm["file"].as<std::string> () };
-
-  std::ifstream input{ filename, std::ios::binary };
-  if ( !input.is_open () )
+  const auto& format{ vm["format"].as<std::string> () };
+  if ( !make_encoder ( format ) )
   {
-    std::cerr << "Cannot open input file '" << filename 
-        << "' in binary mode for reading !\n";
-    return ( 3 );
+    std::cerr << "Unknown output format '" << format << "' !\n";
+    return ( 1 );
   }
-  
-  char output[]{ 
-      "00000000  00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00  ................\n" 
-  };
-  char * const offset_limit{ output + OFFSET_LIMIT_POSITION };
-  char * const hex_start{ output + HEX_START_POSITION };
-  char * const printables_start{ output + PRINTABLES_START_POSITION };
 
-  char read_buffer[READ_SIZE]{};
-  auto byte_ctr{ 0 };
-  while ( !input.eof () )
+  std::unique_ptr<TokenBucket> rate_limit{};
+  if ( !vm["rate-limit"].empty () )
   {
-    input.read ( read_buffer, READ_SIZE );
-
-    auto temp_byte_ctr{ byte_ctr };
-    char *offset_ptr{ offset_limit };
-    while ( temp_byte_ctr ) {
-      *offset_ptr = *( HEX_CHARS + ( temp_byte_ctr % READ_SIZE ) );
-      temp_byte_ctr >>= BIT_SHIFT_AMOUNT;
-      --offset_ptr;
+    const auto megabytes_per_second{ vm["rate-limit"].as<double> () };
+    if ( !( megabytes_per_second > 0.0 ) )
+    {
+      std::cerr << "The rate limit must be above zero !\n";
+      return ( 1 );
     }
+    rate_limit = std::make_unique<TokenBucket> ( 
+        megabytes_per_second, 
+        READ_BLOCK_SIZE 
+    );
+  }
 
-    char *hex_ptr{ hex_start };
-    char *printables_ptr{ printables_start };
-    auto *byte_ptr{ read_buffer };
-    const auto bytes_read{ input.gcount () };
-    for ( auto i{ 0 }; i < bytes_read; ++i )
+  std::unique_ptr<RunStats> stats{};
+  if ( is_stats || is_json_stats )
+  {
+    stats = std::make_unique<RunStats> ();
+  }
+  auto report_stats = [&] ()
+  {
+    if ( stats )
     {
-      const auto byte_value{ static_cast<unsigned char>( *byte_ptr ) };
-      const auto hex_representation{ *( HEX_VALUES + byte_value ) };
-      *hex_ptr = *hex_representation;
-      ++hex_ptr;
-      *hex_ptr = *( hex_representation + 1 );
-        
-      *printables_ptr = *( PRINTABLES + byte_value );
-
-      hex_ptr += HEX_SKIP_AMOUNT;
-      ++printables_ptr;
-      ++byte_ptr;
+      const auto since{ stats->start () };
+      std::cout.flush ();
+      stats->add ( PhaseEnum::Write, since, 0 );
+      stats->report ( is_json_stats, std::cerr );
     }
+  };
 
-    if ( bytes_read < READ_SIZE )
+  std::vector<std::string> errors{};
+  const auto files{ 
+      expand_inputs ( 
+          vm["file"].as<std::vector<std::string>> (), 
+          is_recursive, 
+          errors 
+      ) 
+  };
+  for ( const auto& e : errors )
+  {
+    std::cerr << e << "\n";
+  }
+  if ( files.empty () )
+  {
+    std::cerr << "No input file given !\n";
+    return ( 2 );
+  }
+
+  // A single file going to stdout keeps the original streaming behaviour.
+  if ( files.size () == 1 && !is_output_files )
+  {
+    const auto filename{ files.front ().string () };
+    const auto input{ open_reader ( filename, is_no_cache ) };
+    if ( !input->is_open () )
+    {
+      std::cerr << "Cannot open input file '" << filename 
+          << "' in binary mode for reading !\n";
+      return ( 3 );
+    }
+    try
+    {
+      encode_stream ( 
+          *input, 
+          std::cout, 
+          *make_encoder ( format ), 
+          filename, 
+          rate_limit.get (),
+          stats.get ()
+      );
+    }
+    catch ( const std::exception& e )
     {
-      for ( auto i{ READ_SIZE - bytes_read }; i > 0; --i )
+      std::cerr << e.what () << "\n";
+      return ( 5 );
+    }
+    report_stats ();
+    return ( errors.empty () ? 0 : 2 );
+  }
+
+  // Each file is dumped by a pool worker. When writing to stdout, the dumps
+  // are buffered and this thread emits them in the order of the file list.
+  // The pool hands out the files in list order and a worker only starts one
+  // while it is within a window of the next file to emit, so that at most a
+  // few dumps per worker are held in memory at any time.
+  struct result_struct
+  {
+    std::string text{};
+    std::string error{};
+    int exit_code{};
+  };
+  const auto num_workers{ 
+      std::min<unsigned> ( 
+          vm["jobs"].as<unsigned> (), 
+          static_cast<unsigned>( files.size () ) 
+      ) 
+  };
+  const std::size_t window{ 
+      is_output_files 
+          ? files.size () 
+          : std::size_t{ BUFFERED_FILES_PER_JOB } * num_workers 
+  };
+  std::vector<result_struct> results( files.size () );
+  std::vector<char> is_done( files.size (), 0 );
+  std::size_t num_emitted{ 0 };
+  std::mutex done_lock{};
+  std::condition_variable done_signal{};
+
+  ThreadPool pool{ 
+      num_workers,
+      files.size (),
+      [&] ( std::size_t i ) 
       {
-        *hex_ptr = ' ';
-        ++hex_ptr;
-        *hex_ptr = ' ';
+        // Files are started in list order, so the file waited for by the
+        // emitting thread is always taken before a worker waits for the
+        // window.
+        {
+          std::unique_lock<std::mutex> guard{ done_lock };
+          done_signal.wait ( 
+              guard, 
+              [&] () { return ( i < num_emitted + window ); } 
+          );
+        }
+
+        auto& result{ results[i] };
+        const auto filename{ files[i].string () };
+        const auto encoder{ make_encoder ( format ) };
+        const auto input{ open_reader ( filename, is_no_cache ) };
+        try
+        {
+          if ( !input->is_open () )
+          {
+            result.error = "Cannot open input file '" + filename 
+                + "' in binary mode for reading !";
+            result.exit_code = 3;
+          }
+          else if ( is_output_files )
+          {
+            const auto output_filename{ filename + encoder->extension () };
+            std::ofstream output{ output_filename, std::ios::binary };
+            if ( !output.is_open () )
+            {
+              result.error = "Cannot open output file '" + output_filename 
+                  + "' for writing !";
+              result.exit_code = 4;
+            }
+            else
+            {
+              encode_stream ( 
+                  *input, 
+                  output, 
+                  *encoder, 
+                  filename, 
+                  rate_limit.get (),
+                  stats.get ()
+              );
+            }
+          }
+          else
+          {
+            // The whole dump is held until its turn, so its text is
+            // reserved at once rather than grown and copied as it comes.
+            std::error_code ec{};
+            const auto size{ std::filesystem::file_size ( files[i], ec ) };
+            if ( !ec )
+            {
+              result.text.reserve ( 
+                  static_cast<std::size_t>( 
+                      encoder->max_chars ( size, filename ) 
+                  ) 
+              );
+            }
+            encode_string ( 
+                *input, 
+                result.text, 
+                *encoder, 
+                filename, 
+                rate_limit.get (),
+                stats.get ()
+            );
+          }
+        }
+        catch ( const std::exception& e )
+        {
+          result.error = "'" + filename + "': " + e.what ();
+          result.exit_code = 5;
+        }
+
+        {
+          std::lock_guard<std::mutex> guard{ done_lock };
+          is_done[i] = 1;
+        }
+        done_signal.notify_all ();
+      }
+  };
 
-        *printables_ptr = ' ';
+  auto exit_code{ errors.empty () ? 0 : 2 };
+  for ( std::size_t i{ 0 }; i < files.size (); ++i )
+  {
+    {
+      std::unique_lock<std::mutex> guard{ done_lock };
+      done_signal.wait ( guard, [&] () { return ( is_done[i] != 0 ); } );
+    }
 
-        hex_ptr += HEX_SKIP_AMOUNT;
-        ++printables_ptr;
+    auto& result{ results[i] };
+    if ( result.exit_code )
+    {
+      std::cerr << result.error << "\n";
+      exit_code = result.exit_code;
+    }
+    else if ( !is_output_files )
+    {
+      // The workers' copies into their buffers count as writes too, so
+      // buffered dumps show about twice their size written.
+      RunStats::Clock::time_point since{};
+      if ( stats )
+      {
+        since = stats->start ();
+      }
+      std::cout << ( i ? "\n" : "" ) << "==> " << files[i].string () 
+          << " <==\n" << result.text;
+      if ( stats )
+      {
+        stats->add ( PhaseEnum::Write, since, result.text.size () );
       }
     }
+    std::string{}.swap ( result.text );
 
-    byte_ctr += READ_SIZE;
-
-    std::cout << output;
+    {
+      std::lock_guard<std::mutex> guard{ done_lock };
+      ++num_emitted;
+    }
+    done_signal.notify_all ();
   }
-  
-  input.close ();
-
+  pool.join ();
+  report_stats ();
 
-  return ( 0 );
+  return ( exit_code );
 }
 
 
@@ -0,0 +1,694 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : HexLib.cpp
+// SYNOPSIS : Implementation file for the Hex formatting library.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// SYSTEM /////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+
+#include "HexLib.h"
+#include "Encoders.h"
+#include "Stats.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+namespace HexLib
+{
+  static_assert (
+      ROW_BYTES == CANONICAL_ROW_BYTES,
+      "HexLib.h must match the canonical row of Encoders.h"
+  );
+  static_assert (
+      MAX_OFFSET_CHARS == MAX_OFFSET_DIGITS,
+      "HexLib.h must match the offsets of Encoders.h"
+  );
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // LOCAL CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  namespace
+  {
+    //! Bytes consumed between hints that let the kernel drop cached pages.
+    const std::uint64_t DROP_WINDOW_SIZE{ 8ULL << 20 };
+
+    //! Bytes in a megabyte for rate limits.
+    const double BYTES_PER_MEGABYTE{ 1'000'000.0 };
+
+    //! The longest burst a rate limit allows, in seconds of its rate.
+    const double RATE_LIMIT_BURST_SECONDS{ 0.1 };
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // LOCAL CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  namespace
+  {
+    //! Reads a file through the standard library.
+    class StreamReader final : public BlockReader
+    {
+    public:
+      //! Opens a file for reading in binary mode.
+      explicit StreamReader ( const std::string& filename )
+        : input_{ filename, std::ios::binary }
+      {
+      }
+
+      bool is_open () const override
+      {
+        return ( input_.is_open () );
+      }
+
+      std::size_t read ( char* buffer, std::size_t size ) override
+      {
+        input_.read ( buffer, static_cast<std::streamsize>( size ) );
+        if ( input_.bad () )
+        {
+          throw std::system_error{
+              std::make_error_code ( std::errc::io_error ),
+              "Reading input failed"
+          };
+        }
+        return ( static_cast<std::size_t>( input_.gcount () ) );
+      }
+
+    private:
+      std::ifstream input_;
+    };
+
+
+#ifndef _WIN32
+    /**
+     * @brief Reads a file while keeping it out of the page cache.
+     *
+     * The kernel is told the file is read sequentially, so it reads ahead
+     * aggressively, and every DROP_WINDOW_SIZE bytes it is told the pages
+     * already consumed will not be needed again. A long dump then only ever
+     * holds about one window of the file in the page cache instead of
+     * evicting everything else on the host.
+     */
+    class UncachedReader final : public BlockReader
+    {
+    public:
+      //! Opens a file for reading.
+      explicit UncachedReader ( const std::string& filename )
+        : fd_{ ::open ( filename.c_str (), O_RDONLY | O_CLOEXEC ) }
+      {
+        if ( fd_ >= 0 )
+        {
+          ::posix_fadvise ( fd_, 0, 0, POSIX_FADV_SEQUENTIAL );
+        }
+      }
+
+      UncachedReader ( const UncachedReader& ) = delete;
+      UncachedReader& operator= ( const UncachedReader& ) = delete;
+
+      ~UncachedReader () override
+      {
+        if ( fd_ >= 0 )
+        {
+          drop_consumed ();
+          ::close ( fd_ );
+        }
+      }
+
+      bool is_open () const override
+      {
+        return ( fd_ >= 0 );
+      }
+
+      std::size_t read ( char* buffer, std::size_t size ) override
+      {
+        std::size_t total{};
+        while ( total < size )
+        {
+          const auto bytes_read{
+              ::read ( fd_, buffer + total, size - total )
+          };
+          if ( bytes_read < 0 )
+          {
+            if ( errno == EINTR )
+            {
+              continue;
+            }
+            throw std::system_error{
+                errno,
+                std::generic_category (),
+                "Reading input failed"
+            };
+          }
+          if ( bytes_read == 0 )
+          {
+            break;
+          }
+          total += static_cast<std::size_t>( bytes_read );
+        }
+
+        offset_ += total;
+        if ( offset_ - dropped_ >= DROP_WINDOW_SIZE )
+        {
+          drop_consumed ();
+        }
+        return ( total );
+      }
+
+    private:
+      void drop_consumed ()
+      {
+        ::posix_fadvise (
+            fd_,
+            static_cast<off_t>( dropped_ ),
+            static_cast<off_t>( offset_ - dropped_ ),
+            POSIX_FADV_DONTNEED
+        );
+        dropped_ = offset_;
+      }
+
+      int fd_;
+      std::uint64_t offset_{};
+      std::uint64_t dropped_{};
+    };
+#endif /* _WIN32 */
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // LOCAL FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  namespace
+  {
+    /**
+     * @brief Gives the number of digits an offset is written with.
+     *
+     * @param[in] offset The offset.
+     * @returns From OFFSET_DIGITS to MAX_OFFSET_DIGITS.
+     */
+    std::size_t offset_digits ( std::uint64_t offset )
+    {
+      std::size_t digits{ OFFSET_DIGITS };
+      while ( digits < MAX_OFFSET_DIGITS && ( offset >> ( 4 * digits ) ) )
+      {
+        ++digits;
+      }
+      return ( digits );
+    }
+
+
+    /**
+     * @brief Checks if a command line argument is a wildcard pattern.
+     *
+     * @param[in] arg The command line argument.
+     * @returns \c true if the argument has any of \c * , \c ? , or \c [ .
+     */
+    bool has_wildcards ( const std::string& arg )
+    {
+      return ( arg.find_first_of ( "*?[" ) != std::string::npos );
+    }
+
+
+    /**
+     * @brief Appends all regular files below a directory in sorted order.
+     *
+     * @param[in] directory The directory to walk.
+     * @param[out] files The list to append to.
+     */
+    void add_directory (
+        const std::filesystem::path& directory,
+        std::vector<std::filesystem::path>& files
+    )
+    {
+      std::vector<std::filesystem::path> found{};
+      std::error_code ec{};
+      for (
+          std::filesystem::recursive_directory_iterator it{ directory, ec },
+              end{};
+          !ec && it != end;
+          it.increment ( ec )
+      )
+      {
+        if ( it->is_regular_file ( ec ) )
+        {
+          found.push_back ( it->path () );
+        }
+      }
+      std::sort ( found.begin (), found.end () );
+      files.insert ( files.end (), found.begin (), found.end () );
+    }
+
+
+    /**
+     * @brief Encodes all of an input file, optionally timing each phase.
+     *
+     * Timing is a template parameter so that runs without statistics have
+     * no clock reads or counters at all.
+     *
+     * @tparam IS_TIMED Whether to count into \c stats .
+     * @tparam Output A \c std::ostream , or a \c std::string appended to.
+     * @param[in] input The file to read from.
+     * @param[in] out Where to write the encoded text.
+     * @param[in] encoder The encoder for the output format.
+     * @param[in] name The name of the input, for formats that record it.
+     * @param[in] rate_limit The limit on reading, or \c nullptr for none.
+     * @param[in,out] stats Where to count, when \c IS_TIMED is set.
+     */
+    template<bool IS_TIMED, typename Output>
+    void encode_blocks (
+        BlockReader& input,
+        Output& out,
+        Encoder& encoder,
+        const std::string& name,
+        TokenBucket* rate_limit,
+        RunStats* stats
+    )
+    {
+      RunStats::Clock::time_point since{};
+      auto write = [&] ( const TextBuffer& text )
+      {
+        if constexpr ( IS_TIMED )
+        {
+          since = stats->add ( PhaseEnum::Format, since, text.size () );
+        }
+        if constexpr ( std::is_same_v<Output, std::string> )
+        {
+          out.append ( text.data (), text.size () );
+        }
+        else
+        {
+          out.write (
+              text.data (),
+              static_cast<std::streamsize>( text.size () )
+          );
+        }
+        if constexpr ( IS_TIMED )
+        {
+          since = stats->add ( PhaseEnum::Write, since, text.size () );
+        }
+      };
+
+      std::vector<char> read_buffer( READ_BLOCK_SIZE );
+      TextBuffer text{};
+      encoder.begin ( name, text );
+      if constexpr ( IS_TIMED )
+      {
+        since = stats->start ();
+      }
+      for ( ;; )
+      {
+        const auto bytes_read{
+            input.read ( read_buffer.data (), READ_BLOCK_SIZE )
+        };
+        if ( rate_limit && bytes_read )
+        {
+          rate_limit->acquire ( bytes_read );
+        }
+        if constexpr ( IS_TIMED )
+        {
+          since = stats->add ( PhaseEnum::Read, since, bytes_read );
+        }
+        if ( !bytes_read )
+        {
+          break;
+        }
+        encoder.encode (
+            reinterpret_cast<const unsigned char*>( read_buffer.data () ),
+            bytes_read,
+            text
+        );
+        write ( text );
+        text.clear ();
+      }
+      encoder.finish ( text );
+      write ( text );
+    }
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASS IMPLEMENTATIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  TokenBucket::TokenBucket ( double megabytes_per_second, std::size_t min_burst )
+    : rate_{ megabytes_per_second * BYTES_PER_MEGABYTE },
+      burst_{
+          std::max (
+              rate_ * RATE_LIMIT_BURST_SECONDS,
+              static_cast<double>( min_burst )
+          )
+      },
+      tokens_{ burst_ },
+      last_refill_{ std::chrono::steady_clock::now () }
+  {
+  }
+
+
+  void TokenBucket::acquire ( std::size_t bytes )
+  {
+    std::chrono::duration<double> wait{};
+    {
+      std::lock_guard<std::mutex> guard{ lock_ };
+      const auto now{ std::chrono::steady_clock::now () };
+      const std::chrono::duration<double> elapsed{ now - last_refill_ };
+      last_refill_ = now;
+      tokens_ = std::min ( burst_, tokens_ + elapsed.count () * rate_ );
+      tokens_ -= static_cast<double>( bytes );
+      if ( tokens_ < 0.0 )
+      {
+        wait = std::chrono::duration<double>{ -tokens_ / rate_ };
+      }
+    }
+    if ( wait.count () > 0.0 )
+    {
+      std::this_thread::sleep_for ( wait );
+    }
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTION IMPLEMENTATIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  std::size_t rows_capacity ( std::size_t size, std::uint64_t base ) noexcept
+  {
+    if ( !size )
+    {
+      return ( 0 );
+    }
+    const auto rows{ ( size + ROW_BYTES - 1 ) / ROW_BYTES };
+    const auto last_offset{ base + ( rows - 1 ) * ROW_BYTES };
+    return (
+        rows * ( MAX_CANONICAL_ROW_CHARS - MAX_OFFSET_DIGITS
+            + offset_digits ( last_offset ) )
+    );
+  }
+
+
+  std::size_t format_rows (
+      std::span<const std::byte> data,
+      std::uint64_t base,
+      std::span<char> out
+  ) noexcept
+  {
+    if ( out.size () < rows_capacity ( data.size (), base ) )
+    {
+      return ( 0 );
+    }
+    const auto* const end{
+        put_canonical_rows (
+            reinterpret_cast<const unsigned char*>( data.data () ),
+            data.size (),
+            base,
+            out.data ()
+        )
+    };
+    return ( static_cast<std::size_t>( end - out.data () ) );
+  }
+
+
+  std::size_t format_offset (
+      std::uint64_t offset,
+      std::span<char> out
+  ) noexcept
+  {
+    if ( out.size () < offset_digits ( offset ) )
+    {
+      return ( 0 );
+    }
+    const auto* const end{ put_offset ( offset, out.data () ) };
+    return ( static_cast<std::size_t>( end - out.data () ) );
+  }
+
+
+  std::size_t format_end (
+      std::uint64_t total,
+      std::span<char> out
+  ) noexcept
+  {
+    if ( total % ROW_BYTES || out.size () < rows_capacity ( 1, total ) )
+    {
+      return ( 0 );
+    }
+    const auto* const end{
+        put_canonical_row<false> ( nullptr, 0, total, out.data () )
+    };
+    return ( static_cast<std::size_t>( end - out.data () ) );
+  }
+
+
+  std::unique_ptr<BlockReader> open_reader (
+      const std::string& filename,
+      bool is_no_cache
+  )
+  {
+#ifndef _WIN32
+    if ( is_no_cache )
+    {
+      return ( std::make_unique<UncachedReader> ( filename ) );
+    }
+#else
+    static_cast<void>( is_no_cache );
+#endif /* _WIN32 */
+    return ( std::make_unique<StreamReader> ( filename ) );
+  }
+
+
+  void encode_stream (
+      BlockReader& input,
+      std::ostream& out,
+      Encoder& encoder,
+      const std::string& name,
+      TokenBucket* rate_limit,
+      RunStats* stats
+  )
+  {
+    if ( stats )
+    {
+      encode_blocks<true> ( input, out, encoder, name, rate_limit, stats );
+    }
+    else
+    {
+      encode_blocks<false> ( input, out, encoder, name, rate_limit, stats );
+    }
+  }
+
+
+  void encode_string (
+      BlockReader& input,
+      std::string& out,
+      Encoder& encoder,
+      const std::string& name,
+      TokenBucket* rate_limit,
+      RunStats* stats
+  )
+  {
+    if ( stats )
+    {
+      encode_blocks<true> ( input, out, encoder, name, rate_limit, stats );
+    }
+    else
+    {
+      encode_blocks<false> ( input, out, encoder, name, rate_limit, stats );
+    }
+  }
+
+
+  bool wildcard_match ( const char* pattern, const char* text )
+  {
+    const char* star_pattern{ nullptr };
+    const char* star_text{ nullptr };
+    while ( *text )
+    {
+      if ( *pattern == '*' )
+      {
+        star_pattern = ++pattern;
+        star_text = text;
+        continue;
+      }
+
+      auto matched{ false };
+      auto* next_pattern{ pattern + 1 };
+      if ( *pattern == '?' )
+      {
+        matched = true;
+      }
+      else if ( *pattern == '[' )
+      {
+        auto* p{ pattern + 1 };
+        const auto negated{ *p == '!' || *p == '^' };
+        if ( negated )
+        {
+          ++p;
+        }
+        auto in_class{ false };
+        for ( ; *p && ( *p != ']' || p == pattern + 1 + negated ); ++p )
+        {
+          if ( p[1] == '-' && p[2] && p[2] != ']' )
+          {
+            in_class = in_class || ( *p <= *text && *text <= p[2] );
+            p += 2;
+          }
+          else
+          {
+            in_class = in_class || *p == *text;
+          }
+        }
+        if ( *p == ']' )
+        {
+          matched = in_class != negated;
+          next_pattern = p + 1;
+        }
+        else
+        {
+          matched = *pattern == *text;
+        }
+      }
+      else
+      {
+        matched = *pattern != '\0' && *pattern == *text;
+      }
+
+      if ( matched )
+      {
+        pattern = next_pattern;
+        ++text;
+      }
+      else if ( star_pattern )
+      {
+        pattern = star_pattern;
+        text = ++star_text;
+      }
+      else
+      {
+        return ( false );
+      }
+    }
+
+    while ( *pattern == '*' )
+    {
+      ++pattern;
+    }
+    return ( *pattern == '\0' );
+  }
+
+
+  std::vector<std::filesystem::path> expand_inputs (
+      const std::vector<std::string>& args,
+      bool recursive,
+      std::vector<std::string>& errors
+  )
+  {
+    std::vector<std::filesystem::path> files{};
+    for ( const auto& arg : args )
+    {
+      std::vector<std::filesystem::path> candidates{};
+      if ( has_wildcards ( arg ) )
+      {
+        const std::filesystem::path pattern_path{ arg };
+        const auto parent{
+            pattern_path.has_parent_path ()
+                ? pattern_path.parent_path ()
+                : std::filesystem::path{ "." }
+        };
+        const auto pattern{ pattern_path.filename ().string () };
+        std::error_code ec{};
+        for (
+            std::filesystem::directory_iterator it{ parent, ec }, end{};
+            !ec && it != end;
+            it.increment ( ec )
+        )
+        {
+          const auto name{ it->path ().filename ().string () };
+          if ( wildcard_match ( pattern.c_str (), name.c_str () ) )
+          {
+            candidates.push_back (
+                pattern_path.has_parent_path ()
+                    ? it->path ()
+                    : std::filesystem::path{ name }
+            );
+          }
+        }
+        if ( candidates.empty () )
+        {
+          errors.push_back ( "No files match '" + arg + "' !" );
+          continue;
+        }
+        std::sort ( candidates.begin (), candidates.end () );
+      }
+      else
+      {
+        candidates.emplace_back ( arg );
+      }
+
+      for ( const auto& c : candidates )
+      {
+        std::error_code ec{};
+        if ( std::filesystem::is_directory ( c, ec ) )
+        {
+          if ( recursive )
+          {
+            add_directory ( c, files );
+          }
+          else
+          {
+            errors.push_back (
+                "'" + c.string () + "' is a directory, use --recursive !"
+            );
+          }
+        }
+        else
+        {
+          files.push_back ( c );
+        }
+      }
+    }
+    return ( files );
+  }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Implementation file for the Hex formatting library.
+ *
+ * Only the standard library and the operating system are included, not the
+ * precompiled header, so the library builds without Boost.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
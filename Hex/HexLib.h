@@ -0,0 +1,292 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : HexLib.h
+// SYNOPSIS : The Hex formatting library, for use by Hex and other tools.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// SYSTEM /////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FORWARD DECLARATIONS
+///////////////////////////////////////////////////////////////////////////////
+
+class Encoder;
+class RunStats;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! The Hex formatting library.
+namespace HexLib
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! Bytes in a row of the canonical format.
+  inline constexpr std::size_t ROW_BYTES{ 16 };
+
+  //! Most characters an offset is written with.
+  inline constexpr std::size_t MAX_OFFSET_CHARS{ 16 };
+
+  //! Size of the blocks read from input files.
+  inline constexpr std::size_t READ_BLOCK_SIZE{ 1 << 16 };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The base class of every way of reading an input file.
+  class BlockReader
+  {
+  public:
+    virtual ~BlockReader () = default;
+
+    //! Whether the file was opened.
+    virtual bool is_open () const = 0;
+
+    /**
+     * @brief Reads the next block of the file.
+     *
+     * @param[out] buffer Where to read to.
+     * @param[in] size The most bytes to read.
+     * @returns The number of bytes read, which is less than \c size only at
+     * the end of the file.
+     * @throws std::system_error If reading fails.
+     */
+    virtual std::size_t read ( char* buffer, std::size_t size ) = 0;
+  };
+
+
+  /**
+   * @brief Limits the rate of reading with a token bucket.
+   *
+   * One bucket is shared by every thread reading input so the limit applies
+   * to the whole process. Reads take tokens as they go; when the bucket runs
+   * dry the reader sleeps until the debt is paid back, so the average rate
+   * never exceeds the limit and bursts are bounded by a tenth of a second's
+   * worth of tokens.
+   */
+  class TokenBucket final
+  {
+  public:
+    /**
+     * @brief Creates a full bucket.
+     *
+     * @param[in] megabytes_per_second The rate limit.
+     * @param[in] min_burst The smallest burst to allow, normally one block.
+     */
+    TokenBucket ( double megabytes_per_second, std::size_t min_burst );
+
+    /**
+     * @brief Takes tokens for some bytes, sleeping if the limit is reached.
+     *
+     * @param[in] bytes The number of bytes read.
+     */
+    void acquire ( std::size_t bytes );
+
+  private:
+    std::mutex lock_{};
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_refill_;
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTION PROTOTYPES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Gives the room needed to format bytes as canonical rows.
+   *
+   * @param[in] size The number of bytes.
+   * @param[in] base The offset of the first byte.
+   * @returns The most characters format_rows() writes for them.
+   */
+  std::size_t rows_capacity ( std::size_t size, std::uint64_t base ) noexcept;
+
+  /**
+   * @brief Formats bytes as canonical rows into a caller's buffer.
+   *
+   * Each row is an offset, sixteen hexadecimal bytes, and their printable
+   * characters, with a short last row padded with spaces, exactly as Hex
+   * writes them. Nothing is allocated, so this is safe to call from any
+   * thread on any buffer.
+   *
+   * @param[in] data The bytes, at most one short row of which is written
+   * unless \c data is a multiple of ROW_BYTES long.
+   * @param[in] base The offset of the first byte.
+   * @param[out] out Where to write.
+   * @returns The number of characters written, or zero if \c out is smaller
+   * than rows_capacity() and nothing was written.
+   */
+  std::size_t format_rows (
+      std::span<const std::byte> data,
+      std::uint64_t base,
+      std::span<char> out
+  ) noexcept;
+
+  /**
+   * @brief Formats an offset as Hex does into a caller's buffer.
+   *
+   * @param[in] offset The offset.
+   * @param[out] out Where to write, with room for MAX_OFFSET_CHARS.
+   * @returns The number of characters written, or zero if \c out is too
+   * small and nothing was written.
+   */
+  std::size_t format_offset (
+      std::uint64_t offset,
+      std::span<char> out
+  ) noexcept;
+
+  /**
+   * @brief Formats the row that closes a canonical dump, if it has one.
+   *
+   * A dump whose size is a multiple of ROW_BYTES ends with a blank row
+   * giving its size.
+   *
+   * @param[in] total The number of bytes dumped.
+   * @param[out] out Where to write, with room for one row.
+   * @returns The number of characters written, zero when there is no such
+   * row or \c out is too small.
+   */
+  std::size_t format_end (
+      std::uint64_t total,
+      std::span<char> out
+  ) noexcept;
+
+  /**
+   * @brief Opens an input file with the reader for the options given.
+   *
+   * @param[in] filename The file to open.
+   * @param[in] is_no_cache Whether to keep the file out of the page cache.
+   * @returns A reader, which must be checked with BlockReader::is_open().
+   *
+   * @note Windows has no equivalent of the page cache hints, so files are
+   * always read through the standard library there.
+   */
+  std::unique_ptr<BlockReader> open_reader (
+      const std::string& filename,
+      bool is_no_cache
+  );
+
+  /**
+   * @brief Encodes all of an input file with the given encoder.
+   *
+   * @param[in] input The file to read from.
+   * @param[in] out The stream to write the encoded text to.
+   * @param[in] encoder The encoder for the output format.
+   * @param[in] name The name of the input, for formats that record it.
+   * @param[in] rate_limit The limit on reading, or \c nullptr for none.
+   * @param[in,out] stats Where to count the time of each phase, or
+   * \c nullptr to run without timing.
+   * @throws std::system_error If reading fails.
+   */
+  void encode_stream (
+      BlockReader& input,
+      std::ostream& out,
+      Encoder& encoder,
+      const std::string& name,
+      TokenBucket* rate_limit,
+      RunStats* stats = nullptr
+  );
+
+  /**
+   * @brief Encodes all of an input file onto the end of a string.
+   *
+   * Reserving Encoder::max_chars() in the string first lets a whole dump be
+   * held in memory without the copies of growing it, and moved on from
+   * there.
+   *
+   * @param[in] input The file to read from.
+   * @param[in,out] out The string to append the encoded text to.
+   * @param[in] encoder The encoder for the output format.
+   * @param[in] name The name of the input, for formats that record it.
+   * @param[in] rate_limit The limit on reading, or \c nullptr for none.
+   * @param[in,out] stats Where to count the time of each phase, or
+   * \c nullptr to run without timing.
+   * @throws std::system_error If reading fails.
+   */
+  void encode_string (
+      BlockReader& input,
+      std::string& out,
+      Encoder& encoder,
+      const std::string& name,
+      TokenBucket* rate_limit,
+      RunStats* stats = nullptr
+  );
+
+  /**
+   * @brief Matches a file name against a wildcard pattern.
+   *
+   * @param[in] pattern A pattern using \c * , \c ? , and \c [...] classes.
+   * @param[in] text The file name to match.
+   * @returns \c true if the whole of \c text matches \c pattern .
+   */
+  bool wildcard_match ( const char* pattern, const char* text );
+
+  /**
+   * @brief Expands file arguments into the list of files to dump.
+   *
+   * Wildcards are expanded in the last path component only, and directories
+   * are walked when \c recursive is set. Expansions are sorted so the order
+   * of the output does not depend on the file system.
+   *
+   * @param[in] args The file arguments in command line order.
+   * @param[in] recursive Whether directories are walked.
+   * @param[out] errors Messages for arguments that could not be used.
+   * @returns The files to dump, in output order.
+   */
+  std::vector<std::filesystem::path> expand_inputs (
+      const std::vector<std::string>& args,
+      bool recursive,
+      std::vector<std::string>& errors
+  );
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief The Hex formatting library, for use by Hex and other tools.
+ *
+ * The library is this header and HexLib.cpp, with the encoders of
+ * Encoders.h and the counters of Stats.h that it is built on. None of them
+ * needs more than the standard library and the operating system, so other
+ * tools can format rows, read files, or dump whole files in any format
+ * without taking in Hex's command line or Boost. Dumping in a given format
+ * needs an Encoder from make_encoder() in Encoders.h, and timing the phases
+ * of a dump a RunStats from Stats.h.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,1045 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Server.h
+// SYNOPSIS : A read-only server of formatted file ranges on a Unix socket.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+
+#include "PCH.h"
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+
+#include "Encoders.h"
+
+
+
+#ifndef _WIN32
+///////////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+///////////////////////////////////////////////////////////////////////////////
+
+//! Formats whose lines do not depend on what comes before them.
+const char* const SERVED_FORMATS[]{ "canonical", "plain", "base64" };
+
+//! Number of lines of a format in one cached page.
+const std::size_t PAGE_LINES{ 256 };
+
+//! Most files kept open at once.
+const std::size_t MAX_OPEN_FILES{ 64 };
+
+//! Longest request line accepted.
+const std::size_t MAX_REQUEST_CHARS{ 4096 };
+
+//! Most input bytes one request can ask for.
+const std::uint64_t MAX_RANGE_BYTES{ 16ULL << 20 };
+
+//! Bytes read from a client socket at a time.
+const std::size_t SOCKET_READ_SIZE{ 1 << 12 };
+
+//! Unwritten answer characters above which a client's requests wait.
+const std::size_t MAX_PENDING_OUTPUT{ 1 << 20 };
+
+//! How long a client may read none of its answers before it is dropped.
+const std::chrono::seconds CLIENT_SEND_TIMEOUT{ 30 };
+
+//! Connections waiting to be accepted.
+const int LISTEN_BACKLOG{ 64 };
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CLASSES
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief A file kept open for reading ranges of it.
+ *
+ * Ranges are read with \c pread rather than through a mapping, so a file
+ * truncated while it is served gives a short read, and an error for that
+ * request, rather than a \c SIGBUS that would end the whole server.
+ */
+class ServedFile final
+{
+public:
+  /**
+   * @brief Opens a file.
+   *
+   * @param[in] filename The file to open, with no symbolic link in its last
+   * part.
+   * @throws std::system_error If the file cannot be opened or is not a
+   * regular file.
+   */
+  explicit ServedFile ( const std::string& filename )
+    : fd_{ ::open ( filename.c_str (), O_RDONLY | O_CLOEXEC | O_NOFOLLOW ) }
+  {
+    if ( fd_ < 0 )
+    {
+      throw std::system_error{ errno, std::generic_category (), filename };
+    }
+    if ( ::fstat ( fd_, &info_ ) < 0 || !S_ISREG ( info_.st_mode ) )
+    {
+      const auto error{ S_ISREG ( info_.st_mode ) ? errno : EISDIR };
+      ::close ( fd_ );
+      throw std::system_error{ error, std::generic_category (), filename };
+    }
+    version_ = std::to_string ( info_.st_dev ) + ":"
+        + std::to_string ( info_.st_ino ) + ":"
+        + std::to_string ( info_.st_size ) + ":"
+        + std::to_string ( info_.st_mtim.tv_sec ) + "."
+        + std::to_string ( info_.st_mtim.tv_nsec );
+  }
+
+  ServedFile ( const ServedFile& ) = delete;
+  ServedFile& operator= ( const ServedFile& ) = delete;
+
+  ~ServedFile ()
+  {
+    ::close ( fd_ );
+  }
+
+  /**
+   * @brief Checks whether the file is still the one that was opened, as it
+   * was then.
+   *
+   * @param[in] info What \c stat gives for the file's name now.
+   * @returns \c true if it is the same file with the same size and time of
+   * last change.
+   */
+  bool is_current ( const struct stat& info ) const
+  {
+    return (
+        info.st_dev == info_.st_dev
+        && info.st_ino == info_.st_ino
+        && info.st_size == info_.st_size
+        && info.st_mtim.tv_sec == info_.st_mtim.tv_sec
+        && info.st_mtim.tv_nsec == info_.st_mtim.tv_nsec
+    );
+  }
+
+  //! The size of the file when it was opened.
+  std::uint64_t size () const
+  {
+    return ( static_cast<std::uint64_t>( info_.st_size ) );
+  }
+
+  //! Names this file as it was when opened, for keys of cached pages.
+  const std::string& version () const
+  {
+    return ( version_ );
+  }
+
+  /**
+   * @brief Reads a range of the file.
+   *
+   * @param[in] offset The first byte to read.
+   * @param[in] size The number of bytes to read.
+   * @param[out] out Where to read to.
+   * @throws std::system_error If reading fails or the file has shrunk.
+   */
+  void read ( std::uint64_t offset, std::size_t size, unsigned char* out ) const
+  {
+    while ( size )
+    {
+      const auto n{
+          ::pread ( fd_, out, size, static_cast<off_t>( offset ) )
+      };
+      if ( n < 0 && errno == EINTR )
+      {
+        continue;
+      }
+      if ( n < 0 )
+      {
+        throw std::system_error{ errno, std::generic_category (), "read" };
+      }
+      if ( n == 0 )
+      {
+        throw std::system_error{
+            std::make_error_code ( std::errc::io_error ),
+            "File changed while being read"
+        };
+      }
+      out += n;
+      offset += static_cast<std::uint64_t>( n );
+      size -= static_cast<std::size_t>( n );
+    }
+  }
+
+private:
+  int fd_;
+  struct stat info_{};
+  std::string version_{};
+};
+
+
+/**
+ * @brief A thread-safe least recently used cache.
+ *
+ * Values are shared so that an entry evicted while a worker still uses it
+ * stays alive until that worker is done with it.
+ *
+ * @tparam Value The type of the cached values.
+ */
+template <typename Value>
+class LruCache final
+{
+public:
+  /**
+   * @brief Creates an empty cache.
+   *
+   * @param[in] capacity The most cost the cache holds.
+   */
+  explicit LruCache ( std::size_t capacity )
+    : capacity_{ capacity }
+  {
+  }
+
+  /**
+   * @brief Looks a value up, marking it as most recently used.
+   *
+   * @param[in] key The key of the value.
+   * @returns The value, or \c nullptr if it is not cached.
+   */
+  std::shared_ptr<const Value> find ( const std::string& key )
+  {
+    std::lock_guard<std::mutex> guard{ lock_ };
+    const auto it{ index_.find ( key ) };
+    if ( it == index_.end () )
+    {
+      ++misses_;
+      return ( nullptr );
+    }
+    ++hits_;
+    entries_.splice ( entries_.begin (), entries_, it->second );
+    return ( it->second->value );
+  }
+
+  /**
+   * @brief Adds a value, in place of any with the same key, evicting the
+   * least recently used ones to make room.
+   *
+   * @param[in] key The key of the value.
+   * @param[in] value The value.
+   * @param[in] cost What the value counts against the capacity.
+   */
+  void insert (
+      const std::string& key,
+      std::shared_ptr<const Value> value,
+      std::size_t cost
+  )
+  {
+    std::lock_guard<std::mutex> guard{ lock_ };
+    const auto it{ index_.find ( key ) };
+    if ( it != index_.end () )
+    {
+      used_ -= it->second->cost;
+      entries_.erase ( it->second );
+      index_.erase ( it );
+    }
+    entries_.push_front ( entry_struct{ key, std::move ( value ), cost } );
+    index_.emplace ( key, entries_.begin () );
+    used_ += cost;
+    while ( used_ > capacity_ && entries_.size () > 1 )
+    {
+      used_ -= entries_.back ().cost;
+      index_.erase ( entries_.back ().key );
+      entries_.pop_back ();
+    }
+  }
+
+  //! Number of lookups that found their value.
+  std::uint64_t hits () const
+  {
+    std::lock_guard<std::mutex> guard{ lock_ };
+    return ( hits_ );
+  }
+
+  //! Number of lookups that did not find their value.
+  std::uint64_t misses () const
+  {
+    std::lock_guard<std::mutex> guard{ lock_ };
+    return ( misses_ );
+  }
+
+private:
+  struct entry_struct
+  {
+    std::string key;
+    std::shared_ptr<const Value> value;
+    std::size_t cost;
+  };
+
+  mutable std::mutex lock_{};
+  std::size_t capacity_;
+  std::size_t used_{};
+  std::list<entry_struct> entries_{};
+  std::unordered_map<
+      std::string,
+      typename std::list<entry_struct>::iterator
+  > index_{};
+  std::uint64_t hits_{};
+  std::uint64_t misses_{};
+};
+
+
+/**
+ * @brief Serves formatted ranges of files over a Unix domain socket.
+ *
+ * A client sends requests of one line each,
+ *
+ *     <format> <offset> <length> <file>
+ *
+ * where the file is a path under the root directory the server was given,
+ * or relative to it. Paths are resolved, symbolic links included, before
+ * being checked, so nothing outside the root can be read through them.
+ * and gets back either \c "OK <n>" and a newline followed by \c n characters
+ * of formatted text, or \c "ERR <message>" and a newline. The text holds every
+ * whole line of the format that overlaps the range, exactly as a dump of the
+ * whole file would have them, and the closing text of the dump when the range
+ * reaches the end of the file.
+ *
+ * Files stay open between requests, and formatted pages of PAGE_LINES lines
+ * are kept in a shared LRU cache, so repeated views of the same regions of
+ * large files cost a lookup and a copy. Each request checks the identity,
+ * size and time of last change of its file, so a file that was changed or
+ * replaced is opened again and never answered from pages of its old
+ * contents.
+ *
+ * The calling thread runs a poll loop that accepts connections and watches
+ * idle clients. A client with input is handed to one of a fixed number of
+ * workers, which answers every complete request it has and then gives the
+ * client back to the loop, so a few workers serve many connections. Answers
+ * the client is not reading yet are kept for it, the loop watches until it
+ * can take more, and a client that reads nothing for CLIENT_SEND_TIMEOUT is
+ * dropped, so no worker ever waits on a socket.
+ */
+class RangeServer final
+{
+public:
+  /**
+   * @brief Sets up a server.
+   *
+   * @param[in] socket_path Where to create the socket.
+   * @param[in] root The directory whose files are served.
+   * @param[in] num_workers Number of worker threads, at least one is used.
+   * @param[in] cache_bytes Most characters of formatted text to cache.
+   * @throws std::filesystem::filesystem_error If the root does not exist.
+   */
+  RangeServer (
+      std::string socket_path,
+      const std::string& root,
+      unsigned num_workers,
+      std::size_t cache_bytes
+  )
+    : socket_path_{ std::move ( socket_path ) },
+      root_{ std::filesystem::canonical ( root ) },
+      num_workers_{ std::max ( num_workers, 1U ) },
+      files_{ MAX_OPEN_FILES },
+      pages_{ cache_bytes }
+  {
+  }
+
+  RangeServer ( const RangeServer& ) = delete;
+  RangeServer& operator= ( const RangeServer& ) = delete;
+
+  /**
+   * @brief Serves requests until the process is interrupted or terminated.
+   *
+   * @throws std::system_error If the socket cannot be set up.
+   */
+  void run ()
+  {
+    open_socket ();
+
+    ::signal ( SIGPIPE, SIG_IGN );
+    wake_fd_ = wake_pipe_[1];
+    ::signal ( SIGINT, on_stop_signal );
+    ::signal ( SIGTERM, on_stop_signal );
+
+    std::vector<std::thread> workers{};
+    for ( unsigned w{ 0 }; w < num_workers_; ++w )
+    {
+      workers.emplace_back ( [this] () { work (); } );
+    }
+
+    poll_loop ();
+
+    {
+      std::lock_guard<std::mutex> guard{ lock_ };
+      is_stopping_ = true;
+    }
+    ready_signal_.notify_all ();
+    for ( auto& t : workers )
+    {
+      t.join ();
+    }
+
+    ::signal ( SIGINT, SIG_DFL );
+    ::signal ( SIGTERM, SIG_DFL );
+    close_socket ();
+  }
+
+  //! Number of page lookups answered from the cache.
+  std::uint64_t cache_hits () const
+  {
+    return ( pages_.hits () );
+  }
+
+  //! Number of page lookups that had to format the page.
+  std::uint64_t cache_misses () const
+  {
+    return ( pages_.misses () );
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  //! A connected client, its unanswered input and its unwritten answers.
+  struct client_struct
+  {
+    int fd;
+    std::string input{};
+    std::string output{};
+    std::size_t output_sent{};
+    //! When the client last took some output, or was given some to take.
+    Clock::time_point last_progress{};
+    //! Whether the client has sent all its requests.
+    bool is_input_done{};
+  };
+
+  using Client = std::unique_ptr<client_struct>;
+
+  static void on_stop_signal ( int )
+  {
+    is_signalled_ = 1;
+    const char byte{ 0 };
+    static_cast<void>( ::write ( wake_fd_, &byte, 1 ) );
+  }
+
+  static void throw_errno ( const std::string& what )
+  {
+    throw std::system_error{ errno, std::generic_category (), what };
+  }
+
+  void open_socket ()
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if ( socket_path_.size () >= sizeof ( address.sun_path ) )
+    {
+      throw std::system_error{
+          std::make_error_code ( std::errc::filename_too_long ),
+          socket_path_
+      };
+    }
+    std::memcpy (
+        address.sun_path,
+        socket_path_.c_str (),
+        socket_path_.size () + 1
+    );
+
+    // A socket left behind by a server that died is replaced, but one a
+    // server still answers on, and anything that is not a socket, is not.
+    struct stat info{};
+    if (
+        ::lstat ( socket_path_.c_str (), &info ) == 0
+        && S_ISSOCK ( info.st_mode )
+    )
+    {
+      const auto probe_fd{ ::socket ( AF_UNIX, SOCK_STREAM, 0 ) };
+      if ( probe_fd < 0 )
+      {
+        throw_errno ( "socket" );
+      }
+      const auto is_live{
+          ::connect (
+              probe_fd,
+              reinterpret_cast<const sockaddr*>( &address ),
+              sizeof ( address )
+          ) == 0
+          || errno != ECONNREFUSED
+      };
+      ::close ( probe_fd );
+      if ( is_live )
+      {
+        throw std::system_error{
+            std::make_error_code ( std::errc::address_in_use ),
+            socket_path_
+        };
+      }
+      ::unlink ( socket_path_.c_str () );
+    }
+
+    listen_fd_ = ::socket ( AF_UNIX, SOCK_STREAM, 0 );
+    if ( listen_fd_ < 0 )
+    {
+      throw_errno ( "socket" );
+    }
+    ::fcntl ( listen_fd_, F_SETFD, FD_CLOEXEC );
+    if (
+        ::bind (
+            listen_fd_,
+            reinterpret_cast<const sockaddr*>( &address ),
+            sizeof ( address )
+        ) < 0
+    )
+    {
+      throw_errno ( socket_path_ );
+    }
+    if ( ::listen ( listen_fd_, LISTEN_BACKLOG ) < 0 )
+    {
+      throw_errno ( socket_path_ );
+    }
+    set_non_blocking ( listen_fd_ );
+
+    if ( ::pipe ( wake_pipe_ ) < 0 )
+    {
+      throw_errno ( "pipe" );
+    }
+    for ( const auto fd : wake_pipe_ )
+    {
+      ::fcntl ( fd, F_SETFD, FD_CLOEXEC );
+      set_non_blocking ( fd );
+    }
+  }
+
+  void close_socket ()
+  {
+    for ( auto& c : idle_ )
+    {
+      ::close ( c->fd );
+    }
+    idle_.clear ();
+    ::close ( listen_fd_ );
+    ::unlink ( socket_path_.c_str () );
+    ::close ( wake_pipe_[0] );
+    ::close ( wake_pipe_[1] );
+  }
+
+  static void set_non_blocking ( int fd )
+  {
+    ::fcntl ( fd, F_SETFL, ::fcntl ( fd, F_GETFL ) | O_NONBLOCK );
+  }
+
+  static bool is_sending ( const client_struct& client )
+  {
+    return ( client.output_sent < client.output.size () );
+  }
+
+  void poll_loop ()
+  {
+    std::vector<pollfd> watched{};
+    for ( ;; )
+    {
+      // Clients with answers left to write are watched for room to write
+      // them, until their deadline, and the others for requests.
+      watched.clear ();
+      watched.push_back ( pollfd{ wake_pipe_[0], POLLIN, 0 } );
+      watched.push_back ( pollfd{ listen_fd_, POLLIN, 0 } );
+      auto timeout{ -1 };
+      auto now{ Clock::now () };
+      for ( const auto& c : idle_ )
+      {
+        if ( !is_sending ( *c ) )
+        {
+          watched.push_back ( pollfd{ c->fd, POLLIN, 0 } );
+          continue;
+        }
+        watched.push_back ( pollfd{ c->fd, POLLOUT, 0 } );
+        const auto left{
+            std::chrono::ceil<std::chrono::milliseconds>(
+                c->last_progress + CLIENT_SEND_TIMEOUT - now
+            )
+        };
+        const auto wait{
+            static_cast<int>( std::max<long long> ( left.count (), 0 ) )
+        };
+        timeout = timeout < 0 ? wait : std::min ( timeout, wait );
+      }
+
+      if (
+          ::poll ( watched.data (), watched.size (), timeout ) < 0
+          && errno != EINTR
+      )
+      {
+        throw_errno ( "poll" );
+      }
+
+      if ( watched[0].revents )
+      {
+        char bytes[64];
+        while ( ::read ( wake_pipe_[0], bytes, sizeof ( bytes ) ) > 0 )
+        {
+        }
+        std::lock_guard<std::mutex> guard{ lock_ };
+        for ( auto& c : returned_ )
+        {
+          idle_.push_back ( std::move ( c ) );
+        }
+        returned_.clear ();
+        if ( is_signalled_ )
+        {
+          return;
+        }
+      }
+
+      // Clients with input, room for output, or which hung up, go to the
+      // workers, and those past their deadline are dropped. The watched
+      // list matches idle_ from index two.
+      now = Clock::now ();
+      std::vector<Client> busy{};
+      for ( std::size_t i{ 2 }, c{ 0 }; i < watched.size (); ++i )
+      {
+        const auto is_stalled{
+            is_sending ( *idle_[c] )
+            && now - idle_[c]->last_progress >= CLIENT_SEND_TIMEOUT
+        };
+        if ( watched[i].revents || is_stalled )
+        {
+          if ( watched[i].revents )
+          {
+            busy.push_back ( std::move ( idle_[c] ) );
+          }
+          else
+          {
+            ::close ( idle_[c]->fd );
+          }
+          idle_.erase ( idle_.begin () + static_cast<std::ptrdiff_t>( c ) );
+        }
+        else
+        {
+          ++c;
+        }
+      }
+
+      if ( watched[1].revents & POLLIN )
+      {
+        for ( ;; )
+        {
+          const auto fd{ ::accept ( listen_fd_, nullptr, nullptr ) };
+          if ( fd < 0 )
+          {
+            break;
+          }
+          ::fcntl ( fd, F_SETFD, FD_CLOEXEC );
+          set_non_blocking ( fd );
+          idle_.push_back ( std::make_unique<client_struct> (
+              client_struct{ fd }
+          ) );
+        }
+      }
+
+      if ( !busy.empty () )
+      {
+        {
+          std::lock_guard<std::mutex> guard{ lock_ };
+          for ( auto& c : busy )
+          {
+            ready_.push_back ( std::move ( c ) );
+          }
+        }
+        ready_signal_.notify_all ();
+      }
+    }
+  }
+
+  void work ()
+  {
+    for ( ;; )
+    {
+      Client client{};
+      {
+        std::unique_lock<std::mutex> guard{ lock_ };
+        ready_signal_.wait (
+            guard,
+            [this] () { return ( is_stopping_ || !ready_.empty () ); }
+        );
+        if ( is_stopping_ )
+        {
+          while ( !ready_.empty () )
+          {
+            ::close ( ready_.front ()->fd );
+            ready_.pop_front ();
+          }
+          return;
+        }
+        client = std::move ( ready_.front () );
+        ready_.pop_front ();
+      }
+
+      if ( serve ( *client ) )
+      {
+        {
+          std::lock_guard<std::mutex> guard{ lock_ };
+          returned_.push_back ( std::move ( client ) );
+        }
+        const char byte{ 0 };
+        static_cast<void>( ::write ( wake_pipe_[1], &byte, 1 ) );
+      }
+      else
+      {
+        ::close ( client->fd );
+      }
+    }
+  }
+
+  /**
+   * @brief Answers the requests a client has sent, as far as it reads the
+   * answers, without ever waiting on its socket.
+   *
+   * New input is only read once every earlier answer is written, so a
+   * client that does not read holds back no more than a socket buffer of
+   * requests.
+   *
+   * @param[in,out] client The client.
+   * @returns \c false if the client is done and must be closed.
+   */
+  bool serve ( client_struct& client )
+  {
+    if ( !is_sending ( client ) && !client.is_input_done )
+    {
+      char buffer[SOCKET_READ_SIZE];
+      for ( ;; )
+      {
+        const auto bytes_read{
+            ::read ( client.fd, buffer, sizeof ( buffer ) )
+        };
+        if ( bytes_read > 0 )
+        {
+          client.input.append (
+              buffer,
+              static_cast<std::size_t>( bytes_read )
+          );
+          continue;
+        }
+        if ( bytes_read < 0 && errno == EINTR )
+        {
+          continue;
+        }
+        if ( bytes_read < 0 && errno != EAGAIN && errno != EWOULDBLOCK )
+        {
+          return ( false );
+        }
+        client.is_input_done = bytes_read == 0;
+        break;
+      }
+    }
+
+    std::size_t start{ 0 };
+    auto end{ client.input.find ( '\n' ) };
+    for ( ;; )
+    {
+      client.output.erase ( 0, client.output_sent );
+      client.output_sent = 0;
+      if ( client.output.empty () )
+      {
+        client.last_progress = Clock::now ();
+      }
+      for (
+          ;
+          end != std::string::npos
+          && client.output.size () < MAX_PENDING_OUTPUT;
+          start = end + 1, end = client.input.find ( '\n', start )
+      )
+      {
+        client.output += answer ( client.input.substr ( start, end - start ) );
+      }
+      if ( !flush ( client ) )
+      {
+        return ( false );
+      }
+      if ( end == std::string::npos || is_sending ( client ) )
+      {
+        break;
+      }
+    }
+    client.input.erase ( 0, start );
+
+    if ( end == std::string::npos && client.input.size () > MAX_REQUEST_CHARS )
+    {
+      client.output += "ERR Request too long\n";
+      flush ( client );
+      return ( false );
+    }
+    return ( is_sending ( client ) || !client.is_input_done );
+  }
+
+  /**
+   * @brief Writes as much of a client's output as its socket takes now.
+   *
+   * @param[in,out] client The client.
+   * @returns \c false if the socket failed.
+   */
+  static bool flush ( client_struct& client )
+  {
+    while ( is_sending ( client ) )
+    {
+      const auto n{
+          ::write (
+              client.fd,
+              client.output.data () + client.output_sent,
+              client.output.size () - client.output_sent
+          )
+      };
+      if ( n >= 0 )
+      {
+        client.output_sent += static_cast<std::size_t>( n );
+        client.last_progress = Clock::now ();
+      }
+      else if ( errno == EAGAIN || errno == EWOULDBLOCK )
+      {
+        return ( true );
+      }
+      else if ( errno != EINTR )
+      {
+        return ( false );
+      }
+    }
+    client.output.clear ();
+    client.output_sent = 0;
+    return ( true );
+  }
+
+  /**
+   * @brief Answers one request.
+   *
+   * @param[in] request The request line, without its newline.
+   * @returns The response, with its status line.
+   */
+  std::string answer ( const std::string& request )
+  {
+    std::istringstream fields{ request };
+    std::string format{};
+    std::uint64_t offset{};
+    std::uint64_t length{};
+    fields >> format >> offset >> length >> std::ws;
+    std::string filename{};
+    std::getline ( fields, filename );
+    if ( !fields && !fields.eof () )
+    {
+      return ( "ERR Expected '<format> <offset> <length> <file>'\n" );
+    }
+    if ( filename.empty () )
+    {
+      return ( "ERR No file given\n" );
+    }
+    if (
+        std::find_if (
+            std::begin ( SERVED_FORMATS ),
+            std::end ( SERVED_FORMATS ),
+            [&] ( const char* f ) { return ( format == f ); }
+        ) == std::end ( SERVED_FORMATS )
+    )
+    {
+      return ( "ERR Unknown or unserved format '" + format + "'\n" );
+    }
+    if ( length > MAX_RANGE_BYTES )
+    {
+      return (
+          "ERR Length above " + std::to_string ( MAX_RANGE_BYTES ) + "\n"
+      );
+    }
+
+    try
+    {
+      const auto text{ format_range ( format, offset, length, filename ) };
+      return ( "OK " + std::to_string ( text.size () ) + "\n" + text );
+    }
+    catch ( const std::exception& e )
+    {
+      return ( std::string{ "ERR " } + e.what () + "\n" );
+    }
+  }
+
+  /**
+   * @brief Formats the lines of a file overlapping a range.
+   *
+   * @param[in] format One of SERVED_FORMATS.
+   * @param[in] offset The first byte of the range.
+   * @param[in] length The number of bytes in the range.
+   * @param[in] filename The file.
+   * @returns The formatted text.
+   */
+  std::string format_range (
+      const std::string& format,
+      std::uint64_t offset,
+      std::uint64_t length,
+      const std::string& filename
+  )
+  {
+    const auto path{ resolve ( filename ) };
+    struct stat info{};
+    if ( ::stat ( path.c_str (), &info ) < 0 )
+    {
+      throw_errno ( filename );
+    }
+    auto file{ files_.find ( path ) };
+    if ( !file || !file->is_current ( info ) )
+    {
+      file = std::make_shared<const ServedFile> ( path );
+      files_.insert ( path, file, 1 );
+    }
+    if ( offset > file->size () )
+    {
+      throw std::out_of_range{ "Offset past the end of the file" };
+    }
+    const auto end{ std::min ( file->size (), offset + length ) };
+    if ( end == offset )
+    {
+      return ( std::string{} );
+    }
+
+    const auto line_bytes{ make_encoder ( format )->line_bytes () };
+    const auto page_bytes{ line_bytes * PAGE_LINES };
+    const auto first_page{ offset / page_bytes };
+    const auto last_page{ ( end - 1 ) / page_bytes };
+    std::string text{};
+    for ( auto p{ first_page }; p <= last_page; ++p )
+    {
+      const auto page{ format_page ( format, path, *file, p, page_bytes ) };
+      const auto page_start{ p * page_bytes };
+
+      std::size_t from{ 0 };
+      if ( p == first_page )
+      {
+        from = skip_lines ( *page, 0, ( offset - page_start ) / line_bytes );
+      }
+      auto to{ page->size () };
+      if ( p == last_page && end < file->size () )
+      {
+        to = skip_lines ( *page, 0, ( end - 1 - page_start ) / line_bytes + 1 );
+      }
+      text.append ( *page, from, to - from );
+    }
+    return ( text );
+  }
+
+  /**
+   * @brief Resolves a requested file under the root.
+   *
+   * @param[in] filename The file, under the root or relative to it.
+   * @returns Its path with no symbolic links or dot parts.
+   * @throws std::system_error If it does not exist or is outside the root.
+   */
+  std::string resolve ( const std::string& filename ) const
+  {
+    std::error_code ec{};
+    const auto path{ std::filesystem::canonical ( root_ / filename, ec ) };
+    if ( ec )
+    {
+      throw std::system_error{ ec, filename };
+    }
+    // The path is inside the root when the root is all a prefix of it.
+    const auto [in_root, in_path]{
+        std::mismatch (
+            root_.begin (),
+            root_.end (),
+            path.begin (),
+            path.end ()
+        )
+    };
+    if ( in_root != root_.end () )
+    {
+      throw std::system_error{
+          std::make_error_code ( std::errc::permission_denied ),
+          filename + " is outside the served directory"
+      };
+    }
+    return ( path.string () );
+  }
+
+  //! Finds the position after a number of lines of text.
+  static std::size_t skip_lines (
+      const std::string& text,
+      std::size_t from,
+      std::uint64_t lines
+  )
+  {
+    for ( ; lines && from < text.size (); --lines )
+    {
+      const auto end{ text.find ( '\n', from ) };
+      from = end == std::string::npos ? text.size () : end + 1;
+    }
+    return ( from );
+  }
+
+  std::shared_ptr<const std::string> format_page (
+      const std::string& format,
+      const std::string& path,
+      const ServedFile& file,
+      std::uint64_t page,
+      std::uint64_t page_bytes
+  )
+  {
+    auto key{ format };
+    key += '\0';
+    key += std::to_string ( page );
+    key += '\0';
+    key += file.version ();
+    key += '\0';
+    key += path;
+    auto text{ pages_.find ( key ) };
+    if ( text )
+    {
+      return ( text );
+    }
+
+    const auto start{ page * page_bytes };
+    const auto size{ std::min ( page_bytes, file.size () - start ) };
+    std::vector<unsigned char> bytes( static_cast<std::size_t>( size ) );
+    file.read ( start, bytes.size (), bytes.data () );
+    const auto encoder{ make_encoder ( format ) };
+    TextBuffer buffer{};
+    encoder->start_at ( start );
+    encoder->encode ( bytes.data (), bytes.size (), buffer );
+    if ( start + size == file.size () )
+    {
+      encoder->finish ( buffer );
+    }
+    text = std::make_shared<const std::string> (
+        buffer.data (),
+        buffer.size ()
+    );
+    pages_.insert ( key, text, text->size () );
+    return ( text );
+  }
+
+  static inline volatile std::sig_atomic_t is_signalled_{};
+  static inline volatile int wake_fd_{ -1 };
+
+  std::string socket_path_;
+  std::filesystem::path root_;
+  unsigned num_workers_;
+  int listen_fd_{ -1 };
+  int wake_pipe_[2]{ -1, -1 };
+  LruCache<ServedFile> files_;
+  LruCache<std::string> pages_;
+
+  std::vector<Client> idle_{};
+  std::mutex lock_{};
+  std::condition_variable ready_signal_{};
+  std::deque<Client> ready_{};
+  std::vector<Client> returned_{};
+  bool is_stopping_{};
+};
+#endif /* _WIN32 */
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief A read-only server of formatted file ranges on a Unix socket.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
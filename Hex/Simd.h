@@ -0,0 +1,57 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Simd.h
+// SYNOPSIS : The vector instruction sets the encoders are compiled for.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// SYSTEM /////////////////////////////////////////////////////////////////////
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) \
+    || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define HEX_HAVE_SSE2
+#include <emmintrin.h>
+#endif /* SSE2 */
+
+// Without SSSE3 enabled for the whole build, its kernels are compiled for it
+// alone and chosen at run time when the processor has it.
+#if defined( HEX_HAVE_SSE2 ) && ( defined( __SSSE3__ ) || defined( __AVX__ ) )
+#define HEX_HAVE_SSSE3
+#define HEX_SSSE3_TARGET
+#include <tmmintrin.h>
+#elif defined( HEX_HAVE_SSE2 ) && ( defined( __GNUC__ ) || defined( _MSC_VER ) )
+#define HEX_HAVE_SSSE3
+#define HEX_SSSE3_DISPATCH
+#ifdef _MSC_VER
+#define HEX_SSSE3_TARGET
+#include <intrin.h>
+#else
+#define HEX_SSSE3_TARGET __attribute__(( target( "ssse3" ) ))
+#endif /* _MSC_VER */
+#include <tmmintrin.h>
+#endif /* SSSE3 */
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief The vector instruction sets the encoders are compiled for.
+ *
+ * \c HEX_HAVE_SSE2 and \c HEX_HAVE_SSSE3 are defined for the instruction
+ * sets kernels may use. With \c HEX_SSSE3_DISPATCH also defined, SSSE3 is
+ * not enabled for the whole build, so its kernels are marked
+ * \c HEX_SSSE3_TARGET and only called once the processor is found to have
+ * it.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
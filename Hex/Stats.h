@@ -0,0 +1,339 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Stats.h
+// SYNOPSIS : Counters for reporting where the time of a run goes.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// SYSTEM /////////////////////////////////////////////////////////////////////
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+///////////////////////////////////////////////////////////////////////////////
+
+//! Names of the phases of a run, in report order.
+const char* const PHASE_NAMES[]{ "read", "format", "write" };
+
+//! Nanoseconds in a second.
+const double NANOSECONDS_PER_SECOND{ 1e9 };
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CLASSES
+///////////////////////////////////////////////////////////////////////////////
+
+//! A phase of a run.
+enum class PhaseEnum
+{
+  Read,   ///< Reading input, including any wait for the rate limit.
+  Format, ///< Encoding input as text.
+  Write,  ///< Writing text to the output.
+  Count   ///< The number of phases.
+};
+
+
+/**
+ * @brief Time, calls, bytes, and system calls of each phase of a run.
+ *
+ * Workers add to the same counters with relaxed atomics, so the time of a
+ * phase is summed over the threads in it and can exceed the wall time; the
+ * report labels it so. System calls are counted on each thread on its own,
+ * from its counters in \c /proc/thread-self/io , read when a phase starts
+ * and ends, so each phase gets only the calls its own thread made in it.
+ * Nothing here is touched unless statistics were asked for.
+ */
+class RunStats final
+{
+public:
+  //! The clock phases are timed with.
+  using Clock = std::chrono::steady_clock;
+
+  //! Starts the wall clock.
+  RunStats ()
+    : start_{ Clock::now () }
+  {
+  }
+
+  /**
+   * @brief Starts timing phases on the calling thread.
+   *
+   * @returns The time the first phase starts, for add().
+   */
+  Clock::time_point start ()
+  {
+    last_syscalls () = thread_syscalls ();
+    return ( Clock::now () );
+  }
+
+  /**
+   * @brief Adds one call of a phase, ended on the thread that started it.
+   *
+   * @param[in] phase The phase.
+   * @param[in] since When the call started, from start() or the previous
+   * add() on the same thread.
+   * @param[in] bytes The bytes it handled.
+   * @returns The time the call ended, for timing the next phase. Reading
+   * the system call counters is left out of every phase.
+   */
+  Clock::time_point add (
+      PhaseEnum phase,
+      Clock::time_point since,
+      std::uint64_t bytes
+  )
+  {
+    const auto now{ Clock::now () };
+    auto& p{ phases_[static_cast<std::size_t>( phase )] };
+    p.nanoseconds.fetch_add (
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                now - since
+            ).count ()
+        ),
+        std::memory_order_relaxed
+    );
+    p.calls.fetch_add ( 1, std::memory_order_relaxed );
+    p.bytes.fetch_add ( bytes, std::memory_order_relaxed );
+
+    // Each reading of the counters is itself one read system call, which
+    // the next reading includes.
+    const auto syscalls{ thread_syscalls () };
+    auto& last{ last_syscalls () };
+    if ( syscalls < 0 || last < 0 )
+    {
+      is_syscalls_known_.store ( false, std::memory_order_relaxed );
+    }
+    else
+    {
+      p.syscalls.fetch_add (
+          static_cast<std::uint64_t>( syscalls - last - 1 ),
+          std::memory_order_relaxed
+      );
+    }
+    last = syscalls;
+    return ( syscalls < 0 ? now : Clock::now () );
+  }
+
+  /**
+   * @brief Writes the report.
+   *
+   * @param[in] is_json Whether to write JSON rather than text.
+   * @param[in] out The stream to write to.
+   */
+  void report ( bool is_json, std::ostream& out ) const
+  {
+    const std::chrono::duration<double> wall{ Clock::now () - start_ };
+    const auto peak_rss_kib{ read_peak_rss_kib () };
+    const auto is_syscalls_known{
+        is_syscalls_known_.load ( std::memory_order_relaxed )
+    };
+    const auto input_bytes{
+        phase_value ( PhaseEnum::Read, &phase_struct::bytes )
+    };
+    const auto megabytes_per_second{
+        wall.count () > 0.0 ? input_bytes / wall.count () / 1e6 : 0.0
+    };
+
+    if ( is_json )
+    {
+      out << "{ \"wall_seconds\": " << wall.count ();
+      for ( std::size_t i{ 0 }; i < std::size ( PHASE_NAMES ); ++i )
+      {
+        const auto phase{ static_cast<PhaseEnum>( i ) };
+        out << ", \"" << PHASE_NAMES[i] << "\": { \"thread_seconds\": "
+            << seconds ( phase ) << ", \"calls\": "
+            << phase_value ( phase, &phase_struct::calls )
+            << ", \"bytes\": "
+            << phase_value ( phase, &phase_struct::bytes );
+        if ( is_syscalls_known )
+        {
+          out << ", \"syscalls\": "
+              << phase_value ( phase, &phase_struct::syscalls );
+        }
+        out << " }";
+      }
+      out << ", \"megabytes_per_second\": " << megabytes_per_second;
+      if ( peak_rss_kib )
+      {
+        out << ", \"peak_rss_kib\": " << peak_rss_kib;
+      }
+      out << " }\n";
+      return;
+    }
+
+    out << "wall     " << wall.count () << " s, " << megabytes_per_second
+        << " MB/s\n";
+    for ( std::size_t i{ 0 }; i < std::size ( PHASE_NAMES ); ++i )
+    {
+      const auto phase{ static_cast<PhaseEnum>( i ) };
+      out << PHASE_NAMES[i]
+          << std::string ( 9 - std::strlen ( PHASE_NAMES[i] ), ' ' )
+          << seconds ( phase ) << " s summed over threads, "
+          << phase_value ( phase, &phase_struct::calls ) << " calls, "
+          << phase_value ( phase, &phase_struct::bytes ) << " bytes";
+      if ( is_syscalls_known )
+      {
+        out << ", " << phase_value ( phase, &phase_struct::syscalls )
+            << " syscalls";
+      }
+      out << "\n";
+    }
+    if ( peak_rss_kib )
+    {
+      out << "peak RSS " << peak_rss_kib << " KiB\n";
+    }
+  }
+
+private:
+  struct phase_struct
+  {
+    std::atomic<std::uint64_t> nanoseconds{};
+    std::atomic<std::uint64_t> calls{};
+    std::atomic<std::uint64_t> bytes{};
+    std::atomic<std::uint64_t> syscalls{};
+  };
+
+#ifdef __linux__
+  //! The calling thread's \c /proc/thread-self/io , kept open.
+  struct thread_io_struct
+  {
+    int fd{ ::open ( "/proc/thread-self/io", O_RDONLY | O_CLOEXEC ) };
+
+    ~thread_io_struct ()
+    {
+      if ( fd >= 0 )
+      {
+        ::close ( fd );
+      }
+    }
+  };
+#endif /* __linux__ */
+
+  std::uint64_t phase_value (
+      PhaseEnum phase,
+      std::atomic<std::uint64_t> phase_struct::* member
+  ) const
+  {
+    return (
+        ( phases_[static_cast<std::size_t>( phase )].*member ).load (
+            std::memory_order_relaxed
+        )
+    );
+  }
+
+  double seconds ( PhaseEnum phase ) const
+  {
+    return (
+        phase_value ( phase, &phase_struct::nanoseconds )
+        / NANOSECONDS_PER_SECOND
+    );
+  }
+
+  //! The calling thread's counters at its last start() or add().
+  static std::int64_t& last_syscalls ()
+  {
+    thread_local std::int64_t last{ -1 };
+    return ( last );
+  }
+
+  /**
+   * @brief Reads the read and write system calls the calling thread has made.
+   *
+   * They come from \c /proc/thread-self/io , so they are only known on
+   * Linux.
+   *
+   * @returns The count, or -1 if it is not known.
+   */
+  static std::int64_t thread_syscalls ()
+  {
+#ifdef __linux__
+    thread_local const thread_io_struct io{};
+    if ( io.fd < 0 )
+    {
+      return ( -1 );
+    }
+    char text[512];
+    const auto size{ ::pread ( io.fd, text, sizeof ( text ) - 1, 0 ) };
+    if ( size <= 0 )
+    {
+      return ( -1 );
+    }
+    text[size] = '\0';
+    const auto* const reads{ std::strstr ( text, "syscr:" ) };
+    const auto* const writes{ std::strstr ( text, "syscw:" ) };
+    if ( !reads || !writes )
+    {
+      return ( -1 );
+    }
+    return (
+        static_cast<std::int64_t>(
+            std::strtoull ( reads + 6, nullptr, 10 )
+            + std::strtoull ( writes + 6, nullptr, 10 )
+        )
+    );
+#else
+    return ( -1 );
+#endif /* __linux__ */
+  }
+
+  //! Reads the largest resident set size, in kibibytes, or zero.
+  static std::uint64_t read_peak_rss_kib ()
+  {
+    std::uint64_t peak_rss_kib{};
+#ifndef _WIN32
+    rusage usage{};
+    if ( ::getrusage ( RUSAGE_SELF, &usage ) == 0 )
+    {
+#ifdef __APPLE__
+      peak_rss_kib = static_cast<std::uint64_t>( usage.ru_maxrss ) >> 10;
+#else
+      peak_rss_kib = static_cast<std::uint64_t>( usage.ru_maxrss );
+#endif /* __APPLE__ */
+    }
+#endif /* _WIN32 */
+    return ( peak_rss_kib );
+  }
+
+  Clock::time_point start_;
+  std::atomic<bool> is_syscalls_known_{ true };
+  std::array<phase_struct, static_cast<std::size_t>( PhaseEnum::Count )>
+      phases_{};
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Counters for reporting where the time of a run goes.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
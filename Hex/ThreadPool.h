@@ -0,0 +1,107 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : ThreadPool.h
+// SYNOPSIS : A small thread pool running a batch of tasks in order.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+
+#include "PCH.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CLASSES
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Runs a fixed batch of indexed tasks over a set of worker threads.
+ *
+ * Each worker takes the next index from a shared counter whenever it is
+ * free, so tasks start in index order and a few large files cannot leave
+ * the rest of the workers idle.
+ */
+class ThreadPool final
+{
+public:
+  //! The callable invoked for each task index.
+  using Task = std::function<void ( std::size_t )>;
+
+  /**
+   * @brief Starts the workers for a batch of tasks.
+   *
+   * @param[in] num_workers Number of worker threads, at least one is used.
+   * @param[in] num_tasks Number of task indices to run, from zero.
+   * @param[in] task The callable to invoke for each task index.
+   */
+  ThreadPool ( unsigned num_workers, std::size_t num_tasks, Task task )
+    : task_{ std::move ( task ) },
+      num_tasks_{ num_tasks }
+  {
+    const auto count{ std::max ( num_workers, 1U ) };
+    workers_.reserve ( count );
+    for ( unsigned w{ 0 }; w < count; ++w )
+    {
+      workers_.emplace_back ( [this] () { work (); } );
+    }
+  }
+
+  ThreadPool ( const ThreadPool& ) = delete;
+  ThreadPool& operator= ( const ThreadPool& ) = delete;
+
+  //! Waits for every task of the batch to finish.
+  ~ThreadPool ()
+  {
+    join ();
+  }
+
+  //! Waits for every task of the batch to finish.
+  void join ()
+  {
+    for ( auto& t : workers_ )
+    {
+      if ( t.joinable () )
+      {
+        t.join ();
+      }
+    }
+  }
+
+private:
+  void work ()
+  {
+    for (
+        auto index{ next_.fetch_add ( 1 ) };
+        index < num_tasks_;
+        index = next_.fetch_add ( 1 )
+    )
+    {
+      task_ ( index );
+    }
+  }
+
+  Task task_;
+  std::size_t num_tasks_;
+  std::atomic<std::size_t> next_{ 0 };
+  std::vector<std::thread> workers_{};
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief A small thread pool running a batch of tasks in order.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
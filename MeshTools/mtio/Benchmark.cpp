@@ -0,0 +1,560 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Benchmark.cpp
+// SYNOPSIS : Compares loading MT files with mtio against reading streams.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// STANDARD LIBRARY ///////////////////////////////////////////////////////////
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// OPERATING SYSTEM ///////////////////////////////////////////////////////////
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+// BOOST //////////////////////////////////////////////////////////////////////
+#include <boost/program_options.hpp>
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "MtIo.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CONSTANTS
+///////////////////////////////////////////////////////////////////////////////
+
+//! The exit code if there is any problem with command line arguments.
+const auto EXIT_COMMAND_LINE_ERROR{ 1 };
+
+//! The exit code if a benchmark file could not be written or read.
+const auto EXIT_FILE_ERROR{ 2 };
+
+//! The exit code if no errors were encountered.
+const auto EXIT_SUCCESSFUL{ 0 };
+
+//! The vertex counts of the meshes benchmarked unless told otherwise.
+const std::vector<std::uint32_t> DEFAULT_VERTICES{
+    65'536, 1'048'576, 8'388'608
+};
+
+//! Bytes in a MiB.
+const double BYTES_PER_MIB{ 1'048'576.0 };
+
+//! The thirteen \c float of the material written to benchmark files.
+const float MATERIAL[13]{
+    0.2473f, 0.1995f, 0.0745f, 1.0f,
+    0.7516f, 0.6065f, 0.2265f, 1.0f,
+    0.6283f, 0.5558f, 0.3661f, 1.0f,
+    51.2f
+};
+
+
+//! Where the sums of everything read end up.
+volatile std::uint64_t touched_sum{};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// STRUCTS
+///////////////////////////////////////////////////////////////////////////////
+
+//! Sections of an MT file read into vectors, as hand-rolled readers do.
+struct loaded_mesh_struct
+{
+  //! The header.
+  MtFormat::header_struct header{};
+  //! The section table.
+  std::vector<MtFormat::section_struct> sections{};
+  //! The bytes of each section.
+  std::vector<std::vector<std::byte>> data{};
+};
+
+
+//! The milliseconds one way of loading took, best of all repeats.
+struct timing_struct
+{
+  //! Until the sections could be used.
+  double open_ms{};
+  //! Until every byte of every section had been read once.
+  double touch_ms{};
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Writes a mesh of random triangles as an MT file.
+ *
+ * Compressed files hold positions that wander as scanned surfaces do, and
+ * indices of neighbouring vertices, so that they compress as real meshes
+ * do rather than as noise.
+ *
+ * @param[in] filename The file to write.
+ * @param[in] num_vertices The number of vertices.
+ * @param[in] is_compressed Whether sections are compressed.
+ * @returns \c true if the file was written.
+ */
+bool make_input (
+    const std::string& filename,
+    std::uint32_t num_vertices,
+    bool is_compressed
+)
+{
+  std::mt19937 random{ num_vertices };
+  std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+  std::vector<float> positions( num_vertices * std::size_t{ 3 } );
+  std::vector<float> normals( positions.size () );
+  std::vector<float> tex_coords( num_vertices * std::size_t{ 2 } );
+  const auto next_unit{ [&] () { return ( unit ( random ) ); } };
+  std::generate ( positions.begin (), positions.end (), next_unit );
+  std::generate ( normals.begin (), normals.end (), next_unit );
+  std::generate ( tex_coords.begin (), tex_coords.end (), next_unit );
+  std::vector<std::uint32_t> indices( num_vertices * std::size_t{ 2 } * 3 );
+  std::uniform_int_distribution<std::uint32_t> vertex{ 0, num_vertices - 1 };
+  std::generate (
+      indices.begin (),
+      indices.end (),
+      [&] () { return ( vertex ( random ) ); }
+  );
+  if ( is_compressed )
+  {
+    for ( std::size_t i{ 3 }; i < positions.size (); ++i )
+    {
+      positions[i] = positions[i - 3] + 0.001f * ( positions[i] - 0.5f );
+    }
+    for ( std::size_t i{ 0 }; i < indices.size (); ++i )
+    {
+      indices[i] = static_cast<std::uint32_t>(
+          ( i / 6 + indices[i] % 4 ) % num_vertices
+      );
+    }
+  }
+
+  MtFormat::Writer writer{};
+  writer.add (
+      MtFormat::SectionEnum::Positions,
+      MtFormat::FormatEnum::Float32x3,
+      positions.data (),
+      num_vertices
+  );
+  writer.add (
+      MtFormat::SectionEnum::Normals,
+      MtFormat::FormatEnum::Float32x3,
+      normals.data (),
+      num_vertices
+  );
+  writer.add (
+      MtFormat::SectionEnum::TexCoords,
+      MtFormat::FormatEnum::Float32x2,
+      tex_coords.data (),
+      num_vertices
+  );
+  writer.add (
+      MtFormat::SectionEnum::Materials,
+      MtFormat::FormatEnum::Material,
+      MATERIAL,
+      1
+  );
+  writer.add (
+      MtFormat::SectionEnum::Indices,
+      MtFormat::FormatEnum::Uint32,
+      indices.data (),
+      indices.size ()
+  );
+
+  if ( is_compressed )
+  {
+    writer.compress ();
+  }
+
+  std::ofstream output{ filename, std::ios_base::binary };
+  writer.write (
+      output,
+      MtFormat::header_struct{
+          .num_vertices{ num_vertices },
+          .num_indices{ static_cast<std::uint32_t>( indices.size () ) },
+          .bounds_min{ 0.0f, 0.0f, 0.0f },
+          .bounds_max{ 1.0f, 1.0f, 1.0f }
+      }
+  );
+  output.close ();
+  return ( !output.fail () );
+}
+
+
+/**
+ * @brief Asks the operating system to drop a file from the page cache.
+ *
+ * @param[in] filename The file.
+ * @returns \c false where cold runs are not possible.
+ */
+bool drop_cached ( const std::string& filename )
+{
+#ifndef _WIN32
+  const auto fd{ ::open ( filename.c_str (), O_RDONLY | O_CLOEXEC ) };
+  if ( fd < 0 )
+  {
+    return ( false );
+  }
+  ::fdatasync ( fd );
+  const auto result{ ::posix_fadvise ( fd, 0, 0, POSIX_FADV_DONTNEED ) };
+  ::close ( fd );
+  return ( result == 0 );
+#else
+  static_cast<void>( filename );
+  return ( false );
+#endif /* _WIN32 */
+}
+
+
+/**
+ * @brief Reads an MT file with a stream into vectors.
+ *
+ * @param[in] filename The file.
+ * @returns The sections.
+ * @throws std::runtime_error If the file cannot be read.
+ */
+loaded_mesh_struct load_stream ( const std::string& filename )
+{
+  loaded_mesh_struct mesh{};
+  std::ifstream input{ filename, std::ios_base::binary };
+  input.read (
+      reinterpret_cast<char*>( &mesh.header ),
+      sizeof ( mesh.header )
+  );
+  mesh.sections.resize ( mesh.header.num_sections );
+  input.seekg ( mesh.header.header_bytes );
+  input.read (
+      reinterpret_cast<char*>( mesh.sections.data () ),
+      mesh.sections.size () * sizeof ( MtFormat::section_struct )
+  );
+  for ( const auto& section : mesh.sections )
+  {
+    auto& data{ mesh.data.emplace_back ( section.bytes ) };
+    input.seekg ( static_cast<std::streamoff>( section.offset ) );
+    input.read (
+        reinterpret_cast<char*>( data.data () ),
+        static_cast<std::streamsize>( data.size () )
+    );
+  }
+  if ( !input )
+  {
+    throw std::runtime_error{ "Cannot read '" + filename + "'" };
+  }
+  return ( mesh );
+}
+
+
+/**
+ * @brief Reads every byte once, as uploading them would.
+ *
+ * @param[in] bytes The bytes.
+ * @returns A sum of them, so the reads are not optimised away.
+ */
+std::uint64_t touch ( std::span<const std::byte> bytes )
+{
+  std::uint64_t sum{ 0 };
+  for ( const auto b : bytes )
+  {
+    sum += static_cast<std::uint64_t>( b );
+  }
+  return ( sum );
+}
+
+
+/**
+ * @brief Decodes every section of a file into vectors, the chunks of each
+ * shared between all hardware threads.
+ *
+ * @param[in] mesh The file.
+ * @returns The sections.
+ */
+std::vector<std::vector<std::byte>> decode_all ( const MtIo::MtFile& mesh )
+{
+  std::vector<std::vector<std::byte>> data{};
+  const auto workers{ std::max ( std::thread::hardware_concurrency (), 1U ) };
+  for ( const auto& section : mesh.sections () )
+  {
+    auto& decoded{
+        data.emplace_back ( std::size_t{ section.count } * section.stride )
+    };
+    const auto chunks{ mesh.chunk_count ( section ) };
+    std::vector<std::jthread> threads{};
+    for ( auto w{ 0U }; w < std::min<std::size_t> ( workers, chunks ); ++w )
+    {
+      threads.emplace_back (
+          [&mesh, &section, &decoded, chunks, workers, w] ()
+          {
+            for ( std::size_t c{ w }; c < chunks; c += workers )
+            {
+              mesh.decode_chunk ( section, c, decoded );
+            }
+          }
+      );
+    }
+  }
+  return ( data );
+}
+
+
+/**
+ * @brief Times one way of loading a file.
+ *
+ * @param[in] filename The file.
+ * @param[in] method \c "stream" , \c "mtio" , \c "mtio-checksum" , or
+ * \c "mtio-decode" for a compressed file.
+ * @param[in] is_cold Whether the file is dropped from the page cache first.
+ * @param[in] repeat The number of times to load it.
+ * @param[in,out] sink Accumulates the sums of touch().
+ * @returns The best times.
+ */
+timing_struct time_load (
+    const std::string& filename,
+    const std::string& method,
+    bool is_cold,
+    unsigned repeat,
+    std::uint64_t& sink
+)
+{
+  using Clock = std::chrono::steady_clock;
+  const auto milliseconds{
+      [] ( Clock::time_point from, Clock::time_point to )
+      {
+        return (
+            std::chrono::duration<double, std::milli>( to - from ).count ()
+        );
+      }
+  };
+
+  timing_struct best{ 1e300, 1e300 };
+  for ( auto r{ 0U }; r < repeat; ++r )
+  {
+    if ( is_cold )
+    {
+      drop_cached ( filename );
+    }
+    const auto start{ Clock::now () };
+    Clock::time_point opened{};
+    if ( method == "stream" )
+    {
+      const auto mesh{ load_stream ( filename ) };
+      opened = Clock::now ();
+      for ( const auto& data : mesh.data )
+      {
+        sink += touch ( data );
+      }
+    }
+    else if ( method == "mtio-decode" )
+    {
+      const MtIo::MtFile mesh{ filename };
+      const auto data{ decode_all ( mesh ) };
+      opened = Clock::now ();
+      for ( const auto& section : data )
+      {
+        sink += touch ( section );
+      }
+    }
+    else
+    {
+      const MtIo::MtFile mesh{
+          filename,
+          method == "mtio-checksum"
+              ? MtIo::ValidationEnum::Checksum
+              : MtIo::ValidationEnum::Structure
+      };
+      opened = Clock::now ();
+      for ( const auto& section : mesh.sections () )
+      {
+        sink += touch ( mesh.bytes ( section ) );
+      }
+    }
+    const auto touched{ Clock::now () };
+    best.open_ms = std::min ( best.open_ms, milliseconds ( start, opened ) );
+    best.touch_ms = std::min ( best.touch_ms, milliseconds ( start, touched ) );
+  }
+  return ( best );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DRIVER
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief The benchmark driver function.
+ *
+ * @param[in] argc The argument count.
+ * @param[in] argv The command-line arguments.
+ * @returns An integer exit code.
+ */
+int main ( int argc, char* argv[] )
+{
+  boost::program_options::options_description description{
+      "Benchmark [options]"
+  };
+  bool is_help{ false };
+  bool is_keep{ false };
+  description.add_options ()
+    (
+      "help,h",
+      boost::program_options::bool_switch ( &is_help ),
+      "Display help message\n"
+    )
+    (
+      "vertices,v",
+      boost::program_options::value<std::vector<std::uint32_t>> ()
+          ->multitoken ()
+          ->default_value ( DEFAULT_VERTICES, "65536 1048576 8388608" ),
+      "Vertex counts of the meshes loaded"
+    )
+    (
+      "repeat,r",
+      boost::program_options::value<unsigned> ()->default_value ( 5 ),
+      "Times each load is repeated, the best being reported"
+    )
+    (
+      "directory,d",
+      boost::program_options::value<std::string> ()->default_value ( "." ),
+      "Directory to write the benchmark files in"
+    )
+    (
+      "keep,k",
+      boost::program_options::bool_switch ( &is_keep ),
+      "Keep the benchmark files"
+    );
+
+  boost::program_options::variables_map vm{};
+  try
+  {
+    store (
+        boost::program_options::parse_command_line ( argc, argv, description ),
+        vm
+    );
+    notify ( vm );
+  }
+  catch ( const std::exception& e )
+  {
+    std::cerr << e.what () << "\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if ( is_help )
+  {
+    std::cout << description;
+    return ( EXIT_SUCCESSFUL );
+  }
+
+  const auto repeat{ std::max ( vm["repeat"].as<unsigned> (), 1U ) };
+  const std::filesystem::path directory{ vm["directory"].as<std::string> () };
+  std::uint64_t sink{ 0 };
+
+  std::cout << std::setw ( 10 ) << "vertices" << std::setw ( 10 ) << "MiB"
+      << std::setw ( 15 ) << "method" << std::setw ( 6 ) << "cache"
+      << std::setw ( 12 ) << "open ms" << std::setw ( 12 ) << "touch ms"
+      << "\n";
+  const auto& vertex_counts{ vm["vertices"].as<std::vector<std::uint32_t>> () };
+  for ( const auto num_vertices : vertex_counts )
+  {
+    for ( const auto is_compressed : { false, true } )
+    {
+      const auto filename{
+          ( directory
+            / ( "mtio-benchmark." + std::to_string ( num_vertices )
+                + ( is_compressed ? ".z.mt" : ".mt" ) )
+          ).string ()
+      };
+      if (
+          num_vertices == 0
+          || !make_input ( filename, num_vertices, is_compressed )
+      )
+      {
+        std::cerr << "Cannot write '" << filename << "' !\n";
+        return ( EXIT_FILE_ERROR );
+      }
+      const auto mib{
+          std::filesystem::file_size ( filename ) / BYTES_PER_MIB
+      };
+      const auto methods{
+          is_compressed
+              ? std::vector<const char*>{ "mtio-decode" }
+              : std::vector<const char*>{ "stream", "mtio", "mtio-checksum" }
+      };
+
+      try
+      {
+        for ( const auto is_cold : { false, true } )
+        {
+          if ( is_cold && !drop_cached ( filename ) )
+          {
+            continue;
+          }
+          for ( const auto* method : methods )
+          {
+            const auto timing{
+                time_load ( filename, method, is_cold, repeat, sink )
+            };
+            std::cout << std::setw ( 10 ) << num_vertices << std::setw ( 10 )
+                << std::fixed << std::setprecision ( 1 ) << mib
+                << std::setw ( 15 ) << method << std::setw ( 6 )
+                << ( is_cold ? "cold" : "hot" ) << std::setw ( 12 )
+                << std::setprecision ( 3 ) << timing.open_ms
+                << std::setw ( 12 ) << timing.touch_ms << "\n";
+          }
+        }
+      }
+      catch ( const std::exception& e )
+      {
+        std::cerr << e.what () << "\n";
+        return ( EXIT_FILE_ERROR );
+      }
+
+      if ( !is_keep )
+      {
+        std::filesystem::remove ( filename );
+      }
+    }
+  }
+
+  // Keeps the sums, and so the reads, from being optimised away.
+  touched_sum = sink;
+  return ( EXIT_SUCCESSFUL );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Compares loading MT files with mtio against reading streams.
+ *
+ * For each mesh size a file of random triangles is written, then loaded by
+ * reading each section into a vector, by mapping it with mtio, and by
+ * mapping it with its checksum verified. A file with compressed sections is
+ * also written, and decoded on all hardware threads. The time until the
+ * sections can be used, and until every byte has been read, is the best of
+ * several runs with the file cached, and where possible with it dropped
+ * from the cache.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,1296 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : MtFormat.h
+// SYNOPSIS : The layout of MT files, for writers and readers alike.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// STANDARD LIBRARY ///////////////////////////////////////////////////////////
+// NOTE: Only the standard library, zlib, and SSE2 intrinsics are used, and not
+// the precompiled header, so that programs reading MT files can include this
+// as it is.
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <span>
+#include <utility>
+#include <vector>
+
+// ZLIB ///////////////////////////////////////////////////////////////////////
+#include <zlib.h>
+
+// SYSTEM /////////////////////////////////////////////////////////////////////
+// NOTE: Where the compiler targets SSE2, byte planes are decoded sixteen
+// elements at a time.
+#if defined( __SSE2__ ) || defined( _M_X64 ) \
+    || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define MTFORMAT_HAVE_SSE2
+#include <emmintrin.h>
+#endif /* SSE2 */
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for the layout of MT files.
+namespace MtFormat
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The bytes every MT file with a header starts with.
+  inline constexpr std::array<unsigned char, 4> MAGIC{ 0x89, 'M', 'T', '\n' };
+
+  //! The version of the MT format with a header.
+  inline constexpr std::uint16_t VERSION{ 3 };
+
+  //! Reads as this when a file has the byte order of the reader.
+  inline constexpr std::uint16_t ENDIAN_TAG{ 0x0102 };
+
+  //! The alignment of each section from the start of the file.
+  inline constexpr std::uint64_t SECTION_ALIGNMENT{ 64 };
+
+  //! The alignment of each attribute in, and the stride of, interleaved
+  //! vertices, as GPUs need.
+  inline constexpr std::uint32_t VERTEX_ALIGNMENT{ 4 };
+
+  //! The number of vertices interleaved at once, small enough to stay in
+  //! cache while each attribute is copied in.
+  inline constexpr std::size_t VERTICES_PER_BLOCK{ 1'024 };
+
+  //! The bit of a section format the codec of a compressed section starts
+  //! at, the bits below holding the FormatEnum of its elements.
+  inline constexpr std::uint32_t CODEC_SHIFT{ 24 };
+
+  //! The most bytes a chunk of a compressed section holds once decoded,
+  //! unless one element is larger, small enough to stay in cache as it is
+  //! decoded.
+  inline constexpr std::size_t CHUNK_BYTES{ 256 * 1'024 };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // ENUMS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! An enumeration of what a section can hold.
+  enum class SectionEnum : std::uint32_t
+  {
+    Positions = 1,   ///< Vertex positions.
+    Normals,         ///< Vertex normals.
+    TexCoords,       ///< Vertex texture \c U and \c V values.
+    VertexMaterials, ///< A material for each vertex.
+    Materials,       ///< The materials of the mesh.
+    MaterialIndices, ///< An index into Materials for each vertex.
+    DiffuseColours,  ///< A diffuse colour for each vertex.
+    Indices,         ///< Vertex indices, three for each triangle.
+    Vertices,        ///< Vertices with their attributes interleaved.
+    VertexLayout,    ///< Where each attribute lies within Vertices.
+    LodIndices,      ///< Vertex indices of a coarser level of detail, one
+                     ///< section for each level from the finest.
+    Meshlets,        ///< The meshlets the triangles are split into.
+    MeshletVertices, ///< The vertex indices used by each meshlet in turn.
+    MeshletTriangles, ///< Three numbers into the vertices of its meshlet
+                      ///< for each triangle of each meshlet in turn.
+    Bvh,              ///< The nodes of a bounding volume hierarchy of the
+                      ///< triangles, depth first.
+    BvhTriangles      ///< The triangles of each leaf of Bvh in turn, by
+                      ///< their number in Indices.
+  };
+
+
+  //! An enumeration of the formats of section elements.
+  enum class FormatEnum : std::uint32_t
+  {
+    Uint8 = 1, ///< An <tt>unsigned char</tt>.
+    Uint16,    ///< A 16-bit unsigned integer.
+    Uint32,    ///< A 32-bit unsigned integer.
+    Float32x2, ///< Two \c float .
+    Float32x3, ///< Three \c float .
+    Float32x4, ///< Four \c float .
+    Material,  ///< Thirteen \c float , as ambient, diffuse, and specular
+               ///< colours then shininess.
+    Unorm16x3, ///< Three 16-bit unsigned integers, where 0 to 65535 spans
+               ///< the bounding box of the header.
+    Float16x3, ///< Three IEEE half precision floats, as offsets from the
+               ///< centre of the bounding box of the header.
+    Octahedral16x2, ///< Two 16-bit signed integers, where -32767 to 32767
+                    ///< spans -1 to 1, of a unit vector folded onto an
+                    ///< octahedron.
+    Unorm8x4,  ///< Four <tt>unsigned char</tt>, where 0 to 255 spans 0 to 1.
+    Vertex,    ///< Interleaved attributes, as many bytes as the stride.
+    Attribute, ///< An attribute_struct .
+    Meshlet,   ///< A meshlet_struct .
+    BvhNode    ///< A bvh_node_struct .
+  };
+
+
+  //! An enumeration of how a section is compressed, held in the bits of its
+  //! format from CODEC_SHIFT.
+  enum class CodecEnum : std::uint32_t
+  {
+    None = 0, ///< Not compressed.
+    Deflate   ///< Each chunk delta coded, split into byte planes, then
+              ///< deflated by zlib, as chunks_struct describes.
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief The header at the start of an MT file.
+   *
+   * All fields are in the byte order of the writer, which \c endian gives.
+   * The section table follows straight after.
+   *
+   * @ingroup STRUCT
+   */
+  struct header_struct
+  {
+    //! Always MAGIC.
+    std::array<unsigned char, 4> magic{ MAGIC };
+    //! The version of the format.
+    std::uint16_t version{ VERSION };
+    //! ENDIAN_TAG as the writer stored it.
+    std::uint16_t endian{ ENDIAN_TAG };
+    //! The size of this header, so that later versions can grow it.
+    std::uint32_t header_bytes{ sizeof ( header_struct ) };
+    //! The number of entries in the section table.
+    std::uint32_t num_sections{};
+    //! The number of vertices.
+    std::uint32_t num_vertices{};
+    //! The number of vertex indices.
+    std::uint32_t num_indices{};
+    //! The smallest vertex \c x , \c y , and \c z components.
+    std::array<float, 3> bounds_min{};
+    //! The largest vertex \c x , \c y , and \c z components.
+    std::array<float, 3> bounds_max{};
+    //! Reserved, and zero.
+    std::array<std::uint32_t, 3> reserved{};
+    /**
+     * @brief The CRC-32 of the whole file, taken with this field as zero.
+     */
+    std::uint32_t checksum{};
+  };
+  static_assert( sizeof ( header_struct ) == 64 );
+
+
+  /**
+   * @brief An entry of the section table.
+   *
+   * @ingroup STRUCT
+   */
+  struct section_struct
+  {
+    //! What the section holds, as a SectionEnum.
+    std::uint32_t type{};
+    //! The format of its elements, as a FormatEnum, with its CodecEnum in
+    //! the bits from CODEC_SHIFT.
+    std::uint32_t format{};
+    //! Where it starts, a multiple of SECTION_ALIGNMENT.
+    std::uint64_t offset{};
+    //! Its size in bytes.
+    std::uint64_t bytes{};
+    //! The number of elements.
+    std::uint32_t count{};
+    //! The bytes from the start of one element to the start of the next.
+    std::uint32_t stride{};
+  };
+  static_assert( sizeof ( section_struct ) == 32 );
+
+
+  /**
+   * @brief An entry of a vertex layout section, saying where an attribute
+   * lies within each interleaved vertex.
+   *
+   * @ingroup STRUCT
+   */
+  struct attribute_struct
+  {
+    //! What the attribute holds, as a SectionEnum.
+    std::uint32_t type{};
+    //! Its format, as a FormatEnum.
+    std::uint32_t format{};
+    //! Its offset from the start of a vertex, a multiple of VERTEX_ALIGNMENT.
+    std::uint32_t offset{};
+  };
+  static_assert( sizeof ( attribute_struct ) == 12 );
+
+
+  /**
+   * @brief A meshlet, a cluster of triangles small enough to be drawn or
+   * culled as one, with bounds to cull it by.
+   *
+   * A meshlet faces away from a camera, and can be culled, when
+   * <tt>dot ( normalise ( cone_apex - camera ), cone_axis ) >=
+   * cone_cutoff</tt> .
+   *
+   * @ingroup STRUCT
+   */
+  struct meshlet_struct
+  {
+    //! Where its vertices start in the MeshletVertices section.
+    std::uint32_t vertex_offset{};
+    //! Where its triangles start in the MeshletTriangles section, counted
+    //! in triangles.
+    std::uint32_t triangle_offset{};
+    //! The number of vertices.
+    std::uint32_t vertex_count{};
+    //! The number of triangles.
+    std::uint32_t triangle_count{};
+    //! The centre of a sphere holding all its vertices.
+    std::array<float, 3> centre{};
+    //! The radius of that sphere.
+    float radius{};
+    //! The apex of a cone all its triangles face out of.
+    std::array<float, 3> cone_apex{};
+    //! The sine of the widest angle between a triangle and the cone axis,
+    //! or 1 if the meshlet can never be culled by facing.
+    float cone_cutoff{};
+    //! The unit axis of that cone.
+    std::array<float, 3> cone_axis{};
+    //! Reserved, and zero.
+    std::uint32_t reserved{};
+  };
+  static_assert( sizeof ( meshlet_struct ) == 64 );
+
+
+  /**
+   * @brief A node of a bounding volume hierarchy.
+   *
+   * Nodes are stored depth first, so the first child of an inner node
+   * follows it straight after, and only the second child needs an index.
+   * The root is the first node, and its box is that of the mesh.
+   *
+   * @ingroup STRUCT
+   */
+  struct bvh_node_struct
+  {
+    //! The smallest \c x , \c y , and \c z of its triangles.
+    std::array<float, 3> bounds_min{};
+    //! For a leaf, where its triangles start in the BvhTriangles section,
+    //! and otherwise the index of its second child.
+    std::uint32_t first{};
+    //! The largest \c x , \c y , and \c z of its triangles.
+    std::array<float, 3> bounds_max{};
+    //! For a leaf, the number of its triangles, and otherwise 0.
+    std::uint32_t count{};
+  };
+  static_assert( sizeof ( bvh_node_struct ) == 32 );
+
+
+  /**
+   * @brief The start of a compressed section.
+   *
+   * The section is cut into chunks of \c chunk_elements elements, the last
+   * perhaps shorter, each compressed on its own so that chunks can be
+   * decoded in any order, or at once. This is followed by a
+   * <tt>std::uint64_t</tt> for each chunk, where it ends counted from the
+   * start of the first, then the chunks. In each chunk, each lane of each
+   * element, a component of the width lane_bytes() gives, is stored as its
+   * difference from that lane of the element before, and the bytes are
+   * then stored a plane at a time, the first byte of every element, then
+   * the second, and so on, before the chunk is deflated. The count and
+   * stride of the section are those of the elements once decoded.
+   *
+   * @ingroup STRUCT
+   */
+  struct chunks_struct
+  {
+    //! The number of elements in each chunk.
+    std::uint32_t chunk_elements{};
+    //! The number of chunks.
+    std::uint32_t num_chunks{};
+  };
+  static_assert( sizeof ( chunks_struct ) == 8 );
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Gives the size of an element of a format.
+   *
+   * @param[in] format The format.
+   * @returns The size in bytes, the least a vertex can have for Vertex, or
+   * zero for an unknown format.
+   */
+  inline constexpr std::uint32_t format_bytes ( FormatEnum format ) noexcept
+  {
+    switch ( format )
+    {
+      case FormatEnum::Uint8:
+        return ( 1 );
+
+      case FormatEnum::Uint16:
+        return ( 2 );
+
+      case FormatEnum::Uint32:
+        return ( 4 );
+
+      case FormatEnum::Float32x2:
+        return ( 8 );
+
+      case FormatEnum::Float32x3:
+        return ( 12 );
+
+      case FormatEnum::Float32x4:
+        return ( 16 );
+
+      case FormatEnum::Material:
+        return ( 52 );
+
+      case FormatEnum::Unorm16x3:
+      case FormatEnum::Float16x3:
+        return ( 6 );
+
+      case FormatEnum::Octahedral16x2:
+      case FormatEnum::Unorm8x4:
+        return ( 4 );
+
+      case FormatEnum::Vertex:
+        return ( VERTEX_ALIGNMENT );
+
+      case FormatEnum::Attribute:
+        return ( sizeof ( attribute_struct ) );
+
+      case FormatEnum::Meshlet:
+        return ( sizeof ( meshlet_struct ) );
+
+      case FormatEnum::BvhNode:
+        return ( sizeof ( bvh_node_struct ) );
+    }
+    return ( 0 );
+  }
+
+  /**
+   * @brief Rounds an offset up to the next section boundary.
+   *
+   * @param[in] offset The offset.
+   * @returns The first multiple of SECTION_ALIGNMENT not below \c offset .
+   */
+  inline constexpr std::uint64_t align_section ( std::uint64_t offset ) noexcept
+  {
+    return ( ( offset + SECTION_ALIGNMENT - 1 ) & ~( SECTION_ALIGNMENT - 1 ) );
+  }
+
+  /**
+   * @brief Says whether a section holds an attribute of each vertex, and so
+   * can be interleaved.
+   *
+   * @param[in] type The section type.
+   * @returns \c true for a vertex attribute.
+   */
+  inline constexpr bool is_vertex_attribute ( SectionEnum type ) noexcept
+  {
+    switch ( type )
+    {
+      case SectionEnum::Positions:
+      case SectionEnum::Normals:
+      case SectionEnum::TexCoords:
+      case SectionEnum::VertexMaterials:
+      case SectionEnum::MaterialIndices:
+      case SectionEnum::DiffuseColours:
+        return ( true );
+
+      default:
+        return ( false );
+    }
+  }
+
+  /**
+   * @brief Copies elements of one size into strided slots.
+   *
+   * The size is a template parameter so that each copy is a few moves.
+   *
+   * @tparam Bytes The size of each element.
+   * @param[in] p_in The packed elements.
+   * @param[in] count The number of elements.
+   * @param[out] p_out Where the first element goes.
+   * @param[in] stride The bytes from one slot to the next.
+   */
+  template<std::size_t Bytes>
+  void copy_strided (
+      const std::byte* p_in,
+      std::size_t count,
+      std::byte* p_out,
+      std::size_t stride
+  ) noexcept
+  {
+    for ( std::size_t j{ 0 }; j < count; ++j )
+    {
+      std::memcpy ( p_out + j * stride, p_in + j * Bytes, Bytes );
+    }
+  }
+
+  /**
+   * @brief Continues a CRC-32 over more bytes.
+   *
+   * @param[in] crc The CRC-32 so far, zero to start.
+   * @param[in] bytes The bytes.
+   * @returns The CRC-32 including \c bytes .
+   */
+  inline std::uint32_t checksum (
+      std::uint32_t crc,
+      std::span<const std::byte> bytes
+  ) noexcept
+  {
+    auto* p_next{ reinterpret_cast<const Bytef*>( bytes.data () ) };
+    auto remaining{ bytes.size () };
+    while ( remaining > 0 )
+    {
+      const auto length{
+          static_cast<uInt>( remaining < UINT_MAX ? remaining : UINT_MAX )
+      };
+      crc = static_cast<std::uint32_t>( ::crc32 ( crc, p_next, length ) );
+      p_next += length;
+      remaining -= length;
+    }
+    return ( crc );
+  }
+
+  /**
+   * @brief Gives the format of the elements of a section.
+   *
+   * @param[in] section The section.
+   * @returns Its format, without its codec.
+   */
+  inline constexpr FormatEnum section_format (
+      const section_struct& section
+  ) noexcept
+  {
+    return (
+        static_cast<FormatEnum>(
+            section.format & ( ( 1u << CODEC_SHIFT ) - 1 )
+        )
+    );
+  }
+
+  /**
+   * @brief Gives how a section is compressed.
+   *
+   * @param[in] section The section.
+   * @returns Its codec, CodecEnum::None if it is stored as it is.
+   */
+  inline constexpr CodecEnum section_codec (
+      const section_struct& section
+  ) noexcept
+  {
+    return ( static_cast<CodecEnum>( section.format >> CODEC_SHIFT ) );
+  }
+
+  /**
+   * @brief Gives the width of the lanes a compressed section is delta coded
+   * in, that of the components of its elements.
+   *
+   * @param[in] format The format of the elements.
+   * @param[in] stride The bytes of each element.
+   * @returns 1, 2, or 4.
+   */
+  inline constexpr std::uint32_t lane_bytes (
+      FormatEnum format,
+      std::uint32_t stride
+  ) noexcept
+  {
+    std::uint32_t lane{ 4 };
+    switch ( format )
+    {
+      case FormatEnum::Uint8:
+      case FormatEnum::Unorm8x4:
+        lane = 1;
+        break;
+
+      case FormatEnum::Uint16:
+      case FormatEnum::Unorm16x3:
+      case FormatEnum::Float16x3:
+      case FormatEnum::Octahedral16x2:
+        lane = 2;
+        break;
+
+      default:
+        break;
+    }
+    while ( stride % lane != 0 )
+    {
+      lane /= 2;
+    }
+    return ( lane );
+  }
+
+  /**
+   * @brief Gives the number of elements in each chunk of a compressed
+   * section.
+   *
+   * @param[in] stride The bytes of each element.
+   * @returns As many elements as fit in CHUNK_BYTES, and at least one.
+   */
+  inline constexpr std::uint32_t chunk_elements (
+      std::uint32_t stride
+  ) noexcept
+  {
+    return (
+        static_cast<std::uint32_t>(
+            std::max<std::size_t> ( 1, CHUNK_BYTES / std::max ( stride, 1u ) )
+        )
+    );
+  }
+
+  /**
+   * @brief Delta codes a chunk and splits it into byte planes.
+   *
+   * Each lane is done in turn, so that its planes are written in order.
+   *
+   * @tparam Lane The unsigned integer of the width of a lane.
+   * @param[in] p_in The elements.
+   * @param[in] count The number of elements.
+   * @param[in] stride The bytes of each element, a multiple of the lane.
+   * @param[out] p_out Where the \c count times \c stride bytes go.
+   */
+  template<typename Lane>
+  void encode_planes (
+      const std::byte* p_in,
+      std::size_t count,
+      std::size_t stride,
+      std::byte* p_out
+  ) noexcept
+  {
+    for ( std::size_t l{ 0 }; l < stride; l += sizeof ( Lane ) )
+    {
+      Lane previous{ 0 };
+      for ( std::size_t j{ 0 }; j < count; ++j )
+      {
+        Lane value{};
+        std::memcpy ( &value, p_in + j * stride + l, sizeof ( Lane ) );
+        const auto delta{ static_cast<Lane>( value - previous ) };
+        previous = value;
+        for ( std::size_t b{ 0 }; b < sizeof ( Lane ); ++b )
+        {
+          p_out[( l + b ) * count + j] =
+              static_cast<std::byte>( delta >> ( b * CHAR_BIT ) );
+        }
+      }
+    }
+  }
+
+#ifdef MTFORMAT_HAVE_SSE2
+  /**
+   * @brief Adds up the deltas of consecutive values in a register.
+   *
+   * Each value is added to those after it by shifting the register by one,
+   * two, four, and eight values in turn, a lane at a time.
+   *
+   * @tparam Lane The unsigned integer of the width of a lane.
+   * @tparam Width The bytes of each value, one or more lanes.
+   * @param[in] deltas The deltas of as many values as fit in a register.
+   * @param[in,out] total The value before the first, in every place of the
+   * register, and then the last.
+   * @returns The values.
+   */
+  template<typename Lane, std::size_t Width>
+  inline __m128i add_deltas ( __m128i deltas, __m128i& total ) noexcept
+  {
+    const auto add{
+        [] ( __m128i a, __m128i b )
+        {
+          if constexpr ( sizeof ( Lane ) == 1 )
+          {
+            return ( _mm_add_epi8 ( a, b ) );
+          }
+          else if constexpr ( sizeof ( Lane ) == 2 )
+          {
+            return ( _mm_add_epi16 ( a, b ) );
+          }
+          else
+          {
+            return ( _mm_add_epi32 ( a, b ) );
+          }
+        }
+    };
+    if constexpr ( Width == 1 )
+    {
+      deltas = add ( deltas, _mm_slli_si128 ( deltas, 1 ) );
+    }
+    if constexpr ( Width <= 2 )
+    {
+      deltas = add ( deltas, _mm_slli_si128 ( deltas, 2 ) );
+    }
+    deltas = add ( deltas, _mm_slli_si128 ( deltas, 4 ) );
+    deltas = add ( deltas, _mm_slli_si128 ( deltas, 8 ) );
+    const auto values{ add ( deltas, total ) };
+
+    if constexpr ( Width == 4 )
+    {
+      total = _mm_shuffle_epi32 ( values, 0xFF );
+    }
+    else
+    {
+      auto last{ values };
+      if constexpr ( Width == 1 )
+      {
+        last = _mm_unpackhi_epi8 ( last, last );
+      }
+      last = _mm_shufflehi_epi16 ( last, 0xFF );
+      total = _mm_unpackhi_epi64 ( last, last );
+    }
+    return ( values );
+  }
+
+  /**
+   * @brief Decodes the values of a chunk that start at one byte of each
+   * element, sixteen elements at a time.
+   *
+   * The planes of sixteen values are loaded a register each and
+   * interleaved, bytes into words and words into double words, into their
+   * deltas, which add_deltas() turns into values. Values as wide as the
+   * element are stored as they are, and others one at a time.
+   *
+   * @tparam Lane The unsigned integer of the width of a lane.
+   * @tparam Width The bytes of each value, one or more lanes.
+   * @param[in] p_planes The first byte plane of the values.
+   * @param[in] count The number of elements.
+   * @param[in] stride The bytes of each element.
+   * @param[out] p_values Where the value of the first element goes.
+   * @returns The number of elements decoded, a multiple of sixteen.
+   */
+  template<typename Lane, std::size_t Width>
+  std::size_t decode_block (
+      const std::byte* p_planes,
+      std::size_t count,
+      std::size_t stride,
+      std::byte* p_values
+  ) noexcept
+  {
+    const auto store{
+        [stride] ( __m128i values, std::byte* p_first )
+        {
+          if ( stride == Width )
+          {
+            _mm_storeu_si128 ( reinterpret_cast<__m128i*>( p_first ), values );
+            return;
+          }
+
+          alignas ( 16 ) std::array<std::byte, 16> bytes{};
+          _mm_store_si128 (
+              reinterpret_cast<__m128i*>( bytes.data () ),
+              values
+          );
+          for ( std::size_t k{ 0 }; k < 16 / Width; ++k )
+          {
+            std::memcpy ( p_first + k * stride, &bytes[k * Width], Width );
+          }
+        }
+    };
+    const auto load{
+        [p_planes, count] ( std::size_t b, std::size_t j )
+        {
+          return (
+              _mm_loadu_si128 (
+                  reinterpret_cast<const __m128i*>( p_planes + b * count + j )
+              )
+          );
+        }
+    };
+
+    auto total{ _mm_setzero_si128 () };
+    std::size_t j{ 0 };
+    for ( ; j + 16 <= count; j += 16 )
+    {
+      auto* p_first{ p_values + j * stride };
+      if constexpr ( Width == 1 )
+      {
+        store ( add_deltas<Lane, Width> ( load ( 0, j ), total ), p_first );
+      }
+      else if constexpr ( Width == 2 )
+      {
+        const auto low{ load ( 0, j ) };
+        const auto high{ load ( 1, j ) };
+        for ( const auto deltas : {
+            _mm_unpacklo_epi8 ( low, high ),
+            _mm_unpackhi_epi8 ( low, high )
+        } )
+        {
+          store ( add_deltas<Lane, Width> ( deltas, total ), p_first );
+          p_first += 8 * stride;
+        }
+      }
+      else
+      {
+        const auto low{ load ( 0, j ) };
+        const auto high{ load ( 1, j ) };
+        const auto low_words{ _mm_unpacklo_epi8 ( low, high ) };
+        const auto high_words{ _mm_unpackhi_epi8 ( low, high ) };
+        const auto third{ load ( 2, j ) };
+        const auto top{ load ( 3, j ) };
+        const auto low_tops{ _mm_unpacklo_epi8 ( third, top ) };
+        const auto high_tops{ _mm_unpackhi_epi8 ( third, top ) };
+        for ( const auto deltas : {
+            _mm_unpacklo_epi16 ( low_words, low_tops ),
+            _mm_unpackhi_epi16 ( low_words, low_tops ),
+            _mm_unpacklo_epi16 ( high_words, high_tops ),
+            _mm_unpackhi_epi16 ( high_words, high_tops )
+        } )
+        {
+          store ( add_deltas<Lane, Width> ( deltas, total ), p_first );
+          p_first += 4 * stride;
+        }
+      }
+    }
+    return ( j );
+  }
+#endif /* MTFORMAT_HAVE_SSE2 */
+
+  /**
+   * @brief Joins the byte planes of a chunk and undoes its delta coding,
+   * the reverse of encode_planes().
+   *
+   * Elements of two or four bytes are decoded whole, as their lanes
+   * interleave as their bytes do, and wider ones a lane at a time. With
+   * SSE2, decode_block() decodes all but the last few elements, and the
+   * rest are joined a byte at a time.
+   *
+   * @tparam Lane The unsigned integer of the width of a lane.
+   * @param[in] p_in The byte planes.
+   * @param[in] count The number of elements.
+   * @param[in] stride The bytes of each element, a multiple of the lane.
+   * @param[out] p_out Where the elements go.
+   */
+  template<typename Lane>
+  void decode_planes (
+      const std::byte* p_in,
+      std::size_t count,
+      std::size_t stride,
+      std::byte* p_out
+  ) noexcept
+  {
+    const auto width{
+        stride == 2 || stride == 4 ? stride : sizeof ( Lane )
+    };
+    for ( std::size_t l{ 0 }; l < stride; l += width )
+    {
+      std::size_t decoded{ 0 };
+#ifdef MTFORMAT_HAVE_SSE2
+      const auto* p_planes{ p_in + l * count };
+      switch ( width )
+      {
+        case 1:
+          if constexpr ( sizeof ( Lane ) == 1 )
+          {
+            decoded = decode_block<Lane, 1> (
+                p_planes, count, stride, p_out + l
+            );
+          }
+          break;
+
+        case 2:
+          if constexpr ( sizeof ( Lane ) <= 2 )
+          {
+            decoded = decode_block<Lane, 2> (
+                p_planes, count, stride, p_out + l
+            );
+          }
+          break;
+
+        default:
+          decoded = decode_block<Lane, 4> (
+              p_planes, count, stride, p_out + l
+          );
+          break;
+      }
+#endif /* MTFORMAT_HAVE_SSE2 */
+
+      for ( auto m{ l }; m < l + width; m += sizeof ( Lane ) )
+      {
+        std::array<const std::byte*, sizeof ( Lane )> p_planes{};
+        for ( std::size_t b{ 0 }; b < sizeof ( Lane ); ++b )
+        {
+          p_planes[b] = p_in + ( m + b ) * count;
+        }
+        Lane value{ 0 };
+        if ( decoded > 0 )
+        {
+          std::memcpy (
+              &value,
+              p_out + ( decoded - 1 ) * stride + m,
+              sizeof ( Lane )
+          );
+        }
+        for ( auto j{ decoded }; j < count; ++j )
+        {
+          Lane delta{ 0 };
+          for ( std::size_t b{ 0 }; b < sizeof ( Lane ); ++b )
+          {
+            delta |= static_cast<Lane>(
+                static_cast<Lane>( p_planes[b][j] ) << ( b * CHAR_BIT )
+            );
+          }
+          value = static_cast<Lane>( value + delta );
+          std::memcpy ( p_out + j * stride + m, &value, sizeof ( Lane ) );
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Compresses the elements of a section with CodecEnum::Deflate.
+   *
+   * @param[in] data The elements.
+   * @param[in] format Their format.
+   * @param[in] stride The bytes of each element.
+   * @param[in] level The zlib compression level, 1 to 9.
+   * @returns The compressed section, as chunks_struct describes.
+   * @throws std::runtime_error If zlib fails.
+   */
+  inline std::vector<std::byte> compress (
+      std::span<const std::byte> data,
+      FormatEnum format,
+      std::uint32_t stride,
+      int level
+  )
+  {
+    const auto count{ data.size () / stride };
+    const chunks_struct chunks{
+        .chunk_elements{ chunk_elements ( stride ) },
+        .num_chunks{
+            static_cast<std::uint32_t>(
+                ( count + chunk_elements ( stride ) - 1 )
+                / chunk_elements ( stride )
+            )
+        }
+    };
+    const auto table_bytes{
+        sizeof ( chunks ) + chunks.num_chunks * sizeof ( std::uint64_t )
+    };
+    std::vector<std::byte> out ( table_bytes );
+    std::memcpy ( out.data (), &chunks, sizeof ( chunks ) );
+
+    const auto lane{ lane_bytes ( format, stride ) };
+    std::vector<std::byte> planes{};
+    for ( std::uint32_t c{ 0 }; c < chunks.num_chunks; ++c )
+    {
+      const std::size_t first{ std::size_t{ c } * chunks.chunk_elements };
+      const auto elements{
+          std::min<std::size_t> ( chunks.chunk_elements, count - first )
+      };
+      const auto* p_in{ data.data () + first * stride };
+      planes.resize ( elements * stride );
+      switch ( lane )
+      {
+        case 1:
+          encode_planes<std::uint8_t> (
+              p_in, elements, stride, planes.data ()
+          );
+          break;
+
+        case 2:
+          encode_planes<std::uint16_t> (
+              p_in, elements, stride, planes.data ()
+          );
+          break;
+
+        default:
+          encode_planes<std::uint32_t> (
+              p_in, elements, stride, planes.data ()
+          );
+          break;
+      }
+
+      const auto start{ out.size () };
+      auto size{ ::compressBound ( static_cast<uLong>( planes.size () ) ) };
+      out.resize ( start + size );
+      if (
+          ::compress2 (
+              reinterpret_cast<Bytef*>( out.data () + start ),
+              &size,
+              reinterpret_cast<const Bytef*>( planes.data () ),
+              static_cast<uLong>( planes.size () ),
+              level
+          ) != Z_OK
+      )
+      {
+        throw std::runtime_error{ "Cannot compress MT section" };
+      }
+      out.resize ( start + size );
+      const std::uint64_t end{ out.size () - table_bytes };
+      std::memcpy (
+          out.data () + sizeof ( chunks ) + c * sizeof ( end ),
+          &end,
+          sizeof ( end )
+      );
+    }
+    return ( out );
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Writes an MT file from sections held elsewhere.
+   *
+   * Sections are not copied, so their data must stay alive until write() is
+   * called. Only interleaved vertices and compressed sections are held by
+   * the writer itself.
+   */
+  class Writer final
+  {
+  public:
+    Writer () = default;
+    Writer ( const Writer& ) = delete;
+    Writer& operator= ( const Writer& ) = delete;
+
+    /**
+     * @brief Adds a section.
+     *
+     * @param[in] type What the section holds.
+     * @param[in] format The format of its elements.
+     * @param[in] p_data The elements.
+     * @param[in] count The number of elements.
+     */
+    void add (
+        SectionEnum type,
+        FormatEnum format,
+        const void* p_data,
+        std::size_t count
+    )
+    {
+      const auto stride{ format_bytes ( format ) };
+      sections_.emplace_back (
+          section_struct{
+              .type{ static_cast<std::uint32_t>( type ) },
+              .format{ static_cast<std::uint32_t>( format ) },
+              .bytes{ count * std::uint64_t{ stride } },
+              .count{ static_cast<std::uint32_t>( count ) },
+              .stride{ stride }
+          }
+      );
+      data_.emplace_back ( static_cast<const std::byte*>( p_data ) );
+    }
+
+    /**
+     * @brief Replaces the vertex attribute sections added so far with one
+     * section of interleaved vertices, and a vertex layout section saying
+     * where each attribute lies within a vertex.
+     *
+     * The two sections take the place of the first attribute section. The
+     * vertices are built a block at a time, each block staying in cache as
+     * every attribute is copied into it, so memory is written in one pass.
+     *
+     * @returns The stride of a vertex, or zero if there were no attributes.
+     * @throws std::invalid_argument If the attributes have different
+     * counts.
+     */
+    std::uint32_t interleave ()
+    {
+      std::vector<std::size_t> attributes{};
+      layout_.clear ();
+      std::uint32_t stride{ 0 };
+      for ( std::size_t s{ 0 }; s < sections_.size (); ++s )
+      {
+        const auto& section{ sections_[s] };
+        if ( !is_vertex_attribute ( static_cast<SectionEnum>( section.type ) ) )
+        {
+          continue;
+        }
+        if (
+            !attributes.empty ()
+            && section.count != sections_[attributes.front ()].count
+        )
+        {
+          throw std::invalid_argument{
+              "Vertex attributes to interleave differ in count"
+          };
+        }
+        stride = ( stride + VERTEX_ALIGNMENT - 1 ) & ~( VERTEX_ALIGNMENT - 1 );
+        layout_.emplace_back (
+            attribute_struct{
+                .type{ section.type },
+                .format{ section.format },
+                .offset{ stride }
+            }
+        );
+        stride += section.stride;
+        attributes.emplace_back ( s );
+      }
+      if ( attributes.empty () )
+      {
+        return ( 0 );
+      }
+      stride = ( stride + VERTEX_ALIGNMENT - 1 ) & ~( VERTEX_ALIGNMENT - 1 );
+
+      const std::size_t count{ sections_[attributes.front ()].count };
+      vertices_.assign ( count * stride, std::byte{ 0 } );
+      for ( std::size_t first{ 0 }; first < count; first += VERTICES_PER_BLOCK )
+      {
+        const auto block{ std::min ( VERTICES_PER_BLOCK, count - first ) };
+        for ( std::size_t a{ 0 }; a < attributes.size (); ++a )
+        {
+          const auto size{ sections_[attributes[a]].stride };
+          const auto* p_in{ data_[attributes[a]] + first * size };
+          auto* p_out{ vertices_.data () + first * stride + layout_[a].offset };
+          switch ( size )
+          {
+            case 1:
+              copy_strided<1> ( p_in, block, p_out, stride );
+              break;
+
+            case 4:
+              copy_strided<4> ( p_in, block, p_out, stride );
+              break;
+
+            case 6:
+              copy_strided<6> ( p_in, block, p_out, stride );
+              break;
+
+            case 8:
+              copy_strided<8> ( p_in, block, p_out, stride );
+              break;
+
+            case 12:
+              copy_strided<12> ( p_in, block, p_out, stride );
+              break;
+
+            case 16:
+              copy_strided<16> ( p_in, block, p_out, stride );
+              break;
+
+            default:
+              for ( std::size_t j{ 0 }; j < block; ++j )
+              {
+                std::memcpy ( p_out + j * stride, p_in + j * size, size );
+              }
+              break;
+          }
+        }
+      }
+
+      std::vector<section_struct> sections{};
+      std::vector<const std::byte*> data{};
+      for ( std::size_t s{ 0 }; s < sections_.size (); ++s )
+      {
+        if ( s == attributes.front () )
+        {
+          sections.emplace_back (
+              section_struct{
+                  .type{ static_cast<std::uint32_t>( SectionEnum::Vertices ) },
+                  .format{ static_cast<std::uint32_t>( FormatEnum::Vertex ) },
+                  .bytes{ vertices_.size () },
+                  .count{ static_cast<std::uint32_t>( count ) },
+                  .stride{ stride }
+              }
+          );
+          data.emplace_back ( vertices_.data () );
+          sections.emplace_back (
+              section_struct{
+                  .type{
+                      static_cast<std::uint32_t>( SectionEnum::VertexLayout )
+                  },
+                  .format{
+                      static_cast<std::uint32_t>( FormatEnum::Attribute )
+                  },
+                  .bytes{ layout_.size () * sizeof ( attribute_struct ) },
+                  .count{ static_cast<std::uint32_t>( layout_.size () ) },
+                  .stride{ sizeof ( attribute_struct ) }
+              }
+          );
+          data.emplace_back (
+              reinterpret_cast<const std::byte*>( layout_.data () )
+          );
+        }
+        const auto type{ static_cast<SectionEnum>( sections_[s].type ) };
+        if ( !is_vertex_attribute ( type ) )
+        {
+          sections.emplace_back ( sections_[s] );
+          data.emplace_back ( data_[s] );
+        }
+      }
+      sections_ = std::move ( sections );
+      data_ = std::move ( data );
+      return ( stride );
+    }
+
+    /**
+     * @brief Compresses each section that gets smaller for it with
+     * CodecEnum::Deflate, but for the vertex layout, which readers need as
+     * it is.
+     *
+     * Call this last, after interleave().
+     *
+     * @param[in] level The zlib compression level, 1 to 9.
+     * @returns The number of sections compressed.
+     * @throws std::runtime_error If zlib fails.
+     */
+    std::size_t compress ( int level = Z_DEFAULT_COMPRESSION )
+    {
+      std::size_t compressed{ 0 };
+      for ( std::size_t s{ 0 }; s < sections_.size (); ++s )
+      {
+        auto& section{ sections_[s] };
+        if (
+            section.type
+                == static_cast<std::uint32_t>( SectionEnum::VertexLayout )
+            || section_codec ( section ) != CodecEnum::None
+            || section.bytes == 0
+        )
+        {
+          continue;
+        }
+        auto bytes{
+            MtFormat::compress (
+                data ( s ),
+                section_format ( section ),
+                section.stride,
+                level
+            )
+        };
+        if ( bytes.size () >= section.bytes )
+        {
+          continue;
+        }
+        section.format |=
+            static_cast<std::uint32_t>( CodecEnum::Deflate ) << CODEC_SHIFT;
+        section.bytes = bytes.size ();
+        // Moving a vector keeps its buffer, so data_ stays valid.
+        compressed_.emplace_back ( std::move ( bytes ) );
+        data_[s] = compressed_.back ().data ();
+        ++compressed;
+      }
+      return ( compressed );
+    }
+
+    /**
+     * @brief Gives the sections added, with offsets once written.
+     *
+     * @returns The section table.
+     */
+    const std::vector<section_struct>& sections () const noexcept
+    {
+      return ( sections_ );
+    }
+
+    /**
+     * @brief Gives the data of a section.
+     *
+     * @param[in] i The number of the section.
+     * @returns Its bytes.
+     */
+    std::span<const std::byte> data ( std::size_t i ) const noexcept
+    {
+      return (
+          std::span<const std::byte>{
+              data_[i],
+              static_cast<std::size_t>( sections_[i].bytes )
+          }
+      );
+    }
+
+    /**
+     * @brief Writes the header, section table, and sections.
+     *
+     * The checksum is taken as the file is written, and the header then
+     * rewritten with it, so the stream must be seekable.
+     *
+     * @param[in,out] out The stream, at the start of the file.
+     * @param[in] header The header, whose section count, checksum, and
+     * format fields are filled in here.
+     * @returns The number of bytes written.
+     */
+    std::uint64_t write ( std::ostream& out, header_struct header )
+    {
+      header.magic = MAGIC;
+      header.version = VERSION;
+      header.endian = ENDIAN_TAG;
+      header.header_bytes = sizeof ( header_struct );
+      header.num_sections = static_cast<std::uint32_t>( sections_.size () );
+      header.checksum = 0;
+
+      auto offset{
+          sizeof ( header_struct )
+          + sections_.size () * std::uint64_t{ sizeof ( section_struct ) }
+      };
+      for ( auto& section : sections_ )
+      {
+        offset = align_section ( offset );
+        section.offset = offset;
+        offset += section.bytes;
+      }
+
+      const auto start{ out.tellp () };
+      std::uint32_t crc{ 0 };
+      const auto put{
+          [&out, &crc] ( const void* p_bytes, std::uint64_t size )
+          {
+            const std::span<const std::byte> bytes{
+                static_cast<const std::byte*>( p_bytes ),
+                static_cast<std::size_t>( size )
+            };
+            crc = checksum ( crc, bytes );
+            out.write (
+                reinterpret_cast<const char*>( bytes.data () ),
+                static_cast<std::streamsize>( bytes.size () )
+            );
+          }
+      };
+
+      static constexpr std::array<std::byte, SECTION_ALIGNMENT> PADDING{};
+      put ( &header, sizeof ( header ) );
+      put ( sections_.data (), sections_.size () * sizeof ( section_struct ) );
+      std::uint64_t written{
+          sizeof ( header_struct )
+          + sections_.size () * std::uint64_t{ sizeof ( section_struct ) }
+      };
+      for ( std::size_t i{ 0 }; i < sections_.size (); ++i )
+      {
+        put ( PADDING.data (), sections_[i].offset - written );
+        put ( data_[i], sections_[i].bytes );
+        written = sections_[i].offset + sections_[i].bytes;
+      }
+
+      header.checksum = crc;
+      out.seekp ( start );
+      out.write (
+          reinterpret_cast<const char*>( &header ),
+          sizeof ( header )
+      );
+      out.seekp ( 0, std::ios_base::end );
+      return ( written );
+    }
+
+  private:
+    std::vector<section_struct> sections_{};
+    std::vector<const std::byte*> data_{};
+    std::vector<std::byte> vertices_{};
+    std::vector<attribute_struct> layout_{};
+    std::vector<std::vector<std::byte>> compressed_{};
+  };
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief The layout of MT files, for writers and readers alike.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,593 @@
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : MtIo.cpp
+// SYNOPSIS : Implementation file for the mtio library.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// STANDARD LIBRARY ///////////////////////////////////////////////////////////
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+
+// OPERATING SYSTEM ///////////////////////////////////////////////////////////
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* _WIN32 */
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "MtIo.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+namespace MtIo
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  namespace
+  {
+    /**
+     * @brief Makes the error for a failed system call.
+     *
+     * @param[in] what What was being done.
+     * @param[in] path The file it was done to.
+     * @returns The error, from \c errno or \c GetLastError() .
+     */
+    std::system_error system_error (
+        const char* what,
+        const std::filesystem::path& path
+    )
+    {
+#ifdef _WIN32
+      const auto code{ static_cast<int>( ::GetLastError () ) };
+#else
+      const auto code{ errno };
+#endif /* _WIN32 */
+      return (
+          std::system_error{
+              code,
+              std::system_category (),
+              std::string{ what } + " '" + path.string () + "'"
+          }
+      );
+    }
+
+
+    /**
+     * @brief Checks the chunk table of a compressed section.
+     *
+     * @param[in] bytes The bytes of the section.
+     * @param[in] section Its entry of the section table.
+     * @param[in] name What to call it in errors.
+     * @throws FormatError If the chunks do not cover its elements, or do not
+     * fill its bytes.
+     */
+    void check_chunks (
+        std::span<const std::byte> bytes,
+        const MtFormat::section_struct& section,
+        const std::string& name
+    )
+    {
+      MtFormat::chunks_struct chunks{};
+      if ( bytes.size () < sizeof ( chunks ) )
+      {
+        throw FormatError{ name + " has no chunk table" };
+      }
+      std::memcpy ( &chunks, bytes.data (), sizeof ( chunks ) );
+      const auto table_bytes{
+          sizeof ( chunks )
+          + std::uint64_t{ chunks.num_chunks } * sizeof ( std::uint64_t )
+      };
+      if (
+          chunks.chunk_elements == 0
+          || std::uint64_t{ chunks.chunk_elements } * section.stride
+              > std::max<std::uint64_t> (
+                    MtFormat::CHUNK_BYTES,
+                    section.stride
+                )
+          || chunks.num_chunks
+              != ( std::uint64_t{ section.count } + chunks.chunk_elements - 1 )
+                  / chunks.chunk_elements
+          || table_bytes > bytes.size ()
+      )
+      {
+        throw FormatError{ name + " has an invalid chunk table" };
+      }
+      std::uint64_t previous{ 0 };
+      for ( std::uint32_t c{ 0 }; c < chunks.num_chunks; ++c )
+      {
+        std::uint64_t end{};
+        std::memcpy (
+            &end,
+            bytes.data () + sizeof ( chunks ) + c * sizeof ( end ),
+            sizeof ( end )
+        );
+        if ( end < previous )
+        {
+          throw FormatError{ name + " has an invalid chunk table" };
+        }
+        previous = end;
+      }
+      if ( previous != bytes.size () - table_bytes )
+      {
+        throw FormatError{ name + " has chunks that do not fill it" };
+      }
+    }
+  }
+
+
+  void validate ( std::span<const std::byte> file, ValidationEnum validation )
+  {
+    MtFormat::header_struct header{};
+    if ( file.size () < sizeof ( header ) )
+    {
+      throw FormatError{ "File is too small to be an MT file" };
+    }
+    std::memcpy ( &header, file.data (), sizeof ( header ) );
+    if ( header.magic != MtFormat::MAGIC )
+    {
+      throw FormatError{ "File is not an MT file with a header" };
+    }
+    if ( header.endian != MtFormat::ENDIAN_TAG )
+    {
+      throw FormatError{ "MT file has the other byte order" };
+    }
+    if ( header.version != MtFormat::VERSION )
+    {
+      throw FormatError{
+          "MT file has unsupported version "
+          + std::to_string ( header.version )
+      };
+    }
+    if (
+        header.header_bytes < sizeof ( header )
+        || header.header_bytes % alignof ( MtFormat::section_struct ) != 0
+    )
+    {
+      throw FormatError{ "MT file has an invalid header size" };
+    }
+
+    const auto table_end{
+        std::uint64_t{ header.header_bytes }
+        + std::uint64_t{ header.num_sections }
+            * sizeof ( MtFormat::section_struct )
+    };
+    if ( table_end > file.size () )
+    {
+      throw FormatError{ "MT section table runs past the end of the file" };
+    }
+
+    MtFormat::section_struct vertices{};
+    MtFormat::section_struct vertex_layout{};
+    for ( std::uint32_t i{ 0 }; i < header.num_sections; ++i )
+    {
+      MtFormat::section_struct section{};
+      std::memcpy (
+          &section,
+          file.data () + header.header_bytes
+              + i * sizeof ( MtFormat::section_struct ),
+          sizeof ( section )
+      );
+      const auto element_bytes{
+          MtFormat::format_bytes ( MtFormat::section_format ( section ) )
+      };
+      const auto name{ "MT section " + std::to_string ( i ) };
+      if ( section.offset % MtFormat::SECTION_ALIGNMENT != 0 )
+      {
+        throw FormatError{ name + " is not aligned" };
+      }
+      if (
+          section.offset < table_end
+          || section.offset > file.size ()
+          || section.bytes > file.size () - section.offset
+      )
+      {
+        throw FormatError{ name + " lies outside the file" };
+      }
+      const auto codec{ MtFormat::section_codec ( section ) };
+      if (
+          element_bytes == 0
+          || section.stride < element_bytes
+          || ( codec == MtFormat::CodecEnum::None
+              && section.bytes
+                  != std::uint64_t{ section.count } * section.stride )
+      )
+      {
+        throw FormatError{ name + " has an invalid format or size" };
+      }
+      if ( codec == MtFormat::CodecEnum::Deflate )
+      {
+        check_chunks (
+            file.subspan (
+                static_cast<std::size_t>( section.offset ),
+                static_cast<std::size_t>( section.bytes )
+            ),
+            section,
+            name
+        );
+      }
+      else if ( codec != MtFormat::CodecEnum::None )
+      {
+        throw FormatError{ name + " has an unknown codec" };
+      }
+
+      if ( section.type
+          == static_cast<std::uint32_t>( MtFormat::SectionEnum::Vertices ) )
+      {
+        vertices = section;
+      }
+      else if ( section.type
+          == static_cast<std::uint32_t>( MtFormat::SectionEnum::VertexLayout ) )
+      {
+        if ( codec != MtFormat::CodecEnum::None )
+        {
+          throw FormatError{ name + " is a compressed vertex layout" };
+        }
+        vertex_layout = section;
+      }
+    }
+
+    if ( vertices.type != 0 )
+    {
+      if (
+          vertex_layout.type == 0
+          || vertex_layout.format
+              != static_cast<std::uint32_t>( MtFormat::FormatEnum::Attribute )
+      )
+      {
+        throw FormatError{ "MT vertices have no vertex layout" };
+      }
+      for ( std::uint32_t a{ 0 }; a < vertex_layout.count; ++a )
+      {
+        MtFormat::attribute_struct attribute{};
+        std::memcpy (
+            &attribute,
+            file.data () + vertex_layout.offset + a * vertex_layout.stride,
+            sizeof ( attribute )
+        );
+        const auto attribute_bytes{
+            MtFormat::format_bytes (
+                static_cast<MtFormat::FormatEnum>( attribute.format )
+            )
+        };
+        if (
+            attribute_bytes == 0
+            || std::uint64_t{ attribute.offset } + attribute_bytes
+                > vertices.stride
+        )
+        {
+          throw FormatError{
+              "MT vertex attribute " + std::to_string ( a )
+              + " lies outside the vertex"
+          };
+        }
+      }
+    }
+
+    if ( validation == ValidationEnum::Checksum )
+    {
+      const auto expected{ header.checksum };
+      header.checksum = 0;
+      auto crc{
+          MtFormat::checksum (
+              0,
+              std::as_bytes ( std::span{ &header, 1 } )
+          )
+      };
+      crc = MtFormat::checksum ( crc, file.subspan ( sizeof ( header ) ) );
+      if ( crc != expected )
+      {
+        throw FormatError{ "MT file checksum does not match" };
+      }
+    }
+  }
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  // MappedFile ///////////////////////////////////////////////////////////////
+
+  MappedFile::MappedFile ( const std::filesystem::path& path )
+  {
+#ifdef _WIN32
+    const auto file{
+        ::CreateFileW (
+            path.c_str (),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        )
+    };
+    if ( file == INVALID_HANDLE_VALUE )
+    {
+      throw system_error ( "Cannot open", path );
+    }
+    LARGE_INTEGER size{};
+    if ( !::GetFileSizeEx ( file, &size ) )
+    {
+      const auto error{ system_error ( "Cannot size", path ) };
+      ::CloseHandle ( file );
+      throw error;
+    }
+    size_ = static_cast<std::size_t>( size.QuadPart );
+    if ( size_ == 0 )
+    {
+      ::CloseHandle ( file );
+      return;
+    }
+
+    const auto mapping{
+        ::CreateFileMappingW ( file, nullptr, PAGE_READONLY, 0, 0, nullptr )
+    };
+    if ( mapping == nullptr )
+    {
+      const auto error{ system_error ( "Cannot map", path ) };
+      ::CloseHandle ( file );
+      throw error;
+    }
+    // The view keeps the mapping and file open until it is unmapped.
+    const auto* p_view{ ::MapViewOfFile ( mapping, FILE_MAP_READ, 0, 0, 0 ) };
+    const auto error{ system_error ( "Cannot map", path ) };
+    ::CloseHandle ( mapping );
+    ::CloseHandle ( file );
+    if ( p_view == nullptr )
+    {
+      throw error;
+    }
+    p_data_ = static_cast<const std::byte*>( p_view );
+#else
+    const auto fd{ ::open ( path.c_str (), O_RDONLY | O_CLOEXEC ) };
+    if ( fd < 0 )
+    {
+      throw system_error ( "Cannot open", path );
+    }
+    struct stat status{};
+    if ( ::fstat ( fd, &status ) != 0 )
+    {
+      const auto error{ system_error ( "Cannot size", path ) };
+      ::close ( fd );
+      throw error;
+    }
+    size_ = static_cast<std::size_t>( status.st_size );
+    if ( size_ == 0 )
+    {
+      ::close ( fd );
+      return;
+    }
+
+    auto* p_map{ ::mmap ( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 ) };
+    if ( p_map == MAP_FAILED )
+    {
+      const auto error{ system_error ( "Cannot map", path ) };
+      ::close ( fd );
+      size_ = 0;
+      throw error;
+    }
+    ::close ( fd );
+    p_data_ = static_cast<const std::byte*>( p_map );
+#endif /* _WIN32 */
+  }
+
+
+  MappedFile::MappedFile ( MappedFile&& other ) noexcept
+    : p_data_{ std::exchange ( other.p_data_, nullptr ) },
+      size_{ std::exchange ( other.size_, 0 ) }
+  {
+  }
+
+
+  MappedFile& MappedFile::operator= ( MappedFile&& other ) noexcept
+  {
+    if ( this != &other )
+    {
+      unmap ();
+      p_data_ = std::exchange ( other.p_data_, nullptr );
+      size_ = std::exchange ( other.size_, 0 );
+    }
+    return ( *this );
+  }
+
+
+  MappedFile::~MappedFile ()
+  {
+    unmap ();
+  }
+
+
+  void MappedFile::unmap () noexcept
+  {
+    if ( p_data_ != nullptr )
+    {
+#ifdef _WIN32
+      ::UnmapViewOfFile ( p_data_ );
+#else
+      ::munmap ( const_cast<std::byte*>( p_data_ ), size_ );
+#endif /* _WIN32 */
+      p_data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+
+  // MtFile ///////////////////////////////////////////////////////////////////
+
+  MtFile::MtFile (
+      const std::filesystem::path& path,
+      ValidationEnum validation
+  )
+    : file_{ path }
+  {
+    const auto bytes{ file_.bytes () };
+    validate ( bytes, validation );
+
+    // Mappings are page aligned and the header size is checked, so the
+    // header and table can be used in place.
+    p_header_ = reinterpret_cast<const MtFormat::header_struct*>(
+        bytes.data ()
+    );
+    sections_ = {
+        reinterpret_cast<const MtFormat::section_struct*>(
+            bytes.data () + p_header_->header_bytes
+        ),
+        p_header_->num_sections
+    };
+  }
+
+
+  const MtFormat::section_struct* MtFile::find (
+      MtFormat::SectionEnum type,
+      std::size_t nth
+  ) const noexcept
+  {
+    for ( const auto& section : sections_ )
+    {
+      if (
+          section.type == static_cast<std::uint32_t>( type )
+          && nth-- == 0
+      )
+      {
+        return ( &section );
+      }
+    }
+    return ( nullptr );
+  }
+
+
+  std::size_t MtFile::chunk_count (
+      const MtFormat::section_struct& section
+  ) const noexcept
+  {
+    if ( MtFormat::section_codec ( section ) == MtFormat::CodecEnum::None )
+    {
+      return ( 1 );
+    }
+    MtFormat::chunks_struct chunks{};
+    std::memcpy ( &chunks, bytes ( section ).data (), sizeof ( chunks ) );
+    return ( chunks.num_chunks );
+  }
+
+
+  void MtFile::decode_chunk (
+      const MtFormat::section_struct& section,
+      std::size_t chunk,
+      std::span<std::byte> destination
+  ) const
+  {
+    const auto data{ bytes ( section ) };
+    const auto size{ std::size_t{ section.count } * section.stride };
+    if ( destination.size () < size )
+    {
+      throw std::invalid_argument{ "Buffer is too small for MT section" };
+    }
+    if ( MtFormat::section_codec ( section ) == MtFormat::CodecEnum::None )
+    {
+      std::memcpy ( destination.data (), data.data (), size );
+      return;
+    }
+
+    // Validation has checked the table, so chunks lie within the section.
+    MtFormat::chunks_struct chunks{};
+    std::memcpy ( &chunks, data.data (), sizeof ( chunks ) );
+    const auto* p_ends{ data.data () + sizeof ( chunks ) };
+    const auto* p_chunks{
+        p_ends + chunks.num_chunks * sizeof ( std::uint64_t )
+    };
+    std::uint64_t begin{ 0 };
+    if ( chunk > 0 )
+    {
+      std::memcpy (
+          &begin,
+          p_ends + ( chunk - 1 ) * sizeof ( begin ),
+          sizeof ( begin )
+      );
+    }
+    std::uint64_t end{};
+    std::memcpy ( &end, p_ends + chunk * sizeof ( end ), sizeof ( end ) );
+
+    const auto first{ chunk * chunks.chunk_elements };
+    const auto elements{
+        std::min<std::size_t> ( chunks.chunk_elements, section.count - first )
+    };
+    thread_local std::vector<std::byte> planes{};
+    planes.resize ( elements * section.stride );
+    auto planes_bytes{ static_cast<uLongf>( planes.size () ) };
+    if (
+        ::uncompress (
+            reinterpret_cast<Bytef*>( planes.data () ),
+            &planes_bytes,
+            reinterpret_cast<const Bytef*>( p_chunks + begin ),
+            static_cast<uLong>( end - begin )
+        ) != Z_OK
+        || planes_bytes != planes.size ()
+    )
+    {
+      throw FormatError{ "MT section chunk does not inflate to its size" };
+    }
+
+    auto* p_out{ destination.data () + first * section.stride };
+    switch (
+        MtFormat::lane_bytes (
+            MtFormat::section_format ( section ),
+            section.stride
+        )
+    )
+    {
+      case 1:
+        MtFormat::decode_planes<std::uint8_t> (
+            planes.data (), elements, section.stride, p_out
+        );
+        break;
+
+      case 2:
+        MtFormat::decode_planes<std::uint16_t> (
+            planes.data (), elements, section.stride, p_out
+        );
+        break;
+
+      default:
+        MtFormat::decode_planes<std::uint32_t> (
+            planes.data (), elements, section.stride, p_out
+        );
+        break;
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Implementation file for the mtio library.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,479 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : MtIo.h
+// SYNOPSIS : The mtio library, for reading MT files in place.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// STANDARD LIBRARY ///////////////////////////////////////////////////////////
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "MtFormat.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! The mtio library, for reading MT files in place.
+namespace MtIo
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // ENUMS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! An enumeration of how much of a file is checked when it is opened.
+  enum class ValidationEnum
+  {
+    Structure, ///< The header and section table, which is always done.
+    Checksum   ///< As Structure, and the CRC-32 of every byte as well.
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The error thrown when a file is not a valid MT file.
+  class FormatError final : public std::runtime_error
+  {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+
+  /**
+   * @brief A file mapped read-only into memory.
+   *
+   * Pages are read by the operating system as they are first touched, and
+   * are shared with its page cache, so nothing is copied.
+   */
+  class MappedFile final
+  {
+  public:
+    /**
+     * @brief Maps a file.
+     *
+     * @param[in] path The file.
+     * @throws std::system_error If the file cannot be opened or mapped.
+     */
+    explicit MappedFile ( const std::filesystem::path& path );
+
+    MappedFile ( MappedFile&& other ) noexcept;
+    MappedFile& operator= ( MappedFile&& other ) noexcept;
+    MappedFile ( const MappedFile& ) = delete;
+    MappedFile& operator= ( const MappedFile& ) = delete;
+
+    //! Unmaps the file.
+    ~MappedFile ();
+
+    /**
+     * @brief Gives the bytes of the file.
+     *
+     * @returns The bytes, valid for the life of this object.
+     */
+    std::span<const std::byte> bytes () const noexcept
+    {
+      return ( std::span<const std::byte>{ p_data_, size_ } );
+    }
+
+  private:
+    void unmap () noexcept;
+
+    const std::byte* p_data_{};
+    std::size_t size_{};
+  };
+
+
+  /**
+   * @brief An MT file mapped into memory, with typed views of its sections.
+   *
+   * Views point into the mapping, so they are valid only while this object
+   * lives, and nothing is copied when they are made.
+   */
+  class MtFile final
+  {
+  public:
+    /**
+     * @brief Maps and checks an MT file.
+     *
+     * @param[in] path The file.
+     * @param[in] validation How much of the file to check.
+     * @throws std::system_error If the file cannot be mapped.
+     * @throws FormatError If the file is not a valid MT version 3 file.
+     */
+    explicit MtFile (
+        const std::filesystem::path& path,
+        ValidationEnum validation = ValidationEnum::Structure
+    );
+
+    /**
+     * @brief Gives the header.
+     *
+     * @returns The header.
+     */
+    const MtFormat::header_struct& header () const noexcept
+    {
+      return ( *p_header_ );
+    }
+
+    /**
+     * @brief Gives the section table.
+     *
+     * @returns The entries of the table, in file order.
+     */
+    std::span<const MtFormat::section_struct> sections () const noexcept
+    {
+      return ( sections_ );
+    }
+
+    /**
+     * @brief Finds a section.
+     *
+     * @param[in] type What the section holds.
+     * @param[in] nth Which section of that type, counting from 0.
+     * @returns The nth section of that type, or \c nullptr if there is
+     * none.
+     */
+    const MtFormat::section_struct* find (
+        MtFormat::SectionEnum type,
+        std::size_t nth = 0
+    ) const noexcept;
+
+    /**
+     * @brief Gives the bytes of a section.
+     *
+     * @param[in] section An entry of sections().
+     * @returns The bytes of the section.
+     */
+    std::span<const std::byte> bytes (
+        const MtFormat::section_struct& section
+    ) const noexcept
+    {
+      return (
+          file_.bytes ().subspan (
+              static_cast<std::size_t>( section.offset ),
+              static_cast<std::size_t>( section.bytes )
+          )
+      );
+    }
+
+    /**
+     * @brief Views a section as an array of scalars.
+     *
+     * @tparam Scalar The type of each component of each element.
+     * @param[in] type What the section holds.
+     * @param[in] nth Which section of that type, counting from 0.
+     * @returns All components of all elements, or an empty view if there is
+     * no such section.
+     * @throws FormatError If the elements are not packed arrays of
+     * \c Scalar , or are compressed, when decoded() gives them.
+     */
+    template<typename Scalar>
+    std::span<const Scalar> view (
+        MtFormat::SectionEnum type,
+        std::size_t nth = 0
+    ) const
+    {
+      const auto* p_section{ find ( type, nth ) };
+      if ( p_section == nullptr )
+      {
+        return ( std::span<const Scalar>{} );
+      }
+      const auto data{ bytes ( *p_section ) };
+      if (
+          MtFormat::section_codec ( *p_section ) != MtFormat::CodecEnum::None
+      )
+      {
+        throw FormatError{ "MT section is compressed, so must be decoded" };
+      }
+      if (
+          p_section->stride % sizeof ( Scalar ) != 0
+          || p_section->stride
+              != MtFormat::format_bytes (
+                     MtFormat::section_format ( *p_section )
+                 )
+      )
+      {
+        throw FormatError{ "MT section is not a packed array of that type" };
+      }
+      return (
+          std::span<const Scalar>{
+              reinterpret_cast<const Scalar*>( data.data () ),
+              data.size () / sizeof ( Scalar )
+          }
+      );
+    }
+
+    /**
+     * @brief Gives the number of chunks a section decodes in.
+     *
+     * @param[in] section An entry of sections().
+     * @returns The number of chunks if it is compressed, and otherwise 1.
+     */
+    std::size_t chunk_count (
+        const MtFormat::section_struct& section
+    ) const noexcept;
+
+    /**
+     * @brief Decodes one chunk of a section into its place in a buffer for
+     * the whole section.
+     *
+     * Chunks are independent, so threads can decode different chunks into
+     * the same buffer at once. Each chunk is inflated into a buffer of the
+     * thread small enough to stay in cache, then joined and undelta coded
+     * straight into \c destination .
+     *
+     * @param[in] section An entry of sections().
+     * @param[in] chunk The chunk, below chunk_count().
+     * @param[out] destination At least \c count times \c stride bytes.
+     * @throws std::invalid_argument If \c destination is too small.
+     * @throws FormatError If the chunk does not inflate to its size.
+     */
+    void decode_chunk (
+        const MtFormat::section_struct& section,
+        std::size_t chunk,
+        std::span<std::byte> destination
+    ) const;
+
+    /**
+     * @brief Decodes a section, or copies it if it is not compressed.
+     *
+     * @param[in] section An entry of sections().
+     * @param[out] destination At least \c count times \c stride bytes.
+     * @throws std::invalid_argument If \c destination is too small.
+     * @throws FormatError If a chunk does not inflate to its size.
+     */
+    void decode (
+        const MtFormat::section_struct& section,
+        std::span<std::byte> destination
+    ) const
+    {
+      for ( std::size_t c{ 0 }; c < chunk_count ( section ); ++c )
+      {
+        decode_chunk ( section, c, destination );
+      }
+    }
+
+    /**
+     * @brief Decodes a section, compressed or not, into an array of
+     * scalars.
+     *
+     * @tparam Scalar The type of each component of each element.
+     * @param[in] type What the section holds.
+     * @param[in] nth Which section of that type, counting from 0.
+     * @returns All components of all elements, or nothing if there is no
+     * such section.
+     * @throws FormatError If the elements are not packed arrays of
+     * \c Scalar , or cannot be decoded.
+     */
+    template<typename Scalar>
+    std::vector<Scalar> decoded (
+        MtFormat::SectionEnum type,
+        std::size_t nth = 0
+    ) const
+    {
+      const auto* p_section{ find ( type, nth ) };
+      if ( p_section == nullptr )
+      {
+        return ( std::vector<Scalar>{} );
+      }
+      if (
+          p_section->stride % sizeof ( Scalar ) != 0
+          || p_section->stride
+              != MtFormat::format_bytes (
+                     MtFormat::section_format ( *p_section )
+                 )
+      )
+      {
+        throw FormatError{ "MT section is not a packed array of that type" };
+      }
+      std::vector<Scalar> elements (
+          std::size_t{ p_section->count } * p_section->stride
+          / sizeof ( Scalar )
+      );
+      decode ( *p_section, std::as_writable_bytes ( std::span{ elements } ) );
+      return ( elements );
+    }
+
+    //! Gives the vertex \c x , \c y , and \c z components.
+    std::span<const float> positions () const
+    {
+      return ( view<float> ( MtFormat::SectionEnum::Positions ) );
+    }
+
+    //! Gives the vertex normal \c x , \c y , and \c z components.
+    std::span<const float> normals () const
+    {
+      return ( view<float> ( MtFormat::SectionEnum::Normals ) );
+    }
+
+    //! Gives the texture \c U and \c V values of each vertex.
+    std::span<const float> tex_coords () const
+    {
+      return ( view<float> ( MtFormat::SectionEnum::TexCoords ) );
+    }
+
+    //! Gives the thirteen \c float of each material of the mesh.
+    std::span<const float> materials () const
+    {
+      return ( view<float> ( MtFormat::SectionEnum::Materials ) );
+    }
+
+    //! Gives the material of each vertex, if the mesh has one per vertex.
+    std::span<const std::uint8_t> material_indices () const
+    {
+      return ( view<std::uint8_t> ( MtFormat::SectionEnum::MaterialIndices ) );
+    }
+
+    //! Gives the diffuse colour of each vertex, if the mesh has them.
+    std::span<const float> diffuse_colours () const
+    {
+      return ( view<float> ( MtFormat::SectionEnum::DiffuseColours ) );
+    }
+
+    //! Gives the vertex indices, three for each triangle.
+    std::span<const std::uint32_t> indices () const
+    {
+      return ( view<std::uint32_t> ( MtFormat::SectionEnum::Indices ) );
+    }
+
+    /**
+     * @brief Gives the vertex indices of a coarser level of detail, which
+     * draw the same vertices as indices().
+     *
+     * @param[in] level The level, from 1 for the first below full detail.
+     * @returns Three indices for each triangle, or an empty view if the
+     * file has no such level.
+     */
+    std::span<const std::uint32_t> lod_indices ( std::size_t level ) const
+    {
+      return (
+          level == 0
+              ? indices ()
+              : view<std::uint32_t> (
+                    MtFormat::SectionEnum::LodIndices,
+                    level - 1
+                )
+      );
+    }
+
+    //! Gives the meshlets, if the file has them.
+    std::span<const MtFormat::meshlet_struct> meshlets () const
+    {
+      return (
+          view<MtFormat::meshlet_struct> ( MtFormat::SectionEnum::Meshlets )
+      );
+    }
+
+    //! Gives the vertex indices used by each meshlet in turn.
+    std::span<const std::uint32_t> meshlet_vertices () const
+    {
+      return ( view<std::uint32_t> ( MtFormat::SectionEnum::MeshletVertices ) );
+    }
+
+    //! Gives three numbers into the vertices of its meshlet for each
+    //! triangle of each meshlet in turn.
+    std::span<const std::uint8_t> meshlet_triangles () const
+    {
+      return (
+          view<std::uint8_t> ( MtFormat::SectionEnum::MeshletTriangles )
+      );
+    }
+
+    //! Gives the nodes of the bounding volume hierarchy, if the file has
+    //! one, the root first.
+    std::span<const MtFormat::bvh_node_struct> bvh () const
+    {
+      return ( view<MtFormat::bvh_node_struct> ( MtFormat::SectionEnum::Bvh ) );
+    }
+
+    //! Gives the triangles of each leaf of bvh() in turn, by their number
+    //! in indices().
+    std::span<const std::uint32_t> bvh_triangles () const
+    {
+      return ( view<std::uint32_t> ( MtFormat::SectionEnum::BvhTriangles ) );
+    }
+
+    /**
+     * @brief Gives the interleaved vertices, if the file has them, ready to
+     * be copied to the GPU as they are.
+     *
+     * @returns The bytes of all vertices, each the stride of the Vertices
+     * section, or an empty view if there are none.
+     */
+    std::span<const std::byte> vertices () const
+    {
+      const auto* p_section{ find ( MtFormat::SectionEnum::Vertices ) };
+      if ( p_section == nullptr )
+      {
+        return ( std::span<const std::byte>{} );
+      }
+      return ( bytes ( *p_section ) );
+    }
+
+    //! Gives where each attribute lies within an interleaved vertex.
+    std::span<const MtFormat::attribute_struct> vertex_layout () const
+    {
+      return (
+          view<MtFormat::attribute_struct> (
+              MtFormat::SectionEnum::VertexLayout
+          )
+      );
+    }
+
+  private:
+    MappedFile file_;
+    const MtFormat::header_struct* p_header_{};
+    std::span<const MtFormat::section_struct> sections_{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTION PROTOTYPES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Checks that bytes hold a valid MT version 3 file.
+   *
+   * The header must be that of this version and byte order, every section
+   * must lie within the file at an aligned offset, and its size must match
+   * its count and stride, or for a compressed section, its chunk table.
+   * Interleaved vertices must have a layout whose attributes all lie within
+   * the stride.
+   *
+   * @param[in] file The bytes of the file.
+   * @param[in] validation How much of the file to check.
+   * @throws FormatError Saying what is wrong, if anything is.
+   */
+  void validate ( std::span<const std::byte> file, ValidationEnum validation );
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief The mtio library, for reading MT files in place.
+ *
+ * The library is this header, MtIo.cpp, and MtFormat.h, which MeshTools
+ * writes files with.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,611 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Bvh.h
+// SYNOPSIS : Utilities for building bounding volume hierarchies of meshes.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "Jobs.h"
+#include "../mtio/MtFormat.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for building bounding volume hierarchies of meshes.
+namespace Bvh
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The number of bins triangle centres are sorted into to find a split.
+  const std::size_t BINS{ 16 };
+
+  //! The most triangles a leaf can have.
+  const std::size_t MAX_LEAF_TRIANGLES{ 8 };
+
+  //! The cost of visiting a node, against that of testing a triangle.
+  const float TRAVERSAL_COST{ 1.0f };
+
+  //! How many subtrees each worker is given, so that uneven ones balance.
+  const std::size_t SUBTREES_PER_WORKER{ 4 };
+
+  //! How deep the nodes split before subtrees are built can go.
+  const std::size_t MAX_TOP_DEPTH{ 32 };
+
+  //! The index of no node.
+  const std::uint32_t NO_NODE{ std::numeric_limits<std::uint32_t>::max () };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief An axis aligned box, empty until grown.
+   *
+   * @ingroup STRUCT
+   */
+  struct box_struct
+  {
+    //! The smallest \c x , \c y , and \c z .
+    std::array<float, 3> min{
+        std::numeric_limits<float>::max (),
+        std::numeric_limits<float>::max (),
+        std::numeric_limits<float>::max ()
+    };
+    //! The largest \c x , \c y , and \c z .
+    std::array<float, 3> max{
+        std::numeric_limits<float>::lowest (),
+        std::numeric_limits<float>::lowest (),
+        std::numeric_limits<float>::lowest ()
+    };
+  };
+
+  /**
+   * @brief A triangle and its box, moved about as nodes are split so that
+   * each node's triangles lie together.
+   *
+   * @ingroup STRUCT
+   */
+  struct reference_struct
+  {
+    //! The box of the triangle.
+    box_struct box{};
+    //! The number of the triangle.
+    std::uint32_t triangle{};
+  };
+
+  /**
+   * @brief A bounding volume hierarchy, laid out as its MT sections are.
+   *
+   * @ingroup STRUCT
+   */
+  struct hierarchy_struct
+  {
+    //! The nodes, depth first.
+    std::vector<MtFormat::bvh_node_struct> nodes{};
+    //! The triangles of each leaf in turn.
+    std::vector<std::uint32_t> triangles{};
+  };
+
+  /**
+   * @brief A node split before the subtrees below it are built.
+   *
+   * @ingroup STRUCT
+   */
+  struct top_node_struct
+  {
+    //! The box of its triangles.
+    box_struct box{};
+    //! Where its triangles start.
+    std::size_t begin{};
+    //! Where its triangles end.
+    std::size_t end{};
+    //! Its children in the top nodes, or NO_NODE for a subtree.
+    std::array<std::uint32_t, 2> children{ NO_NODE, NO_NODE };
+    //! Its subtree, if it is one.
+    std::uint32_t subtree{ NO_NODE };
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Grows a box to take in another.
+   *
+   * @param[in,out] box The box grown.
+   * @param[in] other The box to take in.
+   */
+  inline void grow ( box_struct& box, const box_struct& other ) noexcept
+  {
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      box.min[k] = std::min ( box.min[k], other.min[k] );
+      box.max[k] = std::max ( box.max[k], other.max[k] );
+    }
+  }
+
+  /**
+   * @brief Gives half the surface area of a box that is not empty.
+   *
+   * @param[in] box The box.
+   * @returns The area.
+   */
+  inline float half_area ( const box_struct& box ) noexcept
+  {
+    const auto dx{ box.max[0] - box.min[0] };
+    const auto dy{ box.max[1] - box.min[1] };
+    const auto dz{ box.max[2] - box.min[2] };
+    return ( dx * dy + dy * dz + dz * dx );
+  }
+
+  /**
+   * @brief Gives twice the centre of a box along an axis.
+   *
+   * @param[in] box The box.
+   * @param[in] axis The axis.
+   * @returns The sum of its least and greatest values.
+   */
+  inline float centre2 ( const box_struct& box, std::size_t axis ) noexcept
+  {
+    return ( box.min[axis] + box.max[axis] );
+  }
+
+  /**
+   * @brief Gives the box of some triangles.
+   *
+   * @param[in] references The triangles of all nodes.
+   * @param[in] begin Where the triangles start.
+   * @param[in] end Where they end.
+   * @returns The box.
+   */
+  box_struct bound (
+      std::span<const reference_struct> references,
+      std::size_t begin,
+      std::size_t end
+  )
+  {
+    box_struct box{};
+    for ( auto j{ begin }; j < end; ++j )
+    {
+      grow ( box, references[j].box );
+    }
+    return ( box );
+  }
+
+  /**
+   * @brief Finds where to split the triangles of a node, by the surface
+   * area heuristic over bins of their centres.
+   *
+   * The triangles are reordered so that those of the first child come
+   * first. A node of few enough triangles that no split makes cheaper
+   * stays a leaf, and one whose triangle centres all coincide is split in
+   * half.
+   *
+   * @param[in,out] references The triangles of all nodes.
+   * @param[in] begin Where the triangles of the node start.
+   * @param[in] end Where they end.
+   * @param[in] box The box of the node.
+   * @param[out] children The boxes of the children, if it is split.
+   * @returns Where the triangles of the second child start, or \c begin if
+   * the node is a leaf.
+   */
+  std::size_t split (
+      std::span<reference_struct> references,
+      std::size_t begin,
+      std::size_t end,
+      const box_struct& box,
+      std::array<box_struct, 2>& children
+  )
+  {
+    const auto count{ end - begin };
+    if ( count <= 1 )
+    {
+      return ( begin );
+    }
+    box_struct centres{};
+    for ( auto j{ begin }; j < end; ++j )
+    {
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        const auto c{ centre2 ( references[j].box, k ) };
+        centres.min[k] = std::min ( centres.min[k], c );
+        centres.max[k] = std::max ( centres.max[k], c );
+      }
+    }
+
+    // Costs are scaled by the area of the node, so that flat nodes compare.
+    // Small nodes need no more bins than triangles.
+    const auto bins{ std::min ( BINS, count ) };
+    const auto area{ half_area ( box ) };
+    auto best_cost{ static_cast<float>( count ) * area };
+    std::size_t best_axis{ 3 };
+    std::size_t best_bin{ 0 };
+    for ( std::size_t axis{ 0 }; axis < 3; ++axis )
+    {
+      const auto extent{ centres.max[axis] - centres.min[axis] };
+      if ( !( extent > 0.0f ) )
+      {
+        continue;
+      }
+      const auto scale{ static_cast<float>( bins ) / extent };
+      std::array<box_struct, BINS> bin_boxes{};
+      std::array<std::size_t, BINS> bin_counts{};
+      for ( auto j{ begin }; j < end; ++j )
+      {
+        const auto& triangle{ references[j].box };
+        const auto bin{
+            std::min (
+                static_cast<std::size_t>(
+                    ( centre2 ( triangle, axis ) - centres.min[axis] ) * scale
+                ),
+                bins - 1
+            )
+        };
+        grow ( bin_boxes[bin], triangle );
+        ++bin_counts[bin];
+      }
+
+      // The right side of each split, swept from the right.
+      std::array<box_struct, BINS> right_boxes{};
+      std::array<float, BINS> right_costs{};
+      std::size_t right_count{ 0 };
+      for ( auto bin{ bins - 1 }; bin > 0; --bin )
+      {
+        right_boxes[bin - 1] = right_boxes[bin];
+        grow ( right_boxes[bin - 1], bin_boxes[bin] );
+        right_count += bin_counts[bin];
+        right_costs[bin - 1] = right_count == 0
+            ? 0.0f
+            : half_area ( right_boxes[bin - 1] )
+                * static_cast<float>( right_count );
+      }
+      box_struct left{};
+      std::size_t left_count{ 0 };
+      for ( std::size_t bin{ 0 }; bin < bins - 1; ++bin )
+      {
+        grow ( left, bin_boxes[bin] );
+        left_count += bin_counts[bin];
+        if ( left_count == 0 || left_count == count )
+        {
+          continue;
+        }
+        const auto cost{
+            TRAVERSAL_COST * area
+            + half_area ( left ) * static_cast<float>( left_count )
+            + right_costs[bin]
+        };
+        if ( cost < best_cost )
+        {
+          best_cost = cost;
+          best_axis = axis;
+          best_bin = bin;
+          children = { left, right_boxes[bin] };
+        }
+      }
+    }
+
+    if ( best_axis == 3 )
+    {
+      if ( count <= MAX_LEAF_TRIANGLES )
+      {
+        return ( begin );
+      }
+      // Nothing tells the triangles apart, so any half will do.
+      if ( !( centres.max[0] > centres.min[0] )
+          && !( centres.max[1] > centres.min[1] )
+          && !( centres.max[2] > centres.min[2] ) )
+      {
+        const auto mid{ begin + count / 2 };
+        children = {
+            bound ( references, begin, mid ),
+            bound ( references, mid, end )
+        };
+        return ( mid );
+      }
+      // Splits exist, but cost more than a leaf too big to keep, so the
+      // widest axis is split in the middle.
+      for ( std::size_t axis{ 0 }; axis < 3; ++axis )
+      {
+        if (
+            best_axis == 3
+            || centres.max[axis] - centres.min[axis]
+                > centres.max[best_axis] - centres.min[best_axis]
+        )
+        {
+          best_axis = axis;
+        }
+      }
+      best_bin = bins / 2 - 1;
+      children = {};
+    }
+
+    const auto scale{
+        static_cast<float>( bins )
+        / ( centres.max[best_axis] - centres.min[best_axis] )
+    };
+    const auto middle{
+        std::partition (
+            references.begin () + begin,
+            references.begin () + end,
+            [&] ( const reference_struct& reference )
+            {
+              const auto bin{
+                  std::min (
+                      static_cast<std::size_t>(
+                          ( centre2 ( reference.box, best_axis )
+                              - centres.min[best_axis] ) * scale
+                      ),
+                      bins - 1
+                  )
+              };
+              return ( bin <= best_bin );
+            }
+        )
+    };
+    auto mid{ static_cast<std::size_t>( middle - references.begin () ) };
+    if ( mid == begin || mid == end )
+    {
+      mid = begin + count / 2;
+      children = {};
+    }
+    if ( children[0].min[0] > children[0].max[0] )
+    {
+      children = {
+          bound ( references, begin, mid ),
+          bound ( references, mid, end )
+      };
+    }
+    return ( mid );
+  }
+
+  /**
+   * @brief Builds the nodes below a node, depth first.
+   *
+   * @param[in,out] references The triangles of all nodes.
+   * @param[in] begin Where the triangles of the node start.
+   * @param[in] end Where they end.
+   * @param[in] box The box of the node.
+   * @returns The nodes, the node itself first, with second children
+   * numbered from it.
+   */
+  std::vector<MtFormat::bvh_node_struct> build_subtree (
+      std::span<reference_struct> references,
+      std::size_t begin,
+      std::size_t end,
+      const box_struct& box
+  )
+  {
+    struct task_struct
+    {
+      std::size_t begin{};
+      std::size_t end{};
+      box_struct box{};
+      std::uint32_t parent{ NO_NODE };
+    };
+
+    std::vector<MtFormat::bvh_node_struct> nodes{};
+    std::vector<task_struct> tasks{ task_struct{ begin, end, box } };
+    while ( !tasks.empty () )
+    {
+      const auto task{ tasks.back () };
+      tasks.pop_back ();
+      const auto index{ static_cast<std::uint32_t>( nodes.size () ) };
+      if ( task.parent != NO_NODE )
+      {
+        nodes[task.parent].first = index;
+      }
+      auto& node{ nodes.emplace_back () };
+      node.bounds_min = task.box.min;
+      node.bounds_max = task.box.max;
+      std::array<box_struct, 2> children{};
+      const auto mid{
+          split ( references, task.begin, task.end, task.box, children )
+      };
+      if ( mid == task.begin )
+      {
+        node.first = static_cast<std::uint32_t>( task.begin );
+        node.count = static_cast<std::uint32_t>( task.end - task.begin );
+        continue;
+      }
+
+      // The first child is taken next, so that it follows its parent.
+      tasks.emplace_back (
+          task_struct{ mid, task.end, children[1], index }
+      );
+      tasks.emplace_back ( task_struct{ task.begin, mid, children[0] } );
+    }
+    return ( nodes );
+  }
+
+  /**
+   * @brief Builds a bounding volume hierarchy of the triangles of a mesh.
+   *
+   * Nodes are split by the surface area heuristic. The top of the
+   * hierarchy is split first, until its nodes are small enough to give
+   * each worker several, and the subtrees below are then built at once.
+   * The splits do not depend on the workers, so neither does the result.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] workers The number of workers to build with.
+   * @returns The hierarchy, with no nodes if there are no triangles.
+   */
+  hierarchy_struct build (
+      std::span<const std::uint32_t> indices,
+      const float* p_positions,
+      unsigned workers
+  )
+  {
+    hierarchy_struct result{};
+    const auto num_triangles{ indices.size () / 3 };
+    if ( num_triangles == 0 )
+    {
+      return ( result );
+    }
+    std::vector<reference_struct> references( num_triangles );
+    for ( std::size_t t{ 0 }; t < num_triangles; ++t )
+    {
+      references[t].triangle = static_cast<std::uint32_t>( t );
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        for ( std::size_t m{ 0 }; m < 3; ++m )
+        {
+          const auto value{
+              p_positions[indices[t * 3 + k] * std::size_t{ 3 } + m]
+          };
+          auto& box{ references[t].box };
+          box.min[m] = std::min ( box.min[m], value );
+          box.max[m] = std::max ( box.max[m], value );
+        }
+      }
+    }
+
+    // The top, split one node at a time.
+    const auto subtree_triangles{
+        std::max<std::size_t> (
+            num_triangles / ( std::size_t{ workers } * SUBTREES_PER_WORKER ),
+            MAX_LEAF_TRIANGLES
+        )
+    };
+    std::vector<top_node_struct> top{
+        top_node_struct{
+            .box{ bound ( references, 0, num_triangles ) },
+            .end{ num_triangles }
+        }
+    };
+    std::vector<std::pair<std::uint32_t, std::size_t>> pending{ { 0, 0 } };
+    std::vector<std::uint32_t> subtrees{};
+    while ( !pending.empty () )
+    {
+      const auto [n, depth]{ pending.back () };
+      pending.pop_back ();
+      const auto node{ top[n] };
+      std::array<box_struct, 2> children{};
+      const auto mid{
+          node.end - node.begin <= subtree_triangles || depth == MAX_TOP_DEPTH
+              ? node.begin
+              : split (
+                    references,
+                    node.begin,
+                    node.end,
+                    node.box,
+                    children
+                )
+      };
+      if ( mid == node.begin )
+      {
+        top[n].subtree = static_cast<std::uint32_t>( subtrees.size () );
+        subtrees.emplace_back ( n );
+        continue;
+      }
+      const std::array<std::size_t, 3> ends{ node.begin, mid, node.end };
+      for ( std::size_t c{ 0 }; c < 2; ++c )
+      {
+        const auto child{ static_cast<std::uint32_t>( top.size () ) };
+        top[n].children[c] = child;
+        pending.emplace_back ( child, depth + 1 );
+        top.emplace_back (
+            top_node_struct{
+                .box{ children[c] },
+                .begin{ ends[c] },
+                .end{ ends[c + 1] }
+            }
+        );
+      }
+    }
+
+    // Subtrees cover separate runs of the triangles, so can be built at
+    // once.
+    std::vector<std::vector<MtFormat::bvh_node_struct>> built(
+        subtrees.size ()
+    );
+    Jobs::parallel_for (
+        subtrees.size (),
+        Jobs::worker_count ( workers, subtrees.size () ),
+        [&] ( std::size_t s, unsigned )
+        {
+          const auto& node{ top[subtrees[s]] };
+          built[s] = build_subtree (
+              references,
+              node.begin,
+              node.end,
+              node.box
+          );
+        }
+    );
+
+    result.triangles.reserve ( num_triangles );
+    for ( const auto& reference : references )
+    {
+      result.triangles.emplace_back ( reference.triangle );
+    }
+
+    // The top nodes are laid out depth first, with each subtree in place.
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> stack{
+        { 0, NO_NODE }
+    };
+    while ( !stack.empty () )
+    {
+      const auto [n, parent]{ stack.back () };
+      stack.pop_back ();
+      const auto index{ static_cast<std::uint32_t>( result.nodes.size () ) };
+      if ( parent != NO_NODE )
+      {
+        result.nodes[parent].first = index;
+      }
+      const auto& node{ top[n] };
+      if ( node.subtree != NO_NODE )
+      {
+        for ( auto subtree_node : built[node.subtree] )
+        {
+          if ( subtree_node.count == 0 )
+          {
+            subtree_node.first += index;
+          }
+          result.nodes.emplace_back ( subtree_node );
+        }
+        continue;
+      }
+      result.nodes.emplace_back (
+          MtFormat::bvh_node_struct{
+              .bounds_min{ node.box.min },
+              .bounds_max{ node.box.max }
+          }
+      );
+      stack.emplace_back ( node.children[1], index );
+      stack.emplace_back ( node.children[0], NO_NODE );
+    }
+    return ( result );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for building bounding volume hierarchies of meshes.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
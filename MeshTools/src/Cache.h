@@ -0,0 +1,890 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Cache.h
+// SYNOPSIS : Utilities for skipping conversion work already done.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for the caches of conversions and imported scenes.
+namespace Cache
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The extension added to an input file for its manifest.
+  const auto* MANIFEST_EXTENSION{ ".mtcache" };
+
+  //! The first line of every manifest, naming its format.
+  const auto* MANIFEST_MAGIC{ "MTCACHE 3" };
+
+  //! What a line naming a file that an input was imported from starts with.
+  const auto* DEPENDENCY_FIELD{ "dependency" };
+
+  //! The hash recorded for a file that an importer looked for but could not
+  //! read, so that it appearing later is seen as a change.
+  const auto* MISSING_CONTENT{ "missing" };
+
+  //! The bytes of an input file read and hashed at once.
+  const std::size_t HASH_BLOCK_BYTES{ 1'048'576 };
+
+  //! The bytes hashed at once by the four lanes of the hash.
+  const std::size_t HASH_STRIPE_BYTES{ 32 };
+
+  //! The primes of the XXH64 hash.
+  const std::array<std::uint64_t, 5> HASH_PRIMES{
+      0x9E3779B185EBCA87ULL,
+      0xC2B2AE3D27D4EB4FULL,
+      0x165667B19E3779F9ULL,
+      0x85EBCA77C2B2AE63ULL,
+      0x27D4EB2F165667C5ULL
+  };
+
+  //! The Assimp export format post-processed scenes are cached in.
+  const auto* SCENE_FORMAT{ "assbin" };
+
+  //! The extension of cached post-processed scenes.
+  const auto* SCENE_EXTENSION{ ".assbin" };
+
+  //! The extension of the list of files a cached scene was imported from.
+  const auto* DEPENDENCIES_EXTENSION{ ".deps" };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // ENUMS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! An enumeration of what looking up an input file found.
+  enum class LookupEnum
+  {
+    Hit,        ///< Its outputs are current, so it need not be converted.
+    NoManifest, ///< It has never been converted with the cache.
+    KeyChanged, ///< It, the options, or MeshTools have changed since.
+    DependencyChanged, ///< A file it was imported from has changed since.
+    OutputChanged ///< An output has gone or been changed since.
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief An XXH64 hash of bytes given in pieces.
+   *
+   * @ingroup STRUCT
+   */
+  struct hash_struct
+  {
+    //! The four lanes the stripes are hashed into.
+    std::array<std::uint64_t, 4> lanes{
+        HASH_PRIMES[0] + HASH_PRIMES[1],
+        HASH_PRIMES[1],
+        0,
+        0 - HASH_PRIMES[0]
+    };
+    //! The bytes given since the last whole stripe.
+    std::array<std::byte, HASH_STRIPE_BYTES> pending{};
+    //! The number of pending bytes.
+    std::size_t pending_bytes{};
+    //! The number of bytes given.
+    std::uint64_t total_bytes{};
+  };
+
+  /**
+   * @brief A file other than an input file that importing it read or looked
+   * for, such as a glTF buffer, an OBJ material library, or a texture.
+   *
+   * @ingroup STRUCT
+   */
+  struct dependency_struct
+  {
+    //! The name of the file, as the importer gave it.
+    std::string name{};
+    //! Its hash from content_hash(), or MISSING_CONTENT.
+    std::string content{};
+  };
+
+  /**
+   * @brief The number of input files found and not found in the cache.
+   *
+   * @ingroup STRUCT
+   */
+  struct report_struct
+  {
+    //! Files skipped as their outputs were current.
+    std::atomic<std::size_t> hits{};
+    //! Files converted.
+    std::atomic<std::size_t> misses{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Reads files for an importer as Assimp does by default, noting the
+   * name of every file it opens or looks for.
+   *
+   * Only an import can tell which files beside an input file it reads, so
+   * the cache learns them here and checks them as it checks the input.
+   */
+  class DependencyRecorder final : public Assimp::DefaultIOSystem
+  {
+  public:
+    bool Exists ( const char* p_file ) const override
+    {
+      note ( p_file );
+      return ( Assimp::DefaultIOSystem::Exists ( p_file ) );
+    }
+
+    Assimp::IOStream* Open (
+        const char* p_file,
+        const char* p_mode = "rb"
+    ) override
+    {
+      note ( p_file );
+      return ( Assimp::DefaultIOSystem::Open ( p_file, p_mode ) );
+    }
+
+    /**
+     * @brief Gives the names noted since they were last taken, and forgets
+     * them.
+     *
+     * @returns The names, each once, in the order first noted.
+     */
+    std::vector<std::string> take ()
+    {
+      auto names{ std::move ( names_ ) };
+      names_.clear ();
+      return ( names );
+    }
+
+  private:
+    void note ( const char* p_file ) const
+    {
+      if (
+          p_file != nullptr
+          && std::find ( names_.begin (), names_.end (), p_file )
+              == names_.end ()
+      )
+      {
+        names_.emplace_back ( p_file );
+      }
+    }
+
+    //! Assimp looks files up through a const interface.
+    mutable std::vector<std::string> names_{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Gives the manifest of an input file.
+   *
+   * @param[in] f The name of the input file.
+   * @returns The name of its manifest, beside it as its outputs are.
+   */
+  std::string manifest_name ( const std::string& f )
+  {
+    return ( f + MANIFEST_EXTENSION );
+  }
+
+  /**
+   * @brief Gives a name to write a file under before renaming it into
+   * place, unique to this process, thread, and call, so that workers or
+   * runs writing the same file at once never write into each other.
+   *
+   * @param[in] f The name of the file once renamed.
+   * @returns The temporary name, beside it.
+   */
+  std::string temporary_name ( const std::string& f )
+  {
+    static std::atomic<std::uint64_t> count{ 0 };
+    std::ostringstream name{};
+    name << f << "." << GetProcessId ( GetCurrentProcess () ) << "."
+        << std::this_thread::get_id () << "." << count++ << ".tmp";
+    return ( name.str () );
+  }
+
+  /**
+   * @brief Reads eight bytes as a little-endian number.
+   *
+   * @param[in] p_bytes The bytes.
+   * @returns The number.
+   */
+  std::uint64_t hash_word ( const std::byte* p_bytes )
+  {
+    std::uint64_t word{};
+    std::memcpy ( &word, p_bytes, sizeof ( word ) );
+    return ( word );
+  }
+
+  /**
+   * @brief Mixes eight bytes into a lane of the hash.
+   *
+   * @param[in] lane The lane.
+   * @param[in] word The bytes, from hash_word().
+   * @returns The new lane.
+   */
+  std::uint64_t hash_round ( std::uint64_t lane, std::uint64_t word )
+  {
+    lane += word * HASH_PRIMES[1];
+    return ( std::rotl ( lane, 31 ) * HASH_PRIMES[0] );
+  }
+
+  /**
+   * @brief Adds bytes to a hash.
+   *
+   * @param[in,out] hash The hash.
+   * @param[in] bytes The bytes, following those already given.
+   */
+  void hash_update ( hash_struct& hash, std::span<const std::byte> bytes )
+  {
+    hash.total_bytes += bytes.size ();
+    const auto stripe{
+        [&] ( const std::byte* p_stripe )
+        {
+          for ( std::size_t k{ 0 }; k < hash.lanes.size (); ++k )
+          {
+            hash.lanes[k] =
+                hash_round ( hash.lanes[k], hash_word ( p_stripe + k * 8 ) );
+          }
+        }
+    };
+    if ( hash.pending_bytes > 0 )
+    {
+      const auto taken{
+          std::min ( HASH_STRIPE_BYTES - hash.pending_bytes, bytes.size () )
+      };
+      std::memcpy (
+          hash.pending.data () + hash.pending_bytes,
+          bytes.data (),
+          taken
+      );
+      hash.pending_bytes += taken;
+      bytes = bytes.subspan ( taken );
+      if ( hash.pending_bytes < HASH_STRIPE_BYTES )
+      {
+        return;
+      }
+      stripe ( hash.pending.data () );
+      hash.pending_bytes = 0;
+    }
+    while ( bytes.size () >= HASH_STRIPE_BYTES )
+    {
+      stripe ( bytes.data () );
+      bytes = bytes.subspan ( HASH_STRIPE_BYTES );
+    }
+    std::memcpy ( hash.pending.data (), bytes.data (), bytes.size () );
+    hash.pending_bytes = bytes.size ();
+  }
+
+  /**
+   * @brief Finishes a hash.
+   *
+   * @param[in] hash The hash, with all its bytes given.
+   * @returns The XXH64 of the bytes, with a seed of zero.
+   */
+  std::uint64_t hash_digest ( const hash_struct& hash )
+  {
+    std::uint64_t digest{};
+    if ( hash.total_bytes >= HASH_STRIPE_BYTES )
+    {
+      digest =
+          std::rotl ( hash.lanes[0], 1 ) + std::rotl ( hash.lanes[1], 7 )
+          + std::rotl ( hash.lanes[2], 12 ) + std::rotl ( hash.lanes[3], 18 );
+      for ( const auto lane : hash.lanes )
+      {
+        digest ^= hash_round ( 0, lane );
+        digest = digest * HASH_PRIMES[0] + HASH_PRIMES[3];
+      }
+    }
+    else
+    {
+      digest = HASH_PRIMES[4];
+    }
+    digest += hash.total_bytes;
+
+    const auto* p{ hash.pending.data () };
+    const auto* p_end{ p + hash.pending_bytes };
+    for ( ; p + 8 <= p_end; p += 8 )
+    {
+      digest ^= hash_round ( 0, hash_word ( p ) );
+      digest = std::rotl ( digest, 27 ) * HASH_PRIMES[0] + HASH_PRIMES[3];
+    }
+    if ( p + 4 <= p_end )
+    {
+      std::uint32_t word{};
+      std::memcpy ( &word, p, sizeof ( word ) );
+      digest ^= word * HASH_PRIMES[0];
+      digest = std::rotl ( digest, 23 ) * HASH_PRIMES[1] + HASH_PRIMES[2];
+      p += 4;
+    }
+    for ( ; p < p_end; ++p )
+    {
+      digest ^= std::to_integer<std::uint64_t>( *p ) * HASH_PRIMES[4];
+      digest = std::rotl ( digest, 11 ) * HASH_PRIMES[0];
+    }
+
+    digest ^= digest >> 33;
+    digest *= HASH_PRIMES[1];
+    digest ^= digest >> 29;
+    digest *= HASH_PRIMES[2];
+    digest ^= digest >> 32;
+    return ( digest );
+  }
+
+  /**
+   * @brief Hashes a string, for naming files by a key.
+   *
+   * @param[in] text The string.
+   * @returns Its XXH64, as sixteen hexadecimal digits.
+   */
+  std::string hash_text ( const std::string& text )
+  {
+    hash_struct state{};
+    hash_update ( state, std::as_bytes ( std::span{ text } ) );
+    std::ostringstream hash{};
+    hash << std::hex << std::setfill ( '0' ) << std::setw ( 16 )
+        << hash_digest ( state );
+    return ( hash.str () );
+  }
+
+  /**
+   * @brief Hashes the contents of an input file.
+   *
+   * The contents are hashed with XXH64, which runs at memory speed and,
+   * unlike a checksum, spreads every change over all 64 bits, and their
+   * size is added, so that an unchanged file is found without trusting its
+   * timestamp.
+   *
+   * @param[in] f The name of the input file.
+   * @returns The hash, or an empty string if the file cannot be read.
+   */
+  std::string content_hash ( const std::string& f )
+  {
+    std::ifstream input{ f, std::ios_base::in | std::ios_base::binary };
+    if ( !input )
+    {
+      return ( std::string{} );
+    }
+    std::vector<char> block( HASH_BLOCK_BYTES );
+    hash_struct state{};
+    while ( input )
+    {
+      input.read (
+          block.data (),
+          static_cast<std::streamsize>( block.size () )
+      );
+      const auto length{ static_cast<std::size_t>( input.gcount () ) };
+      hash_update (
+          state,
+          std::as_bytes ( std::span{ block.data (), length } )
+      );
+    }
+    if ( !input.eof () )
+    {
+      return ( std::string{} );
+    }
+
+    std::ostringstream hash{};
+    hash << std::hex << std::setfill ( '0' ) << "input=" << std::setw ( 16 )
+        << hash_digest ( state ) << std::dec << "-" << state.total_bytes;
+    return ( hash.str () );
+  }
+
+  /**
+   * @brief Hashes a file that an input file was imported from.
+   *
+   * @param[in] name The name of the file.
+   * @returns The file, with its hash.
+   */
+  dependency_struct hash_dependency ( const std::string& name )
+  {
+    const auto content{ content_hash ( name ) };
+    return (
+        dependency_struct{
+            name,
+            content.empty () ? MISSING_CONTENT : content
+        }
+    );
+  }
+
+  /**
+   * @brief Hashes the files that importing an input file read or looked
+   * for, other than the input file itself.
+   *
+   * @param[in] f The name of the input file.
+   * @param[in] names The names noted by a DependencyRecorder.
+   * @returns The files, with their hashes.
+   */
+  std::vector<dependency_struct> hash_dependencies (
+      const std::string& f,
+      const std::vector<std::string>& names
+  )
+  {
+    std::vector<dependency_struct> dependencies{};
+    for ( const auto& name : names )
+    {
+      std::error_code ec{};
+      if ( name == f || std::filesystem::equivalent ( name, f, ec ) )
+      {
+        continue;
+      }
+      dependencies.push_back ( hash_dependency ( name ) );
+    }
+    return ( dependencies );
+  }
+
+  /**
+   * @brief Checks that a file an input was imported from is unchanged.
+   *
+   * @param[in] dependency The file, with its hash when imported.
+   * @returns \c true if it still has that hash, or is still missing.
+   */
+  bool is_current ( const dependency_struct& dependency )
+  {
+    return (
+        hash_dependency ( dependency.name ).content == dependency.content
+    );
+  }
+
+  /**
+   * @brief Gives the line recording a file an input was imported from.
+   *
+   * @param[in] dependency The file, with its hash.
+   * @returns The line, without its end.
+   */
+  std::string dependency_line ( const dependency_struct& dependency )
+  {
+    return (
+        std::string{ DEPENDENCY_FIELD } + " " + dependency.content + " "
+        + dependency.name
+    );
+  }
+
+  /**
+   * @brief Reads a line from dependency_line().
+   *
+   * @param[in] line The line.
+   * @param[out] dependency The file it records.
+   * @returns \c true if the line records a file.
+   */
+  bool read_dependency (
+      const std::string& line,
+      dependency_struct& dependency
+  )
+  {
+    std::istringstream fields{ line };
+    std::string field{};
+    fields >> field >> dependency.content;
+    std::getline ( fields >> std::ws, dependency.name );
+    return ( !fields.fail () && field == DEPENDENCY_FIELD );
+  }
+
+  /**
+   * @brief Makes the key an input file is cached under.
+   *
+   * @param[in] content Its hash from content_hash().
+   * @param[in] settings Everything else the outputs depend on, on one line.
+   * @returns The key, or an empty string if the file could not be read.
+   */
+  std::string file_key (
+      const std::string& content,
+      const std::string& settings
+  )
+  {
+    return ( content.empty () ? content : content + " " + settings );
+  }
+
+  /**
+   * @brief Gives when a file was last written, as finely as its file system
+   * records it, so that a file rewritten within the same second is seen to
+   * have changed.
+   *
+   * @param[in] f The name of the file.
+   * @param[out] ec Set if the time cannot be read.
+   * @returns The time, in ticks of the file clock.
+   */
+  std::int64_t write_time ( const std::string& f, std::error_code& ec )
+  {
+    const auto written{ std::filesystem::last_write_time ( f, ec ) };
+    return (
+        static_cast<std::int64_t>( written.time_since_epoch ().count () )
+    );
+  }
+
+  /**
+   * @brief Looks up whether the outputs of an input file are current.
+   *
+   * Outputs must still have the size and time of last writing the manifest
+   * recorded, so that one edited or replaced since is converted again. The
+   * files the input was imported from must still have the hashes recorded,
+   * as the input itself must still have the hash in its key, and are only
+   * hashed once every output is found current.
+   *
+   * @param[in] f The name of the input file.
+   * @param[in] key Its key from file_key().
+   * @returns What was found.
+   */
+  LookupEnum lookup ( const std::string& f, const std::string& key )
+  {
+    std::ifstream manifest{ manifest_name ( f ) };
+    std::string line{};
+    if ( !std::getline ( manifest, line ) || line != MANIFEST_MAGIC )
+    {
+      return ( LookupEnum::NoManifest );
+    }
+    if ( !std::getline ( manifest, line ) || line != "key " + key )
+    {
+      return ( LookupEnum::KeyChanged );
+    }
+
+    // Each line gives a file the input was imported from, or the size and
+    // time of an output, then its name, which may hold spaces.
+    std::vector<dependency_struct> dependencies{};
+    while ( std::getline ( manifest, line ) )
+    {
+      dependency_struct dependency{};
+      if ( read_dependency ( line, dependency ) )
+      {
+        dependencies.push_back ( std::move ( dependency ) );
+        continue;
+      }
+      std::istringstream fields{ line };
+      std::uintmax_t bytes{};
+      std::int64_t written{};
+      std::string output{};
+      fields >> bytes >> written;
+      std::getline ( fields >> std::ws, output );
+      boost::system::error_code ec{};
+      std::error_code time_ec{};
+      if (
+          !fields
+          || boost::filesystem::file_size ( output, ec ) != bytes || ec
+          || write_time ( output, time_ec ) != written || time_ec
+      )
+      {
+        return ( LookupEnum::OutputChanged );
+      }
+    }
+    for ( const auto& dependency : dependencies )
+    {
+      if ( !is_current ( dependency ) )
+      {
+        return ( LookupEnum::DependencyChanged );
+      }
+    }
+    return ( LookupEnum::Hit );
+  }
+
+  /**
+   * @brief Records the outputs of an input file just converted.
+   *
+   * The manifest is written beside the input under a name from
+   * temporary_name() then renamed over any old one, so that a run stopped
+   * part way never leaves a manifest naming outputs that were not all
+   * written.
+   *
+   * @param[in] f The name of the input file.
+   * @param[in] key Its key from file_key().
+   * @param[in] dependencies The files it was imported from.
+   * @param[in] outputs The names of the files it was converted into.
+   * @returns \c true if the manifest was written.
+   */
+  bool store (
+      const std::string& f,
+      const std::string& key,
+      const std::vector<dependency_struct>& dependencies,
+      const std::vector<std::string>& outputs
+  )
+  {
+    const auto name{ manifest_name ( f ) };
+    const auto temporary{ temporary_name ( name ) };
+    {
+      std::ofstream manifest{
+          temporary,
+          std::ios_base::out | std::ios_base::trunc
+      };
+      manifest << MANIFEST_MAGIC << "\n" << "key " << key << "\n";
+      for ( const auto& dependency : dependencies )
+      {
+        manifest << dependency_line ( dependency ) << "\n";
+      }
+      for ( const auto& output : outputs )
+      {
+        boost::system::error_code ec{};
+        const auto bytes{ boost::filesystem::file_size ( output, ec ) };
+        std::error_code time_ec{};
+        const auto written{ write_time ( output, time_ec ) };
+        if ( ec || time_ec )
+        {
+          manifest.close ();
+          boost::filesystem::remove ( temporary, ec );
+          return ( false );
+        }
+        manifest << bytes << " " << written << " " << output << "\n";
+      }
+      manifest.close ();
+      if ( manifest.fail () )
+      {
+        boost::system::error_code ec{};
+        boost::filesystem::remove ( temporary, ec );
+        return ( false );
+      }
+    }
+    boost::system::error_code ec{};
+    boost::filesystem::rename ( temporary, name, ec );
+    if ( ec )
+    {
+      boost::system::error_code remove_ec{};
+      boost::filesystem::remove ( temporary, remove_ec );
+      return ( false );
+    }
+    return ( true );
+  }
+
+  /**
+   * @brief Gives the stem of the names the post-processed scene of an input
+   * file is cached under.
+   *
+   * Only what the imported scene depends on is in the key, so that changing
+   * how it is exported, such as its material, finds the same scene. The
+   * files it was imported from are listed under the stem with extension
+   * DEPENDENCIES_EXTENSION , and the scene itself is named by the stem and
+   * a hash of that list.
+   *
+   * @param[in] directory The directory of cached scenes.
+   * @param[in] f The name of the input file.
+   * @param[in] content Its hash from content_hash().
+   * @param[in] flags The Assimp post-processing steps it is imported with.
+   * @param[in] importer The importer, whose mesh splitting limits are used.
+   * @returns The stem, or an empty string if the input could not be read.
+   */
+  std::string scene_name (
+      const std::string& directory,
+      const std::string& f,
+      const std::string& content,
+      unsigned flags,
+      const Assimp::Importer& importer
+  )
+  {
+    if ( content.empty () )
+    {
+      return ( content );
+    }
+    std::ostringstream key{};
+    key << content << " flags=" << std::hex << flags << std::dec
+        << " triangle-limit="
+        << importer.GetPropertyInteger ( AI_CONFIG_PP_SLM_TRIANGLE_LIMIT, 0 )
+        << " vertex-limit="
+        << importer.GetPropertyInteger ( AI_CONFIG_PP_SLM_VERTEX_LIMIT, 0 );
+    const auto name{
+        boost::filesystem::path{ f }.filename ().string () + "."
+        + hash_text ( key.str () )
+    };
+    return ( ( boost::filesystem::path{ directory } / name ).string () );
+  }
+
+  /**
+   * @brief Imports the post-processed scene of an input file, from the
+   * scene cache if it is there, and otherwise from the file, caching it.
+   *
+   * A scene is only read from the cache while every file listed as one it
+   * was imported from is unchanged. A cached scene that cannot be read, as
+   * one written by another version of Assimp, is imported again and
+   * replaced. Scenes and lists are written under names from
+   * temporary_name() then renamed, the scene first, so that a list only
+   * ever names a whole scene imported from the files it lists, even when
+   * several workers cache the same scene at once.
+   *
+   * The importer is given a DependencyRecorder, which it owns, if it does
+   * not have one already.
+   *
+   * @param[in] f The name of the input file.
+   * @param[in] stem The stem of the names its scene is cached under, from
+   * scene_name(), or an empty string for no caching.
+   * @param[in] flags The Assimp post-processing steps to import with.
+   * @param[in,out] importer The importer to use.
+   * @param[out] dependencies The files the scene was imported from.
+   * @param[out] cached The name of the cached scene read or written, if any.
+   * @param[out] is_hit Whether the scene came from the cache.
+   * @param[out] is_stored Whether the scene was imported and cached.
+   * @returns The scene, owned by \c importer , or \c nullptr if it could
+   * not be imported.
+   */
+  const aiScene* import_scene (
+      const std::string& f,
+      const std::string& stem,
+      unsigned flags,
+      Assimp::Importer& importer,
+      std::vector<dependency_struct>& dependencies,
+      std::string& cached,
+      bool& is_hit,
+      bool& is_stored
+  )
+  {
+    is_hit = false;
+    is_stored = false;
+    dependencies.clear ();
+    cached.clear ();
+    auto* p_recorder{
+        dynamic_cast<DependencyRecorder*>( importer.GetIOHandler () )
+    };
+    if ( p_recorder == nullptr )
+    {
+      p_recorder = new DependencyRecorder{};
+      importer.SetIOHandler ( p_recorder );
+    }
+
+    const auto list_name{ stem + DEPENDENCIES_EXTENSION };
+    if ( !stem.empty () && boost::filesystem::exists ( list_name ) )
+    {
+      std::ifstream list{ list_name };
+      std::vector<dependency_struct> listed{};
+      std::string text{};
+      std::string line{};
+      auto is_current_list{ static_cast<bool>( list ) };
+      while ( is_current_list && std::getline ( list, line ) )
+      {
+        dependency_struct dependency{};
+        is_current_list =
+            read_dependency ( line, dependency ) && is_current ( dependency );
+        text += line + "\n";
+        listed.push_back ( std::move ( dependency ) );
+      }
+      const auto name{ stem + "." + hash_text ( text ) + SCENE_EXTENSION };
+      if ( is_current_list && boost::filesystem::exists ( name ) )
+      {
+        const auto* p_scene{ importer.ReadFile ( name, 0 ) };
+        p_recorder->take ();
+        if ( p_scene != nullptr && p_scene->mRootNode != nullptr )
+        {
+          dependencies = std::move ( listed );
+          cached = name;
+          is_hit = true;
+          return ( p_scene );
+        }
+        importer.FreeScene ();
+      }
+    }
+
+    p_recorder->take ();
+    const auto* p_scene{ importer.ReadFile ( f, flags ) };
+    dependencies = hash_dependencies ( f, p_recorder->take () );
+    if (
+        !stem.empty ()
+        && p_scene != nullptr
+        && !( p_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE )
+        && p_scene->mRootNode != nullptr
+    )
+    {
+      std::string text{};
+      for ( const auto& dependency : dependencies )
+      {
+        text += dependency_line ( dependency ) + "\n";
+      }
+      cached = stem + "." + hash_text ( text ) + SCENE_EXTENSION;
+
+      const auto temporary{ temporary_name ( cached ) };
+      Assimp::Exporter exporter{};
+      boost::system::error_code ec{};
+      if (
+          exporter.Export ( p_scene, SCENE_FORMAT, temporary )
+              == aiReturn_SUCCESS
+      )
+      {
+        boost::filesystem::rename ( temporary, cached, ec );
+        is_stored = !ec;
+      }
+      if ( !is_stored )
+      {
+        boost::filesystem::remove ( temporary, ec );
+        return ( p_scene );
+      }
+
+      const auto list_temporary{ temporary_name ( list_name ) };
+      {
+        std::ofstream list{
+            list_temporary,
+            std::ios_base::out | std::ios_base::trunc
+        };
+        list << text;
+        list.close ();
+        is_stored = !list.fail ();
+      }
+      if ( is_stored )
+      {
+        boost::filesystem::rename ( list_temporary, list_name, ec );
+        is_stored = !ec;
+      }
+      if ( !is_stored )
+      {
+        boost::filesystem::remove ( list_temporary, ec );
+      }
+    }
+    return ( p_scene );
+  }
+
+  /**
+   * @brief Describes what looking up an input file found, for logging.
+   *
+   * @param[in] lookup What was found.
+   * @returns A description.
+   */
+  const char* lookup_description ( LookupEnum lookup )
+  {
+    switch ( lookup )
+    {
+      case LookupEnum::Hit:
+        return ( "outputs are current" );
+
+      case LookupEnum::NoManifest:
+        return ( "no manifest" );
+
+      case LookupEnum::KeyChanged:
+        return ( "input, options, or MeshTools changed" );
+
+      case LookupEnum::DependencyChanged:
+        return ( "a file it was imported from changed" );
+
+      case LookupEnum::OutputChanged:
+        return ( "an output is missing or changed" );
+    }
+    return ( "unknown" );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for skipping conversion work already done.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -65,20 +65,37 @@ namespace Colouring
     //! The shininess value for the material.
     float shininess{};
   };
+
+
+  /**
+   * @brief A material meshes can be coloured with, as a material for each
+   * height band of their vertices.
+   *
+   * A material with one band colours every vertex the same.
+   *
+   * @ingroup STRUCT
+   */
+  struct palette_struct
+  {
+    //! The name it is chosen by, in lower case.
+    std::string name{};
+    //! The height each band but the lowest starts at, in rising order.
+    std::vector<float> band_starts{};
+    //! The material of each band, lowest first.
+    std::vector<material_struct> materials{};
+  };
   
   
   /////////////////////////////////////////////////////////////////////////////
   // ENUMS
   /////////////////////////////////////////////////////////////////////////////
 
-  //! An enumeration of all materials catered for in this application.
-  enum class MaterialEnum 
+  //! An enumeration of the per-vertex colouring an MT v2 mesh can have.
+  enum class VertexColourEnum : std::uint32_t
   {
-    Gold,     ///< An identifier for gold.
-    Jade,     ///< An identifier for jade.
-    Pearl,    ///< An identifier for pearl.
-    Silver,   ///< An identifier for silver.
-    Landscape ///< An identifier for landscapes.
+    None,   ///< Every vertex uses the first material of the table.
+    Index,  ///< Each vertex has a byte indexing the material table.
+    Diffuse ///< Each vertex has its own diffuse colour.
   };
   
 
@@ -86,6 +103,10 @@ namespace Colouring
   // CONSTANTS
   /////////////////////////////////////////////////////////////////////////////
 
+  //! The most height bands a material can have, so that a band fits in a
+  //! byte.
+  const std::size_t MAX_BANDS{ 256 };
+
   /**
    * @defgroup LANDSCAPE Landscape Colour Data
    *
@@ -112,6 +133,24 @@ namespace Colouring
 
   //! Landscape shininess value.
   const auto LANDSCAPE_SHININESS{ 0.01f };
+
+  //! The number of height bands a landscape is coloured with.
+  const auto LANDSCAPE_BANDS{ 6U };
+
+  //! The heights at which each landscape band but the highest ends.
+  const float LANDSCAPE_BAND_TOPS[LANDSCAPE_BANDS - 1]{
+      0.32f, 0.35f, 0.4f, 0.45f, 0.5f
+  };
+
+  //! Landscape diffuse colours of each height band, lowest first.
+  const rgba_struct LANDSCAPE_DIFFUSE_COLOURS[LANDSCAPE_BANDS]{
+      { .red{ 0.0f }, .green{ 0.3922f }, .blue{ 0.0f } },
+      { .red{ 0.0f }, .green{ 0.5f }, .blue{ 0.0f } },
+      { .red{ 0.4196f }, .green{ 0.5569f }, .blue{ 0.1373f } },
+      { .red{ 0.8672f }, .green{ 0.7216f }, .blue{ 0.5294f } },
+      { .red{ 0.5f }, .green{ 0.5f }, .blue{ 0.5f } },
+      { .red{ 1.0f }, .green{ 1.0f }, .blue{ 1.0f } }
+  };
   
   /**
    * @}
@@ -167,59 +206,361 @@ namespace Colouring
   /////////////////////////////////////////////////////////////////////////////
 
   /**
-   * @brief Returns diffuse colour data for a landscape.
+   * @brief Gives the materials built into this application.
+   *
+   * @returns The materials by name, which a materials file can add to or
+   * replace.
+   */
+  std::map<std::string, palette_struct> builtin_palettes ()
+  {
+    std::map<std::string, palette_struct> palettes{};
+    palettes["gold"] = palette_struct{ .name{ "gold" }, .materials{ GOLD } };
+    palettes["jade"] = palette_struct{ .name{ "jade" }, .materials{ JADE } };
+    palettes["pearl"] = palette_struct{ .name{ "pearl" }, .materials{ PEARL } };
+    palettes["silver"] = palette_struct{
+        .name{ "silver" },
+        .materials{ SILVER }
+    };
+
+    auto& landscape{ palettes["landscape"] };
+    landscape.name = "landscape";
+    landscape.band_starts.assign (
+        std::begin ( LANDSCAPE_BAND_TOPS ),
+        std::end ( LANDSCAPE_BAND_TOPS )
+    );
+    for ( const auto& diffuse : LANDSCAPE_DIFFUSE_COLOURS )
+    {
+      landscape.materials.emplace_back (
+          material_struct{
+              LANDSCAPE_AMBIENT_COLOUR,
+              diffuse,
+              LANDSCAPE_SPECULAR_COLOUR,
+              LANDSCAPE_SHININESS
+          }
+      );
+    }
+    return ( palettes );
+  }
+
+  /**
+   * @brief Reads a colour written as three or four numbers.
    *
-   * @param[in] height The value of a vertex \c y coordinate.
-   * @returns rgba_struct A diffuse colour for the given height value.
+   * @param[in] text The \c red , \c green , \c blue , and perhaps
+   * \c alpha components, separated by spaces.
+   * @returns The colour, opaque unless \c alpha is given.
+   * @throws std::runtime_error If \c text is not a colour.
+   */
+  rgba_struct parse_colour ( const std::string& text )
+  {
+    std::istringstream fields{ text };
+    rgba_struct colour{};
+    fields >> colour.red >> colour.green >> colour.blue;
+    if ( !fields )
+    {
+      throw std::runtime_error{ "'" + text + "' is not a colour" };
+    }
+    if ( !( fields >> colour.alpha ) )
+    {
+      colour.alpha = 1.0f;
+    }
+    if ( !( fields >> std::ws ).eof () )
+    {
+      throw std::runtime_error{ "'" + text + "' is not a colour" };
+    }
+    return ( colour );
+  }
+
+  /**
+   * @brief Reads a material, each part of which defaults to that of
+   * another.
    *
-   * @internal @note Though this function will not be needed once texturing
-   * code is in place, there is the possibility to enhance it with
-   * randomization.
+   * @param[in] tree The \c ambient , \c diffuse , and \c specular colours
+   * and \c shininess , each optional.
+   * @param[in] defaults The material missing parts are taken from.
+   * @returns The material.
+   * @throws std::runtime_error If a colour is not valid.
+   * @throws boost::property_tree::ptree_error If \c shininess is not a
+   * number.
    */
-  rgba_struct landscape_diffuse_colour ( float height )
+  material_struct parse_material (
+      const boost::property_tree::ptree& tree,
+      const material_struct& defaults
+  )
   {
-    float red{};
-    float green{};
-    float blue{};
-    
-    if ( height < 0.32f )
+    const auto colour{
+        [&tree] ( const char* key, const rgba_struct& otherwise )
+        {
+          const auto text{ tree.get_optional<std::string> ( key ) };
+          return ( text ? parse_colour ( *text ) : otherwise );
+        }
+    };
+    return (
+        material_struct{
+            .ambient{ colour ( "ambient", defaults.ambient ) },
+            .diffuse{ colour ( "diffuse", defaults.diffuse ) },
+            .specular{ colour ( "specular", defaults.specular ) },
+            .shininess{ tree.get<float> ( "shininess", defaults.shininess ) }
+        }
+    );
+  }
+
+  /**
+   * @brief Checks that a node has no keys but those it may have, so that a
+   * misspelt one is not silently ignored.
+   *
+   * @param[in] tree The node.
+   * @param[in] keys The keys it may have.
+   * @param[in] what What the node is, for the error.
+   * @throws std::runtime_error If the node has any other key.
+   */
+  void check_keys (
+      const boost::property_tree::ptree& tree,
+      std::initializer_list<const char*> keys,
+      const std::string& what
+  )
+  {
+    for ( const auto& [key, node] : tree )
     {
-      red = 0.0f;
-      green = 0.3922f;
-      blue = 0.0f;
+      if ( std::find ( keys.begin (), keys.end (), key ) == keys.end () )
+      {
+        throw std::runtime_error{ what + " has an unknown key '" + key + "'" };
+      }
     }
-    else if ( height < 0.35f )
+  }
+
+  /**
+   * @brief Reads materials from a file, so that new materials need no
+   * change to this application.
+   *
+   * The file is in the Boost property tree INFO format, with a node for
+   * each material named as it is chosen. A material gives its \c ambient ,
+   * \c diffuse , and \c specular colours, each as three or four numbers in
+   * quotes, and its \c shininess . To colour vertices by height, it also
+   * has a \c band node for each height band, lowest first, each but the
+   * first giving the height it starts \c from , and any of the colours and
+   * shininess that differ from those of the material :
+   *
+   * @code
+   * dusk
+   * {
+   *   ambient "0.1 0.1 0.1"
+   *   specular "0.1 0.1 0.1"
+   *   shininess 0.01
+   *   band { diffuse "0.0 0.2 0.4" }
+   *   band { from 0.4 diffuse "0.6 0.5 0.3" }
+   * }
+   * @endcode
+   *
+   * @param[in] file The name of the file.
+   * @param[in,out] palettes The materials by name, to which those of the
+   * file are added, replacing any of the same name.
+   * @throws std::runtime_error If a material is not valid or has a key not
+   * listed here.
+   * @throws boost::property_tree::ptree_error If the file cannot be read,
+   * or a number is not valid.
+   */
+  void load_palettes (
+      const std::string& file,
+      std::map<std::string, palette_struct>& palettes
+  )
+  {
+    boost::property_tree::ptree tree{};
+    boost::property_tree::read_info ( file, tree );
+    for ( const auto& [name, node] : tree )
     {
-      red = 0.0f;
-      green = 0.5f;
-      blue = 0.0f;
+      palette_struct palette{ .name{ boost::to_lower_copy ( name ) } };
+      check_keys (
+          node,
+          { "ambient", "diffuse", "specular", "shininess", "band" },
+          "Material '" + name + "'"
+      );
+      const auto material{ parse_material ( node, material_struct{} ) };
+      for ( const auto& [key, band] : node )
+      {
+        if ( key != "band" )
+        {
+          continue;
+        }
+        check_keys (
+            band,
+            { "ambient", "diffuse", "specular", "shininess", "from" },
+            "A band of material '" + name + "'"
+        );
+        const auto from{ band.get_optional<float> ( "from" ) };
+        if ( palette.materials.empty () == from.has_value () )
+        {
+          throw std::runtime_error{
+              "Material '" + name + "' must give where each band but the"
+              " lowest starts from"
+          };
+        }
+        if ( from )
+        {
+          if ( palette.band_starts.size () > 0
+              && *from < palette.band_starts.back () )
+          {
+            throw std::runtime_error{
+                "Material '" + name + "' has bands out of order"
+            };
+          }
+          palette.band_starts.emplace_back ( *from );
+        }
+        palette.materials.emplace_back ( parse_material ( band, material ) );
+      }
+      if ( palette.materials.empty () )
+      {
+        palette.materials.emplace_back ( material );
+      }
+      if ( palette.materials.size () > MAX_BANDS )
+      {
+        throw std::runtime_error{
+            "Material '" + name + "' has more than 256 bands"
+        };
+      }
+      palettes[palette.name] = std::move ( palette );
     }
-    else if ( height < 0.4f )
+  }
+
+  /**
+   * @brief Finds the height band of each vertex.
+   *
+   * Four vertices are done at once, each compared with the start of every
+   * band and the comparisons counted, so that no height branches.
+   *
+   * @param[in] palette The material, with more than one band.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @returns The band of each vertex, from 0 for the lowest.
+   */
+  std::vector<std::uint8_t> vertex_bands (
+      const palette_struct& palette,
+      const float* p_positions,
+      std::size_t count
+  )
+  {
+    std::vector<std::uint8_t> bands( count );
+    std::size_t j{ 0 };
+    for ( ; j + 4 <= count; j += 4 )
     {
-      red = 0.4196f;
-      green = 0.5569f;
-      blue = 0.1373f;
+      // A height that is not a number lies in the highest band, as no
+      // comparison with it is less.
+      const auto* p_y{ p_positions + j * 3 + 1 };
+      const auto heights{ _mm_setr_ps ( p_y[0], p_y[3], p_y[6], p_y[9] ) };
+      auto band{ _mm_setzero_si128 () };
+      for ( const auto start : palette.band_starts )
+      {
+        band = _mm_sub_epi32 (
+            band,
+            _mm_castps_si128 (
+                _mm_cmpnlt_ps ( heights, _mm_set1_ps ( start ) )
+            )
+        );
+      }
+      const auto words{ _mm_packs_epi32 ( band, band ) };
+      const auto four{
+          _mm_cvtsi128_si32 ( _mm_packus_epi16 ( words, words ) )
+      };
+      std::memcpy ( bands.data () + j, &four, sizeof ( four ) );
     }
-    else if ( height < 0.45f )
+    for ( ; j < count; ++j )
     {
-      red = 0.8672f;
-      green = 0.7216f;
-      blue = 0.5294f;
+      const auto height{ p_positions[j * 3 + 1] };
+      std::uint8_t band{ 0 };
+      for ( const auto start : palette.band_starts )
+      {
+        band += height < start ? 0 : 1;
+      }
+      bands[j] = band;
     }
-    else if ( height < 0.5f )
+    return ( bands );
+  }
+
+  /**
+   * @brief Colours every vertex with what its height band has in a table.
+   *
+   * The kernel is chosen once for the mesh, filling every vertex when the
+   * material has one band, and otherwise finding bands with vertex_bands()
+   * then looking each up.
+   *
+   * @tparam Element What each vertex gets.
+   * @param[in] palette The material.
+   * @param[in] table What each band gives, lowest first.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @returns What each vertex gets.
+   */
+  template<typename Element>
+  std::vector<Element> colour_vertices (
+      const palette_struct& palette,
+      std::span<const Element> table,
+      const float* p_positions,
+      std::size_t count
+  )
+  {
+    if ( table.size () == 1 )
     {
-      red = 0.5f;
-      green = 0.5f;
-      blue = 0.5f;
+      return ( std::vector<Element>( count, table.front () ) );
     }
-    else
+    const auto bands{ vertex_bands ( palette, p_positions, count ) };
+    std::vector<Element> colours( count );
+    for ( std::size_t j{ 0 }; j < count; ++j )
     {
-      red = 1.0f;
-      green = 1.0f;
-      blue = 1.0f;
+      colours[j] = table[bands[j]];
     }
+    return ( colours );
+  }
+
+  /**
+   * @brief Gives every vertex the material of its height band, for MT v1.
+   *
+   * @param[in] palette The material.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @returns The material of each vertex.
+   */
+  std::vector<material_struct> vertex_materials (
+      const palette_struct& palette,
+      const float* p_positions,
+      std::size_t count
+  )
+  {
+    return (
+        colour_vertices<material_struct> (
+            palette,
+            palette.materials,
+            p_positions,
+            count
+        )
+    );
+  }
 
-    return ( rgba_struct{ .red{ red }, .green{ green }, .blue{ blue } } );
+  /**
+   * @brief Gives every vertex the diffuse colour of its height band.
+   *
+   * @param[in] palette The material.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @returns The diffuse colour of each vertex.
+   */
+  std::vector<rgba_struct> vertex_diffuse_colours (
+      const palette_struct& palette,
+      const float* p_positions,
+      std::size_t count
+  )
+  {
+    std::vector<rgba_struct> diffuse{};
+    for ( const auto& material : palette.materials )
+    {
+      diffuse.emplace_back ( material.diffuse );
+    }
+    return (
+        colour_vertices<rgba_struct> (
+            palette,
+            diffuse,
+            p_positions,
+            count
+        )
+    );
   }
   
 }
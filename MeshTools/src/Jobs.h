@@ -0,0 +1,222 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Jobs.h
+// SYNOPSIS : Utilities for running conversion work concurrently.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for running work concurrently.
+namespace Jobs
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Limits how much memory the tasks running at once may use.
+   *
+   * A task asks for its estimated memory before it starts and waits until
+   * that much is free. A task estimated to need more than the whole budget
+   * still runs, but only once nothing else holds any of it, so huge tasks run
+   * alone rather than never.
+   */
+  class MemoryBudget final
+  {
+  public:
+    //! Memory held by a running task, given back when destroyed.
+    class Reservation final
+    {
+    public:
+      /**
+       * @brief Holds memory from a budget.
+       *
+       * @param[in] budget The budget the memory was taken from.
+       * @param[in] bytes The amount of memory held.
+       */
+      Reservation ( MemoryBudget& budget, std::uint64_t bytes )
+        : budget_{ budget },
+          bytes_{ bytes }
+      {
+      }
+
+      Reservation ( const Reservation& ) = delete;
+      Reservation& operator= ( const Reservation& ) = delete;
+
+      //! Gives the memory back.
+      ~Reservation ()
+      {
+        budget_.release ( bytes_ );
+      }
+
+    private:
+      MemoryBudget& budget_;
+      std::uint64_t bytes_;
+    };
+
+    /**
+     * @brief Creates a budget.
+     *
+     * @param[in] bytes The memory that running tasks may use in total.
+     */
+    explicit MemoryBudget ( std::uint64_t bytes )
+      : limit_{ bytes }
+    {
+    }
+
+    /**
+     * @brief Waits until memory is free and takes it.
+     *
+     * @param[in] bytes The memory wanted.
+     * @returns The memory held, given back when it is destroyed.
+     */
+    Reservation acquire ( std::uint64_t bytes )
+    {
+      std::unique_lock<std::mutex> lock{ mutex_ };
+      is_free_.wait (
+          lock,
+          [this, bytes] ()
+          {
+            return ( in_use_ == 0 || in_use_ + bytes <= limit_ );
+          }
+      );
+      in_use_ += bytes;
+      return ( Reservation{ *this, bytes } );
+    }
+
+  private:
+    void release ( std::uint64_t bytes )
+    {
+      {
+        const std::lock_guard<std::mutex> lock{ mutex_ };
+        in_use_ -= bytes;
+      }
+      is_free_.notify_all ();
+    }
+
+    std::uint64_t limit_;
+    std::uint64_t in_use_{};
+    std::mutex mutex_{};
+    std::condition_variable is_free_{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Decides how many workers to run.
+   *
+   * @param[in] wanted The number of workers asked for, or zero for one per
+   * core.
+   * @param[in] tasks The number of tasks there are.
+   * @returns A worker count from one to \c tasks .
+   */
+  unsigned worker_count ( unsigned wanted, std::size_t tasks ) noexcept
+  {
+    auto workers{ wanted };
+    if ( workers == 0 )
+    {
+      workers = std::max ( std::thread::hardware_concurrency (), 1U );
+    }
+    if ( workers > tasks )
+    {
+      workers = static_cast<unsigned>( std::max<std::size_t> ( tasks, 1 ) );
+    }
+    return ( workers );
+  }
+
+  /**
+   * @brief Runs numbered tasks on a number of workers.
+   *
+   * Tasks are started in number order, each by the first worker free, and
+   * the calling thread is one of the workers. With one worker everything runs
+   * on the calling thread.
+   *
+   * @param[in] count The number of tasks.
+   * @param[in] workers The number of workers.
+   * @param[in] task Called as <tt>task ( index, worker )</tt> for each task,
+   * where \c worker is below \c workers and no two tasks run at once with the
+   * same one.
+   * @throws Whatever the first task to fail threw, once all workers stop.
+   */
+  template<typename Task>
+  void parallel_for ( std::size_t count, unsigned workers, Task&& task )
+  {
+    std::atomic<std::size_t> next{ 0 };
+    std::mutex failure_mutex{};
+    std::exception_ptr p_failure{};
+    const auto work{
+        [&] ( unsigned worker )
+        {
+          try
+          {
+            for (
+                auto i{ next.fetch_add ( 1 ) };
+                i < count;
+                i = next.fetch_add ( 1 )
+            )
+            {
+              task ( i, worker );
+            }
+          }
+          catch ( ... )
+          {
+            next = count;
+            const std::lock_guard<std::mutex> lock{ failure_mutex };
+            if ( !p_failure )
+            {
+              p_failure = std::current_exception ();
+            }
+          }
+        }
+    };
+
+    std::vector<std::thread> threads{};
+    threads.reserve ( workers > 1 ? workers - 1 : 0 );
+    for ( auto w{ 1U }; w < workers; ++w )
+    {
+      threads.emplace_back ( work, w );
+    }
+    work ( 0 );
+    for ( auto& t : threads )
+    {
+      t.join ();
+    }
+
+    if ( p_failure )
+    {
+      std::rethrow_exception ( p_failure );
+    }
+  }
+
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for running conversion work concurrently.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -69,6 +69,157 @@ namespace Log
   > Logger;
 
 
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Holds log records made by one task until they can be emitted.
+   *
+   * Tasks running at the same time each log into their own buffer, so the
+   * lines of one task are never interleaved with those of another.
+   */
+  class Buffer final
+  {
+  public:
+    //! A log record being written, added to its buffer when destroyed.
+    class Record final
+    {
+    public:
+      /**
+       * @brief Starts a record.
+       *
+       * @param[in] buffer The buffer to add the record to.
+       * @param[in] level The severity of the record.
+       */
+      Record ( Buffer& buffer, boost::log::trivial::severity_level level )
+        : buffer_{ buffer },
+          level_{ level }
+      {
+      }
+
+      //! Adds the record to its buffer.
+      ~Record ()
+      {
+        buffer_.records_.emplace_back ( level_, message_.str () );
+      }
+
+      /**
+       * @brief Appends a value to the message of the record.
+       *
+       * @param[in] value The value to append.
+       * @returns This record.
+       */
+      template<typename Value>
+      Record& operator<< ( const Value& value )
+      {
+        message_ << value;
+        return ( *this );
+      }
+
+    private:
+      Buffer& buffer_;
+      boost::log::trivial::severity_level level_;
+      std::ostringstream message_{};
+    };
+
+    /**
+     * @brief Starts a record, used as <tt>logmt ( info ) << ...</tt>
+     *
+     * @param[in] level The severity of the record.
+     * @returns The record to write the message to.
+     */
+    Record operator() ( boost::log::trivial::severity_level level )
+    {
+      return ( Record{ *this, level } );
+    }
+
+    /**
+     * @brief Moves the records of another buffer to the end of this one.
+     *
+     * @param[in,out] other The buffer to take the records of.
+     */
+    void append ( Buffer& other )
+    {
+      records_.insert (
+          records_.end (),
+          std::make_move_iterator ( other.records_.begin () ),
+          std::make_move_iterator ( other.records_.end () )
+      );
+      other.records_.clear ();
+    }
+
+    /**
+     * @brief Emits the records in the order they were made and empties the
+     * buffer.
+     *
+     * @param[in] logger The logger to emit the records with.
+     */
+    void flush ( Logger& logger )
+    {
+      for ( const auto& [level, message] : records_ )
+      {
+        BOOST_LOG_SEV(logger,level) << message;
+      }
+      records_.clear ();
+    }
+
+  private:
+    std::vector<
+        std::pair<boost::log::trivial::severity_level, std::string>
+    > records_{};
+  };
+
+
+  /**
+   * @brief Emits the buffers of numbered tasks in task order, as soon as
+   * every earlier task has finished.
+   *
+   * The log then reads the same however the tasks were scheduled.
+   */
+  class OrderedFlush final
+  {
+  public:
+    /**
+     * @brief Prepares for a number of tasks.
+     *
+     * @param[in] logger The logger to emit records with.
+     * @param[in] count The number of tasks.
+     */
+    OrderedFlush ( Logger& logger, std::size_t count )
+      : logger_{ logger },
+        buffers_( count ),
+        is_done_( count, false )
+    {
+    }
+
+    /**
+     * @brief Records that a task has finished.
+     *
+     * @param[in] index The number of the task.
+     * @param[in,out] buffer The records of the task, which are taken.
+     */
+    void done ( std::size_t index, Buffer& buffer )
+    {
+      const std::lock_guard<std::mutex> lock{ mutex_ };
+      buffers_[index].append ( buffer );
+      is_done_[index] = true;
+      while ( next_ < is_done_.size () && is_done_[next_] )
+      {
+        buffers_[next_].flush ( logger_ );
+        ++next_;
+      }
+    }
+
+  private:
+    Logger& logger_;
+    std::mutex mutex_{};
+    std::vector<Buffer> buffers_;
+    std::vector<bool> is_done_;
+    std::size_t next_{};
+  };
+
+
   /////////////////////////////////////////////////////////////////////////////
   // FUNCTIONS
   /////////////////////////////////////////////////////////////////////////////
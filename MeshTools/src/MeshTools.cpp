@@ -20,10 +20,22 @@
 #pragma comment(lib, "assimp-vc142-mt.lib")
 #pragma comment(lib, "zlibstatic.lib")
 #endif /* _DEBUG */
+#pragma comment(lib, "gdiplus.lib")
+#pragma comment(lib, "shlwapi.lib")
 
 // LOCAL //////////////////////////////////////////////////////////////////////
+#include "Bvh.h"
+#include "Cache.h"
 #include "Colouring.h"
+#include "Jobs.h"
 #include "Log.h"
+#include "Meshlets.h"
+#include "Occlusion.h"
+#include "Optimise.h"
+#include "Quantise.h"
+#include "Simplify.h"
+#include "Texture.h"
+#include "../mtio/MtFormat.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -66,30 +78,1548 @@ const auto EXIT_NO_DATA_FILE_FOUND_ERROR{ 5 };
 //! The exit code if data could not be imported from a file.
 const auto EXIT_DATA_IMPORT_ERROR{ 6 };
 
+//! The exit code if textures are to be baked but images cannot be decoded.
+const auto EXIT_TEXTURE_DECODER_ERROR{ 7 };
+
 //! The exit code if no errors were encountered.
 const auto EXIT_SUCCESSFUL{ 0 };
 
 /**
- * @} 
+ * @} 
+ */
+
+//! The file extension for MT files.
+#ifdef _DEBUG
+const auto* MT_FILE_EXTENSION{ ".mtd" };
+#else
+const auto* MT_FILE_EXTENSION{ ".mt" };
+#endif /* _DEBUG */
+
+//! The version of what this application writes, part of the key of every
+//! cached file. Raise it with any change that alters the MT files written
+//! for the same input and options, so that they are converted again.
+const auto CACHE_VERSION{ 1U };
+
+//! The version of the MT format with a header and a table of sections.
+const auto MT_VERSION_HEADER{ unsigned{ MtFormat::VERSION } };
+
+//! The version of the MT format with a material table but no header.
+const auto MT_VERSION_MATERIAL_TABLE{ 2U };
+
+//! The version of the MT format with a full material for each vertex.
+const auto MT_VERSION_PER_VERTEX_MATERIALS{ 1U };
+
+//! The version of the MT format written unless told otherwise, the one that
+//! existing readers of MT files understand.
+const auto DEFAULT_MT_VERSION{ MT_VERSION_PER_VERTEX_MATERIALS };
+
+//! The process priority to set in Windows.
+const auto PROCESS_PRIORITY{ IDLE_PRIORITY_CLASS };
+
+//! The number of files converted at once unless told otherwise.
+const auto DEFAULT_JOBS{ 1U };
+
+//! The number of meshes of a scene converted at once unless told otherwise.
+const auto DEFAULT_MESH_JOBS{ 1U };
+
+//! The memory, in MiB, files being converted at once may use by default.
+const auto DEFAULT_MEMORY_BUDGET_MIB{ 4'096U };
+
+//! Bytes in a MiB.
+const std::uint64_t BYTES_PER_MIB{ 1'048'576 };
+
+/**
+ * @brief A rough ratio of the memory a scene needs while it is converted to
+ * the size of its file.
+ *
+ * Text formats grow the most when imported, so this errs on their side.
+ */
+const std::uint64_t IMPORT_MEMORY_FACTOR{ 10 };
+
+/**
+ * @brief The most vertices a mesh may have before it is split when
+ * quantising, so that 16-bit indices can address them all.
+ */
+const auto QUANTISED_VERTEX_LIMIT{
+    static_cast<int>( Quantise::SHORT_INDEX_VERTICES - 1 )
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// STRUCTS
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief The choices from the command line that conversion depends on.
+ *
+ * @ingroup STRUCT
+ */
+struct options_struct
+{
+  //! The material meshes are coloured with.
+  Colouring::palette_struct palette{};
+  //! The version of the MT format written.
+  unsigned mt_version{ DEFAULT_MT_VERSION };
+  //! The per-vertex colouring of landscapes from MT v2.
+  Colouring::VertexColourEnum vertex_colours{
+      Colouring::VertexColourEnum::Index
+  };
+  //! The number of meshes of a scene converted at once, or 0 for one per core.
+  unsigned mesh_jobs{ DEFAULT_MESH_JOBS };
+  //! Whether vertices are renumbered in the order triangles first use them.
+  bool is_fetch_optimised{};
+  //! Whether triangles are sorted to reduce overdraw.
+  bool is_overdraw_sorted{};
+  //! The rise in vertex cache miss ratio allowed when sorting for overdraw.
+  float overdraw_threshold{ Optimise::DEFAULT_OVERDRAW_THRESHOLD };
+  //! Whether attributes and indices are stored in fewer bits, from MT v3.
+  bool is_quantised{};
+  //! How positions are quantised.
+  Quantise::PositionEnum positions{ Quantise::PositionEnum::Unorm16 };
+  //! Whether vertex attributes are interleaved, from MT v3.
+  bool is_interleaved{};
+  //! The number of coarser levels of detail written, from MT v3.
+  unsigned lods{};
+  //! The fraction of the triangles of one level of detail kept in the next.
+  float lod_ratio{ Simplify::DEFAULT_LOD_RATIO };
+  //! Whether triangles are split into meshlets, from MT v3.
+  bool is_meshlets{};
+  //! The most vertices of a meshlet.
+  std::uint32_t meshlet_vertices{ Meshlets::DEFAULT_MAX_VERTICES };
+  //! The most triangles of a meshlet.
+  std::uint32_t meshlet_triangles{ Meshlets::DEFAULT_MAX_TRIANGLES };
+  //! Whether a bounding volume hierarchy of the triangles is written, from
+  //! MT v3.
+  bool is_bvh{};
+  //! The workers each mesh builds its hierarchy and bakes occlusion with,
+  //! set for each scene.
+  unsigned bvh_jobs{ 1 };
+  //! Whether ambient occlusion darkens the colours of each vertex, ambient
+  //! and diffuse in MT v1 and only the vertex diffuse in later versions.
+  bool is_ao_baked{};
+  //! The rays cast from each vertex when baking ambient occlusion.
+  unsigned ao_rays{ Occlusion::DEFAULT_RAYS };
+  //! The length of occlusion rays, as a fraction of the size of what they
+  //! can hit.
+  float ao_distance{ Occlusion::DEFAULT_DISTANCE };
+  //! Whether every mesh of a scene occludes each mesh, not just the mesh
+  //! itself.
+  bool is_ao_scene{};
+  //! The occluders of the whole scene, in its own space, set for each scene
+  //! when it occludes.
+  std::shared_ptr<const Occlusion::occluders_struct> p_scene_occluders{};
+  //! For each mesh of the scene, the world transform of each node drawing
+  //! it, set for each scene when it occludes.
+  std::vector<std::vector<aiMatrix4x4>> mesh_placements{};
+  //! Whether the diffuse texture of each mesh is baked into the diffuse
+  //! colour of each vertex.
+  bool is_texture_baked{};
+  //! How textures are sampled at vertices.
+  Texture::FilterEnum texture_filter{ Texture::FilterEnum::Area };
+  //! The diffuse texture of each material of the scene, or null for none,
+  //! set for each scene when textures are baked.
+  std::vector<std::shared_ptr<const Texture::texture_struct>>
+      material_textures{};
+  //! Whether sections are compressed, from MT v3.
+  bool is_compressed{};
+  //! The zlib compression level sections are compressed at.
+  int compress_level{ Z_DEFAULT_COMPRESSION };
+  //! The directory post-processed scenes are cached in, or empty for none.
+  std::string scene_cache{};
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Gives an array of Assimp vectors as \c x , \c y , and \c z
+ * \c float components.
+ *
+ * Assimp normally stores vectors as packed \c float triples already, and
+ * then its buffer is used as it is. Only when Assimp is built with double
+ * precision are the vectors converted, in one pass into one buffer.
+ *
+ * @param[in] p_vectors The vectors.
+ * @param[in] count The number of vectors.
+ * @param[out] storage Holds the components if they had to be converted.
+ * @returns The <tt>3 * count</tt> components.
+ */
+const float* float_components (
+    const aiVector3D* p_vectors,
+    size_t count,
+    std::vector<float>& storage
+)
+{
+  if constexpr (
+      std::is_same_v<ai_real, float>
+      && sizeof ( aiVector3D ) == 3 * sizeof ( float )
+  )
+  {
+    return ( reinterpret_cast<const float*>( p_vectors ) );
+  }
+  else
+  {
+    storage.resize ( count * 3 );
+    for ( size_t j{ 0 }; j < count; ++j )
+    {
+      storage[j * 3] = static_cast<float>( p_vectors[j].x );
+      storage[j * 3 + 1] = static_cast<float>( p_vectors[j].y );
+      storage[j * 3 + 2] = static_cast<float>( p_vectors[j].z );
+    }
+    return ( storage.data () );
+  }
+}
+
+/**
+ * @brief Gives the world transform of every node of a scene that draws each
+ * of its meshes.
+ *
+ * @param[in] p_scene The scene.
+ * @returns For each mesh, the transforms from its own space into that of
+ * the scene, one for each node drawing it, and none if no node does.
+ */
+std::vector<std::vector<aiMatrix4x4>> mesh_placements ( const aiScene* p_scene )
+{
+  std::vector<std::vector<aiMatrix4x4>> placements( p_scene->mNumMeshes );
+  std::vector<std::pair<const aiNode*, aiMatrix4x4>> pending{
+      { p_scene->mRootNode, aiMatrix4x4{} }
+  };
+  while ( !pending.empty () )
+  {
+    const auto [p_node, parent]{ pending.back () };
+    pending.pop_back ();
+    const auto world{ parent * p_node->mTransformation };
+    for ( unsigned int k{ 0 }; k < p_node->mNumMeshes; ++k )
+    {
+      if ( p_node->mMeshes[k] < placements.size () )
+      {
+        placements[p_node->mMeshes[k]].push_back ( world );
+      }
+    }
+    for ( unsigned int c{ 0 }; c < p_node->mNumChildren; ++c )
+    {
+      pending.emplace_back ( p_node->mChildren[c], world );
+    }
+  }
+  return ( placements );
+}
+
+/**
+ * @brief Moves vertices from the space of their mesh into that of the scene.
+ *
+ * Normals are moved by the inverse transpose of the transform, taken as the
+ * cofactors of its upper 3 x 3 and flipped if it mirrors, and are left
+ * unnormalised. An identity transform copies the vertices as they are, so
+ * that zero normal components keep their sign and ambient occlusion bakes
+ * as it would without the scene.
+ *
+ * @param[in] transform The world transform of a node drawing the mesh.
+ * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+ * @param[in] p_normals The normal \c x , \c y , and \c z of each vertex,
+ * or \c nullptr to move only the positions.
+ * @param[in] count The number of vertices.
+ * @param[out] positions The positions in the space of the scene.
+ * @param[out] normals The normals in the space of the scene, if moved.
+ */
+void place (
+    const aiMatrix4x4& transform,
+    const float* p_positions,
+    const float* p_normals,
+    size_t count,
+    std::vector<float>& positions,
+    std::vector<float>& normals
+)
+{
+  if ( transform == aiMatrix4x4{} )
+  {
+    positions.assign ( p_positions, p_positions + count * 3 );
+    if ( p_normals != nullptr )
+    {
+      normals.assign ( p_normals, p_normals + count * 3 );
+    }
+    return;
+  }
+
+  const std::array<std::array<float, 4>, 3> rows{ {
+      { transform.a1, transform.a2, transform.a3, transform.a4 },
+      { transform.b1, transform.b2, transform.b3, transform.b4 },
+      { transform.c1, transform.c2, transform.c3, transform.c4 }
+  } };
+  positions.resize ( count * 3 );
+  for ( size_t j{ 0 }; j < count; ++j )
+  {
+    const auto* p_p{ p_positions + j * 3 };
+    for ( size_t k{ 0 }; k < 3; ++k )
+    {
+      positions[j * 3 + k] = rows[k][0] * p_p[0] + rows[k][1] * p_p[1]
+          + rows[k][2] * p_p[2] + rows[k][3];
+    }
+  }
+  if ( p_normals == nullptr )
+  {
+    return;
+  }
+
+  const auto cross{
+      [] ( const std::array<float, 4>& a, const std::array<float, 4>& b )
+      {
+        return (
+            std::array<float, 3>{
+                a[1] * b[2] - a[2] * b[1],
+                a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0]
+            }
+        );
+      }
+  };
+  const std::array<std::array<float, 3>, 3> cofactors{
+      cross ( rows[1], rows[2] ),
+      cross ( rows[2], rows[0] ),
+      cross ( rows[0], rows[1] )
+  };
+  const auto determinant{
+      rows[0][0] * cofactors[0][0] + rows[0][1] * cofactors[0][1]
+      + rows[0][2] * cofactors[0][2]
+  };
+  const auto sign{ determinant < 0.0f ? -1.0f : 1.0f };
+  normals.resize ( count * 3 );
+  for ( size_t j{ 0 }; j < count; ++j )
+  {
+    const auto* p_n{ p_normals + j * 3 };
+    for ( size_t k{ 0 }; k < 3; ++k )
+    {
+      normals[j * 3 + k] = sign
+          * ( cofactors[k][0] * p_n[0] + cofactors[k][1] * p_n[1]
+              + cofactors[k][2] * p_n[2] );
+    }
+  }
+}
+
+/**
+ * @brief Describes what a section holds, for logging.
+ *
+ * @param[in] type The section type.
+ * @returns A description.
+ */
+const char* section_description ( MtFormat::SectionEnum type )
+{
+  switch ( type )
+  {
+    case MtFormat::SectionEnum::Positions:
+      return ( "vertex" );
+
+    case MtFormat::SectionEnum::Normals:
+      return ( "vertex normal" );
+
+    case MtFormat::SectionEnum::TexCoords:
+      return ( "texture UV" );
+
+    case MtFormat::SectionEnum::VertexMaterials:
+      return ( "colouring" );
+
+    case MtFormat::SectionEnum::Materials:
+      return ( "material table" );
+
+    case MtFormat::SectionEnum::MaterialIndices:
+      return ( "material index" );
+
+    case MtFormat::SectionEnum::DiffuseColours:
+      return ( "vertex diffuse colour" );
+
+    case MtFormat::SectionEnum::Indices:
+      return ( "index" );
+
+    case MtFormat::SectionEnum::Vertices:
+      return ( "interleaved vertex" );
+
+    case MtFormat::SectionEnum::VertexLayout:
+      return ( "vertex layout" );
+
+    case MtFormat::SectionEnum::LodIndices:
+      return ( "level of detail index" );
+
+    case MtFormat::SectionEnum::Meshlets:
+      return ( "meshlet" );
+
+    case MtFormat::SectionEnum::MeshletVertices:
+      return ( "meshlet vertex" );
+
+    case MtFormat::SectionEnum::MeshletTriangles:
+      return ( "meshlet triangle" );
+
+    case MtFormat::SectionEnum::Bvh:
+      return ( "BVH node" );
+
+    case MtFormat::SectionEnum::BvhTriangles:
+      return ( "BVH triangle" );
+  }
+  return ( "unknown" );
+}
+
+/**
+ * @brief Writes sections one after another with no header, as MT versions 1
+ * and 2 are laid out.
+ *
+ * Version 2 stores the material count before the material table, and the
+ * kind of per-vertex colouring after it, and pads material indices to four
+ * bytes.
+ *
+ * @param[in,out] output_file The file to write to.
+ * @param[in] version The MT version, 1 or 2.
+ * @param[in] writer The sections.
+ * @param[in,out] logmt Where to log.
+ */
+void write_headerless (
+    std::ofstream& output_file,
+    unsigned version,
+    const MtFormat::Writer& writer,
+    Log::Buffer& logmt
+)
+{
+  const auto& sections{ writer.sections () };
+  auto vertex_colours{ Colouring::VertexColourEnum::None };
+  for ( const auto& section : sections )
+  {
+    const auto type{ static_cast<MtFormat::SectionEnum>( section.type ) };
+    if ( type == MtFormat::SectionEnum::MaterialIndices )
+    {
+      vertex_colours = Colouring::VertexColourEnum::Index;
+    }
+    else if ( type == MtFormat::SectionEnum::DiffuseColours )
+    {
+      vertex_colours = Colouring::VertexColourEnum::Diffuse;
+    }
+  }
+
+  for ( std::size_t s{ 0 }; s < sections.size (); ++s )
+  {
+    const auto type{ static_cast<MtFormat::SectionEnum>( sections[s].type ) };
+    const auto data{ writer.data ( s ) };
+    if ( version != MT_VERSION_PER_VERTEX_MATERIALS
+        && type == MtFormat::SectionEnum::Materials )
+    {
+      output_file.write (
+          reinterpret_cast<const char*>( &sections[s].count ),
+          sizeof ( sections[s].count )
+      );
+    }
+
+    output_file.write (
+        reinterpret_cast<const char*>( data.data () ),
+        data.size ()
+    );
+    {
+      logmt ( debug ) << "      Wrote " << data.size () << " bytes for "
+          << section_description ( type ) << " data";
+    }
+
+    if ( version != MT_VERSION_PER_VERTEX_MATERIALS
+        && type == MtFormat::SectionEnum::Materials )
+    {
+      output_file.write (
+          reinterpret_cast<const char*>( &vertex_colours ),
+          sizeof ( vertex_colours )
+      );
+    }
+    else if ( type == MtFormat::SectionEnum::MaterialIndices )
+    {
+      // Pad so that the index data stays aligned.
+      const char padding[3]{};
+      output_file.write ( padding, ( 4 - data.size () % 4 ) % 4 );
+    }
+  }
+}
+
+/**
+ * @brief Converts a mesh of an imported scene into an MT file.
+ *
+ * @param[in] p_mesh The mesh.
+ * @param[in] f The name of the file the scene was imported from.
+ * @param[in] i The number of the mesh in the scene.
+ * @param[in] options The conversion options.
+ * @param[in,out] logmt Where to log.
+ * @returns The name of the MT file written.
+ */
+std::string convert_mesh (
+    const aiMesh* p_mesh,
+    const std::string& f,
+    unsigned int i,
+    const options_struct& options,
+    Log::Buffer& logmt
+)
+{
+  {
+    logmt ( debug ) << "  Mesh " << i << ":";
+  }
+  const size_t numVertices{ p_mesh->mNumVertices };
+  {
+    logmt ( debug ) << "    Number of vertices = " << numVertices;
+  }
+
+  // Only the first set of texture coordinates is written, and a mesh
+  // without one has zeros.
+  std::vector<float> texture_uvs(
+      numVertices * 2,
+      0.0f
+  );
+  const auto is_textured{ p_mesh->HasTextureCoords ( 0 ) };
+  if ( is_textured )
+  {
+    const auto* p_uvs{ p_mesh->mTextureCoords[0] };
+    for ( size_t j{ 0 }; j < numVertices; ++j )
+    {
+      texture_uvs[j * 2] = static_cast<float>( p_uvs[j].x );
+      texture_uvs[j * 2 + 1] = static_cast<float>( p_uvs[j].y );
+    }
+  }
+  const Texture::texture_struct* p_texture{};
+  if (
+      options.is_texture_baked
+      && is_textured
+      && p_mesh->mMaterialIndex < options.material_textures.size ()
+  )
+  {
+    p_texture = options.material_textures[p_mesh->mMaterialIndex].get ();
+  }
+
+  // Vertices and normals are written straight from Assimp's buffers, so only
+  // the colouring needs a pass over the vertices.
+  const auto* p_vertices{ p_mesh->mVertices };
+  assert( p_mesh->mNormals != nullptr );
+  std::vector<float> converted_vertices{};
+  std::vector<float> converted_normals{};
+  const float* p_vertex_floats{
+      float_components ( p_vertices, numVertices, converted_vertices )
+  };
+  const float* p_normal_floats{
+      float_components ( p_mesh->mNormals, numVertices, converted_normals )
+  };
+  const auto is_v1{ options.mt_version == MT_VERSION_PER_VERTEX_MATERIALS };
+  std::vector<Colouring::material_struct> colouring{};
+  std::vector<Colouring::material_struct> material_table{};
+  auto vertex_colours{ Colouring::VertexColourEnum::None };
+  std::vector<std::uint8_t> material_indices{};
+  std::vector<Colouring::rgba_struct> diffuse_colours{};
+  // Colouring is a pass of its own over all vertices, its kernel chosen
+  // once for the mesh.
+  if ( is_v1 )
+  {
+    colouring = Colouring::vertex_materials (
+        options.palette,
+        p_vertex_floats,
+        numVertices
+    );
+    {
+      logmt ( debug ) << "    Created colouring vector of " << numVertices
+          << " Colouring::material";
+    }
+  }
+  else
+  {
+    // A material is stored once per mesh, and only materials with height
+    // bands need anything per vertex, unless a texture or occlusion is
+    // baked into the diffuse colour of each vertex.
+    material_table = options.palette.materials;
+    if ( options.is_ao_baked || p_texture != nullptr )
+    {
+      vertex_colours = Colouring::VertexColourEnum::Diffuse;
+    }
+    else if ( material_table.size () > 1 )
+    {
+      vertex_colours = options.vertex_colours;
+    }
+    if ( vertex_colours == Colouring::VertexColourEnum::Index )
+    {
+      material_indices = Colouring::vertex_bands (
+          options.palette,
+          p_vertex_floats,
+          numVertices
+      );
+    }
+    else if (
+        vertex_colours == Colouring::VertexColourEnum::Diffuse
+        && p_texture == nullptr
+    )
+    {
+      diffuse_colours = Colouring::vertex_diffuse_colours (
+          options.palette,
+          p_vertex_floats,
+          numVertices
+      );
+    }
+    {
+      logmt ( debug ) << "    Created material table of "
+          << material_table.size () << " Colouring::material";
+    }
+  }
+  {
+    logmt ( debug ) << "    Colouring data loaded";
+  }
+
+  const size_t numFaces{ p_mesh->mNumFaces };
+  {
+    logmt ( debug ) << "    Number of faces = " << numFaces;
+  }
+  const auto numIndices{ numFaces * 3 };
+  {
+    logmt ( debug ) << "    Number of indices = " << numFaces * 3;
+  }
+  std::vector<unsigned int> indices{};
+  indices.reserve ( numIndices );
+  {
+    logmt ( debug ) << "    Created indices vector of " << numIndices
+        << " unsigned int";
+  }
+  const auto* p_faces{ p_mesh->mFaces };
+  for ( size_t j{ 0 }; j < numFaces; ++j )
+  {
+    const auto& current_face{ p_faces[j] };
+    assert( current_face.mNumIndices == 3U );
+    const auto* p_current_face_indices{ current_face.mIndices };
+    indices.emplace_back ( *p_current_face_indices );
+    indices.emplace_back ( *( p_current_face_indices + 1 ) );
+    indices.emplace_back ( *( p_current_face_indices + 2 ) );
+  }
+
+  // Textures are sampled once triangles are known, as area filtering needs
+  // the texture area around each vertex, and before occlusion darkens them.
+  if ( p_texture != nullptr )
+  {
+    auto colours{
+        Texture::sample (
+            *p_texture,
+            options.texture_filter,
+            indices,
+            texture_uvs.data (),
+            numVertices,
+            options.bvh_jobs
+        )
+    };
+    if ( is_v1 )
+    {
+      for ( size_t j{ 0 }; j < numVertices; ++j )
+      {
+        colouring[j].diffuse = colours[j];
+      }
+    }
+    else
+    {
+      diffuse_colours = std::move ( colours );
+    }
+    {
+      const auto& base{ p_texture->levels.front () };
+      logmt ( info ) << "    Baked a " << base.width << " x " << base.height
+          << " texture into vertex diffuse colours";
+    }
+  }
+
+  // Occlusion is baked before vertices are reordered, so that it reorders
+  // with the colours it darkens. Against the whole scene, a mesh is baked
+  // where each node drawing it places it, and the results averaged, while a
+  // mesh no node draws is only occluded by itself.
+  if ( options.is_ao_baked )
+  {
+    const auto* p_placements{
+        options.p_scene_occluders && i < options.mesh_placements.size ()
+            && !options.mesh_placements[i].empty ()
+            ? &options.mesh_placements[i]
+            : nullptr
+    };
+    std::vector<float> openness{};
+    if ( p_placements == nullptr )
+    {
+      openness = Occlusion::bake (
+          Occlusion::build ( indices, p_vertex_floats, options.bvh_jobs ),
+          p_vertex_floats,
+          p_normal_floats,
+          numVertices,
+          options.ao_rays,
+          options.ao_distance,
+          options.bvh_jobs
+      );
+    }
+    else
+    {
+      openness.assign ( numVertices, 0.0f );
+      std::vector<float> positions{};
+      std::vector<float> normals{};
+      for ( const auto& transform : *p_placements )
+      {
+        place (
+            transform,
+            p_vertex_floats,
+            p_normal_floats,
+            numVertices,
+            positions,
+            normals
+        );
+        const auto placed{
+            Occlusion::bake (
+                *options.p_scene_occluders,
+                positions.data (),
+                normals.data (),
+                numVertices,
+                options.ao_rays,
+                options.ao_distance,
+                options.bvh_jobs
+            )
+        };
+        for ( size_t j{ 0 }; j < numVertices; ++j )
+        {
+          openness[j] += placed[j];
+        }
+      }
+      const auto scale{ 1.0f / static_cast<float>( p_placements->size () ) };
+      for ( auto& light : openness )
+      {
+        light *= scale;
+      }
+    }
+    for ( size_t j{ 0 }; j < numVertices; ++j )
+    {
+      const auto light{ openness[j] };
+      auto& diffuse{ is_v1 ? colouring[j].diffuse : diffuse_colours[j] };
+      diffuse.red *= light;
+      diffuse.green *= light;
+      diffuse.blue *= light;
+      if ( is_v1 )
+      {
+        auto& ambient{ colouring[j].ambient };
+        ambient.red *= light;
+        ambient.green *= light;
+        ambient.blue *= light;
+      }
+    }
+    {
+      const auto mean{
+          numVertices == 0
+              ? 1.0f
+              : std::accumulate ( openness.begin (), openness.end (), 0.0f )
+                  / static_cast<float>( numVertices )
+      };
+      logmt ( info ) << "    Baked ambient occlusion with "
+          << options.ao_rays << " rays per vertex, leaving " << mean
+          << " of light on average";
+    }
+  }
+
+  if ( options.is_fetch_optimised || options.is_overdraw_sorted )
+  {
+    const auto vertex_bytes{
+        sizeof ( float ) * 8
+        + ( colouring.empty () ? 0 : sizeof ( Colouring::material_struct ) )
+        + ( material_indices.empty () ? 0 : sizeof ( std::uint8_t ) )
+        + ( diffuse_colours.empty () ? 0 : sizeof ( Colouring::rgba_struct ) )
+    };
+    const auto before{
+        Optimise::analyse ( indices, numVertices, vertex_bytes )
+    };
+
+    // Triangles are sorted first, as that changes the order vertices are
+    // first used in.
+    if ( options.is_overdraw_sorted )
+    {
+      Optimise::sort_overdraw (
+          indices,
+          p_vertex_floats,
+          numVertices,
+          options.overdraw_threshold
+      );
+    }
+    if ( options.is_fetch_optimised )
+    {
+      // Reordering needs a copy of Assimp's buffers, made in one pass each.
+      const auto old_numbers{
+          Optimise::reorder_first_use ( indices, numVertices )
+      };
+      converted_vertices =
+          Optimise::reorder_vertices ( old_numbers, p_vertex_floats, 3 );
+      p_vertex_floats = converted_vertices.data ();
+      converted_normals =
+          Optimise::reorder_vertices ( old_numbers, p_normal_floats, 3 );
+      p_normal_floats = converted_normals.data ();
+      texture_uvs =
+          Optimise::reorder_vertices ( old_numbers, texture_uvs.data (), 2 );
+      if ( !colouring.empty () )
+      {
+        colouring =
+            Optimise::reorder_vertices ( old_numbers, colouring.data () );
+      }
+      if ( !material_indices.empty () )
+      {
+        material_indices = Optimise::reorder_vertices (
+            old_numbers,
+            material_indices.data ()
+        );
+      }
+      if ( !diffuse_colours.empty () )
+      {
+        diffuse_colours = Optimise::reorder_vertices (
+            old_numbers,
+            diffuse_colours.data ()
+        );
+      }
+    }
+
+    const auto after{
+        Optimise::analyse ( indices, numVertices, vertex_bytes )
+    };
+    {
+      logmt ( info ) << "    Vertex cache ACMR " << before.acmr << " -> "
+          << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr
+          << ", fetch overfetch " << before.overfetch << " -> "
+          << after.overfetch;
+    }
+  }
+
+  // Each level of detail is made from the one before, and draws the same
+  // vertices. Normals and colours count as attributes, so that edges
+  // between bands of a landscape are kept.
+  std::vector<std::vector<unsigned int>> lod_indices{};
+  if ( options.lods > 0 )
+  {
+    const auto colour_floats{
+        material_indices.empty () ? diffuse_colours.empty () ? 0 : 3 : 1
+    };
+    const auto attributes_per_vertex{ 3 + colour_floats };
+    std::vector<float> attributes( numVertices * attributes_per_vertex );
+    for ( size_t j{ 0 }; j < numVertices; ++j )
+    {
+      auto* p_attribute{ &attributes[j * attributes_per_vertex] };
+      std::copy_n ( p_normal_floats + j * 3, 3, p_attribute );
+      if ( !material_indices.empty () )
+      {
+        p_attribute[3] = material_indices[j];
+      }
+      else if ( !diffuse_colours.empty () )
+      {
+        p_attribute[3] = diffuse_colours[j].red;
+        p_attribute[4] = diffuse_colours[j].green;
+        p_attribute[5] = diffuse_colours[j].blue;
+      }
+    }
+    for ( unsigned level{ 1 }; level <= options.lods; ++level )
+    {
+      const auto& finer{ level == 1 ? indices : lod_indices.back () };
+      const auto target{
+          static_cast<size_t>( finer.size () / 3 * options.lod_ratio )
+      };
+      auto error{ 0.0f };
+      auto coarser{
+          Simplify::simplify (
+              finer,
+              p_vertex_floats,
+              numVertices,
+              attributes.data (),
+              attributes_per_vertex,
+              target,
+              error
+          )
+      };
+      if ( coarser.size () == finer.size () )
+      {
+        logmt ( info ) << "    Level of detail " << level
+            << " not made as no edge can collapse";
+        break;
+      }
+      {
+        logmt ( info ) << "    Level of detail " << level << " has "
+            << coarser.size () / 3 << " triangles with error at most "
+            << error << " of the bounding box diagonal";
+      }
+      lod_indices.emplace_back ( std::move ( coarser ) );
+    }
+  }
+
+  Meshlets::meshlets_struct meshlets{};
+  if ( options.is_meshlets )
+  {
+    meshlets = Meshlets::build (
+        indices,
+        p_vertex_floats,
+        numVertices,
+        options.meshlet_vertices,
+        options.meshlet_triangles
+    );
+    {
+      logmt ( info ) << "    Split into " << meshlets.meshlets.size ()
+          << " meshlets using " << meshlets.vertices.size () << " vertices";
+    }
+  }
+
+  Bvh::hierarchy_struct bvh{};
+  if ( options.is_bvh )
+  {
+    bvh = Bvh::build ( indices, p_vertex_floats, options.bvh_jobs );
+    {
+      logmt ( info ) << "    Built a BVH of " << bvh.nodes.size ()
+          << " nodes";
+    }
+  }
+
+  MtFormat::header_struct header{
+      .num_vertices{ static_cast<std::uint32_t>( numVertices ) },
+      .num_indices{ static_cast<std::uint32_t>( numIndices ) }
+  };
+  if ( numVertices > 0 )
+  {
+    header.bounds_min = { p_vertex_floats[0], p_vertex_floats[1],
+        p_vertex_floats[2] };
+    header.bounds_max = header.bounds_min;
+  }
+  for ( size_t j{ 0 }; j < numVertices * 3; ++j )
+  {
+    header.bounds_min[j % 3] =
+        std::min ( header.bounds_min[j % 3], p_vertex_floats[j] );
+    header.bounds_max[j % 3] =
+        std::max ( header.bounds_max[j % 3], p_vertex_floats[j] );
+  }
+
+  // Quantised data must live as long as the writer.
+  std::vector<std::uint16_t> quantised_positions{};
+  std::vector<std::int16_t> quantised_normals{};
+  std::vector<std::uint8_t> quantised_colours{};
+  std::vector<std::uint16_t> short_indices{};
+  std::vector<std::vector<std::uint16_t>> short_lod_indices{};
+  short_lod_indices.reserve ( lod_indices.size () );
+  MtFormat::Writer writer{};
+  if ( options.is_quantised )
+  {
+    const auto is_half{ options.positions == Quantise::PositionEnum::Half };
+    quantised_positions.resize ( numVertices * 3 );
+    const auto position_error{
+        is_half
+            ? Quantise::positions_half (
+                  p_vertex_floats,
+                  numVertices,
+                  header.bounds_min,
+                  header.bounds_max,
+                  quantised_positions.data ()
+              )
+            : Quantise::positions_unorm16 (
+                  p_vertex_floats,
+                  numVertices,
+                  header.bounds_min,
+                  header.bounds_max,
+                  quantised_positions.data ()
+              )
+    };
+    quantised_normals.resize ( numVertices * 2 );
+    const auto normal_error{
+        Quantise::normals_octahedral (
+            p_normal_floats,
+            numVertices,
+            quantised_normals.data ()
+        )
+    };
+    writer.add (
+        MtFormat::SectionEnum::Positions,
+        is_half
+            ? MtFormat::FormatEnum::Float16x3
+            : MtFormat::FormatEnum::Unorm16x3,
+        quantised_positions.data (),
+        numVertices
+    );
+    writer.add (
+        MtFormat::SectionEnum::Normals,
+        MtFormat::FormatEnum::Octahedral16x2,
+        quantised_normals.data (),
+        numVertices
+    );
+    {
+      logmt ( info ) << "    Quantised positions with error at most "
+          << position_error.max << " and RMS " << position_error.rms
+          << ", and normals with error at most " << normal_error.max
+          << " and RMS " << normal_error.rms << " degrees";
+    }
+  }
+  else
+  {
+    writer.add (
+        MtFormat::SectionEnum::Positions,
+        MtFormat::FormatEnum::Float32x3,
+        p_vertex_floats,
+        numVertices
+    );
+    writer.add (
+        MtFormat::SectionEnum::Normals,
+        MtFormat::FormatEnum::Float32x3,
+        p_normal_floats,
+        numVertices
+    );
+  }
+  writer.add (
+      MtFormat::SectionEnum::TexCoords,
+      MtFormat::FormatEnum::Float32x2,
+      texture_uvs.data (),
+      numVertices
+  );
+  if ( is_v1 )
+  {
+    writer.add (
+        MtFormat::SectionEnum::VertexMaterials,
+        MtFormat::FormatEnum::Material,
+        colouring.data (),
+        colouring.size ()
+    );
+  }
+  else
+  {
+    writer.add (
+        MtFormat::SectionEnum::Materials,
+        MtFormat::FormatEnum::Material,
+        material_table.data (),
+        material_table.size ()
+    );
+    if ( vertex_colours == Colouring::VertexColourEnum::Index )
+    {
+      writer.add (
+          MtFormat::SectionEnum::MaterialIndices,
+          MtFormat::FormatEnum::Uint8,
+          material_indices.data (),
+          material_indices.size ()
+      );
+    }
+    else if (
+        vertex_colours == Colouring::VertexColourEnum::Diffuse
+        && options.is_quantised
+    )
+    {
+      const auto num_components{ diffuse_colours.size () * 4 };
+      quantised_colours.resize ( num_components );
+      const auto colour_error{
+          Quantise::colours_unorm8 (
+              reinterpret_cast<const float*>( diffuse_colours.data () ),
+              num_components,
+              quantised_colours.data ()
+          )
+      };
+      writer.add (
+          MtFormat::SectionEnum::DiffuseColours,
+          MtFormat::FormatEnum::Unorm8x4,
+          quantised_colours.data (),
+          diffuse_colours.size ()
+      );
+      {
+        logmt ( info ) << "    Quantised diffuse colours with error at most "
+            << colour_error.max << " and RMS " << colour_error.rms;
+      }
+    }
+    else if ( vertex_colours == Colouring::VertexColourEnum::Diffuse )
+    {
+      writer.add (
+          MtFormat::SectionEnum::DiffuseColours,
+          MtFormat::FormatEnum::Float32x4,
+          diffuse_colours.data (),
+          diffuse_colours.size ()
+      );
+    }
+  }
+  if ( options.is_quantised && numVertices < Quantise::SHORT_INDEX_VERTICES )
+  {
+    short_indices.resize ( indices.size () );
+    Quantise::indices_uint16 ( indices, short_indices.data () );
+    writer.add (
+        MtFormat::SectionEnum::Indices,
+        MtFormat::FormatEnum::Uint16,
+        short_indices.data (),
+        short_indices.size ()
+    );
+  }
+  else
+  {
+    writer.add (
+        MtFormat::SectionEnum::Indices,
+        MtFormat::FormatEnum::Uint32,
+        indices.data (),
+        indices.size ()
+    );
+  }
+  for ( const auto& lod : lod_indices )
+  {
+    if ( options.is_quantised && numVertices < Quantise::SHORT_INDEX_VERTICES )
+    {
+      auto& short_lod{ short_lod_indices.emplace_back ( lod.size () ) };
+      Quantise::indices_uint16 ( lod, short_lod.data () );
+      writer.add (
+          MtFormat::SectionEnum::LodIndices,
+          MtFormat::FormatEnum::Uint16,
+          short_lod.data (),
+          short_lod.size ()
+      );
+    }
+    else
+    {
+      writer.add (
+          MtFormat::SectionEnum::LodIndices,
+          MtFormat::FormatEnum::Uint32,
+          lod.data (),
+          lod.size ()
+      );
+    }
+  }
+
+  if ( options.is_meshlets )
+  {
+    writer.add (
+        MtFormat::SectionEnum::Meshlets,
+        MtFormat::FormatEnum::Meshlet,
+        meshlets.meshlets.data (),
+        meshlets.meshlets.size ()
+    );
+    writer.add (
+        MtFormat::SectionEnum::MeshletVertices,
+        MtFormat::FormatEnum::Uint32,
+        meshlets.vertices.data (),
+        meshlets.vertices.size ()
+    );
+    writer.add (
+        MtFormat::SectionEnum::MeshletTriangles,
+        MtFormat::FormatEnum::Uint8,
+        meshlets.triangles.data (),
+        meshlets.triangles.size ()
+    );
+  }
+
+  if ( options.is_bvh )
+  {
+    writer.add (
+        MtFormat::SectionEnum::Bvh,
+        MtFormat::FormatEnum::BvhNode,
+        bvh.nodes.data (),
+        bvh.nodes.size ()
+    );
+    writer.add (
+        MtFormat::SectionEnum::BvhTriangles,
+        MtFormat::FormatEnum::Uint32,
+        bvh.triangles.data (),
+        bvh.triangles.size ()
+    );
+  }
+
+  std::stringstream ss_file_name{};
+  ss_file_name << f << "." << i << "." << numVertices << "." << numIndices
+      << MT_FILE_EXTENSION;
+  const auto file_name{ ss_file_name.str () };
+  std::ofstream output_file{
+      file_name,
+      std::ios_base::out | std::ios_base::binary
+  };
+  {
+    logmt ( info ) << "    Opened output file '" << file_name << "'";
+  }
+
+  if ( options.is_interleaved )
+  {
+    const auto stride{ writer.interleave () };
+    {
+      logmt ( debug ) << "    Interleaved vertex attributes with a stride of "
+          << stride << " bytes";
+    }
+  }
+
+  if ( options.is_compressed )
+  {
+    const auto compressed{ writer.compress ( options.compress_level ) };
+    {
+      logmt ( debug ) << "    Compressed " << compressed << " of "
+          << writer.sections ().size () << " sections";
+    }
+  }
+
+  if ( options.mt_version == MtFormat::VERSION )
+  {
+    const auto file_bytes{ writer.write ( output_file, header ) };
+    for ( const auto& section : writer.sections () )
+    {
+      logmt ( debug ) << "      Wrote " << section.bytes << " bytes for "
+          << section_description (
+                 static_cast<MtFormat::SectionEnum>( section.type )
+             )
+          << " data at offset " << section.offset;
+    }
+    {
+      logmt ( debug ) << "      Wrote " << file_bytes
+          << " bytes in all with header and section table";
+    }
+  }
+  else
+  {
+    write_headerless ( output_file, options.mt_version, writer, logmt );
+  }
+
+  output_file.close ();
+  {
+    logmt ( info ) << "    Closed output file '" << file_name << "'";
+  }
+  return ( file_name );
+}
+
+/**
+ * @brief Imports a 3D data file and converts each of its meshes into an MT
+ * file.
+ *
+ * @param[in] f The name of the file.
+ * @param[in,out] importer The importer to use, which no other thread may be
+ * using, with its properties already set.
+ * @param[in] options The conversion options.
+ * @param[in,out] logmt Where to log.
+ * @param[in] content The hash of the file from Cache::content_hash(), if
+ * scenes are cached.
+ * @param[out] dependencies The other files it was imported from.
+ * @param[out] outputs The names of the MT files written, one for each mesh.
+ * @returns \c true if the file was imported.
  */
+bool convert_file (
+    const std::string& f,
+    Assimp::Importer& importer,
+    const options_struct& options,
+    Log::Buffer& logmt,
+    const std::string& content,
+    std::vector<Cache::dependency_struct>& dependencies,
+    std::vector<std::string>& outputs
+)
+{
+  const unsigned flags{ aiProcessPreset_TargetRealtime_Quality };
+  const auto stem{
+      options.scene_cache.empty ()
+          ? std::string{}
+          : Cache::scene_name (
+                options.scene_cache,
+                f,
+                content,
+                flags,
+                importer
+            )
+  };
+  std::string cached{};
+  bool is_scene_hit{ false };
+  bool is_scene_stored{ false };
+  const auto* p_scene{
+      Cache::import_scene (
+          f,
+          stem,
+          flags,
+          importer,
+          dependencies,
+          cached,
+          is_scene_hit,
+          is_scene_stored
+      )
+  };
+  if (
+      p_scene == nullptr
+      || p_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE
+      || p_scene->mRootNode == nullptr
+  )
+  {
+    {
+      logmt ( error ) << "  ASSIMP: Failed to import file '" << f << "' !";
+      logmt ( error ) << "    ASSIMP: " << importer.GetErrorString ();
+      std::string importable{ "" };
+      importer.GetExtensionList ( importable );
+      logmt ( error ) << "    ASSIMP: Supported file extensions = '"
+          << importable << "'";
+    }
+    importer.FreeScene ();
+    return ( false );
+  }
+  else if ( is_scene_hit )
+  {
+    logmt ( info ) << "  Read post-processed scene of file '" << f
+        << "' from '" << cached << "'";
+  }
+  else
+  {
+    logmt ( info ) << "  ASSIMP: Successfully imported file '" << f << "'";
+    if ( is_scene_stored )
+    {
+      logmt ( debug ) << "  Cached post-processed scene in '" << cached
+          << "'";
+    }
+    else if ( !stem.empty () )
+    {
+      logmt ( warning ) << "  Cannot cache post-processed scene in '"
+          << cached << "' !";
+    }
+  }
 
-//! The file extension for MT files.
-#ifdef _DEBUG
-const auto* MT_FILE_EXTENSION{ ".mtd" };
-#else
-const auto* MT_FILE_EXTENSION{ ".mt" };
-#endif /* _DEBUG */
+  const auto num_meshes{ p_scene->mNumMeshes };
+  {
+    logmt ( debug ) << "  Number of meshes = " << num_meshes;
+  }
+  // Meshes are independent, and are logged in mesh order once all are done.
+  // Cores not needed for meshes at once help build each mesh's hierarchy.
+  const auto mesh_workers{
+      Jobs::worker_count ( options.mesh_jobs, num_meshes )
+  };
+  const auto cores{
+      Jobs::worker_count ( 0, std::numeric_limits<std::size_t>::max () )
+  };
+  auto mesh_options{ options };
+  mesh_options.bvh_jobs = std::max ( cores / mesh_workers, 1U );
 
-//! The process priority to set in Windows.
-const auto PROCESS_PRIORITY{ IDLE_PRIORITY_CLASS };
+  // Meshes are written in their own space, without the transforms of the
+  // nodes that draw them, so the scene's occluders are built once from
+  // every mesh moved to where each node drawing it places it.
+  if ( options.is_ao_baked && options.is_ao_scene )
+  {
+    mesh_options.mesh_placements = mesh_placements ( p_scene );
+    std::vector<float> positions{};
+    std::vector<std::uint32_t> scene_indices{};
+    std::vector<float> placed{};
+    std::vector<float> no_normals{};
+    for ( unsigned int i{ 0 }; i < num_meshes; ++i )
+    {
+      const auto* p_mesh{ p_scene->mMeshes[i] };
+      std::vector<float> converted{};
+      const auto* p_floats{
+          float_components (
+              p_mesh->mVertices,
+              p_mesh->mNumVertices,
+              converted
+          )
+      };
+      for ( const auto& transform : mesh_options.mesh_placements[i] )
+      {
+        const auto first{
+            static_cast<std::uint32_t>( positions.size () / 3 )
+        };
+        place (
+            transform,
+            p_floats,
+            nullptr,
+            p_mesh->mNumVertices,
+            placed,
+            no_normals
+        );
+        positions.insert ( positions.end (), placed.begin (), placed.end () );
+        for ( unsigned int j{ 0 }; j < p_mesh->mNumFaces; ++j )
+        {
+          const auto& face{ p_mesh->mFaces[j] };
+          for ( unsigned int k{ 0 }; k < face.mNumIndices; ++k )
+          {
+            scene_indices.emplace_back ( first + face.mIndices[k] );
+          }
+        }
+      }
+    }
+    mesh_options.p_scene_occluders =
+        std::make_shared<const Occlusion::occluders_struct> (
+            Occlusion::build ( scene_indices, positions.data (), cores )
+        );
+    {
+      logmt ( info ) << "  Built occluders of "
+          << scene_indices.size () / 3 << " triangles for the scene";
+    }
+  }
+
+  // Each diffuse texture is decoded once for all the meshes using it, and
+  // the textures at once. Files are found beside the scene, and hashed
+  // before they are decoded, as the cache depends on them as it does on
+  // the files the scene was imported from.
+  if ( options.is_texture_baked )
+  {
+    std::vector<std::string> names{};
+    std::vector<std::size_t> material_names( p_scene->mNumMaterials );
+    for ( unsigned int m{ 0 }; m < p_scene->mNumMaterials; ++m )
+    {
+      aiString path{};
+      material_names[m] = std::numeric_limits<std::size_t>::max ();
+      if (
+          p_scene->mMaterials[m]->GetTextureCount ( aiTextureType_DIFFUSE ) == 0
+          || p_scene->mMaterials[m]->GetTexture (
+                 aiTextureType_DIFFUSE,
+                 0,
+                 &path
+             ) != aiReturn_SUCCESS
+      )
+      {
+        continue;
+      }
+      const auto found{
+          std::find ( names.begin (), names.end (), path.C_Str () )
+      };
+      material_names[m] = static_cast<std::size_t>( found - names.begin () );
+      if ( found == names.end () )
+      {
+        names.emplace_back ( path.C_Str () );
+      }
+    }
+
+    std::vector<std::shared_ptr<const Texture::texture_struct>> textures(
+        names.size ()
+    );
+    std::vector<std::string> failures( names.size () );
+    std::vector<Cache::dependency_struct> files( names.size () );
+    const auto texture_workers{ Jobs::worker_count ( 0, names.size () ) };
+    Jobs::parallel_for (
+        names.size (),
+        texture_workers,
+        [&] ( std::size_t t, unsigned )
+        {
+          try
+          {
+            const auto* p_embedded{
+                p_scene->GetEmbeddedTexture ( names[t].c_str () )
+            };
+            const boost::filesystem::path name{ names[t] };
+            const auto file{
+                name.is_absolute ()
+                    ? name
+                    : boost::filesystem::path{ f }.parent_path () / name
+            };
+            if ( p_embedded == nullptr )
+            {
+              files[t] = Cache::hash_dependency ( file.string () );
+            }
+            auto image{
+                p_embedded != nullptr
+                    ? Texture::decode_embedded ( *p_embedded, names[t] )
+                    : Texture::decode_file ( file )
+            };
+            textures[t] = std::make_shared<const Texture::texture_struct> (
+                Texture::make_levels (
+                    std::move ( image ),
+                    std::max ( cores / texture_workers, 1U )
+                )
+            );
+          }
+          catch ( const std::exception& e )
+          {
+            failures[t] = e.what ();
+          }
+        }
+    );
+    for ( std::size_t t{ 0 }; t < names.size (); ++t )
+    {
+      const auto is_listed{
+          std::any_of (
+              dependencies.begin (),
+              dependencies.end (),
+              [&] ( const Cache::dependency_struct& dependency )
+              {
+                return ( dependency.name == files[t].name );
+              }
+          )
+      };
+      if ( !files[t].name.empty () && !is_listed )
+      {
+        dependencies.push_back ( std::move ( files[t] ) );
+      }
+      if ( textures[t] )
+      {
+        logmt ( debug ) << "  Decoded texture '" << names[t] << "' into "
+            << textures[t]->levels.size () << " levels";
+      }
+      else
+      {
+        logmt ( warning ) << "  Cannot bake texture '" << names[t] << "': "
+            << failures[t] << " !";
+      }
+    }
+    mesh_options.material_textures.assign ( p_scene->mNumMaterials, {} );
+    for ( unsigned int m{ 0 }; m < p_scene->mNumMaterials; ++m )
+    {
+      if ( material_names[m] < names.size () )
+      {
+        mesh_options.material_textures[m] = textures[material_names[m]];
+      }
+    }
+  }
+  std::vector<Log::Buffer> mesh_logs( num_meshes );
+  outputs.assign ( num_meshes, std::string{} );
+  Jobs::parallel_for (
+      num_meshes,
+      mesh_workers,
+      [&] ( std::size_t i, unsigned )
+      {
+        outputs[i] = convert_mesh (
+            p_scene->mMeshes[i],
+            f,
+            static_cast<unsigned int>( i ),
+            mesh_options,
+            mesh_logs[i]
+        );
+      }
+  );
+  for ( auto& mesh_log : mesh_logs )
+  {
+    logmt.append ( mesh_log );
+  }
+
+  // Scenes can be huge, so do not keep this one until the next import.
+  importer.FreeScene ();
+  return ( true );
+}
 
-#ifdef __VERTEX_AND_TRIANGLE_LIMITS__
-//! The maximum number of vertices processed before a mesh is split.
-const auto VERTEX_LIMIT{ 262'144 };
 
-//! The maximum number of triangles processed before a mesh is split.
-const auto TRIANGLE_LIMIT{ 786'432 };
-#endif /* __VERTEX_AND_TRIANGLE_LIMITS__ */
+/**
+ * @brief Describes everything but the input file that MT files depend on,
+ * for the keys of cached files.
+ *
+ * The number of workers is left out, as it changes only how fast files are
+ * converted.
+ *
+ * @param[in] options The conversion options.
+ * @param[in] triangle_limit The triangles before a mesh is split, or 0.
+ * @param[in] vertex_limit The vertices before a mesh is split, or 0.
+ * @returns The description, on one line.
+ */
+std::string cache_settings (
+    const options_struct& options,
+    int triangle_limit,
+    int vertex_limit
+)
+{
+  std::ostringstream settings{};
+  settings << "cache-version=" << CACHE_VERSION
+      << " material=" << options.palette.name
+      << " mt-version=" << options.mt_version
+      << " vertex-colours=" << static_cast<int>( options.vertex_colours )
+      << " triangle-limit=" << triangle_limit
+      << " vertex-limit=" << vertex_limit
+      << " optimise=" << options.is_fetch_optimised
+      << " overdraw=" << options.is_overdraw_sorted
+      << " overdraw-threshold=" << options.overdraw_threshold
+      << " quantise=" << options.is_quantised
+      << " positions=" << static_cast<int>( options.positions )
+      << " interleave=" << options.is_interleaved
+      << " lods=" << options.lods
+      << " lod-ratio=" << options.lod_ratio
+      << " meshlets=" << options.is_meshlets
+      << " meshlet-vertices=" << options.meshlet_vertices
+      << " meshlet-triangles=" << options.meshlet_triangles
+      << " bvh=" << options.is_bvh
+      << " bake-ao=" << options.is_ao_baked
+      << " ao-rays=" << options.ao_rays
+      << " ao-distance=" << options.ao_distance
+      << " ao-scene=" << options.is_ao_scene
+      << " bake-textures=" << options.is_texture_baked
+      << " texture-filter=" << static_cast<int>( options.texture_filter )
+      << " texture-sampling=" << Texture::SAMPLING_VERSION
+      << " compress=" << options.is_compressed
+      << " compress-level=" << options.compress_level;
+
+  // Materials files can change what a name means, so all of it is here.
+  settings << std::setprecision ( std::numeric_limits<float>::max_digits10 );
+  for ( const auto start : options.palette.band_starts )
+  {
+    settings << " from=" << start;
+  }
+  for ( const auto& material : options.palette.materials )
+  {
+    const auto* p_floats{ reinterpret_cast<const float*>( &material ) };
+    settings << " band=";
+    for ( std::size_t c{ 0 }; c < 13; ++c )
+    {
+      settings << ( c == 0 ? "" : "," ) << p_floats[c];
+    }
+  }
+  return ( settings.str () );
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -119,33 +1649,214 @@ int main ( int argc, char* argv[], char* envp[] )
   bool is_help{ false };
   description.add_options ()
     (
-      "help,h",
-      boost::program_options::bool_switch ( &is_help ),
-      "Display help message\n"
+      "help,h",
+      boost::program_options::bool_switch ( &is_help ),
+      "Display help message\n"
+    )
+    (
+      "log-level,l",
+      boost::program_options::value<std::string> ()->default_value ( 
+          Log::DEFAULT_LOG_LEVEL 
+      ),
+      "Logging level\n"
+    )
+    (
+      "triangle-limit,t",
+      boost::program_options::value<int> ()->default_value ( 0 ),
+      "Maximum number of triangles before a mesh is split, or 0 for Assimp's"
+    )
+    (
+      "vertex-limit,v",
+      boost::program_options::value<int> ()->default_value ( 0 ),
+      "Maximum number of vertices before a mesh is split, or 0 for Assimp's"
+    )
+    (
+      "jobs,j",
+      boost::program_options::value<unsigned> ()->default_value (
+          DEFAULT_JOBS
+      ),
+      "Number of files converted at once, or 0 for one per core"
+    )
+    (
+      "mesh-jobs",
+      boost::program_options::value<unsigned> ()->default_value (
+          DEFAULT_MESH_JOBS
+      ),
+      "Number of meshes of a file converted at once, or 0 for one per core"
+    )
+    (
+      "cache",
+      boost::program_options::bool_switch (),
+      "Skip files whose MT files are current, by a manifest beside each"
+    )
+    (
+      "force",
+      boost::program_options::bool_switch (),
+      "With --cache, convert every file and renew its manifest"
+    )
+    (
+      "scene-cache",
+      boost::program_options::value<std::string> ()->default_value ( "" ),
+      "Directory to cache post-processed scenes in, so that only export"
+      " options changing skips importing"
+    )
+    (
+      "memory-budget",
+      boost::program_options::value<unsigned> ()->default_value (
+          DEFAULT_MEMORY_BUDGET_MIB
+      ),
+      "Memory in MiB that files converted at once may use between them"
+    )
+    (
+      "optimise",
+      boost::program_options::bool_switch (),
+      "Renumber vertices in the order triangles first use them"
+    )
+    (
+      "overdraw",
+      boost::program_options::bool_switch (),
+      "Sort triangles so those facing out of a mesh are drawn first"
+    )
+    (
+      "overdraw-threshold",
+      boost::program_options::value<float> ()->default_value (
+          Optimise::DEFAULT_OVERDRAW_THRESHOLD,
+          "1.05"
+      ),
+      "Rise in vertex cache miss ratio allowed when sorting for overdraw"
+    )
+    (
+      "mt-version",
+      boost::program_options::value<unsigned> ()->default_value (
+          DEFAULT_MT_VERSION
+      ),
+      "MT format version to write, 1, 2, or 3"
+    )
+    (
+      "quantise",
+      boost::program_options::bool_switch (),
+      "Store attributes and indices in fewer bits, from MT v3"
+    )
+    (
+      "position-format",
+      boost::program_options::value<std::string> ()->default_value (
+          "unorm16"
+      ),
+      "Quantised positions as 'unorm16' or 'half'"
+    )
+    (
+      "layout",
+      boost::program_options::value<std::string> ()->default_value (
+          "planar"
+      ),
+      "Vertex attributes 'planar' or 'interleaved', from MT v3"
+    )
+    (
+      "lods",
+      boost::program_options::value<unsigned> ()->default_value ( 0 ),
+      "Coarser levels of detail to write, from MT v3"
+    )
+    (
+      "lod-ratio",
+      boost::program_options::value<float> ()->default_value (
+          Simplify::DEFAULT_LOD_RATIO,
+          "0.5"
+      ),
+      "Fraction of triangles each level of detail keeps of the one before"
+    )
+    (
+      "meshlets",
+      boost::program_options::bool_switch (),
+      "Split triangles into meshlets with culling bounds, from MT v3"
+    )
+    (
+      "meshlet-vertices",
+      boost::program_options::value<std::uint32_t> ()->default_value (
+          Meshlets::DEFAULT_MAX_VERTICES
+      ),
+      "Most vertices of a meshlet, 3 to 256"
+    )
+    (
+      "meshlet-triangles",
+      boost::program_options::value<std::uint32_t> ()->default_value (
+          Meshlets::DEFAULT_MAX_TRIANGLES
+      ),
+      "Most triangles of a meshlet, 1 to 512"
+    )
+    (
+      "bvh",
+      boost::program_options::bool_switch (),
+      "Write a bounding volume hierarchy of the triangles, from MT v3"
+    )
+    (
+      "bake-ao",
+      boost::program_options::bool_switch (),
+      "Darken vertex colours by ambient occlusion, ambient and diffuse in"
+      " MT v1 and only diffuse in later versions"
     )
     (
-      "log-level,l",
-      boost::program_options::value<std::string> ()->default_value ( 
-          Log::DEFAULT_LOG_LEVEL 
+      "ao-rays",
+      boost::program_options::value<unsigned> ()->default_value (
+          Occlusion::DEFAULT_RAYS
       ),
-      "Logging level\n"
+      "Rays cast from each vertex when baking ambient occlusion, 1 to 1024,"
+      " fewer for speed and more for quality"
     )
-#ifdef __VERTEX_AND_TRIANGLE_LIMITS__
     (
-      "triangle-limit,t",
-      boost::program_options::value<int> ()->default_value ( TRIANGLE_LIMIT ),
-      "Maximum number of triangles before a mesh is split"
+      "ao-distance",
+      boost::program_options::value<float> ()->default_value (
+          Occlusion::DEFAULT_DISTANCE,
+          "0.1"
+      ),
+      "Length of occlusion rays, as a fraction of the size of the mesh"
     )
     (
-      "vertex-limit,v",
-      boost::program_options::value<int> ()->default_value ( VERTEX_LIMIT ),
-      "Maximum number of vertices before a mesh is split"
+      "ao-scene",
+      boost::program_options::bool_switch (),
+      "Bake ambient occlusion from every mesh of a file, placed by its"
+      " nodes, not just each mesh itself"
+    )
+    (
+      "bake-textures",
+      boost::program_options::bool_switch (),
+      "Sample the diffuse texture of each mesh into the diffuse colour of"
+      " each vertex"
+    )
+    (
+      "texture-filter",
+      boost::program_options::value<std::string> ()->default_value (
+          "area"
+      ),
+      "Texture sampling 'bilinear', or 'area' to average the texels around"
+      " each vertex"
+    )
+    (
+      "compress",
+      boost::program_options::bool_switch (),
+      "Compress sections in chunks with zlib, from MT v3"
+    )
+    (
+      "compress-level",
+      boost::program_options::value<int> ()->default_value ( 6 ),
+      "zlib compression level, 1 for fastest to 9 for smallest"
+    )
+    (
+      "vertex-colours",
+      boost::program_options::value<std::string> ()->default_value (
+          "index"
+      ),
+      "Per-vertex landscape colouring from MT v2, 'index' or 'diffuse'"
     )
-#endif /* __VERTEX_AND_TRIANGLE_LIMITS__ */
     (
       "material,m",
       boost::program_options::value<std::string> (),
-      "Choose 'gold', 'jade', 'pearl', 'silver', or 'landscape'"
+      "Choose 'gold', 'jade', 'pearl', 'silver', 'landscape', or one from"
+      " --materials"
+    )
+    (
+      "materials",
+      boost::program_options::value<std::string> ()->default_value ( "" ),
+      "File of more materials, as in Materials.info"
     )
     (
       "file,f",
@@ -185,31 +1896,189 @@ int main ( int argc, char* argv[], char* envp[] )
     return ( EXIT_NO_MATERIAL_ERROR );
   }
 
-  Colouring::MaterialEnum material_chosen{};
-  if ( boost::iequals ( material_wanted, "gold" ) )
+  auto palettes{ Colouring::builtin_palettes () };
+  const auto& materials_file{ vm["materials"].as<std::string> () };
+  if ( !materials_file.empty () )
   {
-    material_chosen = Colouring::MaterialEnum::Gold;
+    try
+    {
+      Colouring::load_palettes ( materials_file, palettes );
+    }
+    catch ( const std::exception& e )
+    {
+      std::cerr << "Materials file '" << materials_file
+          << "' is not valid: " << e.what () << " !\n";
+      return ( EXIT_COMMAND_LINE_ERROR );
+    }
+  }
+  const auto palette_chosen{
+      palettes.find ( boost::to_lower_copy ( material_wanted ) )
+  };
+  if ( palette_chosen == palettes.end () )
+  {
+    std::cerr << "The material chosen is not valid !\n";
+    return ( EXIT_INCORRECT_MATERIAL_ERROR );
   }
-  else if ( boost::iequals ( material_wanted, "jade" ) )
+
+  const auto mt_version{ vm["mt-version"].as<unsigned> () };
+  if (
+      mt_version != MT_VERSION_PER_VERTEX_MATERIALS
+      && mt_version != MT_VERSION_MATERIAL_TABLE
+      && mt_version != MT_VERSION_HEADER
+  )
   {
-    material_chosen = Colouring::MaterialEnum::Jade;
+    std::cerr << "The MT version must be 1, 2, or 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
   }
-  else if ( boost::iequals ( material_wanted, "pearl" ) )
+
+  const auto is_quantised{ vm["quantise"].as<bool> () };
+  if ( is_quantised && mt_version != MT_VERSION_HEADER )
   {
-    material_chosen = Colouring::MaterialEnum::Pearl;
+    std::cerr << "Quantised attributes need --mt-version 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
   }
-  else if ( boost::iequals ( material_wanted, "silver" ) )
+
+  const auto& position_format_wanted{
+      vm["position-format"].as<std::string> ()
+  };
+  Quantise::PositionEnum position_format{};
+  if ( boost::iequals ( position_format_wanted, "unorm16" ) )
   {
-    material_chosen = Colouring::MaterialEnum::Silver;
+    position_format = Quantise::PositionEnum::Unorm16;
   }
-  else if ( boost::iequals ( material_wanted, "landscape" ) )
+  else if ( boost::iequals ( position_format_wanted, "half" ) )
   {
-    material_chosen = Colouring::MaterialEnum::Landscape;
+    position_format = Quantise::PositionEnum::Half;
   }
   else
   {
-    std::cerr << "The material chosen is not valid !\n";
-    return ( EXIT_INCORRECT_MATERIAL_ERROR );
+    std::cerr << "Position format must be 'unorm16' or 'half' !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto& layout_wanted{ vm["layout"].as<std::string> () };
+  bool is_interleaved{ false };
+  if ( boost::iequals ( layout_wanted, "interleaved" ) )
+  {
+    is_interleaved = true;
+  }
+  else if ( !boost::iequals ( layout_wanted, "planar" ) )
+  {
+    std::cerr << "Layout must be 'planar' or 'interleaved' !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if ( is_interleaved && mt_version != MT_VERSION_HEADER )
+  {
+    std::cerr << "Interleaved vertex attributes need --mt-version 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto lods{ vm["lods"].as<unsigned> () };
+  const auto lod_ratio{ vm["lod-ratio"].as<float> () };
+  if ( lods > 0 && mt_version != MT_VERSION_HEADER )
+  {
+    std::cerr << "Levels of detail need --mt-version 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if ( !( lod_ratio > 0.0f && lod_ratio < 1.0f ) )
+  {
+    std::cerr << "Level of detail ratio must be between 0 and 1 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto is_meshlets{ vm["meshlets"].as<bool> () };
+  const auto meshlet_vertices{ vm["meshlet-vertices"].as<std::uint32_t> () };
+  const auto meshlet_triangles{
+      vm["meshlet-triangles"].as<std::uint32_t> ()
+  };
+  if ( is_meshlets && mt_version != MT_VERSION_HEADER )
+  {
+    std::cerr << "Meshlets need --mt-version 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if (
+      meshlet_vertices < 3
+      || meshlet_vertices > Meshlets::MAX_VERTICES
+      || meshlet_triangles < 1
+      || meshlet_triangles > Meshlets::MAX_TRIANGLES
+  )
+  {
+    std::cerr << "Meshlets must have 3 to 256 vertices and 1 to 512"
+        " triangles !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto is_bvh{ vm["bvh"].as<bool> () };
+  if ( is_bvh && mt_version != MT_VERSION_HEADER )
+  {
+    std::cerr << "A BVH needs --mt-version 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto is_ao_baked{ vm["bake-ao"].as<bool> () };
+  const auto ao_rays{ vm["ao-rays"].as<unsigned> () };
+  const auto ao_distance{ vm["ao-distance"].as<float> () };
+  const auto is_ao_scene{ vm["ao-scene"].as<bool> () };
+  if ( ao_rays < 1 || ao_rays > Occlusion::MAX_RAYS )
+  {
+    std::cerr << "Occlusion rays per vertex must be from 1 to 1024 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if ( !( ao_distance > 0.0f && ao_distance <= 1.0f ) )
+  {
+    std::cerr << "Occlusion distance must be above 0 and at most 1 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if ( is_ao_scene && !is_ao_baked )
+  {
+    std::cerr << "Occlusion from the whole scene needs --bake-ao !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto is_texture_baked{ vm["bake-textures"].as<bool> () };
+  const auto& texture_filter_wanted{ vm["texture-filter"].as<std::string> () };
+  Texture::FilterEnum texture_filter{};
+  if ( boost::iequals ( texture_filter_wanted, "bilinear" ) )
+  {
+    texture_filter = Texture::FilterEnum::Bilinear;
+  }
+  else if ( boost::iequals ( texture_filter_wanted, "area" ) )
+  {
+    texture_filter = Texture::FilterEnum::Area;
+  }
+  else
+  {
+    std::cerr << "Texture filter must be 'bilinear' or 'area' !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto is_compressed{ vm["compress"].as<bool> () };
+  const auto compress_level{ vm["compress-level"].as<int> () };
+  if ( is_compressed && mt_version != MT_VERSION_HEADER )
+  {
+    std::cerr << "Compressed sections need --mt-version 3 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+  if ( compress_level < Z_BEST_SPEED || compress_level > Z_BEST_COMPRESSION )
+  {
+    std::cerr << "Compression level must be from 1 to 9 !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto& vertex_colours_wanted{ vm["vertex-colours"].as<std::string> () };
+  Colouring::VertexColourEnum vertex_colours{};
+  if ( boost::iequals ( vertex_colours_wanted, "index" ) )
+  {
+    vertex_colours = Colouring::VertexColourEnum::Index;
+  }
+  else if ( boost::iequals ( vertex_colours_wanted, "diffuse" ) )
+  {
+    vertex_colours = Colouring::VertexColourEnum::Diffuse;
+  }
+  else
+  {
+    std::cerr << "Vertex colours must be 'index' or 'diffuse' !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
   }
 
   if ( vm["file"].empty () )
@@ -235,10 +2104,37 @@ int main ( int argc, char* argv[], char* envp[] )
         << Log::DEFAULT_LOG_LEVEL << "']\n";
   }
 
-#ifdef __VERTEX_AND_TRIANGLE_LIMITS__
   const auto triangle_limit{ vm["triangle-limit"].as<int> () };
-  const auto vertex_limit{ vm["vertex-limit"].as<int> () };
-#endif /* __VERTEX_AND_TRIANGLE_LIMITS__ */
+  auto vertex_limit{ vm["vertex-limit"].as<int> () };
+  if ( is_quantised )
+  {
+    // Splitting meshes as they are imported lets every mesh use 16-bit
+    // indices.
+    vertex_limit = vertex_limit > 0
+        ? std::min ( vertex_limit, QUANTISED_VERTEX_LIMIT )
+        : QUANTISED_VERTEX_LIMIT;
+  }
+
+  const auto is_cached{ vm["cache"].as<bool> () };
+  const auto is_forced{ vm["force"].as<bool> () };
+  if ( is_forced && !is_cached )
+  {
+    std::cerr << "Forcing conversion needs the cache !\n";
+    return ( EXIT_COMMAND_LINE_ERROR );
+  }
+
+  const auto& scene_cache{ vm["scene-cache"].as<std::string> () };
+  if ( !scene_cache.empty () )
+  {
+    boost::system::error_code ec{};
+    boost::filesystem::create_directories ( scene_cache, ec );
+    if ( ec || !boost::filesystem::is_directory ( scene_cache ) )
+    {
+      std::cerr << "Scene cache directory '" << scene_cache
+          << "' cannot be made !\n";
+      return ( EXIT_COMMAND_LINE_ERROR );
+    }
+  }
 
   const auto& input_files{ vm["file"].as<std::vector<std::string>> () };
   for ( const auto& f : input_files )
@@ -282,292 +2178,226 @@ int main ( int argc, char* argv[], char* envp[] )
   }
   BOOST_LOG_SEV(logmt,info) << "  ]";
 
-  // ...
-  const std::unique_ptr<
-      aiPropertyStore, 
-      decltype( 
-          []( aiPropertyStore* p_ps ) 
-          { 
-            aiReleasePropertyStore ( p_ps ); 
-          } 
-      )
-  > p_property_store{ aiCreatePropertyStore () };
-  assert( p_property_store.get () != nullptr );
-
-#ifdef __VERTEX_AND_TRIANGLE_LIMITS__
-  aiSetImportPropertyInteger (
-      p_property_store.get (),
-      AI_CONFIG_PP_SLM_VERTEX_LIMIT,
-      vertex_limit
-  );
+  const auto workers{
+      Jobs::worker_count ( vm["jobs"].as<unsigned> (), input_files.size () )
+  };
+  const auto memory_budget_mib{ vm["memory-budget"].as<unsigned> () };
   {
-    BOOST_LOG_SEV(logmt,debug) << "  Mesh split vertex limit = "
-        << vertex_limit;
+    BOOST_LOG_SEV(logmt,info) << "  Converting up to " << workers
+        << " file(s) at once within " << memory_budget_mib << " MiB, and "
+        << Jobs::worker_count (
+               vm["mesh-jobs"].as<unsigned> (),
+               std::numeric_limits<std::size_t>::max ()
+           )
+        << " mesh(es) of each at once";
   }
 
-  aiSetImportPropertyInteger (
-      p_property_store.get (),
-      AI_CONFIG_PP_SLM_TRIANGLE_LIMIT,
-      triangle_limit
-  );
-  {
-    BOOST_LOG_SEV(logmt,debug) << "  Mesh split triangle limit = "
-        << triangle_limit;
-  }
-#endif /* __VERTEX_AND_TRIANGLE_LIMITS__ */
-  
-  for ( const auto& f : input_files )
+  // Textures are decoded by GDI+, which stays started until files are all
+  // converted.
+  std::unique_ptr<Texture::DecoderSession> p_decoder{};
+  if ( is_texture_baked )
   {
-    const std::unique_ptr<
-        aiScene,
-        decltype(
-            []( aiScene* p_s )
-            {
-              aiReleaseImport ( p_s );
-            }
-        )
-    > p_assimp_scene{ 
-          const_cast<aiScene*>(
-              aiImportFileExWithProperties (
-                  f.c_str (),
-                  aiProcessPreset_TargetRealtime_Quality,
-                  nullptr,
-                  p_property_store.get ()
-              )
-          )
-    };
-    const auto* p_scene{ p_assimp_scene.get () };
-    if (
-        p_scene == nullptr
-        || p_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE
-        || p_scene->mRootNode == nullptr
-    )
-    {
-      {
-        BOOST_LOG_SEV(logmt,error) << "  ASSIMP: Failed to import file '"
-            << f << "' !";
-        Assimp::Importer importer{};
-        std::string importable{ "" };
-        importer.GetExtensionList ( importable );
-        BOOST_LOG_SEV(logmt,error) 
-            << "    ASSIMP: Supported file extensions = '" << importable 
-            << "'";
-      }
-      return ( EXIT_DATA_IMPORT_ERROR );
-    }
-    else
+    p_decoder = std::make_unique<Texture::DecoderSession> ();
+    if ( !p_decoder->is_started () )
     {
-      BOOST_LOG_SEV(logmt,info) << "  ASSIMP: Successfully imported file '"
-          << f << "'";
+      BOOST_LOG_SEV(logmt,error) << "  GDI+ cannot start, so textures"
+          " cannot be baked !";
+      return ( EXIT_TEXTURE_DECODER_ERROR );
     }
+  }
 
-    const auto num_meshes{ p_scene->mNumMeshes };
+  // Each worker has its own importer, and so its own property store, as an
+  // importer cannot be shared between threads.
+  std::vector<Assimp::Importer> importers( workers );
+  for ( auto& importer : importers )
+  {
+    if ( vertex_limit > 0 )
     {
-      BOOST_LOG_SEV(logmt,debug) << "  Number of meshes = " << num_meshes;
+      importer.SetPropertyInteger (
+          AI_CONFIG_PP_SLM_VERTEX_LIMIT,
+          vertex_limit
+      );
     }
-    for ( auto i { 0U }; i < num_meshes; ++i )
+    if ( triangle_limit > 0 )
     {
-      {
-        BOOST_LOG_SEV(logmt,debug) << "  Mesh " << i << ":";
-      }
-      const auto* p_mesh{ p_scene->mMeshes[i] };
-      const size_t numVertices{ p_mesh->mNumVertices };
-      {
-        BOOST_LOG_SEV(logmt,debug) << "    Number of vertices = "
-            << numVertices;
-      }
-
-      //MHK: HACK - Start
-      std::vector<float> texture_uvs(
-          numVertices * 2,
-          0.0f
+      importer.SetPropertyInteger (
+          AI_CONFIG_PP_SLM_TRIANGLE_LIMIT,
+          triangle_limit
       );
-      //MHK: HACK - End
+    }
+  }
+  if ( vertex_limit > 0 )
+  {
+    BOOST_LOG_SEV(logmt,debug) << "  Mesh split vertex limit = "
+        << vertex_limit;
+  }
+  if ( triangle_limit > 0 )
+  {
+    BOOST_LOG_SEV(logmt,debug) << "  Mesh split triangle limit = "
+        << triangle_limit;
+  }
 
-      const auto num_floats{ numVertices * 3 };
-      std::vector<float> vertices{};
-      vertices.reserve ( num_floats );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "    Created vertices vector of "
-            << num_floats << " float";
-      }
-      std::vector<float> vertex_normals{};
-      vertex_normals.reserve ( num_floats );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "    Created normals vector of "
-            << num_floats << " float";
-      }
-      std::vector<Colouring::material_struct> colouring{};
-      colouring.reserve ( numVertices );
+  // Start the largest files first so that a big file found last does not
+  // leave one worker busy long after the rest have finished.
+  std::vector<std::uintmax_t> file_sizes{};
+  file_sizes.reserve ( input_files.size () );
+  for ( const auto& f : input_files )
+  {
+    boost::system::error_code ec{};
+    const auto size{ boost::filesystem::file_size ( f, ec ) };
+    file_sizes.emplace_back ( ec ? 0 : size );
+  }
+  std::vector<std::size_t> schedule( input_files.size () );
+  std::iota ( schedule.begin (), schedule.end (), std::size_t{ 0 } );
+  std::stable_sort (
+      schedule.begin (),
+      schedule.end (),
+      [&file_sizes] ( std::size_t a, std::size_t b )
       {
-        BOOST_LOG_SEV(logmt,debug) << "    Created colouring vector of "
-            << numVertices << " Colouring::material";
+        return ( file_sizes[a] > file_sizes[b] );
       }
+  );
 
-      const auto* p_vertices{ p_mesh->mVertices };
-      const auto* p_normals{ p_mesh->mNormals };
-      for ( size_t j{ 0 }; j < numVertices; ++j )
+  const options_struct options{
+      .palette{ palette_chosen->second },
+      .mt_version{ mt_version },
+      .vertex_colours{ vertex_colours },
+      .mesh_jobs{ vm["mesh-jobs"].as<unsigned> () },
+      .is_fetch_optimised{ vm["optimise"].as<bool> () },
+      .is_overdraw_sorted{ vm["overdraw"].as<bool> () },
+      .overdraw_threshold{ vm["overdraw-threshold"].as<float> () },
+      .is_quantised{ is_quantised },
+      .positions{ position_format },
+      .is_interleaved{ is_interleaved },
+      .lods{ lods },
+      .lod_ratio{ lod_ratio },
+      .is_meshlets{ is_meshlets },
+      .meshlet_vertices{ meshlet_vertices },
+      .meshlet_triangles{ meshlet_triangles },
+      .is_bvh{ is_bvh },
+      .is_ao_baked{ is_ao_baked },
+      .ao_rays{ ao_rays },
+      .ao_distance{ ao_distance },
+      .is_ao_scene{ is_ao_scene },
+      .is_texture_baked{ is_texture_baked },
+      .texture_filter{ texture_filter },
+      .is_compressed{ is_compressed },
+      .compress_level{ compress_level },
+      .scene_cache{ scene_cache }
+  };
+  const auto settings{
+      cache_settings ( options, triangle_limit, vertex_limit )
+  };
+  Cache::report_struct cache_report{};
+  Jobs::MemoryBudget memory_budget{ memory_budget_mib * BYTES_PER_MIB };
+  Log::OrderedFlush file_logs{ logmt, input_files.size () };
+  std::atomic<bool> is_import_failed{ false };
+  Jobs::parallel_for (
+      schedule.size (),
+      workers,
+      [&] ( std::size_t task, unsigned worker )
       {
-        const auto& v{ p_vertices[j] };
-        vertices.emplace_back ( v.x );
-        vertices.emplace_back ( v.y );
-        vertices.emplace_back ( v.z );
-        const auto& n{ p_normals[j] };
-        vertex_normals.emplace_back ( n.x );
-        vertex_normals.emplace_back ( n.y );
-        vertex_normals.emplace_back ( n.z );
-
-        // Facilitate creation of a jump table by using an enum class.
-        switch ( material_chosen )
+        const auto index{ schedule[task] };
+        const auto& f{ input_files[index] };
+        Log::Buffer file_log{};
+
+        // Errors are caught for each file, so that one file that cannot be
+        // converted is reported like a failed import and the others still
+        // have their logs written.
+        try
         {
-          case Colouring::MaterialEnum::Gold:
-            {
-              colouring.emplace_back ( Colouring::GOLD );
-            }
-            break;
-
-          case Colouring::MaterialEnum::Jade:
+          // Files are looked up before memory is reserved, so that files
+          // skipped never wait for it.
+          std::string content{};
+          if ( ( is_cached || !scene_cache.empty () ) && !is_import_failed )
+          {
+            content = Cache::content_hash ( f );
+          }
+          std::string key{};
+          if ( is_cached && !is_import_failed )
+          {
+            key = Cache::file_key ( content, settings );
+            const auto lookup{
+                key.empty () || is_forced
+                    ? Cache::LookupEnum::KeyChanged
+                    : Cache::lookup ( f, key )
+            };
+            if ( lookup == Cache::LookupEnum::Hit )
             {
-              colouring.emplace_back ( Colouring::JADE );
+              ++cache_report.hits;
+              {
+                file_log ( info ) << "  Cache hit for file '" << f
+                    << "', so it is skipped";
+              }
+              file_logs.done ( index, file_log );
+              return;
             }
-            break;
-
-          case Colouring::MaterialEnum::Pearl:
-            {
-              colouring.emplace_back ( Colouring::PEARL );
-            }
-            break;
-
-          case Colouring::MaterialEnum::Silver:
+            ++cache_report.misses;
             {
-              colouring.emplace_back ( Colouring::SILVER );
+              file_log ( info ) << "  Cache miss for file '" << f << "', as "
+                  << ( is_forced
+                           ? "conversion is forced"
+                           : Cache::lookup_description ( lookup ) );
             }
-            break;
-
-          case Colouring::MaterialEnum::Landscape:
+          }
+
+          {
+            const auto reservation{
+                memory_budget.acquire (
+                    file_sizes[index] * IMPORT_MEMORY_FACTOR
+                )
+            };
+            // Once one file fails no more are started, as before.
+            std::vector<Cache::dependency_struct> dependencies{};
+            std::vector<std::string> outputs{};
+            if ( !is_import_failed )
             {
-              colouring.emplace_back (
-                  Colouring::material_struct{ 
-                      Colouring::LANDSCAPE_AMBIENT_COLOUR, 
-                      Colouring::landscape_diffuse_colour ( v.y ), 
-                      Colouring::LANDSCAPE_SPECULAR_COLOUR, 
-                      Colouring::LANDSCAPE_SHININESS 
-                  }
-              );
+              if (
+                  !convert_file (
+                      f,
+                      importers[worker],
+                      options,
+                      file_log,
+                      content,
+                      dependencies,
+                      outputs
+                  )
+              )
+              {
+                is_import_failed = true;
+              }
+              else if (
+                  !key.empty ()
+                  && !Cache::store ( f, key, dependencies, outputs )
+              )
+              {
+                {
+                  file_log ( warning ) << "  Cannot write cache manifest '"
+                      << Cache::manifest_name ( f ) << "' !";
+                }
+              }
             }
-            break;
-
-          // NOTE: A default is not coded deliberately.
+          }
         }
+        catch ( const std::exception& e )
+        {
+          {
+            file_log ( error ) << "  Failed to convert file '" << f
+                << "': " << e.what () << " !";
+          }
+          is_import_failed = true;
+        }
+        file_logs.done ( index, file_log );
       }
-      {
-        BOOST_LOG_SEV(logmt,debug)
-            << "    Vertex, vertex normal, and colouring data loaded";
-      }
-
-      const size_t numFaces{ p_mesh->mNumFaces };
-      {
-        BOOST_LOG_SEV(logmt,debug) << "    Number of faces = " << numFaces;
-      }
-      const auto numIndices{ numFaces * 3 };
-      {
-        BOOST_LOG_SEV(logmt,debug) << "    Number of indices = "
-            << numFaces * 3;
-      }
-      std::vector<unsigned int> indices{};
-      indices.reserve ( numIndices );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "    Created indices vector of "
-            << numIndices << " unsigned int";
-      }
-      const auto* p_faces{ p_mesh->mFaces };
-      for ( size_t j{ 0 }; j < numFaces; ++j )
-      {
-        const auto& current_face{ p_faces[j] };
-        assert( current_face.mNumIndices == 3U );
-        const auto* p_current_face_indices{ current_face.mIndices };
-        indices.emplace_back ( *p_current_face_indices );
-        indices.emplace_back ( *( p_current_face_indices + 1 ) );
-        indices.emplace_back ( *( p_current_face_indices + 2 ) );
-      }
-
-      const size_t vertices_bytes{ vertices.size () * sizeof ( float ) };
-      const size_t vertex_normals_bytes{ 
-          vertex_normals.size () * sizeof ( float ) 
-      };
-      const size_t texture_uvs_bytes{ 
-          texture_uvs.size () * sizeof ( float ) 
-      };
-      const size_t colouring_bytes{ 
-          colouring.size () * sizeof ( Colouring::material_struct) 
-      };
-      const size_t indices_bytes{ indices.size () * sizeof ( unsigned int ) };
-      std::stringstream ss_file_name{};
-      ss_file_name << f << "." << i << "." << numVertices << "." << numIndices 
-          << MT_FILE_EXTENSION;
-      const auto file_name{ ss_file_name.str () };
-      std::ofstream output_file{
-          file_name, 
-          std::ios_base::out | std::ios_base::binary 
-      };
-      {
-        BOOST_LOG_SEV(logmt,info) << "    Opened output file '" << file_name
-            << "'";
-      }
-
-      output_file.write (
-          reinterpret_cast<char*>( vertices.data () ), 
-          vertices_bytes
-      );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "      Wrote " << vertices_bytes
-            << " bytes for vertex data";
-      }
-      
-      output_file.write ( 
-          reinterpret_cast<char*>( vertex_normals.data () ), 
-          vertex_normals_bytes
-      );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "      Wrote " << vertex_normals_bytes
-            << " bytes for vertex normal data";
-      }
-
-      output_file.write ( 
-          reinterpret_cast<char*>( texture_uvs.data () ), 
-          texture_uvs_bytes
-      );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "      Wrote " << texture_uvs_bytes
-            << " bytes for texture UV data";
-      }
-
-      output_file.write (
-          reinterpret_cast<char*>( colouring.data () ),
-          colouring_bytes
-      );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "      Wrote " << colouring_bytes
-          << " bytes for colouring data";
-      }
-
-      output_file.write ( 
-          reinterpret_cast<char*>( indices.data () ), 
-          indices_bytes
-      );
-      {
-        BOOST_LOG_SEV(logmt,debug) << "      Wrote " << indices_bytes
-            << " bytes for index data";
-      }
-
-      output_file.close ();
-      {
-        BOOST_LOG_SEV(logmt,info) << "    Closed output file '" << file_name
-            << "'";
-      }
-
-      //...
-    }
+  );
+  if ( is_cached )
+  {
+    BOOST_LOG_SEV(logmt,info) << "  Cache: " << cache_report.hits
+        << " hit(s), " << cache_report.misses << " miss(es)";
+  }
+  if ( is_import_failed )
+  {
+    return ( EXIT_DATA_IMPORT_ERROR );
   }
 
   // ...
@@ -680,7 +2510,159 @@ int main ( int argc, char* argv[], char* envp[] )
  *
  * @internal @note Development MT files end with \c .mtd not \c .mt !
  *
- * The file is separated internally into the following sections :
+ * Version 1 is written by default. Versions 2 and 3 are smaller and faster
+ * to read but share its file extension, so a reader of version 1 files
+ * would misread them, and they are only written when asked for. To move a
+ * project over :
+ * -# update its readers : version 3 files start with a header that
+ *    identifies them, and the \c mtio library reads them in place, while
+ *    version 2 files can only be told apart by how they were written
+ * -# convert its inputs again with <tt>--mt-version 3</tt> , or \c 2 , and
+ *    <tt>--force</tt> if a cache is kept, as the version is part of its key
+ * -# add any of the options that need version 3, such as
+ *    <tt>--quantise</tt> or <tt>--compress</tt>
+ *
+ * Version 3, written with <tt>--mt-version 3</tt>, starts with a 64 byte
+ * header and a table of sections, so that a file can be read without its
+ * name and mapped into memory as it is :
+ * -# a MtFormat::header_struct , starting with the bytes
+ *    <tt>0x89 'M' 'T' '\\n'</tt>, giving the version, byte order, vertex and
+ *    index counts, bounding box, and a CRC-32 of the whole file
+ * -# a MtFormat::section_struct for each section, giving its type, element
+ *    format, offset, size, count, and stride
+ * -# the sections, each starting at a multiple of 64 bytes
+ *
+ * The sections are those of version 2 below, without the material count or
+ * per-vertex colouring kind, which the section table gives instead.
+ *
+ * With <tt>--quantise</tt>, version 3 sections are stored in fewer bits,
+ * as their section table entries say :
+ * - positions as MtFormat::FormatEnum::Unorm16x3 steps across the bounding
+ *   box, or with <tt>--position-format half</tt> as
+ *   MtFormat::FormatEnum::Float16x3 offsets from its centre
+ * - normals as MtFormat::FormatEnum::Octahedral16x2
+ * - vertex diffuse colours as MtFormat::FormatEnum::Unorm8x4
+ * - vertex indices as MtFormat::FormatEnum::Uint16 if there are fewer than
+ *   65536 vertices, which meshes are split to ensure as they are imported
+ *
+ * With <tt>--layout interleaved</tt>, version 3 vertex attributes are
+ * interleaved into one MtFormat::SectionEnum::Vertices section, whose stride
+ * is the size of a vertex, in place of one section each. A
+ * MtFormat::SectionEnum::VertexLayout section follows it, with a
+ * MtFormat::attribute_struct giving the type, format, and offset within a
+ * vertex of each attribute, so that vertices can be copied to the GPU as
+ * they are.
+ *
+ * With <tt>--lods</tt> &lambda;, up to &lambda; coarser levels of detail
+ * follow the vertex indices, each a MtFormat::SectionEnum::LodIndices
+ * section in the format of the indices. Each level keeps about
+ * <tt>--lod-ratio</tt> of the triangles of the one before, by collapsing
+ * edges onto their neighbours, so that every level draws the same
+ * vertices. Outlines and seams keep their shape.
+ *
+ * With <tt>--meshlets</tt>, the triangles are also split into meshlets of
+ * at most <tt>--meshlet-vertices</tt> vertices and
+ * <tt>--meshlet-triangles</tt> triangles, stored in three sections :
+ * - MtFormat::SectionEnum::Meshlets , a MtFormat::meshlet_struct for each
+ *   meshlet, with its bounding sphere and normal cone
+ * - MtFormat::SectionEnum::MeshletVertices , the vertex indices each
+ *   meshlet uses
+ * - MtFormat::SectionEnum::MeshletTriangles , three bytes for each
+ *   triangle, numbering vertices within its meshlet
+ *
+ * With <tt>--bvh</tt>, a bounding volume hierarchy of the triangles,
+ * split by the surface area heuristic, follows in two sections, so that
+ * picking and collision need only map the file :
+ * - MtFormat::SectionEnum::Bvh , a 32 byte MtFormat::bvh_node_struct for
+ *   each node, depth first, the root giving the box of the mesh
+ * - MtFormat::SectionEnum::BvhTriangles , the triangles of each leaf in
+ *   turn, by their number in the vertex indices
+ *
+ * With <tt>--compress</tt>, each section but the vertex layout that gets
+ * smaller for it is stored with MtFormat::CodecEnum::Deflate in the top
+ * bits of its format, at zlib level <tt>--compress-level</tt>. Sections
+ * are cut into chunks of at most MtFormat::CHUNK_BYTES, each delta coded
+ * in the lanes of its format, split into byte planes, and deflated on its
+ * own, as MtFormat::chunks_struct describes, so that readers can decode
+ * chunks on many threads straight into the buffers they are used from.
+ *
+ * Meshes are coloured with the material <tt>--material</tt> names, one of
+ * those built in or one read from the file <tt>--materials</tt> names,
+ * laid out as Materials.info is. A material with height bands gives each
+ * vertex the material of the band its \c y lies in, found four vertices at
+ * a time without branching, in a pass over all vertices of a mesh.
+ *
+ * With <tt>--bake-ao</tt>, each vertex is darkened by how much of the
+ * hemisphere above it is hidden, found by casting <tt>--ao-rays</tt> rays
+ * from it, four at a time down a bounding volume hierarchy, on every core
+ * the meshes converted at once leave free. Rays reach <tt>--ao-distance</tt>
+ * of the size of what they can hit, which is the mesh itself or, with
+ * <tt>--ao-scene</tt>, every mesh of its file, placed by the world
+ * transforms of the nodes that draw it. A mesh drawn by several nodes takes
+ * the mean occlusion of its instances, and one drawn by none is occluded
+ * only by itself. MT v1 darkens the ambient and diffuse colours of each
+ * vertex. Later versions darken only the vertex diffuse colours, written
+ * for every mesh baked, as their material table is per mesh and holds
+ * ambient colours unchanged.
+ *
+ * Texture coordinates are the first set Assimp imports. With
+ * <tt>--bake-textures</tt>, the diffuse texture of each mesh's material,
+ * read beside the input file or embedded in it, in any format GDI+
+ * decodes, is sampled at each vertex into its diffuse colour, before any
+ * occlusion darkens it. Each texture is decoded once for all meshes of the
+ * file, textures at once, and its vertices sampled in tasks over the cores
+ * left free. <tt>--texture-filter bilinear</tt> blends the four texels
+ * nearest each vertex, and \c area , the default, blends smaller copies of
+ * the texture so that each vertex takes the mean of the texels around it.
+ *
+ * With <tt>--cache</tt>, each input file gets a manifest beside it, with
+ * extension <tt>.mtcache</tt>, keyed on a hash of its contents, the cache
+ * version of MeshTools, and every option the MT files depend on, and
+ * listing the MT files written with their sizes and times of writing, to
+ * the finest the file system records. It also lists, with a hash of each,
+ * every other file that importing the input read or looked for, such as a
+ * glTF buffer or an OBJ material library, and every texture file baked
+ * with <tt>--bake-textures</tt>, whose filter and sampling are in the
+ * key. A file whose key is unchanged, whose listed files all still have
+ * the same hashes, and whose MT files are all still as written, is skipped
+ * without being imported.
+ * <tt>--force</tt> converts every file regardless, renewing its manifest,
+ * and a count of hits and misses is logged at the end.
+ *
+ * With <tt>--scene-cache</tt> &delta;, the scene of each input file is kept
+ * in directory &delta; once imported and post-processed, as an Assimp
+ * <tt>assbin</tt> file named by a hash of its contents, the post-processing
+ * steps, the mesh splitting limits, and the list of other files it was
+ * imported from with their hashes, which is kept beside it with extension
+ * <tt>.deps</tt>. Later runs that change only how scenes are exported,
+ * such as the material, read it back in place of importing the file again,
+ * as long as none of those files has changed. Nothing is ever removed from
+ * the directory.
+ *
+ * Version 2, written with <tt>--mt-version 2</tt>, is separated internally
+ * into the following sections :
+ * -# <tt>3&alpha;</tt> \c float for the vertex \c x , \c y , and \c z
+ * components
+ * -# <tt>3&alpha;</tt> \c float for the vertex normal \c x , \c y , and \c z
+ * components
+ * -# <tt>2&alpha;</tt> \c float for the texture \c U and \c V values
+ * -# one <tt>unsigned int</tt> &mu; for the number of materials
+ * -# <tt>13&mu;</tt> \c float for the material lighting data
+ * -# one <tt>unsigned int</tt> for the per-vertex colouring, one of :
+ *   - \c 0 for none, every vertex using the first material
+ *   - \c 1 for <tt>&alpha;</tt> <tt>unsigned char</tt> material indices,
+ *     padded with zeroes to a multiple of four bytes
+ *   - \c 2 for <tt>4&alpha;</tt> \c float vertex diffuse colours that
+ *     replace that of the first material
+ * -# the per-vertex colouring data, if any
+ * -# <tt>&beta;</tt> <tt>unsigned int</tt> for vertex indices
+ *
+ * Only landscapes, and meshes with baked textures or ambient occlusion,
+ * have per-vertex colouring, and the material table of a landscape has a
+ * material for each height band.
+ *
+ * Version 1, written by default, is separated internally into the following
+ * sections :
  * -# <tt>3&alpha;</tt> \c float for the vertex \c x , \c y , and \c z
  * components
  * -# <tt>3&alpha;</tt> \c float for the vertex normal \c x , \c y , and \c z
@@ -691,6 +2673,9 @@ int main ( int argc, char* argv[], char* envp[] )
  *
  * @sa Colouring::rgba_struct 
  * @sa Colouring::material_struct
+ * @sa Colouring::VertexColourEnum
+ * @sa MtFormat::SectionEnum
+ * @sa MtFormat::FormatEnum
  */
 /**
  * @defgroup STRUCT C-style Structs
@@ -0,0 +1,483 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Meshlets.h
+// SYNOPSIS : Utilities for splitting meshes into meshlets.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "Simplify.h"
+#include "../mtio/MtFormat.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for splitting meshes into meshlets.
+namespace Meshlets
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The default most vertices of a meshlet.
+  const std::uint32_t DEFAULT_MAX_VERTICES{ 64 };
+
+  //! The default most triangles of a meshlet.
+  const std::uint32_t DEFAULT_MAX_TRIANGLES{ 124 };
+
+  //! The most vertices a meshlet can have, as its triangles number them in
+  //! bytes.
+  const std::uint32_t MAX_VERTICES{ 256 };
+
+  //! The most triangles a meshlet can have.
+  const std::uint32_t MAX_TRIANGLES{ 512 };
+
+  /**
+   * @brief The least cosine between a normal cone axis and a triangle
+   * normal, below which the cone is too wide to cull by.
+   */
+  const float MIN_CONE_COSINE{ 0.1f };
+
+  /**
+   * @brief The most triangles a vertex offers as candidates when it joins a
+   * meshlet, so that the hub of a fan does not offer all of its triangles
+   * to every meshlet around it.
+   */
+  const std::uint32_t MAX_VERTEX_CANDIDATES{ 32 };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief The meshlets of a mesh, laid out as their MT sections are.
+   *
+   * @ingroup STRUCT
+   */
+  struct meshlets_struct
+  {
+    //! The meshlets.
+    std::vector<MtFormat::meshlet_struct> meshlets{};
+    //! The vertex indices used by each meshlet in turn.
+    std::vector<std::uint32_t> vertices{};
+    //! Three numbers into the vertices of its meshlet for each triangle of
+    //! each meshlet in turn.
+    std::vector<std::uint8_t> triangles{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Sets the bounding sphere and normal cone of a meshlet.
+   *
+   * The sphere is found as Ritter does, from the two vertices furthest
+   * apart along an axis, grown to take in each vertex outside it. The cone
+   * axis is the mean of the triangle normals, and its apex lies on the
+   * axis far enough back that every triangle faces away from it.
+   *
+   * @param[in,out] meshlet The meshlet, with its counts and offsets set.
+   * @param[in] vertices The vertex indices of all meshlets.
+   * @param[in] triangles The triangles of all meshlets.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   */
+  void bound (
+      MtFormat::meshlet_struct& meshlet,
+      std::span<const std::uint32_t> vertices,
+      std::span<const std::uint8_t> triangles,
+      const float* p_positions
+  )
+  {
+    const auto position{
+        [&] ( std::uint32_t local )
+        {
+          return (
+              p_positions
+              + vertices[meshlet.vertex_offset + local] * std::size_t{ 3 }
+          );
+        }
+    };
+    const auto distance{
+        [] ( const float* p0, const float* p1 )
+        {
+          const auto dx{ p1[0] - p0[0] };
+          const auto dy{ p1[1] - p0[1] };
+          const auto dz{ p1[2] - p0[2] };
+          return ( std::sqrt ( dx * dx + dy * dy + dz * dz ) );
+        }
+    };
+
+    // The sphere.
+    std::array<std::uint32_t, 3> lowest{};
+    std::array<std::uint32_t, 3> highest{};
+    for ( std::uint32_t j{ 1 }; j < meshlet.vertex_count; ++j )
+    {
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        if ( position ( j )[k] < position ( lowest[k] )[k] )
+        {
+          lowest[k] = j;
+        }
+        if ( position ( j )[k] > position ( highest[k] )[k] )
+        {
+          highest[k] = j;
+        }
+      }
+    }
+    std::size_t widest{ 0 };
+    auto widest_distance{ 0.0f };
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      const auto d{
+          distance ( position ( lowest[k] ), position ( highest[k] ) )
+      };
+      if ( d > widest_distance )
+      {
+        widest = k;
+        widest_distance = d;
+      }
+    }
+    const auto* p_low{ position ( lowest[widest] ) };
+    const auto* p_high{ position ( highest[widest] ) };
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      meshlet.centre[k] = ( p_low[k] + p_high[k] ) * 0.5f;
+    }
+    meshlet.radius = distance ( p_low, p_high ) * 0.5f;
+    for ( std::uint32_t j{ 0 }; j < meshlet.vertex_count; ++j )
+    {
+      const auto* p{ position ( j ) };
+      const auto d{ distance ( meshlet.centre.data (), p ) };
+      if ( d > meshlet.radius )
+      {
+        const auto radius{ ( meshlet.radius + d ) * 0.5f };
+        for ( std::size_t k{ 0 }; k < 3; ++k )
+        {
+          meshlet.centre[k] +=
+              ( p[k] - meshlet.centre[k] ) * ( radius - meshlet.radius ) / d;
+        }
+        meshlet.radius = radius;
+      }
+    }
+
+    // The cone.
+    std::vector<std::array<float, 3>> normals{};
+    std::vector<const float*> corners{};
+    normals.reserve ( meshlet.triangle_count );
+    corners.reserve ( meshlet.triangle_count );
+    std::array<float, 3> axis{};
+    const auto* p_local{
+        &triangles[meshlet.triangle_offset * std::size_t{ 3 }]
+    };
+    for ( std::uint32_t t{ 0 }; t < meshlet.triangle_count; ++t )
+    {
+      auto n{
+          Simplify::triangle_normal (
+              position ( p_local[t * 3] ),
+              position ( p_local[t * 3 + 1] ),
+              position ( p_local[t * 3 + 2] )
+          )
+      };
+      const auto length{
+          std::sqrt ( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] )
+      };
+      if ( length == 0.0f )
+      {
+        continue;
+      }
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        n[k] /= length;
+        axis[k] += n[k];
+      }
+      normals.emplace_back ( n );
+      corners.emplace_back ( position ( p_local[t * 3] ) );
+    }
+    const auto axis_length{
+        std::sqrt ( axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] )
+    };
+    meshlet.cone_apex = meshlet.centre;
+    meshlet.cone_cutoff = 1.0f;
+    if ( axis_length == 0.0f )
+    {
+      return;
+    }
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      meshlet.cone_axis[k] = axis[k] / axis_length;
+    }
+    const auto dot{
+        [] ( const auto& a, const auto& b )
+        {
+          return ( a[0] * b[0] + a[1] * b[1] + a[2] * b[2] );
+        }
+    };
+    auto min_cosine{ 1.0f };
+    for ( const auto& n : normals )
+    {
+      min_cosine = std::min ( min_cosine, dot ( n, meshlet.cone_axis ) );
+    }
+    if ( min_cosine <= MIN_CONE_COSINE )
+    {
+      return;
+    }
+
+    // How far back along the axis the centre must move to be behind the
+    // plane of every triangle.
+    auto back{ 0.0f };
+    for ( std::size_t m{ 0 }; m < normals.size (); ++m )
+    {
+      const std::array<float, 3> to_centre{
+          meshlet.centre[0] - corners[m][0],
+          meshlet.centre[1] - corners[m][1],
+          meshlet.centre[2] - corners[m][2]
+      };
+      back = std::max (
+          back,
+          dot ( to_centre, normals[m] ) / dot ( meshlet.cone_axis, normals[m] )
+      );
+    }
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      meshlet.cone_apex[k] = meshlet.centre[k] - meshlet.cone_axis[k] * back;
+    }
+    meshlet.cone_cutoff = std::sqrt ( 1.0f - min_cosine * min_cosine );
+  }
+
+  /**
+   * @brief Splits the triangles of a mesh into meshlets.
+   *
+   * Meshlets grow as patches. Each keeps the triangles around its vertices
+   * that are not yet in a meshlet, and takes next the one of those that
+   * brings the fewest new vertices, then the one nearest the middle of its
+   * vertices, scaled by how many triangles its corners have left so that
+   * no pockets are left behind, then the lowest numbered. A meshlet ends
+   * when the next triangle would take it past either limit, and that
+   * triangle starts the next meshlet beside it, or when it has none left,
+   * and the first triangle not yet in a meshlet starts the next. A vertex
+   * joining a meshlet offers at most MAX_VERTEX_CANDIDATES of its
+   * triangles not yet in a meshlet, and a triangle is a candidate at most
+   * once for each meshlet, so each step looks at a bounded number of
+   * triangles, building is linear in the number of triangles, and the
+   * result depends only on the input.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] num_vertices The number of vertices.
+   * @param[in] max_vertices The most vertices of a meshlet, 3 to
+   * MAX_VERTICES.
+   * @param[in] max_triangles The most triangles of a meshlet, 1 to
+   * MAX_TRIANGLES.
+   * @returns The meshlets, with every triangle in exactly one.
+   */
+  meshlets_struct build (
+      std::span<const std::uint32_t> indices,
+      const float* p_positions,
+      std::size_t num_vertices,
+      std::uint32_t max_vertices,
+      std::uint32_t max_triangles
+  )
+  {
+    meshlets_struct result{};
+    const auto num_triangles{ indices.size () / 3 };
+    std::vector<std::uint32_t> offsets{};
+    std::vector<std::uint32_t> triangles{};
+    Simplify::vertex_triangles ( indices, num_vertices, offsets, triangles );
+    result.vertices.reserve ( num_vertices + num_vertices / 2 );
+    result.triangles.reserve ( indices.size () );
+
+    // The number of each vertex within the current meshlet, or -1.
+    std::vector<std::int16_t> local( num_vertices, -1 );
+    std::vector<std::uint8_t> is_placed( num_triangles, 0 );
+    std::vector<std::uint32_t> live( num_vertices );
+    for ( std::size_t v{ 0 }; v < num_vertices; ++v )
+    {
+      live[v] = offsets[v + 1] - offsets[v];
+    }
+    // The first triangle of each vertex that may not yet be in a meshlet.
+    std::vector<std::uint32_t> first_live(
+        offsets.begin (), offsets.end () - 1
+    );
+    // One more than the number of the last meshlet each triangle was a
+    // candidate for.
+    std::vector<std::uint32_t> listed( num_triangles, 0 );
+    std::vector<std::uint32_t> candidates{};
+    std::array<float, 3> sum{};
+    const auto new_vertices{
+        [&] ( std::size_t t )
+        {
+          return (
+              ( local[indices[t * 3]] < 0 )
+              + ( local[indices[t * 3 + 1]] < 0 )
+              + ( local[indices[t * 3 + 2]] < 0 )
+          );
+        }
+    };
+
+    MtFormat::meshlet_struct current{};
+    const auto finish{
+        [&] ()
+        {
+          bound ( current, result.vertices, result.triangles, p_positions );
+          for ( std::uint32_t j{ 0 }; j < current.vertex_count; ++j )
+          {
+            local[result.vertices[current.vertex_offset + j]] = -1;
+          }
+          result.meshlets.emplace_back ( current );
+          current = MtFormat::meshlet_struct{
+              .vertex_offset{
+                  static_cast<std::uint32_t>( result.vertices.size () )
+              },
+              .triangle_offset{
+                  static_cast<std::uint32_t>( result.triangles.size () / 3 )
+              }
+          };
+          candidates.clear ();
+          sum = {};
+        }
+    };
+
+    std::size_t first_unplaced{ 0 };
+    for ( std::size_t placed{ 0 }; placed < num_triangles; ++placed )
+    {
+      // Triangles placed since they became candidates are dropped as the
+      // candidates are looked through.
+      auto next{ num_triangles };
+      auto next_new{ 4 };
+      auto next_distance{ 0.0f };
+      std::size_t kept{ 0 };
+      for ( const auto t : candidates )
+      {
+        if ( is_placed[t] )
+        {
+          continue;
+        }
+        candidates[kept++] = t;
+        const auto t_new{ new_vertices ( t ) };
+        if ( t_new > next_new )
+        {
+          continue;
+        }
+        auto t_distance{ 0.0f };
+        for ( std::size_t k{ 0 }; k < 3; ++k )
+        {
+          const auto mean{ sum[k] / current.vertex_count };
+          const auto d{
+              ( p_positions[indices[t * 3] * std::size_t{ 3 } + k]
+                  + p_positions[indices[t * 3 + 1] * std::size_t{ 3 } + k]
+                  + p_positions[indices[t * 3 + 2] * std::size_t{ 3 } + k] )
+              / 3.0f - mean
+          };
+          t_distance += d * d;
+        }
+        t_distance *= static_cast<float>(
+            live[indices[t * 3]] + live[indices[t * 3 + 1]]
+            + live[indices[t * 3 + 2]]
+        );
+        if (
+            t_new < next_new
+            || t_distance < next_distance
+            || ( t_distance == next_distance && t < next )
+        )
+        {
+          next = t;
+          next_new = t_new;
+          next_distance = t_distance;
+        }
+      }
+      candidates.resize ( kept );
+      if ( next == num_triangles )
+      {
+        while ( is_placed[first_unplaced] )
+        {
+          ++first_unplaced;
+        }
+        next = first_unplaced;
+        next_new = new_vertices ( next );
+      }
+
+      if (
+          current.vertex_count + next_new > max_vertices
+          || current.triangle_count == max_triangles
+          || ( candidates.empty () && current.triangle_count > 0 )
+      )
+      {
+        finish ();
+      }
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        const auto v{ indices[next * 3 + k] };
+        if ( local[v] < 0 )
+        {
+          local[v] = static_cast<std::int16_t>( current.vertex_count++ );
+          result.vertices.emplace_back ( v );
+          for ( std::size_t m{ 0 }; m < 3; ++m )
+          {
+            sum[m] += p_positions[v * std::size_t{ 3 } + m];
+          }
+          const auto meshlet{
+              static_cast<std::uint32_t>( result.meshlets.size () + 1 )
+          };
+          auto& r{ first_live[v] };
+          while ( r < offsets[v + 1] && is_placed[triangles[r]] )
+          {
+            ++r;
+          }
+          const auto end{
+              std::min ( r + MAX_VERTEX_CANDIDATES, offsets[v + 1] )
+          };
+          for ( auto s{ r }; s < end; ++s )
+          {
+            const auto t{ triangles[s] };
+            if ( !is_placed[t] && listed[t] != meshlet )
+            {
+              listed[t] = meshlet;
+              candidates.emplace_back ( t );
+            }
+          }
+        }
+        result.triangles.emplace_back ( static_cast<std::uint8_t>( local[v] ) );
+      }
+      ++current.triangle_count;
+      is_placed[next] = 1;
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        --live[indices[next * 3 + k]];
+      }
+    }
+    if ( current.triangle_count > 0 )
+    {
+      finish ();
+    }
+    return ( result );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for splitting meshes into meshlets.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,566 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Occlusion.h
+// SYNOPSIS : Utilities for baking ambient occlusion into mesh vertices.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "Bvh.h"
+#include "Jobs.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for baking ambient occlusion into mesh vertices.
+namespace Occlusion
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The rays cast from each vertex by default.
+  const unsigned DEFAULT_RAYS{ 32 };
+
+  //! The most rays that can be cast from each vertex.
+  const unsigned MAX_RAYS{ 1024 };
+
+  //! The length of rays by default, as a fraction of the diagonal of the
+  //! box of all occluders.
+  const float DEFAULT_DISTANCE{ 0.1f };
+
+  //! How far rays start above the surface, as a fraction of the diagonal of
+  //! the box of all occluders, so that they miss the triangles they leave.
+  const float SURFACE_OFFSET{ 1.0e-4f };
+
+  //! The rays traced together, one for each lane of an SSE register.
+  const std::size_t PACKET_RAYS{ 4 };
+
+  //! The vertices each task bakes.
+  const std::size_t VERTICES_PER_TASK{ 256 };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief A triangle as rays are tested against it, by a corner and the
+   * edges from it.
+   *
+   * @ingroup STRUCT
+   */
+  struct triangle_struct
+  {
+    //! The \c x , \c y , and \c z of the first corner.
+    std::array<float, 3> corner{};
+    //! The edge from the first corner to the second.
+    std::array<float, 3> edge1{};
+    //! The edge from the first corner to the third.
+    std::array<float, 3> edge2{};
+  };
+
+  /**
+   * @brief The triangles rays can hit, with a hierarchy to find them by.
+   *
+   * @ingroup STRUCT
+   */
+  struct occluders_struct
+  {
+    //! The hierarchy of the triangles.
+    Bvh::hierarchy_struct hierarchy{};
+    //! The triangles, in the order the leaves of the hierarchy list them.
+    std::vector<triangle_struct> triangles{};
+    //! The length of the diagonal of the box of all triangles.
+    float diagonal{};
+  };
+
+  /**
+   * @brief Four vectors, each of their \c x , \c y , and \c z in a register
+   * with a lane for each vector.
+   *
+   * @ingroup STRUCT
+   */
+  struct vectors_struct
+  {
+    //! The \c x , \c y , and \c z of the vectors.
+    __m128 xyz[3]{};
+
+    //! Gives the \c x , \c y , or \c z of the vectors.
+    __m128& operator[] ( std::size_t k ) noexcept
+    {
+      return ( xyz[k] );
+    }
+
+    //! Gives the \c x , \c y , or \c z of the vectors.
+    const __m128& operator[] ( std::size_t k ) const noexcept
+    {
+      return ( xyz[k] );
+    }
+  };
+
+  /**
+   * @brief A packet of rays from one vertex, each lane of a register being a
+   * ray.
+   *
+   * @ingroup STRUCT
+   */
+  struct packet_struct
+  {
+    //! Where the rays start.
+    vectors_struct origin{};
+    //! The directions of the rays.
+    vectors_struct direction{};
+    //! The reciprocals of the directions, none of them infinite.
+    vectors_struct inverse{};
+    //! How far the rays go.
+    __m128 reach{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Gathers triangles for rays to be traced against.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] workers The number of workers to build the hierarchy with.
+   * @returns The occluders, with no triangles if there are none.
+   */
+  occluders_struct build (
+      std::span<const std::uint32_t> indices,
+      const float* p_positions,
+      unsigned workers
+  )
+  {
+    occluders_struct occluders{
+        .hierarchy{ Bvh::build ( indices, p_positions, workers ) }
+    };
+    if ( occluders.hierarchy.nodes.empty () )
+    {
+      return ( occluders );
+    }
+    occluders.triangles.reserve ( occluders.hierarchy.triangles.size () );
+    for ( const auto t : occluders.hierarchy.triangles )
+    {
+      const auto* p_a{ p_positions + indices[t * 3] * std::size_t{ 3 } };
+      const auto* p_b{ p_positions + indices[t * 3 + 1] * std::size_t{ 3 } };
+      const auto* p_c{ p_positions + indices[t * 3 + 2] * std::size_t{ 3 } };
+      auto& triangle{ occluders.triangles.emplace_back () };
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        triangle.corner[k] = p_a[k];
+        triangle.edge1[k] = p_b[k] - p_a[k];
+        triangle.edge2[k] = p_c[k] - p_a[k];
+      }
+    }
+    const auto& root{ occluders.hierarchy.nodes.front () };
+    const auto dx{ root.bounds_max[0] - root.bounds_min[0] };
+    const auto dy{ root.bounds_max[1] - root.bounds_min[1] };
+    const auto dz{ root.bounds_max[2] - root.bounds_min[2] };
+    occluders.diagonal = std::sqrt ( dx * dx + dy * dy + dz * dz );
+    return ( occluders );
+  }
+
+  /**
+   * @brief Gives directions about the \c z axis, spread over the hemisphere
+   * above it in proportion to the cosine of their angle with it.
+   *
+   * The directions are a Hammersley set, so are spread more evenly than
+   * random ones.
+   *
+   * @param[in] count The number of directions.
+   * @returns The \c x , \c y , and \c z of each direction, padded with
+   * copies of the last to whole packets.
+   */
+  std::vector<std::array<float, 3>> hemisphere ( unsigned count )
+  {
+    const auto padded{
+        ( count + PACKET_RAYS - 1 ) / PACKET_RAYS * PACKET_RAYS
+    };
+    std::vector<std::array<float, 3>> directions( padded );
+    for ( unsigned r{ 0 }; r < padded; ++r )
+    {
+      const auto i{ std::min ( r, count - 1 ) };
+      auto bits{ i };
+      bits = ( bits << 16 ) | ( bits >> 16 );
+      bits = ( ( bits & 0x55555555U ) << 1 ) | ( ( bits & 0xAAAAAAAAU ) >> 1 );
+      bits = ( ( bits & 0x33333333U ) << 2 ) | ( ( bits & 0xCCCCCCCCU ) >> 2 );
+      bits = ( ( bits & 0x0F0F0F0FU ) << 4 ) | ( ( bits & 0xF0F0F0F0U ) >> 4 );
+      bits = ( ( bits & 0x00FF00FFU ) << 8 ) | ( ( bits & 0xFF00FF00U ) >> 8 );
+      const auto u{ ( static_cast<float>( i ) + 0.5f ) / count };
+      const auto angle{ 6.28318531f * static_cast<float>( bits ) * 0x1p-32f };
+      const auto radius{ std::sqrt ( u ) };
+      directions[r] = {
+          radius * std::cos ( angle ),
+          radius * std::sin ( angle ),
+          std::sqrt ( 1.0f - u )
+      };
+    }
+    return ( directions );
+  }
+
+  /**
+   * @brief Finds which rays of a packet hit a triangle within their reach.
+   *
+   * Both sides of a triangle are hit, by the Moller-Trumbore test made on
+   * all four rays at once.
+   *
+   * @param[in] packet The rays.
+   * @param[in] triangle The triangle.
+   * @returns A mask of the rays that hit it.
+   */
+  inline __m128 hits (
+      const packet_struct& packet,
+      const triangle_struct& triangle
+  ) noexcept
+  {
+    const vectors_struct e1{
+        _mm_set1_ps ( triangle.edge1[0] ),
+        _mm_set1_ps ( triangle.edge1[1] ),
+        _mm_set1_ps ( triangle.edge1[2] )
+    };
+    const vectors_struct e2{
+        _mm_set1_ps ( triangle.edge2[0] ),
+        _mm_set1_ps ( triangle.edge2[1] ),
+        _mm_set1_ps ( triangle.edge2[2] )
+    };
+    const auto& d{ packet.direction };
+    const auto cross{
+        [] ( __m128 ay, __m128 az, __m128 by, __m128 bz )
+        {
+          return (
+              _mm_sub_ps ( _mm_mul_ps ( ay, bz ), _mm_mul_ps ( az, by ) )
+          );
+        }
+    };
+    const vectors_struct p{
+        cross ( d[1], d[2], e2[1], e2[2] ),
+        cross ( d[2], d[0], e2[2], e2[0] ),
+        cross ( d[0], d[1], e2[0], e2[1] )
+    };
+    const auto dot{
+        [] ( const vectors_struct& a, const vectors_struct& b )
+        {
+          return (
+              _mm_add_ps (
+                  _mm_add_ps ( _mm_mul_ps ( a[0], b[0] ),
+                      _mm_mul_ps ( a[1], b[1] ) ),
+                  _mm_mul_ps ( a[2], b[2] )
+              )
+          );
+        }
+    };
+    const auto determinant{ dot ( e1, p ) };
+    const auto inverse{ _mm_div_ps ( _mm_set1_ps ( 1.0f ), determinant ) };
+    const vectors_struct s{
+        _mm_sub_ps ( packet.origin[0], _mm_set1_ps ( triangle.corner[0] ) ),
+        _mm_sub_ps ( packet.origin[1], _mm_set1_ps ( triangle.corner[1] ) ),
+        _mm_sub_ps ( packet.origin[2], _mm_set1_ps ( triangle.corner[2] ) )
+    };
+    const auto u{ _mm_mul_ps ( dot ( s, p ), inverse ) };
+    const vectors_struct q{
+        cross ( s[1], s[2], e1[1], e1[2] ),
+        cross ( s[2], s[0], e1[2], e1[0] ),
+        cross ( s[0], s[1], e1[0], e1[1] )
+    };
+    const auto v{ _mm_mul_ps ( dot ( d, q ), inverse ) };
+    const auto t{ _mm_mul_ps ( dot ( e2, q ), inverse ) };
+
+    // A ray in the plane of the triangle has an infinite or undefined
+    // inverse, and so fails a comparison below.
+    const auto zero{ _mm_setzero_ps () };
+    auto mask{ _mm_cmpge_ps ( u, zero ) };
+    mask = _mm_and_ps ( mask, _mm_cmpge_ps ( v, zero ) );
+    mask = _mm_and_ps (
+        mask,
+        _mm_cmple_ps ( _mm_add_ps ( u, v ), _mm_set1_ps ( 1.0f ) )
+    );
+    mask = _mm_and_ps ( mask, _mm_cmpgt_ps ( t, zero ) );
+    return ( _mm_and_ps ( mask, _mm_cmplt_ps ( t, packet.reach ) ) );
+  }
+
+  /**
+   * @brief Finds which rays of a packet enter a box within their reach.
+   *
+   * @param[in] packet The rays.
+   * @param[in] node The node whose box is tested.
+   * @returns A mask of the rays that enter it.
+   */
+  inline __m128 enters (
+      const packet_struct& packet,
+      const MtFormat::bvh_node_struct& node
+  ) noexcept
+  {
+    auto entry{ _mm_setzero_ps () };
+    auto exit{ packet.reach };
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      const auto low{ _mm_set1_ps ( node.bounds_min[k] ) };
+      const auto high{ _mm_set1_ps ( node.bounds_max[k] ) };
+      const auto& inverse{ packet.inverse[k] };
+      const auto t0{
+          _mm_mul_ps ( _mm_sub_ps ( low, packet.origin[k] ), inverse )
+      };
+      const auto t1{
+          _mm_mul_ps ( _mm_sub_ps ( high, packet.origin[k] ), inverse )
+      };
+      entry = _mm_max_ps ( entry, _mm_min_ps ( t0, t1 ) );
+      exit = _mm_min_ps ( exit, _mm_max_ps ( t0, t1 ) );
+    }
+    return ( _mm_cmple_ps ( entry, exit ) );
+  }
+
+  /**
+   * @brief Finds which rays of a packet hit any occluder.
+   *
+   * The packet goes down the hierarchy together, into each node any of its
+   * rays still looking enter, and a ray stops looking at its first hit.
+   *
+   * @param[in] occluders The occluders.
+   * @param[in] packet The rays.
+   * @param[in] active A mask of the rays to trace.
+   * @param[in,out] stack Space for the nodes still to visit, kept between
+   * calls so that it is not allocated for each.
+   * @returns A mask of the rays traced that hit an occluder.
+   */
+  __m128 occluded (
+      const occluders_struct& occluders,
+      const packet_struct& packet,
+      __m128 active,
+      std::vector<std::uint32_t>& stack
+  )
+  {
+    const auto& nodes{ occluders.hierarchy.nodes };
+    auto hit{ _mm_setzero_ps () };
+    stack.clear ();
+    std::uint32_t n{ 0 };
+    for ( ;; )
+    {
+      const auto& node{ nodes[n] };
+      const auto looking{ _mm_andnot_ps ( hit, active ) };
+      if ( _mm_movemask_ps ( _mm_and_ps ( enters ( packet, node ), looking ) ) )
+      {
+        if ( node.count == 0 )
+        {
+          // The first child follows its parent.
+          stack.emplace_back ( node.first );
+          ++n;
+          continue;
+        }
+        for ( std::uint32_t j{ 0 }; j < node.count; ++j )
+        {
+          hit = _mm_or_ps (
+              hit,
+              _mm_and_ps (
+                  hits ( packet, occluders.triangles[node.first + j] ),
+                  looking
+              )
+          );
+        }
+        if ( _mm_movemask_ps ( _mm_andnot_ps ( hit, active ) ) == 0 )
+        {
+          break;
+        }
+      }
+      if ( stack.empty () )
+      {
+        break;
+      }
+      n = stack.back ();
+      stack.pop_back ();
+    }
+    return ( hit );
+  }
+
+  /**
+   * @brief Bakes how open to the sky around it each vertex is.
+   *
+   * Rays leave each vertex over the hemisphere about its normal, those
+   * near the normal more often, so that the fraction that escape weighs
+   * light as a diffuse surface does. Each vertex turns the same directions
+   * by its own angle, so that neighbouring vertices do not miss the same
+   * gaps. Vertices are baked in tasks spread over the workers, and the
+   * result does not depend on how many there are.
+   *
+   * @param[in] occluders The triangles rays can hit.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] p_normals The normal \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @param[in] rays The rays cast from each vertex, from 1 to MAX_RAYS.
+   * @param[in] distance The length of rays, as a fraction of
+   * occluders_struct::diagonal .
+   * @param[in] workers The number of workers to bake with.
+   * @returns For each vertex, the fraction of rays that hit nothing, or 1
+   * for a vertex with no normal.
+   */
+  std::vector<float> bake (
+      const occluders_struct& occluders,
+      const float* p_positions,
+      const float* p_normals,
+      std::size_t count,
+      unsigned rays,
+      float distance,
+      unsigned workers
+  )
+  {
+    std::vector<float> openness( count, 1.0f );
+    if ( occluders.triangles.empty () || count == 0 )
+    {
+      return ( openness );
+    }
+    const auto directions{ hemisphere ( rays ) };
+    const auto reach{ _mm_set1_ps ( distance * occluders.diagonal ) };
+    const auto offset{ SURFACE_OFFSET * occluders.diagonal };
+    const auto tasks{ ( count + VERTICES_PER_TASK - 1 ) / VERTICES_PER_TASK };
+    Jobs::parallel_for (
+        tasks,
+        Jobs::worker_count ( workers, tasks ),
+        [&] ( std::size_t task, unsigned )
+        {
+          std::vector<std::uint32_t> stack{};
+          const auto end{
+              std::min ( count, ( task + 1 ) * VERTICES_PER_TASK )
+          };
+          for ( auto j{ task * VERTICES_PER_TASK }; j < end; ++j )
+          {
+            const auto* p_n{ p_normals + j * 3 };
+            const auto length{
+                std::sqrt (
+                    p_n[0] * p_n[0] + p_n[1] * p_n[1] + p_n[2] * p_n[2]
+                )
+            };
+            if ( !( length > 0.0f ) )
+            {
+              continue;
+            }
+            const std::array<float, 3> normal{
+                p_n[0] / length,
+                p_n[1] / length,
+                p_n[2] / length
+            };
+
+            // Axes across the normal, without a branch near its poles
+            // (Duff et al., 2017), turned by the angle of the vertex.
+            const auto sign{ std::copysign ( 1.0f, normal[2] ) };
+            const auto a{ -1.0f / ( sign + normal[2] ) };
+            const auto b{ normal[0] * normal[1] * a };
+            const std::array<float, 3> x0{
+                1.0f + sign * normal[0] * normal[0] * a,
+                sign * b,
+                -sign * normal[0]
+            };
+            const std::array<float, 3> y0{
+                b,
+                sign + normal[1] * normal[1] * a,
+                -normal[1]
+            };
+            auto hash{ static_cast<std::uint32_t>( j ) * 0x9E3779B9U };
+            hash ^= hash >> 16;
+            hash *= 0x85EBCA6BU;
+            hash ^= hash >> 13;
+            const auto turn{
+                6.28318531f * static_cast<float>( hash ) * 0x1p-32f
+            };
+            const auto c{ std::cos ( turn ) };
+            const auto s{ std::sin ( turn ) };
+            std::array<float, 3> x_axis{};
+            std::array<float, 3> y_axis{};
+            for ( std::size_t k{ 0 }; k < 3; ++k )
+            {
+              x_axis[k] = c * x0[k] + s * y0[k];
+              y_axis[k] = c * y0[k] - s * x0[k];
+            }
+
+            packet_struct packet{ .reach{ reach } };
+            for ( std::size_t k{ 0 }; k < 3; ++k )
+            {
+              packet.origin[k] =
+                  _mm_set1_ps ( p_positions[j * 3 + k] + normal[k] * offset );
+            }
+            unsigned blocked{ 0 };
+            for ( unsigned r{ 0 }; r < rays; r += PACKET_RAYS )
+            {
+              std::array<std::array<float, PACKET_RAYS>, 3> lanes{};
+              for ( std::size_t l{ 0 }; l < PACKET_RAYS; ++l )
+              {
+                const auto& local{ directions[r + l] };
+                for ( std::size_t k{ 0 }; k < 3; ++k )
+                {
+                  lanes[k][l] = local[0] * x_axis[k] + local[1] * y_axis[k]
+                      + local[2] * normal[k];
+                }
+              }
+              for ( std::size_t k{ 0 }; k < 3; ++k )
+              {
+                packet.direction[k] = _mm_loadu_ps ( lanes[k].data () );
+
+                // Components of zero are nudged, so that boxes are entered
+                // by finite distances.
+                const auto magnitude{
+                    _mm_andnot_ps ( _mm_set1_ps ( -0.0f ), packet.direction[k] )
+                };
+                const auto tiny{
+                    _mm_cmplt_ps ( magnitude, _mm_set1_ps ( 1.0e-20f ) )
+                };
+                packet.inverse[k] = _mm_div_ps (
+                    _mm_set1_ps ( 1.0f ),
+                    _mm_or_ps (
+                        _mm_andnot_ps ( tiny, packet.direction[k] ),
+                        _mm_and_ps ( tiny, _mm_set1_ps ( 1.0e-20f ) )
+                    )
+                );
+              }
+              const auto lanes_used{
+                  std::min<unsigned> ( rays - r, PACKET_RAYS )
+              };
+              const auto active{
+                  _mm_castsi128_ps (
+                      _mm_cmplt_epi32 (
+                          _mm_setr_epi32 ( 0, 1, 2, 3 ),
+                          _mm_set1_epi32 ( static_cast<int>( lanes_used ) )
+                      )
+                  )
+              };
+              const auto hit{ occluded ( occluders, packet, active, stack ) };
+              blocked += std::popcount (
+                  static_cast<unsigned>( _mm_movemask_ps ( hit ) )
+              );
+            }
+            openness[j] = 1.0f
+                - static_cast<float>( blocked ) / static_cast<float>( rays );
+          }
+        }
+    );
+    return ( openness );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for baking ambient occlusion into mesh vertices.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
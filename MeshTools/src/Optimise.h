@@ -0,0 +1,443 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Optimise.h
+// SYNOPSIS : Utilities for ordering mesh data for faster drawing.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for ordering mesh data for faster drawing.
+namespace Optimise
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The entries of the post-transform vertex cache modelled.
+  const std::uint32_t VERTEX_CACHE_SIZE{ 16 };
+
+  //! The size of a line of the vertex fetch cache modelled.
+  const std::uint64_t CACHE_LINE_BYTES{ 64 };
+
+  //! The lines of the vertex fetch cache modelled, 128 KiB as a GPU L2 has.
+  const std::uint32_t FETCH_CACHE_LINES{ 2'048 };
+
+  /**
+   * @brief How far above its own the vertex cache miss ratio of an overdraw
+   * cluster may rise, by default.
+   */
+  const float DEFAULT_OVERDRAW_THRESHOLD{ 1.05f };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Measures of how well an index order suits the GPU.
+   *
+   * @ingroup STRUCT
+   */
+  struct cache_statistics_struct
+  {
+    //! Vertex cache misses per triangle, from 0.5 at best to 3.
+    float acmr{};
+    //! Vertex cache misses per vertex used, from 1 at best.
+    float atvr{};
+    //! Bytes fetched per byte of vertex data used, from 1 at best.
+    float overfetch{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief A first-in first-out cache of numbered entries.
+   *
+   * An entry is cached while fewer than the cache size of other entries have
+   * been added since it was, which is tracked with a time stamp per entry
+   * rather than a queue.
+   */
+  class FifoCache final
+  {
+  public:
+    /**
+     * @brief Creates an empty cache.
+     *
+     * @param[in] entries The number of entries that can be looked up.
+     * @param[in] size The number of entries cached at once.
+     */
+    FifoCache ( std::size_t entries, std::uint32_t size )
+      : stamps_( entries, 0 ),
+        size_{ size },
+        time_{ size + 1 }
+    {
+    }
+
+    /**
+     * @brief Looks up an entry, adding it if it is not cached.
+     *
+     * @param[in] entry The entry.
+     * @returns \c true on a miss.
+     */
+    bool miss ( std::size_t entry )
+    {
+      if ( time_ - stamps_[entry] > size_ )
+      {
+        stamps_[entry] = time_++;
+        return ( true );
+      }
+      return ( false );
+    }
+
+    //! Empties the cache.
+    void clear ()
+    {
+      time_ += size_ + 1;
+    }
+
+  private:
+    std::vector<std::uint32_t> stamps_;
+    std::uint32_t size_;
+    std::uint32_t time_;
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Measures how an index order uses the vertex caches.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] num_vertices The number of vertices.
+   * @param[in] vertex_bytes The bytes of data fetched for each vertex.
+   * @returns The statistics, all zero for a mesh without triangles.
+   */
+  cache_statistics_struct analyse (
+      std::span<const std::uint32_t> indices,
+      std::size_t num_vertices,
+      std::size_t vertex_bytes
+  )
+  {
+    cache_statistics_struct statistics{};
+    if ( indices.size () < 3 || num_vertices == 0 )
+    {
+      return ( statistics );
+    }
+
+    FifoCache vertex_cache{ num_vertices, VERTEX_CACHE_SIZE };
+    const auto num_lines{
+        ( num_vertices * vertex_bytes + CACHE_LINE_BYTES - 1 )
+        / CACHE_LINE_BYTES
+    };
+    FifoCache fetch_cache{ num_lines, FETCH_CACHE_LINES };
+    std::vector<bool> is_used( num_vertices, false );
+    std::uint64_t misses{ 0 };
+    std::uint64_t used{ 0 };
+    std::uint64_t bytes_fetched{ 0 };
+    for ( const auto v : indices )
+    {
+      if ( !vertex_cache.miss ( v ) )
+      {
+        continue;
+      }
+      ++misses;
+      if ( !is_used[v] )
+      {
+        is_used[v] = true;
+        ++used;
+      }
+      const auto first_line{ v * vertex_bytes / CACHE_LINE_BYTES };
+      const auto last_line{
+          ( ( v + 1 ) * vertex_bytes - 1 ) / CACHE_LINE_BYTES
+      };
+      for ( auto line{ first_line }; line <= last_line; ++line )
+      {
+        if ( fetch_cache.miss ( line ) )
+        {
+          bytes_fetched += CACHE_LINE_BYTES;
+        }
+      }
+    }
+
+    statistics.acmr = static_cast<float>( misses )
+        / static_cast<float>( indices.size () / 3 );
+    statistics.atvr = static_cast<float>( misses )
+        / static_cast<float>( used );
+    statistics.overfetch = static_cast<float>( bytes_fetched )
+        / static_cast<float>( used * vertex_bytes );
+    return ( statistics );
+  }
+
+  /**
+   * @brief Renumbers vertices in the order the triangles first use them.
+   *
+   * Vertices fetched close together in time are then close together in
+   * memory. Vertices no triangle uses keep their order, after the rest.
+   *
+   * @param[in,out] indices The vertex indices, which are renumbered.
+   * @param[in] num_vertices The number of vertices.
+   * @returns For each new vertex number, the old number.
+   */
+  std::vector<std::uint32_t> reorder_first_use (
+      std::span<std::uint32_t> indices,
+      std::size_t num_vertices
+  )
+  {
+    const auto UNSEEN{ std::numeric_limits<std::uint32_t>::max () };
+    std::vector<std::uint32_t> new_numbers( num_vertices, UNSEEN );
+    std::vector<std::uint32_t> old_numbers{};
+    old_numbers.reserve ( num_vertices );
+    for ( auto& v : indices )
+    {
+      if ( new_numbers[v] == UNSEEN )
+      {
+        new_numbers[v] = static_cast<std::uint32_t>( old_numbers.size () );
+        old_numbers.emplace_back ( v );
+      }
+      v = new_numbers[v];
+    }
+    for ( std::uint32_t v{ 0 }; v < num_vertices; ++v )
+    {
+      if ( new_numbers[v] == UNSEEN )
+      {
+        old_numbers.emplace_back ( v );
+      }
+    }
+    return ( old_numbers );
+  }
+
+  /**
+   * @brief Copies per-vertex data into a new vertex order, in one pass.
+   *
+   * @param[in] old_numbers For each new vertex number, the old number.
+   * @param[in] p_elements The data of each vertex in the old order.
+   * @param[in] elements_per_vertex The elements each vertex has.
+   * @returns The data in the new order.
+   */
+  template<typename Element>
+  std::vector<Element> reorder_vertices (
+      std::span<const std::uint32_t> old_numbers,
+      const Element* p_elements,
+      std::size_t elements_per_vertex = 1
+  )
+  {
+    std::vector<Element> reordered( old_numbers.size () * elements_per_vertex );
+    auto* p_next{ reordered.data () };
+    for ( const auto v : old_numbers )
+    {
+      const auto* p_vertex{ p_elements + v * elements_per_vertex };
+      p_next = std::copy ( p_vertex, p_vertex + elements_per_vertex, p_next );
+    }
+    return ( reordered );
+  }
+
+  /**
+   * @brief Orders triangles so that those facing out of the mesh come first,
+   * to reduce overdraw, while keeping most of the vertex cache order.
+   *
+   * The triangles are split into clusters wherever the vertex cache starts
+   * afresh, and further while the miss ratio of a cluster stays within
+   * \c threshold of that of the run it was split from. Clusters are then
+   * sorted by how far out of the mesh their surface faces.
+   *
+   * @param[in,out] indices The vertex indices, three for each triangle.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] num_vertices The number of vertices.
+   * @param[in] threshold The rise in miss ratio allowed, such as 1.05.
+   */
+  void sort_overdraw (
+      std::span<std::uint32_t> indices,
+      const float* p_positions,
+      std::size_t num_vertices,
+      float threshold
+  )
+  {
+    const auto num_triangles{ indices.size () / 3 };
+    if ( num_triangles < 2 )
+    {
+      return;
+    }
+
+    // Hard boundaries are triangles that miss on all three vertices.
+    FifoCache cache{ num_vertices, VERTEX_CACHE_SIZE };
+    std::vector<std::size_t> hard{};
+    for ( std::size_t t{ 0 }; t < num_triangles; ++t )
+    {
+      const auto misses{
+          int{ cache.miss ( indices[t * 3] ) }
+          + int{ cache.miss ( indices[t * 3 + 1] ) }
+          + int{ cache.miss ( indices[t * 3 + 2] ) }
+      };
+      if ( misses == 3 || t == 0 )
+      {
+        hard.emplace_back ( t );
+      }
+    }
+    hard.emplace_back ( num_triangles );
+
+    // Soft boundaries split runs as soon as their miss ratio is close
+    // enough to that of the whole run.
+    std::vector<std::size_t> starts{};
+    for ( std::size_t h{ 0 }; h + 1 < hard.size (); ++h )
+    {
+      cache.clear ();
+      std::uint64_t run_misses{ 0 };
+      for ( auto t{ hard[h] }; t < hard[h + 1]; ++t )
+      {
+        for ( auto k{ 0 }; k < 3; ++k )
+        {
+          run_misses += cache.miss ( indices[t * 3 + k] ) ? 1 : 0;
+        }
+      }
+      const auto run_acmr{
+          static_cast<float>( run_misses )
+          / static_cast<float>( hard[h + 1] - hard[h] )
+      };
+
+      cache.clear ();
+      starts.emplace_back ( hard[h] );
+      std::uint64_t misses{ 0 };
+      std::size_t triangles{ 0 };
+      for ( auto t{ hard[h] }; t < hard[h + 1]; ++t )
+      {
+        for ( auto k{ 0 }; k < 3; ++k )
+        {
+          misses += cache.miss ( indices[t * 3 + k] ) ? 1 : 0;
+        }
+        ++triangles;
+        if (
+            t + 1 < hard[h + 1]
+            && static_cast<float>( misses ) / static_cast<float>( triangles )
+                <= threshold * run_acmr
+        )
+        {
+          starts.emplace_back ( t + 1 );
+          cache.clear ();
+          misses = 0;
+          triangles = 0;
+        }
+      }
+    }
+    starts.emplace_back ( num_triangles );
+
+    // Each cluster is keyed by how far its area-weighted centre lies along
+    // its average normal from the centre of the mesh. Sums hold the weighted
+    // centre, then the normal, whose length is twice the area, then the area.
+    const auto num_clusters{ starts.size () - 1 };
+    std::vector<std::array<double, 7>> sums( num_clusters );
+    std::array<double, 3> mesh_centre{};
+    double mesh_area{ 0.0 };
+    for ( std::size_t c{ 0 }; c < num_clusters; ++c )
+    {
+      auto& sum{ sums[c] };
+      sum.fill ( 0.0 );
+      for ( auto t{ starts[c] }; t < starts[c + 1]; ++t )
+      {
+        const auto* p0{ p_positions + indices[t * 3] * std::size_t{ 3 } };
+        const auto* p1{ p_positions + indices[t * 3 + 1] * std::size_t{ 3 } };
+        const auto* p2{ p_positions + indices[t * 3 + 2] * std::size_t{ 3 } };
+        const double e1[3]{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const double e2[3]{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        const double normal[3]{
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0]
+        };
+        const auto area{
+            std::sqrt (
+                normal[0] * normal[0]
+                + normal[1] * normal[1]
+                + normal[2] * normal[2]
+            )
+        };
+        for ( auto k{ 0 }; k < 3; ++k )
+        {
+          const auto centre{ ( p0[k] + p1[k] + p2[k] ) / 3.0 };
+          sum[k] += centre * area;
+          sum[3 + k] += normal[k];
+          mesh_centre[k] += centre * area;
+        }
+        sum[6] += area;
+        mesh_area += area;
+      }
+    }
+    for ( auto& m : mesh_centre )
+    {
+      m = mesh_area > 0.0 ? m / mesh_area : 0.0;
+    }
+
+    std::vector<double> keys( num_clusters, 0.0 );
+    for ( std::size_t c{ 0 }; c < num_clusters; ++c )
+    {
+      const auto& sum{ sums[c] };
+      const auto normal_length{
+          std::sqrt ( sum[3] * sum[3] + sum[4] * sum[4] + sum[5] * sum[5] )
+      };
+      if ( sum[6] <= 0.0 || normal_length <= 0.0 )
+      {
+        continue;
+      }
+      for ( auto k{ 0 }; k < 3; ++k )
+      {
+        keys[c] += ( sum[k] / sum[6] - mesh_centre[k] ) * sum[3 + k]
+            / normal_length;
+      }
+    }
+
+    std::vector<std::size_t> order( num_clusters );
+    std::iota ( order.begin (), order.end (), std::size_t{ 0 } );
+    std::stable_sort (
+        order.begin (),
+        order.end (),
+        [&keys] ( std::size_t a, std::size_t b )
+        {
+          return ( keys[a] > keys[b] );
+        }
+    );
+
+    std::vector<std::uint32_t> sorted{};
+    sorted.reserve ( indices.size () );
+    for ( const auto c : order )
+    {
+      sorted.insert (
+          sorted.end (),
+          indices.begin () + starts[c] * 3,
+          indices.begin () + starts[c + 1] * 3
+      );
+    }
+    std::copy ( sorted.begin (), sorted.end (), indices.begin () );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for ordering mesh data for faster drawing.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -20,6 +20,49 @@
 // HEADER FILES
 ///////////////////////////////////////////////////////////////////////////////
 
+// STANDARD LIBRARY ///////////////////////////////////////////////////////////
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// GDI+ ///////////////////////////////////////////////////////////////////////
+// GDI+ uses the min and max macros that NOMINMAX leaves out.
+namespace Gdiplus
+{
+  using std::max;
+  using std::min;
+}
+#include <objidl.h>
+#include <gdiplus.h>
+#include <shlwapi.h>
+
+// COMPILER INTRINSICS ////////////////////////////////////////////////////////
+#include <immintrin.h>
+
 // BOOST //////////////////////////////////////////////////////////////////////
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
@@ -27,8 +70,12 @@
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/program_options.hpp>
+#include <boost/property_tree/info_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
 
 // ASSIMP /////////////////////////////////////////////////////////////////////
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Exporter.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
@@ -0,0 +1,777 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Quantise.h
+// SYNOPSIS : Utilities for storing mesh data in fewer bits.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for storing mesh data in fewer bits.
+namespace Quantise
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The number of vertices 16-bit indices can address.
+  const std::size_t SHORT_INDEX_VERTICES{ 65'536 };
+
+  //! The largest 16-bit unsigned normalised value.
+  const float UNORM16_MAX{ 65'535.0f };
+
+  //! The largest 16-bit signed normalised value.
+  const float SNORM16_MAX{ 32'767.0f };
+
+  //! The largest 8-bit unsigned normalised value.
+  const float UNORM8_MAX{ 255.0f };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // ENUMS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! An enumeration of the ways positions can be quantised.
+  enum class PositionEnum
+  {
+    Unorm16, ///< 16-bit steps across the bounding box.
+    Half     ///< Half precision offsets from the centre of the bounding box.
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief How far quantised values are from the values they replace.
+   *
+   * @ingroup STRUCT
+   */
+  struct error_struct
+  {
+    //! The largest error.
+    float max{};
+    //! The root mean square error.
+    float rms{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! Gathers the largest and root mean square of errors, four at a time.
+  class ErrorAccumulator final
+  {
+  public:
+    /**
+     * @brief Adds errors.
+     *
+     * @param[in] errors Absolute errors, zero in any lane not used.
+     * @param[in] lanes The number of lanes used.
+     */
+    void add ( __m128 errors, unsigned lanes = 4 )
+    {
+      max_ = _mm_max_ps ( max_, errors );
+      const auto squares{ _mm_mul_ps ( errors, errors ) };
+      sum_ = _mm_add_pd ( sum_, _mm_cvtps_pd ( squares ) );
+      sum_ = _mm_add_pd (
+          sum_,
+          _mm_cvtps_pd ( _mm_movehl_ps ( squares, squares ) )
+      );
+      count_ += lanes;
+    }
+
+    //! Adds one absolute error.
+    void add ( float error )
+    {
+      add ( _mm_set_ss ( error ), 1 );
+    }
+
+    /**
+     * @brief Gives the errors added so far.
+     *
+     * @returns The largest and root mean square error.
+     */
+    error_struct result () const
+    {
+      alignas( 16 ) std::array<float, 4> maxima{};
+      alignas( 16 ) std::array<double, 2> sums{};
+      _mm_store_ps ( maxima.data (), max_ );
+      _mm_store_pd ( sums.data (), sum_ );
+      return (
+          error_struct{
+              .max{ *std::max_element ( maxima.begin (), maxima.end () ) },
+              .rms{
+                  count_ == 0
+                      ? 0.0f
+                      : static_cast<float>(
+                            std::sqrt (
+                                ( sums[0] + sums[1] )
+                                / static_cast<double>( count_ )
+                            )
+                        )
+              }
+          }
+      );
+    }
+
+  private:
+    __m128 max_{ _mm_setzero_ps () };
+    __m128d sum_{ _mm_setzero_pd () };
+    std::uint64_t count_{ 0 };
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Gives the absolute value of each lane.
+   *
+   * @param[in] values The values.
+   * @returns The absolute values.
+   */
+  inline __m128 abs ( __m128 values )
+  {
+    return ( _mm_andnot_ps ( _mm_set1_ps ( -0.0f ), values ) );
+  }
+
+  /**
+   * @brief Gives \c 1 or \c -1 with the sign of each lane.
+   *
+   * @param[in] values The values.
+   * @returns The signs.
+   */
+  inline __m128 sign ( __m128 values )
+  {
+    return (
+        _mm_or_ps (
+            _mm_and_ps ( values, _mm_set1_ps ( -0.0f ) ),
+            _mm_set1_ps ( 1.0f )
+        )
+    );
+  }
+
+  /**
+   * @brief Picks between two values in each lane.
+   *
+   * @param[in] mask All ones in lanes to take from \c chosen , else zero.
+   * @param[in] chosen The values where the mask is set.
+   * @param[in] otherwise The values where it is not.
+   * @returns The values picked.
+   */
+  inline __m128 select ( __m128 mask, __m128 chosen, __m128 otherwise )
+  {
+    return (
+        _mm_or_ps (
+            _mm_and_ps ( mask, chosen ),
+            _mm_andnot_ps ( mask, otherwise )
+        )
+    );
+  }
+
+  /**
+   * @brief Gives the length of four vectors.
+   *
+   * @param[in] x The \c x components.
+   * @param[in] y The \c y components.
+   * @param[in] z The \c z components.
+   * @returns The lengths.
+   */
+  inline __m128 length ( __m128 x, __m128 y, __m128 z )
+  {
+    return (
+        _mm_sqrt_ps (
+            _mm_add_ps (
+                _mm_add_ps ( _mm_mul_ps ( x, x ), _mm_mul_ps ( y, y ) ),
+                _mm_mul_ps ( z, z )
+            )
+        )
+    );
+  }
+
+  /**
+   * @brief Packs eight 32-bit integers from 0 to 65535 into 16 bits each.
+   *
+   * SSE2 can only pack with signed saturation, so the values are moved into
+   * the signed range and back.
+   *
+   * @param[in] low The first four values.
+   * @param[in] high The last four values.
+   * @returns The packed values.
+   */
+  inline __m128i pack_uint16 ( __m128i low, __m128i high )
+  {
+    const auto bias{ _mm_set1_epi32 ( 32'768 ) };
+    return (
+        _mm_xor_si128 (
+            _mm_packs_epi32 (
+                _mm_sub_epi32 ( low, bias ),
+                _mm_sub_epi32 ( high, bias )
+            ),
+            _mm_set1_epi16 ( static_cast<short>( 0x8000 ) )
+        )
+    );
+  }
+
+  /**
+   * @brief Converts a \c float to half precision, rounding to nearest even.
+   *
+   * @param[in] value The value.
+   * @returns The bits of the half precision value.
+   */
+  std::uint16_t float_to_half ( float value )
+  {
+    std::uint32_t bits{};
+    std::memcpy ( &bits, &value, sizeof ( bits ) );
+    const auto sign_bit{
+        static_cast<std::uint16_t>( ( bits >> 16 ) & 0x8000U )
+    };
+    bits &= 0x7FFF'FFFFU;
+
+    std::uint32_t half{};
+    if ( bits >= 0x4780'0000U )
+    {
+      // Too large, infinite, or not a number.
+      half = bits > 0x7F80'0000U ? 0x7E00U : 0x7C00U;
+    }
+    else if ( bits < 0x3880'0000U )
+    {
+      // Subnormal, rounded by a float addition that shifts out the rest.
+      const std::uint32_t magic_bits{ 0x3F00'0000U };
+      float magic{};
+      std::memcpy ( &magic, &magic_bits, sizeof ( magic ) );
+      float shifted{};
+      std::memcpy ( &shifted, &bits, sizeof ( shifted ) );
+      shifted += magic;
+      std::memcpy ( &half, &shifted, sizeof ( half ) );
+      half -= magic_bits;
+    }
+    else
+    {
+      const auto is_odd{ ( bits >> 13 ) & 1U };
+      bits += 0xC800'0FFFU + is_odd;
+      half = bits >> 13;
+    }
+    return ( static_cast<std::uint16_t>( half | sign_bit ) );
+  }
+
+  /**
+   * @brief Converts a half precision value to a \c float .
+   *
+   * @param[in] half The bits of the half precision value.
+   * @returns The value.
+   */
+  float half_to_float ( std::uint16_t half )
+  {
+    const std::uint32_t EXPONENT{ 0x7C00U << 13 };
+    std::uint32_t bits{ ( half & 0x7FFFU ) << 13 };
+    const auto exponent{ bits & EXPONENT };
+    bits += ( 127U - 15U ) << 23;
+    float value{};
+    if ( exponent == EXPONENT )
+    {
+      bits += ( 128U - 16U ) << 23;
+      std::memcpy ( &value, &bits, sizeof ( value ) );
+    }
+    else if ( exponent == 0 )
+    {
+      bits += 1U << 23;
+      std::memcpy ( &value, &bits, sizeof ( value ) );
+      value -= 6.103'515'625e-05f;
+    }
+    else
+    {
+      std::memcpy ( &value, &bits, sizeof ( value ) );
+    }
+    return ( half & 0x8000U ? -value : value );
+  }
+
+  /**
+   * @brief Quantises positions to 16-bit steps across their bounding box.
+   *
+   * Four vertices are done at a time, as three vectors whose lanes run
+   * <tt>x y z x</tt>, <tt>y z x y</tt>, and <tt>z x y z</tt>.
+   *
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @param[in] bounds_min The smallest \c x , \c y , and \c z .
+   * @param[in] bounds_max The largest \c x , \c y , and \c z .
+   * @param[out] p_quantised Three values for each vertex.
+   * @returns The error of each component, in the units of the positions.
+   */
+  error_struct positions_unorm16 (
+      const float* p_positions,
+      std::size_t count,
+      const std::array<float, 3>& bounds_min,
+      const std::array<float, 3>& bounds_max,
+      std::uint16_t* p_quantised
+  )
+  {
+    std::array<float, 3> scales{};
+    std::array<float, 3> steps{};
+    for ( std::size_t c{ 0 }; c < 3; ++c )
+    {
+      const auto extent{ bounds_max[c] - bounds_min[c] };
+      scales[c] = extent > 0.0f ? UNORM16_MAX / extent : 0.0f;
+      steps[c] = extent / UNORM16_MAX;
+    }
+    const auto lanes{
+        [] ( const std::array<float, 3>& v, std::size_t first )
+        {
+          return (
+              _mm_setr_ps (
+                  v[first % 3],
+                  v[( first + 1 ) % 3],
+                  v[( first + 2 ) % 3],
+                  v[first % 3]
+              )
+          );
+        }
+    };
+    const __m128 mins[3]{
+        lanes ( bounds_min, 0 ),
+        lanes ( bounds_min, 1 ),
+        lanes ( bounds_min, 2 )
+    };
+    const __m128 scale_lanes[3]{
+        lanes ( scales, 0 ),
+        lanes ( scales, 1 ),
+        lanes ( scales, 2 )
+    };
+    const __m128 step_lanes[3]{
+        lanes ( steps, 0 ),
+        lanes ( steps, 1 ),
+        lanes ( steps, 2 )
+    };
+    const auto half{ _mm_set1_ps ( 0.5f ) };
+    const auto zero{ _mm_setzero_ps () };
+    const auto top{ _mm_set1_ps ( UNORM16_MAX ) };
+
+    ErrorAccumulator errors{};
+    const auto components{ count * 3 };
+    std::size_t j{ 0 };
+    for ( ; j + 12 <= components; j += 12 )
+    {
+      __m128i quantised[3]{};
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        const auto p{ _mm_loadu_ps ( p_positions + j + k * 4 ) };
+        const auto scaled{
+            _mm_add_ps (
+                _mm_mul_ps ( _mm_sub_ps ( p, mins[k] ), scale_lanes[k] ),
+                half
+            )
+        };
+        quantised[k] = _mm_cvttps_epi32 (
+            _mm_min_ps ( _mm_max_ps ( scaled, zero ), top )
+        );
+        const auto restored{
+            _mm_add_ps (
+                _mm_mul_ps (
+                    _mm_cvtepi32_ps ( quantised[k] ),
+                    step_lanes[k]
+                ),
+                mins[k]
+            )
+        };
+        errors.add ( abs ( _mm_sub_ps ( restored, p ) ) );
+      }
+      _mm_storeu_si128 (
+          reinterpret_cast<__m128i*>( p_quantised + j ),
+          pack_uint16 ( quantised[0], quantised[1] )
+      );
+      _mm_storel_epi64 (
+          reinterpret_cast<__m128i*>( p_quantised + j + 8 ),
+          pack_uint16 ( quantised[2], quantised[2] )
+      );
+    }
+    for ( ; j < components; ++j )
+    {
+      const auto c{ j % 3 };
+      const auto scaled{
+          std::clamp (
+              ( p_positions[j] - bounds_min[c] ) * scales[c] + 0.5f,
+              0.0f,
+              UNORM16_MAX
+          )
+      };
+      p_quantised[j] = static_cast<std::uint16_t>( scaled );
+      errors.add (
+          std::abs (
+              static_cast<float>( p_quantised[j] ) * steps[c] + bounds_min[c]
+              - p_positions[j]
+          )
+      );
+    }
+    return ( errors.result () );
+  }
+
+  /**
+   * @brief Quantises positions to half precision offsets from the centre of
+   * their bounding box.
+   *
+   * The conversion is vectorised when F16C instructions are available, and
+   * is otherwise done a component at a time.
+   *
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] count The number of vertices.
+   * @param[in] bounds_min The smallest \c x , \c y , and \c z .
+   * @param[in] bounds_max The largest \c x , \c y , and \c z .
+   * @param[out] p_quantised Three values for each vertex.
+   * @returns The error of each component, in the units of the positions.
+   */
+  error_struct positions_half (
+      const float* p_positions,
+      std::size_t count,
+      const std::array<float, 3>& bounds_min,
+      const std::array<float, 3>& bounds_max,
+      std::uint16_t* p_quantised
+  )
+  {
+    std::array<float, 3> centre{};
+    for ( std::size_t c{ 0 }; c < 3; ++c )
+    {
+      centre[c] = ( bounds_min[c] + bounds_max[c] ) * 0.5f;
+    }
+
+    ErrorAccumulator errors{};
+    const auto components{ count * 3 };
+    std::size_t j{ 0 };
+#if defined ( __F16C__ ) || defined ( __AVX2__ )
+    const __m128 centres[3]{
+        _mm_setr_ps ( centre[0], centre[1], centre[2], centre[0] ),
+        _mm_setr_ps ( centre[1], centre[2], centre[0], centre[1] ),
+        _mm_setr_ps ( centre[2], centre[0], centre[1], centre[2] )
+    };
+    for ( ; j + 12 <= components; j += 12 )
+    {
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        const auto p{ _mm_loadu_ps ( p_positions + j + k * 4 ) };
+        const auto quantised{
+            _mm_cvtps_ph (
+                _mm_sub_ps ( p, centres[k] ),
+                _MM_FROUND_TO_NEAREST_INT
+            )
+        };
+        _mm_storel_epi64 (
+            reinterpret_cast<__m128i*>( p_quantised + j + k * 4 ),
+            quantised
+        );
+        const auto restored{
+            _mm_add_ps ( _mm_cvtph_ps ( quantised ), centres[k] )
+        };
+        errors.add ( abs ( _mm_sub_ps ( restored, p ) ) );
+      }
+    }
+#endif /* __F16C__ || __AVX2__ */
+    for ( ; j < components; ++j )
+    {
+      const auto c{ j % 3 };
+      p_quantised[j] = float_to_half ( p_positions[j] - centre[c] );
+      errors.add (
+          std::abs (
+              half_to_float ( p_quantised[j] ) + centre[c] - p_positions[j]
+          )
+      );
+    }
+    return ( errors.result () );
+  }
+
+  /**
+   * @brief Quantises normals to two 16-bit values each, by folding the unit
+   * sphere onto an octahedron and the octahedron flat.
+   *
+   * Four normals are done at a time, with their components shuffled into a
+   * vector each and the lower half of the octahedron folded without
+   * branching.
+   *
+   * @param[in] p_normals The \c x , \c y , and \c z of each normal.
+   * @param[in] count The number of normals.
+   * @param[out] p_quantised Two values for each normal.
+   * @returns The error of each normal in degrees.
+   */
+  error_struct normals_octahedral (
+      const float* p_normals,
+      std::size_t count,
+      std::int16_t* p_quantised
+  )
+  {
+    const auto tiny{ _mm_set1_ps ( std::numeric_limits<float>::min () ) };
+    const auto zero{ _mm_setzero_ps () };
+    const auto one{ _mm_set1_ps ( 1.0f ) };
+    const auto scale{ _mm_set1_ps ( SNORM16_MAX ) };
+    const auto step{ _mm_set1_ps ( 1.0f / SNORM16_MAX ) };
+
+    // Encodes and decodes four normals, giving the distance between each
+    // unit normal and its decoded form.
+    const auto encode{
+        [&] ( __m128 x, __m128 y, __m128 z, __m128i& qx, __m128i& qy )
+        {
+          const auto l1{
+              _mm_max_ps (
+                  _mm_add_ps ( _mm_add_ps ( abs ( x ), abs ( y ) ), abs ( z ) ),
+                  tiny
+              )
+          };
+          const auto ox{ _mm_div_ps ( x, l1 ) };
+          const auto oy{ _mm_div_ps ( y, l1 ) };
+          const auto is_lower{ _mm_cmplt_ps ( z, zero ) };
+          const auto fx{
+              _mm_mul_ps ( _mm_sub_ps ( one, abs ( oy ) ), sign ( ox ) )
+          };
+          const auto fy{
+              _mm_mul_ps ( _mm_sub_ps ( one, abs ( ox ) ), sign ( oy ) )
+          };
+          qx = _mm_cvtps_epi32 (
+              _mm_mul_ps ( select ( is_lower, fx, ox ), scale )
+          );
+          qy = _mm_cvtps_epi32 (
+              _mm_mul_ps ( select ( is_lower, fy, oy ), scale )
+          );
+
+          auto dx{ _mm_mul_ps ( _mm_cvtepi32_ps ( qx ), step ) };
+          auto dy{ _mm_mul_ps ( _mm_cvtepi32_ps ( qy ), step ) };
+          const auto dz{
+              _mm_sub_ps ( _mm_sub_ps ( one, abs ( dx ) ), abs ( dy ) )
+          };
+          const auto t{ _mm_max_ps ( _mm_sub_ps ( zero, dz ), zero ) };
+          dx = _mm_sub_ps ( dx, _mm_mul_ps ( sign ( dx ), t ) );
+          dy = _mm_sub_ps ( dy, _mm_mul_ps ( sign ( dy ), t ) );
+          const auto decoded_length{ length ( dx, dy, dz ) };
+          const auto original_length{ _mm_max_ps ( length ( x, y, z ), tiny ) };
+          const auto error{
+              length (
+                  _mm_sub_ps (
+                      _mm_div_ps ( dx, decoded_length ),
+                      _mm_div_ps ( x, original_length )
+                  ),
+                  _mm_sub_ps (
+                      _mm_div_ps ( dy, decoded_length ),
+                      _mm_div_ps ( y, original_length )
+                  ),
+                  _mm_sub_ps (
+                      _mm_div_ps ( dz, decoded_length ),
+                      _mm_div_ps ( z, original_length )
+                  )
+              )
+          };
+          // Normals of no length have no direction to lose.
+          return (
+              _mm_and_ps ( _mm_cmpgt_ps ( original_length, tiny ), error )
+          );
+        }
+    };
+
+    ErrorAccumulator chords{};
+    std::size_t j{ 0 };
+    for ( ; j + 4 <= count; j += 4 )
+    {
+      // Lanes run x0 y0 z0 x1, y1 z1 x2 y2, and z2 x3 y3 z3.
+      const auto a{ _mm_loadu_ps ( p_normals + j * 3 ) };
+      const auto b{ _mm_loadu_ps ( p_normals + j * 3 + 4 ) };
+      const auto c{ _mm_loadu_ps ( p_normals + j * 3 + 8 ) };
+      const auto x{
+          _mm_shuffle_ps (
+              a,
+              _mm_shuffle_ps ( b, c, _MM_SHUFFLE ( 1, 1, 2, 2 ) ),
+              _MM_SHUFFLE ( 2, 0, 3, 0 )
+          )
+      };
+      const auto y{
+          _mm_shuffle_ps (
+              _mm_shuffle_ps ( a, b, _MM_SHUFFLE ( 0, 0, 1, 1 ) ),
+              _mm_shuffle_ps ( b, c, _MM_SHUFFLE ( 2, 2, 3, 3 ) ),
+              _MM_SHUFFLE ( 2, 0, 2, 0 )
+          )
+      };
+      const auto z{
+          _mm_shuffle_ps (
+              _mm_shuffle_ps ( a, b, _MM_SHUFFLE ( 1, 1, 2, 2 ) ),
+              _mm_shuffle_ps ( c, c, _MM_SHUFFLE ( 3, 3, 0, 0 ) ),
+              _MM_SHUFFLE ( 2, 0, 2, 0 )
+          )
+      };
+      __m128i qx{};
+      __m128i qy{};
+      chords.add ( encode ( x, y, z, qx, qy ) );
+      _mm_storeu_si128 (
+          reinterpret_cast<__m128i*>( p_quantised + j * 2 ),
+          _mm_packs_epi32 (
+              _mm_unpacklo_epi32 ( qx, qy ),
+              _mm_unpackhi_epi32 ( qx, qy )
+          )
+      );
+    }
+    for ( ; j < count; ++j )
+    {
+      __m128i qx{};
+      __m128i qy{};
+      chords.add (
+          encode (
+              _mm_set_ss ( p_normals[j * 3] ),
+              _mm_set_ss ( p_normals[j * 3 + 1] ),
+              _mm_set_ss ( p_normals[j * 3 + 2] ),
+              qx,
+              qy
+          ),
+          1
+      );
+      p_quantised[j * 2] =
+          static_cast<std::int16_t>( _mm_cvtsi128_si32 ( qx ) );
+      p_quantised[j * 2 + 1] =
+          static_cast<std::int16_t>( _mm_cvtsi128_si32 ( qy ) );
+    }
+
+    // The chord between two unit vectors gives the angle between them.
+    const auto chord{ chords.result () };
+    const auto degrees{
+        [] ( float length )
+        {
+          return (
+              static_cast<float>(
+                  2.0 * std::asin ( std::min ( length * 0.5, 1.0 ) ) * 180.0
+                  / 3.141'592'653'589'793
+              )
+          );
+        }
+    };
+    return ( error_struct{ degrees ( chord.max ), degrees ( chord.rms ) } );
+  }
+
+  /**
+   * @brief Quantises colour components to eight bits each.
+   *
+   * Four colours are done at a time.
+   *
+   * @param[in] p_components The components of each colour, from 0 to 1.
+   * @param[in] count The number of components.
+   * @param[out] p_quantised A value for each component.
+   * @returns The error of each component, where 1 is full intensity.
+   */
+  error_struct colours_unorm8 (
+      const float* p_components,
+      std::size_t count,
+      std::uint8_t* p_quantised
+  )
+  {
+    const auto half{ _mm_set1_ps ( 0.5f ) };
+    const auto zero{ _mm_setzero_ps () };
+    const auto scale{ _mm_set1_ps ( UNORM8_MAX ) };
+    const auto step{ _mm_set1_ps ( 1.0f / UNORM8_MAX ) };
+
+    ErrorAccumulator errors{};
+    std::size_t j{ 0 };
+    for ( ; j + 16 <= count; j += 16 )
+    {
+      __m128i quantised[4]{};
+      for ( std::size_t k{ 0 }; k < 4; ++k )
+      {
+        const auto c{ _mm_loadu_ps ( p_components + j + k * 4 ) };
+        quantised[k] = _mm_cvttps_epi32 (
+            _mm_min_ps (
+                _mm_max_ps (
+                    _mm_add_ps ( _mm_mul_ps ( c, scale ), half ),
+                    zero
+                ),
+                scale
+            )
+        );
+        errors.add (
+            abs (
+                _mm_sub_ps (
+                    _mm_mul_ps ( _mm_cvtepi32_ps ( quantised[k] ), step ),
+                    c
+                )
+            )
+        );
+      }
+      _mm_storeu_si128 (
+          reinterpret_cast<__m128i*>( p_quantised + j ),
+          _mm_packus_epi16 (
+              _mm_packs_epi32 ( quantised[0], quantised[1] ),
+              _mm_packs_epi32 ( quantised[2], quantised[3] )
+          )
+      );
+    }
+    for ( ; j < count; ++j )
+    {
+      p_quantised[j] = static_cast<std::uint8_t>(
+          std::clamp ( p_components[j] * UNORM8_MAX + 0.5f, 0.0f, UNORM8_MAX )
+      );
+      errors.add (
+          std::abs (
+              static_cast<float>( p_quantised[j] ) / UNORM8_MAX
+              - p_components[j]
+          )
+      );
+    }
+    return ( errors.result () );
+  }
+
+  /**
+   * @brief Narrows vertex indices to 16 bits, eight at a time.
+   *
+   * @param[in] indices The indices, each below SHORT_INDEX_VERTICES.
+   * @param[out] p_quantised The narrowed indices.
+   */
+  void indices_uint16 (
+      std::span<const std::uint32_t> indices,
+      std::uint16_t* p_quantised
+  )
+  {
+    std::size_t j{ 0 };
+    for ( ; j + 8 <= indices.size (); j += 8 )
+    {
+      _mm_storeu_si128 (
+          reinterpret_cast<__m128i*>( p_quantised + j ),
+          pack_uint16 (
+              _mm_loadu_si128 (
+                  reinterpret_cast<const __m128i*>( indices.data () + j )
+              ),
+              _mm_loadu_si128 (
+                  reinterpret_cast<const __m128i*>( indices.data () + j + 4 )
+              )
+          )
+      );
+    }
+    for ( ; j < indices.size (); ++j )
+    {
+      p_quantised[j] = static_cast<std::uint16_t>( indices[j] );
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for storing mesh data in fewer bits.
+ *
+ * The kernels use SSE2, which every x64 processor has, and F16C for half
+ * precision when the compiler targets it.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,585 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Simplify.h
+// SYNOPSIS : Utilities for making coarser levels of detail of meshes.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for making coarser levels of detail of meshes.
+namespace Simplify
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The fraction of the triangles of one level of detail kept in the next.
+  const float DEFAULT_LOD_RATIO{ 0.5f };
+
+  /**
+   * @brief How much a difference in vertex attributes costs against a
+   * distance from the surface, both in units of the mesh size.
+   */
+  const float ATTRIBUTE_WEIGHT{ 0.01f };
+
+  //! The number of buckets collapses are sorted into by cost.
+  const std::size_t COST_BUCKETS{ 2'048 };
+
+  /**
+   * @brief The least cosine between the normals of a triangle before and
+   * after a collapse, below which the collapse is taken to fold it over.
+   */
+  const float FLIP_COSINE{ 0.25f };
+
+  /**
+   * @brief The most triangles a vertex may have and still be collapsed, so
+   * that checking a collapse for folds takes a bounded time. Vertices with
+   * more, such as the hub of a fan, stay, while their neighbours may still
+   * collapse onto them.
+   */
+  const std::uint32_t MAX_COLLAPSE_TRIANGLES{ 32 };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief A quadric, the sum of squared distances to a set of planes, each
+   * weighted by the area of the triangle it came from.
+   *
+   * @ingroup STRUCT
+   */
+  struct quadric_struct
+  {
+    //! The symmetric 3x3 part, as \c xx , \c yy , \c zz , \c xy , \c xz ,
+    //! and \c yz .
+    std::array<float, 6> a{};
+    //! The linear part.
+    std::array<float, 3> b{};
+    //! The constant part.
+    float c{};
+    //! The total area of the planes.
+    float weight{};
+  };
+
+  /**
+   * @brief A candidate collapse of one vertex onto another.
+   *
+   * @ingroup STRUCT
+   */
+  struct collapse_struct
+  {
+    //! The vertex removed.
+    std::uint32_t from{};
+    //! The vertex that takes its place.
+    std::uint32_t to{};
+    //! The error the collapse adds.
+    float cost{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Adds one quadric to another.
+   *
+   * @param[in,out] sum The quadric added to.
+   * @param[in] q The quadric to add.
+   */
+  inline void add ( quadric_struct& sum, const quadric_struct& q )
+  {
+    for ( std::size_t k{ 0 }; k < 6; ++k )
+    {
+      sum.a[k] += q.a[k];
+    }
+    for ( std::size_t k{ 0 }; k < 3; ++k )
+    {
+      sum.b[k] += q.b[k];
+    }
+    sum.c += q.c;
+    sum.weight += q.weight;
+  }
+
+  /**
+   * @brief Gives the weighted sum of squared distances from a point to the
+   * planes of a quadric.
+   *
+   * @param[in] q The quadric.
+   * @param[in] p The \c x , \c y , and \c z of the point.
+   * @returns The error, never negative.
+   */
+  inline float quadric_error ( const quadric_struct& q, const float* p )
+  {
+    const auto x{ p[0] };
+    const auto y{ p[1] };
+    const auto z{ p[2] };
+    const auto error{
+        q.a[0] * x * x + q.a[1] * y * y + q.a[2] * z * z
+        + 2.0f * ( q.a[3] * x * y + q.a[4] * x * z + q.a[5] * y * z )
+        + 2.0f * ( q.b[0] * x + q.b[1] * y + q.b[2] * z )
+        + q.c
+    };
+    return ( std::max ( error, 0.0f ) );
+  }
+
+  /**
+   * @brief Gives the unnormalised normal of a triangle.
+   *
+   * @param[in] p0 The first corner.
+   * @param[in] p1 The second corner.
+   * @param[in] p2 The third corner.
+   * @returns The normal, twice the area of the triangle long.
+   */
+  inline std::array<float, 3> triangle_normal (
+      const float* p0,
+      const float* p1,
+      const float* p2
+  )
+  {
+    const std::array<float, 3> e1{
+        p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]
+    };
+    const std::array<float, 3> e2{
+        p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]
+    };
+    return (
+        std::array<float, 3>{
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0]
+        }
+    );
+  }
+
+  /**
+   * @brief Lists the triangles around each vertex, in compressed rows.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] num_vertices The number of vertices.
+   * @param[out] offsets Where the triangles of each vertex start in
+   * \c triangles , with one more entry at the end.
+   * @param[out] triangles The triangles of each vertex in turn.
+   */
+  void vertex_triangles (
+      std::span<const std::uint32_t> indices,
+      std::size_t num_vertices,
+      std::vector<std::uint32_t>& offsets,
+      std::vector<std::uint32_t>& triangles
+  )
+  {
+    offsets.assign ( num_vertices + 1, 0 );
+    for ( const auto v : indices )
+    {
+      ++offsets[v + 1];
+    }
+    std::partial_sum ( offsets.begin (), offsets.end (), offsets.begin () );
+    triangles.resize ( indices.size () );
+    std::vector<std::uint32_t> next( offsets.begin (), offsets.end () - 1 );
+    for ( std::size_t j{ 0 }; j < indices.size (); ++j )
+    {
+      triangles[next[indices[j]]++] = static_cast<std::uint32_t>( j / 3 );
+    }
+  }
+
+  /**
+   * @brief Marks the vertices on open edges, which have a triangle on one
+   * side only, so that outlines and attribute seams keep their shape.
+   *
+   * The edges are sorted once, so that an edge from \c a to \c b is
+   * closed when the edge from \c b to \c a is found among them, however
+   * many triangles the vertices have.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[out] is_locked Set for each vertex on an open edge.
+   */
+  void lock_boundaries (
+      std::span<const std::uint32_t> indices,
+      std::vector<std::uint8_t>& is_locked
+  )
+  {
+    const auto key{
+        [] ( std::uint32_t a, std::uint32_t b )
+        {
+          return ( std::uint64_t{ a } << 32 | b );
+        }
+    };
+    std::vector<std::uint64_t> edges( indices.size () );
+    for ( std::size_t t{ 0 }; t < indices.size () / 3; ++t )
+    {
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        edges[t * 3 + k] = key (
+            indices[t * 3 + k],
+            indices[t * 3 + ( k + 1 ) % 3]
+        );
+      }
+    }
+    std::sort ( edges.begin (), edges.end () );
+    for ( const auto edge : edges )
+    {
+      const auto a{ static_cast<std::uint32_t>( edge >> 32 ) };
+      const auto b{ static_cast<std::uint32_t>( edge ) };
+      if ( !std::binary_search ( edges.begin (), edges.end (), key ( b, a ) ) )
+      {
+        is_locked[a] = 1;
+        is_locked[b] = 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Reduces a mesh to fewer triangles by collapsing edges.
+   *
+   * Each vertex gathers the quadric of the planes of its triangles, and a
+   * collapse costs the quadric error of moving a vertex onto its
+   * neighbour, plus the difference in their attributes weighted by
+   * ATTRIBUTE_WEIGHT and the area around the vertex. Vertices only ever
+   * move onto other vertices, so the result indexes the same vertices.
+   * Vertices on open edges are locked, and vertices with more than
+   * MAX_COLLAPSE_TRIANGLES triangles are not collapsed.
+   *
+   * Instead of a heap of collapses kept up to date, the collapses are made
+   * in passes: every edge is costed, the costs are sorted into buckets, and
+   * the cheapest collapses whose vertices no other collapse of the pass has
+   * touched, and which fold no triangle over, are made.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] p_positions The \c x , \c y , and \c z of each vertex.
+   * @param[in] num_vertices The number of vertices.
+   * @param[in] p_attributes Other values of each vertex to keep, such as
+   * normals and colours, or \c nullptr for none.
+   * @param[in] attributes_per_vertex The number of values each vertex has.
+   * @param[in] target_triangles The number of triangles wanted.
+   * @param[out] error The largest distance a collapse made moved the
+   * surface: the root mean square, over the area around the vertex removed,
+   * of the distance of its new place from the planes of that area, as a
+   * fraction of the diagonal of the mesh's bounding box.
+   * @returns The vertex indices of the reduced mesh, which has more
+   * triangles than wanted if locked vertices or folds stop it shrinking.
+   */
+  std::vector<std::uint32_t> simplify (
+      std::span<const std::uint32_t> indices,
+      const float* p_positions,
+      std::size_t num_vertices,
+      const float* p_attributes,
+      std::size_t attributes_per_vertex,
+      std::size_t target_triangles,
+      float& error
+  )
+  {
+    std::vector<std::uint32_t> result( indices.begin (), indices.end () );
+    error = 0.0f;
+    if ( result.size () / 3 <= target_triangles || num_vertices == 0 )
+    {
+      return ( result );
+    }
+
+    // Costs are taken in a unit cube, so that they do not depend on the size
+    // of the mesh.
+    std::array<float, 3> origin{ p_positions[0], p_positions[1],
+        p_positions[2] };
+    std::array<float, 3> top{ origin };
+    for ( std::size_t j{ 0 }; j < num_vertices * 3; ++j )
+    {
+      origin[j % 3] = std::min ( origin[j % 3], p_positions[j] );
+      top[j % 3] = std::max ( top[j % 3], p_positions[j] );
+    }
+    const auto extent{
+        std::max ( { top[0] - origin[0], top[1] - origin[1],
+            top[2] - origin[2], std::numeric_limits<float>::min () } )
+    };
+    std::vector<float> positions( num_vertices * 3 );
+    for ( std::size_t j{ 0 }; j < num_vertices * 3; ++j )
+    {
+      positions[j] = ( p_positions[j] - origin[j % 3] ) / extent;
+    }
+    const auto* p_position{ positions.data () };
+
+    std::vector<quadric_struct> quadrics( num_vertices );
+    for ( std::size_t t{ 0 }; t < result.size () / 3; ++t )
+    {
+      const auto* p0{ p_position + result[t * 3] * std::size_t{ 3 } };
+      const auto* p1{ p_position + result[t * 3 + 1] * std::size_t{ 3 } };
+      const auto* p2{ p_position + result[t * 3 + 2] * std::size_t{ 3 } };
+      auto n{ triangle_normal ( p0, p1, p2 ) };
+      const auto length{
+          std::sqrt ( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] )
+      };
+      if ( length == 0.0f )
+      {
+        continue;
+      }
+      for ( auto& component : n )
+      {
+        component /= length;
+      }
+      const auto d{ -( n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2] ) };
+      const auto w{ length * 0.5f };
+      const quadric_struct plane{
+          .a{ w * n[0] * n[0], w * n[1] * n[1], w * n[2] * n[2],
+              w * n[0] * n[1], w * n[0] * n[2], w * n[1] * n[2] },
+          .b{ w * d * n[0], w * d * n[1], w * d * n[2] },
+          .c{ w * d * d },
+          .weight{ w }
+      };
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        add ( quadrics[result[t * 3 + k]], plane );
+      }
+    }
+
+    std::vector<std::uint32_t> offsets{};
+    std::vector<std::uint32_t> triangles{};
+    vertex_triangles ( result, num_vertices, offsets, triangles );
+    std::vector<std::uint8_t> is_locked( num_vertices, 0 );
+    lock_boundaries ( result, is_locked );
+    const auto is_fixed{
+        [&] ( std::uint32_t v )
+        {
+          return (
+              is_locked[v]
+              || offsets[v + 1] - offsets[v] > MAX_COLLAPSE_TRIANGLES
+          );
+        }
+    };
+
+    const auto cost{
+        [&] ( std::uint32_t from, std::uint32_t to )
+        {
+          const auto& q{ quadrics[from] };
+          auto difference{ 0.0f };
+          for ( std::size_t k{ 0 }; k < attributes_per_vertex; ++k )
+          {
+            const auto delta{
+                p_attributes[from * attributes_per_vertex + k]
+                - p_attributes[to * attributes_per_vertex + k]
+            };
+            difference += delta * delta;
+          }
+          return (
+              quadric_error ( q, p_position + to * std::size_t{ 3 } )
+              + ATTRIBUTE_WEIGHT * q.weight * difference
+          );
+        }
+    };
+
+    // Whether moving a vertex onto another folds any of its other
+    // triangles over, or leaves one with no area. Only vertices that are not
+    // fixed move, so this checks at most MAX_COLLAPSE_TRIANGLES.
+    const auto is_folding{
+        [&] ( std::uint32_t from, std::uint32_t to )
+        {
+          for ( auto r{ offsets[from] }; r < offsets[from + 1]; ++r )
+          {
+            const auto* p_corners{ &result[triangles[r] * std::size_t{ 3 }] };
+            if (
+                p_corners[0] == to
+                || p_corners[1] == to
+                || p_corners[2] == to
+            )
+            {
+              continue;
+            }
+            std::array<const float*, 3> before{};
+            std::array<const float*, 3> after{};
+            for ( std::size_t k{ 0 }; k < 3; ++k )
+            {
+              before[k] = p_position + p_corners[k] * std::size_t{ 3 };
+              after[k] = p_corners[k] == from
+                  ? p_position + to * std::size_t{ 3 }
+                  : before[k];
+            }
+            const auto n0{
+                triangle_normal ( before[0], before[1], before[2] )
+            };
+            const auto n1{
+                triangle_normal ( after[0], after[1], after[2] )
+            };
+            const auto dot{ n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] };
+            const auto lengths{
+                std::sqrt (
+                    ( n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2] )
+                    * ( n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2] )
+                )
+            };
+            if ( lengths == 0.0f || dot < FLIP_COSINE * lengths )
+            {
+              return ( true );
+            }
+          }
+          return ( false );
+        }
+    };
+
+    // Costs are never negative, so their bits sort as they do, and the top
+    // bits give a bucket.
+    const auto bucket{
+        [] ( float value )
+        {
+          std::uint32_t bits{};
+          std::memcpy ( &bits, &value, sizeof ( bits ) );
+          return ( ( bits >> 20 ) & ( COST_BUCKETS - 1 ) );
+        }
+    };
+
+    std::vector<collapse_struct> collapses{};
+    std::vector<collapse_struct> sorted{};
+    std::vector<std::uint32_t> bucket_starts( COST_BUCKETS + 1 );
+    std::vector<std::uint8_t> is_touched( num_vertices, 0 );
+    std::vector<std::uint32_t> remap( num_vertices );
+    std::iota ( remap.begin (), remap.end (), std::uint32_t{ 0 } );
+    auto max_distance_squared{ 0.0f };
+    while ( result.size () / 3 > target_triangles )
+    {
+      // Each edge once, collapsing whichever way is cheaper.
+      collapses.clear ();
+      for ( std::size_t t{ 0 }; t < result.size () / 3; ++t )
+      {
+        for ( std::size_t k{ 0 }; k < 3; ++k )
+        {
+          const auto a{ result[t * 3 + k] };
+          const auto b{ result[t * 3 + ( k + 1 ) % 3] };
+          if ( a > b || ( is_fixed ( a ) && is_fixed ( b ) ) )
+          {
+            continue;
+          }
+          const auto a_cost{
+              is_fixed ( a )
+                  ? std::numeric_limits<float>::max ()
+                  : cost ( a, b )
+          };
+          const auto b_cost{
+              is_fixed ( b )
+                  ? std::numeric_limits<float>::max ()
+                  : cost ( b, a )
+          };
+          collapses.emplace_back (
+              a_cost <= b_cost
+                  ? collapse_struct{ a, b, a_cost }
+                  : collapse_struct{ b, a, b_cost }
+          );
+        }
+      }
+
+      std::fill ( bucket_starts.begin (), bucket_starts.end (), 0 );
+      for ( const auto& collapse : collapses )
+      {
+        ++bucket_starts[bucket ( collapse.cost ) + 1];
+      }
+      std::partial_sum (
+          bucket_starts.begin (),
+          bucket_starts.end (),
+          bucket_starts.begin ()
+      );
+      sorted.resize ( collapses.size () );
+      for ( const auto& collapse : collapses )
+      {
+        sorted[bucket_starts[bucket ( collapse.cost )]++] = collapse;
+      }
+
+      const auto wanted{ ( result.size () / 3 - target_triangles + 1 ) / 2 };
+      std::size_t made{ 0 };
+      std::fill ( is_touched.begin (), is_touched.end (), 0 );
+      for ( const auto& collapse : sorted )
+      {
+        if ( made >= wanted )
+        {
+          break;
+        }
+        if (
+            is_touched[collapse.from]
+            || is_touched[collapse.to]
+            || is_folding ( collapse.from, collapse.to )
+        )
+        {
+          continue;
+        }
+        remap[collapse.from] = collapse.to;
+        is_touched[collapse.from] = 1;
+        is_touched[collapse.to] = 1;
+        const auto& q{ quadrics[collapse.from] };
+        if ( q.weight > 0.0f )
+        {
+          max_distance_squared = std::max (
+              max_distance_squared,
+              quadric_error ( q, p_position + collapse.to * std::size_t{ 3 } )
+                  / q.weight
+          );
+        }
+        add ( quadrics[collapse.to], quadrics[collapse.from] );
+        ++made;
+      }
+      if ( made == 0 )
+      {
+        break;
+      }
+
+      // Triangles that lost a corner are dropped.
+      std::size_t kept{ 0 };
+      for ( std::size_t t{ 0 }; t < result.size () / 3; ++t )
+      {
+        const auto a{ remap[result[t * 3]] };
+        const auto b{ remap[result[t * 3 + 1]] };
+        const auto c{ remap[result[t * 3 + 2]] };
+        if ( a != b && b != c && a != c )
+        {
+          result[kept * 3] = a;
+          result[kept * 3 + 1] = b;
+          result[kept * 3 + 2] = c;
+          ++kept;
+        }
+      }
+      result.resize ( kept * 3 );
+      for ( const auto& collapse : sorted )
+      {
+        remap[collapse.from] = collapse.from;
+      }
+      vertex_triangles ( result, num_vertices, offsets, triangles );
+    }
+
+    // Distances were taken in units of the largest side of the bounding box,
+    // and are put in units of its diagonal here.
+    const auto diagonal{
+        std::sqrt (
+            ( top[0] - origin[0] ) * ( top[0] - origin[0] )
+            + ( top[1] - origin[1] ) * ( top[1] - origin[1] )
+            + ( top[2] - origin[2] ) * ( top[2] - origin[2] )
+        ) / extent
+    };
+    error = diagonal > 0.0f
+        ? std::sqrt ( max_distance_squared ) / diagonal
+        : 0.0f;
+    return ( result );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for making coarser levels of detail of meshes.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End:
@@ -0,0 +1,565 @@
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+// FILE     : Texture.h
+// SYNOPSIS : Utilities for baking textures into vertex colours.
+// LICENSE  : MIT
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HEADER FILES
+///////////////////////////////////////////////////////////////////////////////
+
+// PRECOMPILED HEADER FILE ////////////////////////////////////////////////////
+#include "PCH.h"
+
+// LOCAL //////////////////////////////////////////////////////////////////////
+#include "Colouring.h"
+#include "Jobs.h"
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NAMESPACE
+///////////////////////////////////////////////////////////////////////////////
+
+//! A namespace for baking textures into vertex colours.
+namespace Texture
+{
+  /////////////////////////////////////////////////////////////////////////////
+  // CONSTANTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! The rows of a level each task makes from the level above it.
+  const std::size_t ROWS_PER_TASK{ 64 };
+
+  //! The vertices each task samples.
+  const std::size_t VERTICES_PER_TASK{ 1024 };
+
+  //! The version of how levels are made and sampled, part of the key of
+  //! every cached file. Raise it with any change to make_levels() or
+  //! sample() that alters the colours baked.
+  const auto SAMPLING_VERSION{ 1U };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // ENUMS
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! An enumeration of how a texture is sampled at a vertex.
+  enum class FilterEnum
+  {
+    Bilinear, ///< The four texels nearest the vertex are blended.
+    Area      ///< The texels of the area the vertex covers are averaged.
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // STRUCTS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief An image, each texel four bytes of \c blue , \c green , \c red ,
+   * and \c alpha , as GDI+ and Assimp store them.
+   *
+   * @ingroup STRUCT
+   */
+  struct level_struct
+  {
+    //! The texels across.
+    std::uint32_t width{};
+    //! The texels down.
+    std::uint32_t height{};
+    //! The texels, row by row from the top.
+    std::vector<std::uint32_t> texels{};
+  };
+
+  /**
+   * @brief A texture, as levels each half the size of the one before, down
+   * to one texel.
+   *
+   * @ingroup STRUCT
+   */
+  struct texture_struct
+  {
+    //! The levels, the texture itself first.
+    std::vector<level_struct> levels{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // CLASSES
+  /////////////////////////////////////////////////////////////////////////////
+
+  //! Keeps GDI+ started, as decoding images needs, for its lifetime.
+  class DecoderSession final
+  {
+  public:
+    //! Starts GDI+.
+    DecoderSession ()
+    {
+      const Gdiplus::GdiplusStartupInput input{};
+      is_started_ =
+          Gdiplus::GdiplusStartup ( &token_, &input, nullptr ) == Gdiplus::Ok;
+    }
+
+    DecoderSession ( const DecoderSession& ) = delete;
+    DecoderSession& operator= ( const DecoderSession& ) = delete;
+
+    //! Shuts GDI+ down.
+    ~DecoderSession ()
+    {
+      if ( is_started_ )
+      {
+        Gdiplus::GdiplusShutdown ( token_ );
+      }
+    }
+
+    /**
+     * @brief Tells whether GDI+ started.
+     *
+     * @returns \c true if images can be decoded.
+     */
+    bool is_started () const noexcept
+    {
+      return ( is_started_ );
+    }
+
+  private:
+    ULONG_PTR token_{};
+    bool is_started_{};
+  };
+
+
+  /////////////////////////////////////////////////////////////////////////////
+  // FUNCTIONS
+  /////////////////////////////////////////////////////////////////////////////
+
+  /**
+   * @brief Copies the texels out of a decoded GDI+ bitmap.
+   *
+   * @param[in,out] bitmap The bitmap, locked while it is read.
+   * @param[in] name The name of the image, for errors.
+   * @returns The image.
+   * @throws std::runtime_error If the bitmap was not decoded.
+   */
+  level_struct read_bitmap (
+      Gdiplus::Bitmap& bitmap,
+      const std::string& name
+  )
+  {
+    if ( bitmap.GetLastStatus () != Gdiplus::Ok )
+    {
+      throw std::runtime_error{ "Image '" + name + "' cannot be decoded" };
+    }
+    level_struct level{
+        .width{ bitmap.GetWidth () },
+        .height{ bitmap.GetHeight () }
+    };
+    Gdiplus::Rect rect{
+        0,
+        0,
+        static_cast<INT>( level.width ),
+        static_cast<INT>( level.height )
+    };
+    Gdiplus::BitmapData data{};
+    if (
+        bitmap.LockBits (
+            &rect,
+            Gdiplus::ImageLockModeRead,
+            PixelFormat32bppARGB,
+            &data
+        ) != Gdiplus::Ok
+    )
+    {
+      throw std::runtime_error{ "Image '" + name + "' cannot be read" };
+    }
+    level.texels.resize ( std::size_t{ level.width } * level.height );
+    for ( std::uint32_t y{ 0 }; y < level.height; ++y )
+    {
+      std::memcpy (
+          &level.texels[std::size_t{ y } * level.width],
+          static_cast<const std::uint8_t*>( data.Scan0 )
+              + static_cast<std::ptrdiff_t>( y ) * data.Stride,
+          std::size_t{ level.width } * sizeof ( std::uint32_t )
+      );
+    }
+    bitmap.UnlockBits ( &data );
+    return ( level );
+  }
+
+  /**
+   * @brief Decodes an image file, in any format GDI+ reads.
+   *
+   * @param[in] file The name of the file.
+   * @returns The image.
+   * @throws std::runtime_error If the file cannot be decoded.
+   */
+  level_struct decode_file ( const boost::filesystem::path& file )
+  {
+    Gdiplus::Bitmap bitmap{ file.wstring ().c_str () };
+    return ( read_bitmap ( bitmap, file.string () ) );
+  }
+
+  /**
+   * @brief Decodes a texture embedded in a scene.
+   *
+   * Assimp keeps a compressed texture as the bytes of its file, which GDI+
+   * reads through a stream over them, and any other as its texels.
+   *
+   * @param[in] texture The texture.
+   * @param[in] name The name of the texture, for errors.
+   * @returns The image.
+   * @throws std::runtime_error If the texture cannot be decoded.
+   */
+  level_struct decode_embedded (
+      const aiTexture& texture,
+      const std::string& name
+  )
+  {
+    if ( texture.mHeight > 0 )
+    {
+      level_struct level{
+          .width{ texture.mWidth },
+          .height{ texture.mHeight }
+      };
+      level.texels.resize ( std::size_t{ level.width } * level.height );
+      std::memcpy (
+          level.texels.data (),
+          texture.pcData,
+          level.texels.size () * sizeof ( std::uint32_t )
+      );
+      return ( level );
+    }
+    auto* p_stream{
+        SHCreateMemStream (
+            reinterpret_cast<const BYTE*>( texture.pcData ),
+            texture.mWidth
+        )
+    };
+    if ( p_stream == nullptr )
+    {
+      throw std::runtime_error{ "Image '" + name + "' cannot be streamed" };
+    }
+    try
+    {
+      level_struct level{};
+      {
+        Gdiplus::Bitmap bitmap{ p_stream };
+        level = read_bitmap ( bitmap, name );
+      }
+      p_stream->Release ();
+      return ( level );
+    }
+    catch ( ... )
+    {
+      p_stream->Release ();
+      throw;
+    }
+  }
+
+  /**
+   * @brief Gives the four bytes of a texel as \c float lanes.
+   *
+   * @param[in] texel The texel.
+   * @returns Its \c blue , \c green , \c red , and \c alpha , from 0 to 255.
+   */
+  inline __m128 unpack ( std::uint32_t texel ) noexcept
+  {
+    const auto zero{ _mm_setzero_si128 () };
+    const auto bytes{ _mm_cvtsi32_si128 ( static_cast<int>( texel ) ) };
+    return (
+        _mm_cvtepi32_ps (
+            _mm_unpacklo_epi16 ( _mm_unpacklo_epi8 ( bytes, zero ), zero )
+        )
+    );
+  }
+
+  /**
+   * @brief Makes the levels of a texture below it, each texel of one the
+   * mean of the two by two texels above it.
+   *
+   * The rows of each level are made in tasks spread over the workers.
+   *
+   * @param[in] image The texture itself.
+   * @param[in] workers The number of workers to make levels with.
+   * @returns The texture with all its levels.
+   */
+  texture_struct make_levels ( level_struct image, unsigned workers )
+  {
+    texture_struct texture{};
+    texture.levels.emplace_back ( std::move ( image ) );
+    while ( texture.levels.back ().width > 1
+        || texture.levels.back ().height > 1 )
+    {
+      const auto& above{ texture.levels.back () };
+      level_struct level{
+          .width{ std::max ( above.width / 2, 1U ) },
+          .height{ std::max ( above.height / 2, 1U ) }
+      };
+      level.texels.resize ( std::size_t{ level.width } * level.height );
+      const auto tasks{
+          ( level.height + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK
+      };
+      Jobs::parallel_for (
+          tasks,
+          Jobs::worker_count ( workers, tasks ),
+          [&] ( std::size_t task, unsigned )
+          {
+            const std::size_t last_x{ above.width - 1U };
+            const std::size_t last_y{ above.height - 1U };
+            const auto end{
+                std::min<std::size_t> (
+                    level.height,
+                    ( task + 1 ) * ROWS_PER_TASK
+                )
+            };
+            const auto pair{
+                [] ( std::uint32_t a, std::uint32_t b )
+                {
+                  return (
+                      _mm_unpacklo_epi8 (
+                          _mm_unpacklo_epi32 (
+                              _mm_cvtsi32_si128 ( static_cast<int>( a ) ),
+                              _mm_cvtsi32_si128 ( static_cast<int>( b ) )
+                          ),
+                          _mm_setzero_si128 ()
+                      )
+                  );
+                }
+            };
+            for ( auto y{ task * ROWS_PER_TASK }; y < end; ++y )
+            {
+              // A side of one texel is not halved, so its texels repeat.
+              const auto* p_row0{
+                  &above.texels[std::min ( y * 2, last_y ) * above.width]
+              };
+              const auto* p_row1{
+                  &above.texels[std::min ( y * 2 + 1, last_y ) * above.width]
+              };
+              for ( std::size_t x{ 0 }; x < level.width; ++x )
+              {
+                const auto x0{ std::min ( x * 2, last_x ) };
+                const auto x1{ std::min ( x * 2 + 1, last_x ) };
+                const auto top{ pair ( p_row0[x0], p_row0[x1] ) };
+                const auto bottom{ pair ( p_row1[x0], p_row1[x1] ) };
+                // The four texels are summed in 16-bit lanes and rounded.
+                auto sum{ _mm_add_epi16 ( top, bottom ) };
+                sum = _mm_add_epi16 ( sum, _mm_srli_si128 ( sum, 8 ) );
+                sum = _mm_srli_epi16 (
+                    _mm_add_epi16 ( sum, _mm_set1_epi16 ( 2 ) ),
+                    2
+                );
+                level.texels[y * level.width + x] =
+                    static_cast<std::uint32_t>(
+                        _mm_cvtsi128_si32 ( _mm_packus_epi16 ( sum, sum ) )
+                    );
+              }
+            }
+          }
+      );
+      texture.levels.emplace_back ( std::move ( level ) );
+    }
+    return ( texture );
+  }
+
+  /**
+   * @brief Samples a level between its four texels nearest a point, the
+   * texture repeating beyond 0 and 1.
+   *
+   * @param[in] level The level.
+   * @param[in] u The \c u of the point, rising to the right.
+   * @param[in] v The \c v of the point, rising upwards.
+   * @returns The \c blue , \c green , \c red , and \c alpha there, from 0
+   * to 255.
+   */
+  __m128 bilinear ( const level_struct& level, float u, float v ) noexcept
+  {
+    const auto x{ ( u - std::floor ( u ) ) * level.width - 0.5f };
+    const auto y{ ( std::ceil ( v ) - v ) * level.height - 0.5f };
+    const auto x_floor{ std::floor ( x ) };
+    const auto y_floor{ std::floor ( y ) };
+    const auto fx{ _mm_set1_ps ( x - x_floor ) };
+    const auto fy{ _mm_set1_ps ( y - y_floor ) };
+    const auto wrap{
+        [] ( float value, std::uint32_t size )
+        {
+          const auto i{ static_cast<std::int64_t>( value ) };
+          return (
+              static_cast<std::size_t>( ( i % size + size ) % size )
+          );
+        }
+    };
+    const auto x0{ wrap ( x_floor, level.width ) };
+    const auto x1{ wrap ( x_floor + 1.0f, level.width ) };
+    const auto row0{ wrap ( y_floor, level.height ) * level.width };
+    const auto row1{ wrap ( y_floor + 1.0f, level.height ) * level.width };
+    const auto lerp{
+        [] ( __m128 a, __m128 b, __m128 t )
+        {
+          return ( _mm_add_ps ( a, _mm_mul_ps ( _mm_sub_ps ( b, a ), t ) ) );
+        }
+    };
+    const auto top{
+        lerp (
+            unpack ( level.texels[row0 + x0] ),
+            unpack ( level.texels[row0 + x1] ),
+            fx
+        )
+    };
+    const auto bottom{
+        lerp (
+            unpack ( level.texels[row1 + x0] ),
+            unpack ( level.texels[row1 + x1] ),
+            fx
+        )
+    };
+    return ( lerp ( top, bottom, fy ) );
+  }
+
+  /**
+   * @brief Finds the area of the texture each vertex covers, as a third of
+   * the texture area of each triangle using it.
+   *
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] p_uvs The \c u and \c v of each vertex.
+   * @param[in] count The number of vertices.
+   * @returns The area of each vertex, as a fraction of the whole texture.
+   */
+  std::vector<float> footprints (
+      std::span<const std::uint32_t> indices,
+      const float* p_uvs,
+      std::size_t count
+  )
+  {
+    std::vector<float> areas( count, 0.0f );
+    for ( std::size_t t{ 0 }; t + 2 < indices.size (); t += 3 )
+    {
+      const auto* p_a{ p_uvs + indices[t] * std::size_t{ 2 } };
+      const auto* p_b{ p_uvs + indices[t + 1] * std::size_t{ 2 } };
+      const auto* p_c{ p_uvs + indices[t + 2] * std::size_t{ 2 } };
+      const auto area{
+          std::abs (
+              ( p_b[0] - p_a[0] ) * ( p_c[1] - p_a[1] )
+              - ( p_c[0] - p_a[0] ) * ( p_b[1] - p_a[1] )
+          ) / 6.0f
+      };
+      for ( std::size_t k{ 0 }; k < 3; ++k )
+      {
+        areas[indices[t + k]] += area;
+      }
+    }
+    return ( areas );
+  }
+
+  /**
+   * @brief Samples a texture at each vertex.
+   *
+   * Bilinear filtering blends the texels of the texture itself nearest each
+   * vertex. Area filtering blends those of the two levels whose texels are
+   * nearest the size of the area the vertex covers, so that a vertex of a
+   * coarse mesh takes the mean colour around it rather than that of one
+   * texel. Vertices are sampled in tasks spread over the workers.
+   *
+   * @param[in] texture The texture.
+   * @param[in] filter How it is sampled.
+   * @param[in] indices The vertex indices, three for each triangle.
+   * @param[in] p_uvs The \c u and \c v of each vertex.
+   * @param[in] count The number of vertices.
+   * @param[in] workers The number of workers to sample with.
+   * @returns The colour of each vertex.
+   */
+  std::vector<Colouring::rgba_struct> sample (
+      const texture_struct& texture,
+      FilterEnum filter,
+      std::span<const std::uint32_t> indices,
+      const float* p_uvs,
+      std::size_t count,
+      unsigned workers
+  )
+  {
+    std::vector<Colouring::rgba_struct> colours( count );
+    const auto areas{
+        filter == FilterEnum::Area
+            ? footprints ( indices, p_uvs, count )
+            : std::vector<float>{}
+    };
+    const auto& base{ texture.levels.front () };
+    const auto texels{
+        static_cast<float>( base.width ) * static_cast<float>( base.height )
+    };
+    const auto deepest{ static_cast<float>( texture.levels.size () - 1 ) };
+    const auto tasks{ ( count + VERTICES_PER_TASK - 1 ) / VERTICES_PER_TASK };
+    Jobs::parallel_for (
+        tasks,
+        Jobs::worker_count ( workers, tasks ),
+        [&] ( std::size_t task, unsigned )
+        {
+          const auto scale{ _mm_set1_ps ( 1.0f / 255.0f ) };
+          const auto end{
+              std::min ( count, ( task + 1 ) * VERTICES_PER_TASK )
+          };
+          for ( auto j{ task * VERTICES_PER_TASK }; j < end; ++j )
+          {
+            const auto u{ p_uvs[j * 2] };
+            const auto v{ p_uvs[j * 2 + 1] };
+            __m128 texel{};
+            if ( areas.empty () || !( areas[j] * texels > 1.0f ) )
+            {
+              texel = bilinear ( base, u, v );
+            }
+            else
+            {
+              // Each level halves the side of the area a texel covers.
+              const auto depth{
+                  std::min (
+                      0.5f * std::log2 ( areas[j] * texels ),
+                      deepest
+                  )
+              };
+              const auto upper{ static_cast<std::size_t>( depth ) };
+              const auto lower{
+                  std::min ( upper + 1, texture.levels.size () - 1 )
+              };
+              const auto above{ bilinear ( texture.levels[upper], u, v ) };
+              const auto below{ bilinear ( texture.levels[lower], u, v ) };
+              texel = _mm_add_ps (
+                  above,
+                  _mm_mul_ps (
+                      _mm_sub_ps ( below, above ),
+                      _mm_set1_ps ( depth - static_cast<float>( upper ) )
+                  )
+              );
+            }
+            _mm_storeu_ps (
+                &colours[j].red,
+                _mm_mul_ps (
+                    _mm_shuffle_ps (
+                        texel,
+                        texel,
+                        _MM_SHUFFLE ( 3, 0, 1, 2 )
+                    ),
+                    scale
+                )
+            );
+          }
+        }
+    );
+    return ( colours );
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// END
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * @file
+ * @brief Utilities for baking textures into vertex colours.
+ *
+ * @author Mohammad Haroon Khaliq
+ * @date @showdate "%d %B %Y"
+ * @copyright MIT License.
+ */
+ // Local variables:
+ // mode: c++
+ // End: